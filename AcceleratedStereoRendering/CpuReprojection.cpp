@@ -0,0 +1,429 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#include "CpuReprojection.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+
+namespace
+{
+    // Rows per raster band, each band is owned by exactly one thread
+    const int32_t kBandHeight = 16;
+    const float kMaxTessFactor = 64.f;
+
+    // Runs func for every index in [0, count), one index per pool task
+    template<typename Func>
+    void parallelFor(WorkStealingPool* pPool, uint32_t count, const Func& func)
+    {
+        pPool->parallelFor(count, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++) func(i);
+        });
+    }
+
+    // Texture2D.SampleLevel with linear filtering and wrap addressing (default Falcor sampler)
+    template<typename T>
+    T sampleLinear(const T* pData, uint32_t width, uint32_t height, glm::vec2 uv, glm::ivec2 offset = glm::ivec2(0, 0))
+    {
+        float tx = uv.x * (float)width - 0.5f;
+        float ty = uv.y * (float)height - 0.5f;
+        float fx = std::floor(tx);
+        float fy = std::floor(ty);
+        float ax = tx - fx;
+        float ay = ty - fy;
+
+        auto wrap = [](int32_t v, int32_t size) { v %= size; return v < 0 ? v + size : v; };
+        int32_t x0 = wrap((int32_t)fx + offset.x, width);
+        int32_t y0 = wrap((int32_t)fy + offset.y, height);
+        int32_t x1 = wrap(x0 + 1, width);
+        int32_t y1 = wrap(y0 + 1, height);
+
+        T top = pData[y0 * width + x0] * (1.f - ax) + pData[y0 * width + x1] * ax;
+        T bottom = pData[y1 * width + x0] * (1.f - ax) + pData[y1 * width + x1] * ax;
+        return top * (1.f - ay) + bottom * ay;
+    }
+
+    float linearDepth(float depth, float nearZ, float farZ)
+    {
+        return nearZ / (farZ - depth * (farZ - nearZ)) * farZ;
+    }
+
+    // Edge function, positive if p is right of a->b in screen space (y down)
+    inline float edgeFunction(const glm::vec2& a, const glm::vec2& b, const glm::vec2& p)
+    {
+        return (p.x - a.x) * (b.y - a.y) - (p.y - a.y) * (b.x - a.x);
+    }
+
+    // Fill convention for pixels exactly on an edge, shared edges are only drawn once
+    inline bool isTopLeft(const glm::vec2& a, const glm::vec2& b)
+    {
+        glm::vec2 e = b - a;
+        return (e.y > 0.f) || (e.y == 0.f && e.x < 0.f);
+    }
+}
+
+CpuReprojection::SharedPtr CpuReprojection::create(uint32_t threadCount)
+{
+    return SharedPtr(new CpuReprojection(threadCount));
+}
+
+CpuReprojection::CpuReprojection(uint32_t threadCount)
+{
+    mpPool = threadCount ? WorkStealingPool::create(threadCount) : WorkStealingPool::getShared();
+    mpQuadBounds = QuadBoundsReduction::create(mpPool);
+}
+
+void CpuReprojection::execute(const Input& input, const Settings& settings, Output& output)
+{
+    assert(input.pDepth && input.pColor);
+    assert(settings.quadDivideFactor > 0);
+
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    computeQuadLevels(input, settings, output);
+    CpuTimer::TimePoint quadLevelEnd = CpuTimer::getCurrentTimePoint();
+    warpGrid(input, settings, output);
+    CpuTimer::TimePoint warpEnd = CpuTimer::getCurrentTimePoint();
+    rasterize(input, settings, output);
+    CpuTimer::TimePoint end = CpuTimer::getCurrentTimePoint();
+
+    mStats.quadLevelMs = CpuTimer::calcDuration(start, quadLevelEnd);
+    mStats.warpMs = CpuTimer::calcDuration(quadLevelEnd, warpEnd);
+    mStats.rasterMs = CpuTimer::calcDuration(warpEnd, end);
+    mStats.totalMs = CpuTimer::calcDuration(start, end);
+    mStats.mpixPerSec = mStats.totalMs > 0 ? (double)(input.width * input.height) / (mStats.totalMs * 1000.0) : 0;
+}
+
+CpuReprojection::Stats CpuReprojection::benchmark(const Input& input, const Settings& settings, uint32_t iterations)
+{
+    Output output;
+    Stats avg;
+    iterations = std::max(1u, iterations);
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        execute(input, settings, output);
+        avg.quadLevelMs += mStats.quadLevelMs;
+        avg.warpMs += mStats.warpMs;
+        avg.rasterMs += mStats.rasterMs;
+        avg.totalMs += mStats.totalMs;
+    }
+
+    avg.quadLevelMs /= iterations;
+    avg.warpMs /= iterations;
+    avg.rasterMs /= iterations;
+    avg.totalMs /= iterations;
+    avg.mpixPerSec = avg.totalMs > 0 ? (double)(input.width * input.height) / (avg.totalMs * 1000.0) : 0;
+    mStats = avg;
+    return avg;
+}
+
+uint32_t CpuReprojection::compare(const Output& reference, const glm::vec4* pGpuColor, float tolerance)
+{
+    uint32_t mismatches = 0;
+    for (size_t i = 0; i < reference.color.size(); i++)
+    {
+        const glm::vec4& ref = reference.color[i];
+        const glm::vec4& gpu = pGpuColor[i];
+        bool gpuHole = gpu.w == 0.f;
+        if (gpuHole != (reference.holeMask[i] != 0))
+        {
+            mismatches++;
+        }
+        else if (!gpuHole)
+        {
+            glm::vec3 diff = glm::abs(glm::vec3(ref) - glm::vec3(gpu));
+            if (diff.x > tolerance || diff.y > tolerance || diff.z > tolerance) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+// QuadLevelCompute.slang - min/max depth per 16x16 tile, stored as depth ratio or binocular disparity in arc minutes
+void CpuReprojection::computeQuadLevels(const Input& input, const Settings& settings, Output& output)
+{
+    const uint32_t quadCountX = input.width / settings.quadDivideFactor;
+    const uint32_t quadCountY = input.height / settings.quadDivideFactor;
+    output.quadLevels.assign(quadCountX * quadCountY, 0.f);
+
+    // The shader always reduces 16x16 tiles, only the number of tiles depends on the quad divide factor
+    mpQuadBounds->reduce(input.pDepth, nullptr, input.width, input.height, quadCountX, quadCountY, mQuadBounds);
+
+    parallelFor(mpPool.get(), quadCountY, [&](uint32_t qy)
+    {
+        for (uint32_t qx = 0; qx < quadCountX; qx++)
+        {
+            const QuadBoundsReduction::Bounds& bounds = mQuadBounds[qy * quadCountX + qx];
+            const float minDepth = bounds.minDepth;
+            const float maxDepth = bounds.maxDepth;
+
+            float level;
+            if (settings.useBinocularMetric)
+            {
+                float minLinear = linearDepth(minDepth, input.nearZ, input.farZ);
+                float maxLinear = linearDepth(maxDepth, input.nearZ, input.farZ);
+                float angleMin = 2.f * std::atan(0.065f / (2.f * minLinear));
+                float angleMax = 2.f * std::atan(0.065f / (2.f * maxLinear));
+                float disparity = std::abs(angleMin - angleMax);
+                level = (disparity / 3.14159f) * 180.f * 60.f;
+            }
+            else
+            {
+                level = minDepth / maxDepth;
+            }
+            output.quadLevels[qy * quadCountX + qx] = level;
+        }
+    });
+}
+
+// ReprojectionHS.slang - a quad is split if itself or one of its neighbors crosses the threshold
+float CpuReprojection::getTessellationFactor(const Settings& settings, const std::vector<float>& levels, int32_t quadId, uint32_t quadCountX) const
+{
+    auto exceeds = [&](int32_t id)
+    {
+        // Out of bounds structured buffer reads return 0 on the GPU
+        float level = (id >= 0 && id < (int32_t)levels.size()) ? levels[id] : 0.f;
+        return settings.useBinocularMetric ? (level > settings.hullZThreshold) : (level < settings.hullZThreshold);
+    };
+
+    const int32_t qx = (int32_t)quadCountX;
+    bool split = exceeds(quadId) || exceeds(quadId - 1) || exceeds(quadId + 1) || exceeds(quadId - qx) || exceeds(quadId + qx);
+    if (!split && settings.useEightNeighbor)
+    {
+        split = exceeds(quadId - qx + 1) || exceeds(quadId - qx - 1) || exceeds(quadId + qx + 1) || exceeds(quadId + qx - 1);
+    }
+
+    return split ? glm::clamp((float)settings.tessFactor, 1.f, kMaxTessFactor) : 1.f;
+}
+
+// Grid generation (see Reprojection::generateGrid), tessellation and ReprojectionDS/GS.slang vertex processing
+void CpuReprojection::warpGrid(const Input& input, const Settings& settings, const Output& output)
+{
+    const uint32_t width = input.width;
+    const uint32_t height = input.height;
+    const uint32_t quadCountX = width / settings.quadDivideFactor;
+    const uint32_t quadCountY = height / settings.quadDivideFactor;
+    const glm::mat4 reprojectionMat = input.rightViewProj * glm::inverse(input.leftViewProj);
+
+    mRowTriangles.resize(quadCountY);
+    mTessellatedPerRow.assign(quadCountY, 0);
+
+    // Grid vertex of row r (top row first) and column c, identical to the vertex buffer contents
+    auto gridVertex = [&](uint32_t r, uint32_t c, glm::vec2& pos, glm::vec2& uv)
+    {
+        uint32_t y = quadCountY - r;
+        pos = glm::vec2((float)c / (float)quadCountX * 2.f - 1, (float)y / (float)quadCountY * 2.f - 1);
+        uv = glm::vec2((float)c / (float)quadCountX, 1 - (float)y / (float)quadCountY);
+        if (settings.addHalfPixelOffset)
+        {
+            pos += glm::vec2(0.5f / (float)width, -0.5f / (float)height);
+            uv += glm::vec2(0.5f / (float)width, 0.5f / (float)height);
+        }
+    };
+
+    struct DomainVertex
+    {
+        RasterVertex rv;
+        float occFlag;
+        bool valid;
+    };
+
+    parallelFor(mpPool.get(), quadCountY, [&](uint32_t r)
+    {
+        std::vector<Triangle>& triangles = mRowTriangles[r];
+        triangles.clear();
+        std::vector<DomainVertex> domain;
+
+        for (uint32_t c = 0; c < quadCountX; c++)
+        {
+            // Patch control points in index buffer order
+            glm::vec2 pos[4], uv[4];
+            gridVertex(r + 1, c, pos[0], uv[0]);
+            gridVertex(r + 1, c + 1, pos[1], uv[1]);
+            gridVertex(r, c + 1, pos[2], uv[2]);
+            gridVertex(r, c, pos[3], uv[3]);
+
+            // The hull shader reads the quad ID of the first control point
+            int32_t quadId = (int32_t)((r + 1) * quadCountX + c);
+            uint32_t n = (uint32_t)std::ceil(getTessellationFactor(settings, output.quadLevels, quadId, quadCountX));
+            if (n > 1) mTessellatedPerRow[r]++;
+
+            domain.resize((n + 1) * (n + 1));
+            for (uint32_t j = 0; j <= n; j++)
+            {
+                for (uint32_t i = 0; i <= n; i++)
+                {
+                    glm::vec2 domainUV((float)i / (float)n, (float)j / (float)n);
+                    glm::vec2 posH = glm::mix(glm::mix(pos[0], pos[1], domainUV.x), glm::mix(pos[3], pos[2], domainUV.x), domainUV.y);
+                    glm::vec2 texC = glm::mix(glm::mix(uv[0], uv[1], domainUV.x), glm::mix(uv[3], uv[2], domainUV.x), domainUV.y);
+
+                    float z = glm::clamp(sampleLinear(input.pDepth, width, height, texC), 0.000001f, 0.99999f);
+                    glm::vec4 posWH = reprojectionMat * glm::vec4(posH.x, posH.y, z, 1.f);
+
+                    float zLeft = sampleLinear(input.pDepth, width, height, texC, glm::ivec2(-1, 0));
+                    float zRight = sampleLinear(input.pDepth, width, height, texC, glm::ivec2(1, 0));
+
+                    DomainVertex& dv = domain[j * (n + 1) + i];
+                    dv.occFlag = std::abs(2 * zLeft - 2 * zRight);
+                    dv.valid = posWH.w > 0.f; // no clipping, triangles behind the eye are dropped
+                    if (dv.valid)
+                    {
+                        float invW = 1.f / posWH.w;
+                        dv.rv.screen = glm::vec2((posWH.x * invW * 0.5f + 0.5f) * (float)width, (0.5f - posWH.y * invW * 0.5f) * (float)height);
+                        dv.rv.depth = z * invW;
+                        dv.rv.invW = invW;
+                        dv.rv.texCOverW = texC * invW;
+                        dv.rv.occFlagOverW = dv.occFlag * invW;
+                    }
+                }
+            }
+
+            auto emit = [&](const DomainVertex& v0, const DomainVertex& v1, const DomainVertex& v2)
+            {
+                if (!v0.valid || !v1.valid || !v2.valid) return;
+                if (settings.useGeoShader && (v0.occFlag > settings.geoZThreshold || v1.occFlag > settings.geoZThreshold || v2.occFlag > settings.geoZThreshold)) return;
+
+                Triangle t;
+                t.v[0] = v0.rv;
+                t.v[1] = v1.rv;
+                t.v[2] = v2.rv;
+                float minSy = std::min(v0.rv.screen.y, std::min(v1.rv.screen.y, v2.rv.screen.y));
+                float maxSy = std::max(v0.rv.screen.y, std::max(v1.rv.screen.y, v2.rv.screen.y));
+                t.minY = std::max(0, (int32_t)std::ceil(minSy - 0.5f));
+                t.maxY = std::min((int32_t)height - 1, (int32_t)std::floor(maxSy - 0.5f));
+                if (t.minY <= t.maxY) triangles.push_back(t);
+            };
+
+            for (uint32_t j = 0; j < n; j++)
+            {
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    const DomainVertex& v00 = domain[j * (n + 1) + i];
+                    const DomainVertex& v10 = domain[j * (n + 1) + i + 1];
+                    const DomainVertex& v01 = domain[(j + 1) * (n + 1) + i];
+                    const DomainVertex& v11 = domain[(j + 1) * (n + 1) + i + 1];
+                    emit(v00, v10, v11);
+                    emit(v00, v11, v01);
+                }
+            }
+        }
+    });
+}
+
+// Band-parallel rasterization with depth test (Less) and ReprojectionPS.slang shading
+void CpuReprojection::rasterize(const Input& input, const Settings& settings, Output& output)
+{
+    const int32_t width = (int32_t)input.width;
+    const int32_t height = (int32_t)input.height;
+    const uint32_t bandCount = (height + kBandHeight - 1) / kBandHeight;
+
+    output.color.assign(width * height, glm::vec4(settings.clearColor, 0));
+    output.holeMask.assign(width * height, 0);
+    mDepthBuffer.assign(width * height, 1.f);
+
+    // Bin triangles into bands, keeping submission order so depth ties resolve like on the GPU
+    std::vector<std::vector<const Triangle*>> bins(bandCount);
+    output.triangleCount = 0;
+    output.tessellatedQuadCount = 0;
+    for (size_t r = 0; r < mRowTriangles.size(); r++)
+    {
+        output.tessellatedQuadCount += mTessellatedPerRow[r];
+        for (const Triangle& t : mRowTriangles[r])
+        {
+            output.triangleCount++;
+            for (int32_t b = t.minY / kBandHeight; b <= t.maxY / kBandHeight; b++)
+            {
+                bins[b].push_back(&t);
+            }
+        }
+    }
+
+    std::atomic<uint32_t> holeCount(0);
+    parallelFor(mpPool.get(), bandCount, [&](uint32_t band)
+    {
+        const int32_t bandMinY = band * kBandHeight;
+        const int32_t bandMaxY = std::min(height - 1, bandMinY + kBandHeight - 1);
+
+        for (const Triangle* pTri : bins[band])
+        {
+            const RasterVertex* v[3] = { &pTri->v[0], &pTri->v[1], &pTri->v[2] };
+            float area = edgeFunction(v[0]->screen, v[1]->screen, v[2]->screen);
+            if (area == 0.f) continue;
+            if (area < 0.f)
+            {
+                std::swap(v[1], v[2]);
+                area = -area;
+            }
+
+            const bool topLeft0 = isTopLeft(v[1]->screen, v[2]->screen);
+            const bool topLeft1 = isTopLeft(v[2]->screen, v[0]->screen);
+            const bool topLeft2 = isTopLeft(v[0]->screen, v[1]->screen);
+
+            float minSx = std::min(v[0]->screen.x, std::min(v[1]->screen.x, v[2]->screen.x));
+            float maxSx = std::max(v[0]->screen.x, std::max(v[1]->screen.x, v[2]->screen.x));
+            int32_t minX = std::max(0, (int32_t)std::ceil(minSx - 0.5f));
+            int32_t maxX = std::min(width - 1, (int32_t)std::floor(maxSx - 0.5f));
+            int32_t minY = std::max(bandMinY, pTri->minY);
+            int32_t maxY = std::min(bandMaxY, pTri->maxY);
+
+            for (int32_t y = minY; y <= maxY; y++)
+            {
+                for (int32_t x = minX; x <= maxX; x++)
+                {
+                    glm::vec2 p((float)x + 0.5f, (float)y + 0.5f);
+                    float e0 = edgeFunction(v[1]->screen, v[2]->screen, p);
+                    float e1 = edgeFunction(v[2]->screen, v[0]->screen, p);
+                    float e2 = edgeFunction(v[0]->screen, v[1]->screen, p);
+                    if (e0 < 0.f || e1 < 0.f || e2 < 0.f) continue;
+                    if ((e0 == 0.f && !topLeft0) || (e1 == 0.f && !topLeft1) || (e2 == 0.f && !topLeft2)) continue;
+
+                    float b0 = e0 / area, b1 = e1 / area, b2 = e2 / area;
+                    float depth = b0 * v[0]->depth + b1 * v[1]->depth + b2 * v[2]->depth;
+                    if (depth < 0.f || depth > 1.f) continue;
+
+                    uint32_t idx = y * width + x;
+                    if (depth >= mDepthBuffer[idx]) continue;
+
+                    // Perspective correct attributes
+                    float invW = b0 * v[0]->invW + b1 * v[1]->invW + b2 * v[2]->invW;
+                    float occFlag = (b0 * v[0]->occFlagOverW + b1 * v[1]->occFlagOverW + b2 * v[2]->occFlagOverW) / invW;
+                    if (!settings.showDisocclusion && occFlag > settings.threshold) continue;
+                    glm::vec2 texC = (b0 * v[0]->texCOverW + b1 * v[1]->texCOverW + b2 * v[2]->texCOverW) / invW;
+
+                    mDepthBuffer[idx] = depth;
+                    output.color[idx] = glm::vec4(glm::vec3(sampleLinear(input.pColor, input.width, input.height, texC)), 1.f);
+                }
+            }
+        }
+
+        uint32_t bandHoles = 0;
+        for (int32_t i = bandMinY * width; i < (bandMaxY + 1) * width; i++)
+        {
+            if (output.color[i].w == 0.f)
+            {
+                output.holeMask[i] = 1;
+                bandHoles++;
+            }
+        }
+        holeCount += bandHoles;
+    });
+
+    output.holeCount = holeCount;
+}
@@ -0,0 +1,131 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#pragma once
+#include "Falcor.h"
+
+#include <vector>
+
+using namespace Falcor;
+
+// CPU reference of the reprojection grid warp (QuadLevelCompute + ReprojectionVS/HS/DS/GS/PS).
+// Needs no GPU, so it can validate the GPU output and measure the algorithm on headless machines
+class CpuReprojection
+{
+public:
+    using SharedPtr = std::shared_ptr<CpuReprojection>;
+
+    // Mirrors the GUI settings of the Reprojection pass
+    struct Settings
+    {
+        int32_t quadDivideFactor = 16;
+        int32_t tessFactor = 16;
+        float hullZThreshold = 0.997f;
+        float geoZThreshold = 0.010f;
+        float threshold = 0.008f;           // pixel shader discard threshold
+        bool useBinocularMetric = true;
+        bool useEightNeighbor = false;
+        bool useGeoShader = false;          // _USEGEOSHADER + _DISCARD_TRIANGLES
+        bool showDisocclusion = false;
+        bool addHalfPixelOffset = true;
+        glm::vec3 clearColor = glm::vec3(0, 0, 0);
+    };
+
+    // Left eye buffers as produced by the G-buffer and lighting pass (row-major, top row first)
+    struct Input
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        const float* pDepth = nullptr;          // D32Float
+        const glm::vec4* pNormal = nullptr;     // RGBA32Float, only used by the (disabled) planar surface heuristic
+        const glm::vec4* pPosition = nullptr;   // RGBA32Float, see above
+        const glm::vec4* pColor = nullptr;      // RGBA32Float
+        glm::mat4 leftViewProj;
+        glm::mat4 rightViewProj;
+        float nearZ = 0.1f;
+        float farZ = 1000.f;
+        glm::vec3 camPos = glm::vec3(0, 0, 0);
+    };
+
+    struct Output
+    {
+        std::vector<glm::vec4> color;           // right eye image, alpha 0 marks a hole
+        std::vector<uint8_t> holeMask;          // 1 where no grid fragment survived (disocclusion)
+        std::vector<float> quadLevels;          // equivalent of gDiffResult
+        uint32_t holeCount = 0;
+        uint32_t triangleCount = 0;
+        uint32_t tessellatedQuadCount = 0;
+    };
+
+    struct Stats
+    {
+        double quadLevelMs = 0;
+        double warpMs = 0;
+        double rasterMs = 0;
+        double totalMs = 0;
+        double mpixPerSec = 0;
+    };
+
+    // threadCount = 0 runs on the shared pool, other counts get their own pool (e.g. to measure the scaling)
+    static SharedPtr create(uint32_t threadCount = 0);
+
+    void execute(const Input& input, const Settings& settings, Output& output);
+
+    // Runs execute() several times and returns the averaged timings
+    Stats benchmark(const Input& input, const Settings& settings, uint32_t iterations);
+
+    // Number of pixels that differ from a GPU result by more than tolerance (or in the hole mask)
+    static uint32_t compare(const Output& reference, const glm::vec4* pGpuColor, float tolerance);
+
+    const Stats& getStats() const { return mStats; }
+    uint32_t getThreadCount() const { return mpPool->getThreadCount(); }
+
+private:
+    CpuReprojection(uint32_t threadCount);
+
+    struct RasterVertex
+    {
+        glm::vec2 screen;
+        float depth;
+        float invW;
+        glm::vec2 texCOverW;
+        float occFlagOverW;
+    };
+
+    struct Triangle
+    {
+        RasterVertex v[3];
+        int32_t minY, maxY;
+    };
+
+    void computeQuadLevels(const Input& input, const Settings& settings, Output& output);
+    float getTessellationFactor(const Settings& settings, const std::vector<float>& levels, int32_t quadId, uint32_t quadCountX) const;
+    void warpGrid(const Input& input, const Settings& settings, const Output& output);
+    void rasterize(const Input& input, const Settings& settings, Output& output);
+
+    WorkStealingPool::SharedPtr mpPool;
+    QuadBoundsReduction::UniquePtr mpQuadBounds;
+    std::vector<QuadBoundsReduction::Bounds> mQuadBounds;
+    Stats mStats;
+
+    // Triangles generated per quad row, kept in submission order
+    std::vector<std::vector<Triangle>> mRowTriangles;
+    std::vector<uint32_t> mTessellatedPerRow;
+    std::vector<float> mDepthBuffer;
+};
@@ -23,6 +23,9 @@
 #include "RenderPasses/Lighting.h"
 #include "RenderPasses/Reprojection.h"
 #include "RenderPasses/SimpleShadowPass.h"
+#include "UnitTest.h"
+
+#include <ctime>
 
 //const std::string DeferredRenderer::skStartupScene = "Arcade/Arcade.fscene";
 //const std::string DeferredRenderer::skStartupScene = "SimpleScene/simple.fscene";
@@ -30,19 +33,58 @@
 const glm::vec4 skClearColor = vec4(1.0f, 0, 0, 1.f);
 const bool initOpenVR = true; 
 
+static std::string getShaderVariantManifestPath()
+{
+    return getExecutableDirectory() + "/ShaderVariants.txt";
+}
+
 uint32_t DeferredRenderer::gStereoTarget = 0;
+int DeferredRenderer::gExitCode = 0;
 
 void DeferredRenderer::onLoad(SampleCallbacks * pSample, RenderContext * pRenderContext)
 {
+    // The unit tests of the renderer's own CPU code live in this executable, same switch as FalcorTest
+    ArgList args = pSample->getArgList();
+    if (args.argExists("test"))
+    {
+        if (runTests(stderr, pRenderContext, args["test"].asString()) != 0)
+        {
+            gExitCode = 1;
+        }
+        pSample->shutdown();
+        return;
+    }
+
     if (gpDevice->isFeatureSupported(Device::SupportedFeatures::Raytracing) == false)
     {
         logErrorAndExit("Device does not support raytracing!", true);
     }
 
+    // The single-pass stereo G-buffer selects the eye's slice in the vertex shader
+    mMultiViewSupported = gpDevice->isFeatureSupported(Device::SupportedFeatures::RenderTargetArrayIndexFromVertexShader);
+    if (mMultiViewSupported == false)
+    {
+        logInfo("Single-pass stereo G-buffer is not supported, plain stereo renders one pass per eye");
+    }
+
+    // The import optimizations are opt-in, without them the scene is loaded as before
+    if (args.argExists("optimizescene"))
+    {
+        mGenerateOccluders = true;
+        mOptimizeVertexOrder = true;
+        mGenerateLods = true;
+    }
+
+    // Variants used by earlier sessions are compiled in the background once their program links the first time
+    ProgramCompiler::loadManifest(getShaderVariantManifestPath());
+
     mpGraph = RenderGraph::create("Hybrid Stereo Renderer");
+    mpGraph->setResourceAliasing(true);
 
     // G-Buffer
-    mpGraph->addPass(GBufferRaster::create(), "GBuffer");
+    mpGBufferPass = GBufferRaster::create();
+    mpGraph->addPass(mpGBufferPass, "GBuffer");
+    updateMultiView();
 
     // Simple Shadow Pre-Pass
     SimpleShadowPass::SharedPtr pShadowPass = SimpleShadowPass::create();
@@ -59,6 +101,7 @@ void DeferredRenderer::onLoad(SampleCallbacks * pSample, RenderContext * pRender
     pReprojPass->mpMainRenderObject = this;
     pReprojPass->mpLightPass = pLightPass;
     mpGraph->addPass(pReprojPass, "Reprojection");
+    mpReprojectionPass = pReprojPass;
 
     // FXAA Pass Left
     FXAA::SharedPtr fxaaPassLeft = FXAA::create();
@@ -131,19 +174,57 @@ void DeferredRenderer::onLoad(SampleCallbacks * pSample, RenderContext * pRender
 #endif // _USERAINBOW
 
         assert(mpGraph != nullptr);
-        std::string filename;
-        if (openFileDialog(Scene::kFileExtensionFilters, filename))
+        mpBenchmark = StereoBenchmark::create(pSample->getArgList());
+        if (mpBenchmark != nullptr)
         {
-            loadScene(pSample, filename);
+            startBenchmark(pSample);
+        }
+        else
+        {
+            std::string filename;
+            if (openFileDialog(Scene::kFileExtensionFilters, filename))
+            {
+                loadScene(pSample, filename);
+            }
         }
     }
 }
 
 void DeferredRenderer::onFrameRender(SampleCallbacks * pSample, RenderContext * pRenderContext, const Fbo::SharedPtr & pTargetFbo)
 {
+    if (mpBenchmark != nullptr)
+    {
+        // Frame rate and profiler report the previous frame
+        mpBenchmark->endFrame(pSample->getLastFrameTime() * 1000.f, (float)Profiler::getEventCpuTime("onFrameRender"), (float)Profiler::getEventGpuTime("onFrameRender"));
+        if (mpBenchmark->isFinished())
+        {
+            finishBenchmark(pSample);
+        }
+        else
+        {
+            StereoBenchmark::Frame frame = mpBenchmark->beginFrame();
+            if (frame.configChanged)
+            {
+                applyBenchmarkConfig(*frame.pConfig);
+            }
+            if (frame.restartCycle)
+            {
+                resetFixedTime();
+            }
+        }
+    }
+
     if (mMeasurementRunning)
     {
-        if (mFrameCount >= _PROFILING_LOG_BATCH_SIZE)
+        // Everything recorded since the last call (including the profiler times from the end of the last frame) forms one row
+        if (mpTelemetry)
+        {
+            mpTelemetry->record("fixedTime", (float)mFixedFrameTime);
+            mpTelemetry->record("cycle", (float)mNumCycles);
+            mpTelemetry->endFrame();
+        }
+
+        if (mFrameCount >= _PROFILING_MEASUREMENT_FRAMES)
         {
             resetFixedTime();
             mNumCycles++;
@@ -355,6 +436,19 @@ void DeferredRenderer::renderToHMDReprojected(SampleCallbacks * pSample, RenderC
 
 void DeferredRenderer::onShutdown(SampleCallbacks * pSample)
 {
+    if (mpBenchmark != nullptr)
+    {
+        logError("Benchmark: window closed before all configurations finished", false);
+        gExitCode = 1;
+        mpBenchmark = nullptr;
+    }
+
+    if (mMeasurementRunning)
+    {
+        stopMeasurement();
+    }
+
+    ProgramCompiler::saveManifest(getShaderVariantManifestPath());
 }
 
 void DeferredRenderer::onResizeSwapChain(SampleCallbacks * pSample, uint32_t width, uint32_t height)
@@ -440,6 +534,108 @@ void DeferredRenderer::onGuiRender(SampleCallbacks * pSample, Gui * pGui)
         }
     }
 
+    if (pGui->beginGroup("Scene Import"))
+    {
+        pGui->addCheckBox("Generate Occluders", mGenerateOccluders);
+        pGui->addCheckBox("Optimize Vertex Order", mOptimizeVertexOrder);
+        pGui->addCheckBox("Generate LODs", mGenerateLods);
+        if (mSceneFilename.empty() == false && pGui->addButton("Reload Scene"))
+        {
+            loadScene(pSample, mSceneFilename);
+        }
+        pGui->endGroup();
+    }
+
+    if (pGui->beginGroup("Model Import Cache"))
+    {
+        ModelImportCache::Stats stats = ModelImportCache::getStats();
+        std::string statsText = "Hits: " + std::to_string(stats.hits) + " (" + std::to_string((uint32_t)stats.hitTime) + " ms)\n" +
+            "Misses: " + std::to_string(stats.misses) + " (" + std::to_string((uint32_t)stats.missTime) + " ms)\n" +
+            "Entries: " + std::to_string(stats.entryCount) + ", " + std::to_string(stats.size >> 20) + " / " + std::to_string(stats.sizeLimit >> 20) + " MB\n" +
+            "Stores: " + std::to_string(stats.stores) + ", Evictions: " + std::to_string(stats.evictions);
+        pGui->addText(statsText.c_str());
+        bool enabled = ModelImportCache::isEnabled();
+        if (pGui->addCheckBox("Enabled", enabled))
+        {
+            ModelImportCache::setEnabled(enabled);
+        }
+        if (pGui->addButton("Clear", true))
+        {
+            ModelImportCache::clear();
+        }
+        pGui->endGroup();
+    }
+
+    if (pGui->beginGroup("Shader Cache"))
+    {
+        ShaderCache::Stats stats = ShaderCache::getStats();
+        std::string statsText = "Hits: " + std::to_string(stats.hits) + " (" + std::to_string((uint32_t)stats.hitTime) + " ms)\n" +
+            "Misses: " + std::to_string(stats.misses) + ", Rejected: " + std::to_string(stats.rejected) + "\n" +
+            "Compile time stored: " + std::to_string((uint32_t)stats.compileTime) + " ms\n" +
+            "Entries: " + std::to_string(stats.entryCount) + ", " + std::to_string(stats.size >> 20) + " / " + std::to_string(stats.sizeLimit >> 20) + " MB\n" +
+            "Stores: " + std::to_string(stats.stores) + ", Evictions: " + std::to_string(stats.evictions);
+        pGui->addText(statsText.c_str());
+        bool enabled = ShaderCache::isEnabled();
+        if (pGui->addCheckBox("Enabled", enabled))
+        {
+            ShaderCache::setEnabled(enabled);
+        }
+        if (pGui->addButton("Clear", true))
+        {
+            ShaderCache::clear();
+        }
+        pGui->endGroup();
+    }
+
+    if (pGui->beginGroup("Shader Compilation"))
+    {
+        ProgramCompiler::Stats stats = ProgramCompiler::getStats();
+        std::string statsText = "Jobs: " + std::to_string(stats.completed) + " / " + std::to_string(stats.queued) + ", Pending: " + std::to_string(stats.pending) + "\n" +
+            "Threads: " + std::to_string(stats.threadCount) + ", Compile time: " + std::to_string((uint32_t)stats.compileTime) + " ms\n" +
+            "Fallbacks: " + std::to_string(stats.fallbacks) + "\n" +
+            "Waits: " + std::to_string(stats.waits) + " (" + std::to_string((uint32_t)stats.waitTime) + " ms)";
+        pGui->addText(statsText.c_str());
+        bool enabled = ProgramCompiler::isEnabled();
+        if (pGui->addCheckBox("Background Compilation", enabled))
+        {
+            ProgramCompiler::setEnabled(enabled);
+        }
+        pGui->endGroup();
+    }
+
+    if (mpGraph && pGui->beginGroup("Render Graph Memory"))
+    {
+        const ResourceCache::MemoryStats& stats = mpGraph->getResourceMemoryStats();
+        const uint64_t mb = 1024 * 1024;
+        std::string statsText = "Transient: " + std::to_string(stats.transientCount) + " textures in " + std::to_string(stats.heapCount) + " heaps, " + std::to_string(stats.heapSize / mb) + " MB\n" +
+            "Saved: " + std::to_string(stats.getSavedSize() / mb) + " of " + std::to_string(stats.transientSize / mb) + " MB\n" +
+            "Dedicated: " + std::to_string(stats.dedicatedCount) + " textures\n" +
+            "Cached graph variants: " + std::to_string(mpGraph->getCompiledVariantCount());
+        pGui->addText(statsText.c_str());
+        bool aliasing = mpGraph->isResourceAliasingEnabled();
+        if (pGui->addCheckBox("Alias Transient Resources", aliasing))
+        {
+            mpGraph->setResourceAliasing(aliasing);
+        }
+        pGui->endGroup();
+    }
+
+    if (mpGraph && pGui->beginGroup("Render Graph Recording"))
+    {
+        bool parallel = mpGraph->isParallelRecordingEnabled();
+        if (pGui->addCheckBox("Parallel Recording", parallel))
+        {
+            mpGraph->setParallelRecording(parallel);
+        }
+        std::string timesText = "Total: " + std::to_string(mpGraph->getRecordingTime()) + " ms\n";
+        for (const auto& timing : mpGraph->getPassTimings())
+        {
+            timesText += timing.passName + " (level " + std::to_string(timing.level) + "): " + std::to_string(timing.recordingTime) + " ms\n";
+        }
+        pGui->addText(timesText.c_str());
+        pGui->endGroup();
+    }
+
     //pGui->addIntVar("Light Count", mLightCount);
 
     if (pGui->addCheckBox("Use Camera Path", mUseCameraPath))
@@ -469,10 +665,15 @@ void DeferredRenderer::onGuiRender(SampleCallbacks * pSample, Gui * pGui)
                 mFixedRunning = true;
             }
 
-            std::string sampleText = std::to_string(_PROFILING_LOG_BATCH_SIZE) + " Samples";
+            std::string sampleText = std::to_string(_PROFILING_MEASUREMENT_FRAMES) + " Samples";
             pGui->addText(sampleText.c_str());
             pGui->addIntVar("Measure Cycles", mNumCyclesToRun);
 
+            Gui::DropdownList telemetryFormatList;
+            telemetryFormatList.push_back({ (uint32_t)Telemetry::Format::Binary, "Binary" });
+            telemetryFormatList.push_back({ (uint32_t)Telemetry::Format::Csv, "CSV" });
+            pGui->addDropdown("Telemetry Format", telemetryFormatList, (uint32_t&)mTelemetryFormat);
+
             if (pGui->addButton("Start Measurement"))
             {
                 startMeasurement();
@@ -497,8 +698,22 @@ void DeferredRenderer::onGuiRender(SampleCallbacks * pSample, Gui * pGui)
         {
             mpGraph->unmarkOutput("Reprojection.out");
         }
+        updateMultiView();
+    }
 
-        onClickResize();
+    if (!mUseReprojection)
+    {
+        if (mMultiViewSupported)
+        {
+            if (pGui->addCheckBox("Single-Pass Stereo G-Buffer", mUseMultiViewGBuffer))
+            {
+                updateMultiView();
+            }
+        }
+        else
+        {
+            pGui->addText("Single-Pass Stereo G-Buffer: not supported by this GPU");
+        }
     }
 
     Gui::DropdownList renderModeList;
@@ -545,8 +760,6 @@ void DeferredRenderer::onGuiRender(SampleCallbacks * pSample, Gui * pGui)
 
         mLeftOutput = mUseFXAA ? "FXAA_Left.dst" : "Light.out";
         mRightOutput = mUseFXAA ? "FXAA_Right.dst" : "Reprojection.out";
-
-        onClickResize();
     }
 
     if (pGui->addButton("4K Resolution"))
@@ -577,7 +790,7 @@ void DeferredRenderer::loadScene(SampleCallbacks* pSample, const std::string& fi
 {
     ProgressBar::SharedPtr pBar = ProgressBar::create("Loading Scene", 100);
 
-    RtScene::SharedPtr pScene = RtScene::loadFromFile(filename, RtBuildFlags::FastTrace, Model::LoadFlags::None, Scene::LoadFlags::None);
+    RtScene::SharedPtr pScene = RtScene::loadFromFile(filename, RtBuildFlags::FastTrace, getModelLoadFlags(), Scene::LoadFlags::None);
     if (pScene != nullptr)
     {
 #if _USERAINBOW
@@ -594,6 +807,7 @@ void DeferredRenderer::loadScene(SampleCallbacks* pSample, const std::string& fi
         }
 #endif // _USERAINBOW
 
+        mSceneFilename = filename;
         Fbo::SharedPtr pFbo = pSample->getCurrentFbo();
         pScene->setCamerasAspectRatio(float(pFbo->getWidth()) / float(pFbo->getHeight()));
         mpGraph->setScene(pScene);
@@ -607,6 +821,30 @@ void DeferredRenderer::loadScene(SampleCallbacks* pSample, const std::string& fi
     }
 }
 
+Model::LoadFlags DeferredRenderer::getModelLoadFlags() const
+{
+    Model::LoadFlags flags = Model::LoadFlags::None;
+    if (mGenerateOccluders) flags |= Model::LoadFlags::GenerateOccluders;
+    if (mOptimizeVertexOrder) flags |= Model::LoadFlags::OptimizeVertexOrder;
+    if (mGenerateLods) flags |= Model::LoadFlags::GenerateLods;
+    return flags;
+}
+
+std::string DeferredRenderer::getSceneImportString() const
+{
+    std::string stages;
+    if (mGenerateOccluders) stages += "occluders ";
+    if (mOptimizeVertexOrder) stages += "vertexorder ";
+    if (mGenerateLods) stages += "lods ";
+    return stages.empty() ? "none" : stages.substr(0, stages.size() - 1);
+}
+
+void DeferredRenderer::updateMultiView()
+{
+    // Plain stereo executes the graph once per eye, the G-buffer can serve both from a single scene traversal
+    mpGBufferPass->setMultiView(mMultiViewSupported && mUseMultiViewGBuffer && !mUseReprojection);
+}
+
 void DeferredRenderer::updateValues()
 {
     switch (mRenderMode)
@@ -690,6 +928,30 @@ void DeferredRenderer::startMeasurement()
     mFixedRunning = true;
     mMeasurementRunning = true;
     gProfileEnabled = true;
+#if _PROFILING_LOG == 0
+    logWarning("Measurement: _PROFILING_LOG is 0, the telemetry file will not contain the profiler events. Set it to 1 in FalcorConfig.h to record them.");
+#endif
+
+    std::time_t now = std::time(nullptr);
+    char timeString[32];
+    std::strftime(timeString, sizeof(timeString), "%Y%m%d_%H%M%S", std::localtime(&now));
+
+    Fbo::SharedPtr pFbo = mpSample->getCurrentFbo();
+    Telemetry::Metadata metadata;
+    metadata.push_back({ "time", timeString });
+    metadata.push_back({ "scene", mSceneFilename });
+    metadata.push_back({ "sceneImport", getSceneImportString() });
+    metadata.push_back({ "width", std::to_string(pFbo->getWidth()) });
+    metadata.push_back({ "height", std::to_string(pFbo->getHeight()) });
+    metadata.push_back({ "renderMode", mRenderMode == RenderToScreen ? "Screen" : "HMD" });
+    metadata.push_back({ "reprojection", mUseReprojection ? "1" : "0" });
+    metadata.push_back({ "fixedSpeed", std::to_string(mFixedSpeed) });
+    metadata.push_back({ "framesPerCycle", std::to_string(_PROFILING_MEASUREMENT_FRAMES) });
+    metadata.push_back({ "cycles", std::to_string(mNumCyclesToRun) });
+
+    std::string filename = std::string("telemetry_") + timeString + (mTelemetryFormat == Telemetry::Format::Binary ? ".ftlm" : ".csv");
+    mpTelemetry = Telemetry::create(filename, mTelemetryFormat, metadata);
+    Telemetry::setActive(mpTelemetry);
 }
 
 void DeferredRenderer::stopMeasurement()
@@ -699,6 +961,96 @@ void DeferredRenderer::stopMeasurement()
     mMeasurementRunning = false;
     mNumCycles = 0;
     gProfileEnabled = false;
+
+    if (mpTelemetry)
+    {
+        // Waits for the writer thread to drain the queue
+        Telemetry::setActive(nullptr);
+        logInfo("Telemetry: " + std::to_string(mpTelemetry->getFrameCount()) + " frames written to " + mpTelemetry->getFilename() +
+            ", " + std::to_string(mpTelemetry->getDroppedSampleCount()) + " samples dropped");
+        mpTelemetry = nullptr;
+    }
+}
+
+void DeferredRenderer::startBenchmark(SampleCallbacks* pSample)
+{
+    const StereoBenchmark::Settings& settings = mpBenchmark->getSettings();
+    std::string filename = settings.sceneFilename;
+    if (filename.empty())
+    {
+        openFileDialog(Scene::kFileExtensionFilters, filename);
+    }
+    if (!filename.empty())
+    {
+        loadScene(pSample, filename);
+    }
+
+    if (mpGraph->getScene() == nullptr || settings.configs.empty())
+    {
+        logError("Benchmark: can't load scene '" + filename + "'", false);
+        gExitCode = 1;
+        mpBenchmark = nullptr;
+        pSample->shutdown();
+        return;
+    }
+
+    // Same deterministic update as a measurement run: fixed time steps along the camera path
+    mRenderMode = RenderToScreen;
+    mUseCameraPath = settings.useCameraPath;
+    applyCameraPathState();
+    mUseFixedUpdate = true;
+    mFixedSpeed = settings.fixedSpeed;
+    mFixedRunning = true;
+    resetFixedTime();
+    gProfileEnabled = true;
+    pSample->toggleUI(false);
+}
+
+void DeferredRenderer::applyBenchmarkConfig(const StereoBenchmark::Config& config)
+{
+    const bool useReprojection = config.mode != StereoBenchmark::Mode::PlainStereo;
+    if (useReprojection != mUseReprojection)
+    {
+        mUseReprojection = useReprojection;
+        if (mUseReprojection)
+        {
+            mpGraph->markOutput("Reprojection.out");
+        }
+        else
+        {
+            mpGraph->unmarkOutput("Reprojection.out");
+        }
+        updateMultiView();
+    }
+
+    if (useReprojection)
+    {
+        mpReprojectionPass->setHoleFilling(true, config.mode == StereoBenchmark::Mode::ReprojectionRayTrace);
+        mpReprojectionPass->setQuadDivideFactor(config.quadDivideFactor);
+        mpReprojectionPass->setTessellationFactor(config.tessFactor);
+    }
+
+    // Rebuilds the grid and the graph resources
+    onClickResize();
+}
+
+void DeferredRenderer::finishBenchmark(SampleCallbacks* pSample)
+{
+    Fbo::SharedPtr pFbo = pSample->getCurrentFbo();
+    Telemetry::Metadata metadata;
+    metadata.push_back({ "scene", mSceneFilename });
+    metadata.push_back({ "sceneImport", getSceneImportString() });
+    metadata.push_back({ "width", std::to_string(pFbo->getWidth()) });
+    metadata.push_back({ "height", std::to_string(pFbo->getHeight()) });
+
+    if (!mpBenchmark->writeReport(metadata))
+    {
+        gExitCode = 1;
+    }
+
+    mpBenchmark = nullptr;
+    gProfileEnabled = false;
+    pSample->shutdown();
 }
 
 int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
@@ -713,5 +1065,5 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
     config.windowDesc.resizableWindow = false;
     config.deviceDesc.enableVR = initOpenVR;
     Sample::run(config, pRenderer);
-    return 0;
+    return DeferredRenderer::gExitCode;
 }
@@ -21,12 +21,16 @@
 #include "Falcor.h"
 #include "FalcorExperimental.h"
 #include "StereoCameraController.h"
+#include "StereoBenchmark.h"
 
 // Override all base texture with rainbow test texture to visualize Mip-Levels
 #define _USERAINBOW 0
 
 using namespace Falcor;
 
+class Reprojection;
+class GBufferRaster;
+
 class DeferredRenderer : public Renderer
 {
 public:
@@ -34,6 +38,9 @@ public:
     // defines which render target is rendered next (left/right <=> 0/1)
     static uint32_t gStereoTarget;
 
+    // process exit code, non-zero if the benchmark failed or found a regression
+    static int gExitCode;
+
     void onLoad(SampleCallbacks* pSample, RenderContext* pRenderContext) override;
     void onFrameRender(SampleCallbacks* pSample, RenderContext* pRenderContext, const Fbo::SharedPtr& pTargetFbo) override;
     void onShutdown(SampleCallbacks* pSample) override;
@@ -85,9 +92,20 @@ private:
     bool mUseReprojection = true ;
     bool mCropOutput = false;
     bool mUseCameraPath = false;
+    bool mUseMultiViewGBuffer = true;   // plain stereo only, see GBufferRaster::setMultiView()
+    bool mMultiViewSupported = false;   // the device can write SV_RenderTargetArrayIndex from the vertex shader
+    std::shared_ptr<GBufferRaster> mpGBufferPass;
+
+    // Scene import stages, all off by default. -optimizescene enables them, the GUI changes apply to the next loaded scene
+    bool mGenerateOccluders = false;
+    bool mOptimizeVertexOrder = false;
+    bool mGenerateLods = false;
 
     void loadScene(SampleCallbacks* pSample, const std::string& filename);
+    Model::LoadFlags getModelLoadFlags() const;
+    std::string getSceneImportString() const;
     void updateValues();
+    void updateMultiView();
     void initVR(Fbo* pTargetFbo);
     void applyCameraPathState();
 
@@ -113,5 +131,17 @@ private:
     int32_t mNumCycles = 0;
     bool mMeasurementRunning = false;
     int32_t mLightCount = 0;
+
+    // Per-frame telemetry of a measurement run
+    Telemetry::SharedPtr mpTelemetry;
+    Telemetry::Format mTelemetryFormat = Telemetry::Format::Binary;
+    std::string mSceneFilename;
+
+    // Command line benchmark (-benchmark)
+    void startBenchmark(SampleCallbacks* pSample);
+    void applyBenchmarkConfig(const StereoBenchmark::Config& config);
+    void finishBenchmark(SampleCallbacks* pSample);
+    StereoBenchmark::UniquePtr mpBenchmark;
+    std::shared_ptr<Reprojection> mpReprojectionPass;
 };
 
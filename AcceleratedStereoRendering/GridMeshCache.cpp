@@ -0,0 +1,188 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#include "GridMeshCache.h"
+
+namespace
+{
+    // Rows of grid vertices per pool task
+    const uint32_t kRowsPerTask = 8;
+}
+
+GridMeshCache::SharedPtr GridMeshCache::create(size_t memoryBudget)
+{
+    return SharedPtr(new GridMeshCache(memoryBudget));
+}
+
+GridMeshCache::SharedPtr GridMeshCache::getShared()
+{
+    // Weak, so the GPU buffers are released together with the last pass and not at static destruction time
+    static std::weak_ptr<GridMeshCache> sShared;
+    SharedPtr pShared = sShared.lock();
+    if (pShared == nullptr)
+    {
+        pShared = create();
+        sShared = pShared;
+    }
+    return pShared;
+}
+
+GridMeshCache::GridMeshCache(size_t memoryBudget) : mMemoryBudget(memoryBudget)
+{
+    mpPool = WorkStealingPool::getShared();
+}
+
+GridMeshCache::Grid::SharedPtr GridMeshCache::getGrid(uint32_t width, uint32_t height, uint32_t quadDivideFactor, bool halfPixelOffset)
+{
+    assert(quadDivideFactor > 0);
+    Key key = { width, height, quadDivideFactor, halfPixelOffset };
+
+    auto it = mLookup.find(key);
+    if (it != mLookup.end())
+    {
+        mHitCount++;
+        mLruList.splice(mLruList.begin(), mLruList, it->second);
+        return it->second->second;
+    }
+
+    mMissCount++;
+    Grid::SharedPtr pGrid = buildGrid(key);
+    mLruList.emplace_front(key, pGrid);
+    mLookup[key] = mLruList.begin();
+    mMemoryUsage += pGrid->byteSize;
+    evict();
+    return pGrid;
+}
+
+void GridMeshCache::setMemoryBudget(size_t bytes)
+{
+    mMemoryBudget = bytes;
+    evict();
+}
+
+void GridMeshCache::clear()
+{
+    mLruList.clear();
+    mLookup.clear();
+    mMemoryUsage = 0;
+}
+
+void GridMeshCache::evict()
+{
+    // Grids still referenced by a pass stay alive through their SharedPtr, they are just not cached anymore
+    while (mMemoryUsage > mMemoryBudget && mLruList.size() > 1)
+    {
+        const auto& last = mLruList.back();
+        mMemoryUsage -= last.second->byteSize;
+        mLookup.erase(last.first);
+        mLruList.pop_back();
+    }
+}
+
+GridMeshCache::Grid::SharedPtr GridMeshCache::buildGrid(const Key& key)
+{
+    Grid::SharedPtr pGrid = std::make_shared<Grid>();
+    const uint32_t quadSizeX = key.width / key.quadDivideFactor;
+    const uint32_t quadSizeY = key.height / key.quadDivideFactor;
+    const uint32_t vertexCount = (quadSizeX + 1) * (quadSizeY + 1);
+    const uint32_t indexCount = quadSizeX * quadSizeY * 4;
+    pGrid->quadCountX = quadSizeX;
+    pGrid->quadCountY = quadSizeY;
+    pGrid->vertexCount = vertexCount;
+    pGrid->indexCount = indexCount;
+
+    // All streams live in a single allocation that is dropped once the GPU buffers are created
+    const size_t positionBytes = sizeof(glm::vec3) * vertexCount;
+    const size_t uvBytes = sizeof(glm::vec3) * vertexCount; // texcoords are declared as rgb
+    const size_t quadIdBytes = sizeof(float) * vertexCount;
+    const size_t indexBytes = sizeof(uint32_t) * indexCount;
+    std::vector<uint8_t> arena(positionBytes + uvBytes + quadIdBytes + indexBytes);
+    glm::vec3* pPositions = reinterpret_cast<glm::vec3*>(arena.data());
+    glm::vec3* pUVs = reinterpret_cast<glm::vec3*>(arena.data() + positionBytes);
+    float* pQuadIDs = reinterpret_cast<float*>(arena.data() + positionBytes + uvBytes);
+    uint32_t* pIndices = reinterpret_cast<uint32_t*>(arena.data() + positionBytes + uvBytes + quadIdBytes);
+
+    const glm::vec3 posOffset = key.halfPixelOffset ? glm::vec3(0.5f / (float)key.width, -0.5f / (float)key.height, 0) : glm::vec3(0);
+    const glm::vec3 uvOffset = key.halfPixelOffset ? glm::vec3(0.5f / (float)key.width, 0.5f / (float)key.height, 0) : glm::vec3(0);
+
+    // Vertex rows run from the top (y = 1) to the bottom (y = -1), the quad ID of a vertex is the quad to the bottom right of it.
+    // The hull shader reads the ID of the first control point, which is the bottom left vertex of a patch. The quad in row r and column c therefore
+    // reads (r + 1) * quadCountX + c, the same index CpuReprojection uses to look up the tessellation levels.
+    mpPool->parallelFor(quadSizeY + 1, kRowsPerTask, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t row = begin; row < end; row++)
+        {
+            const uint32_t y = quadSizeY - row;
+            for (uint32_t x = 0; x <= quadSizeX; x++)
+            {
+                const uint32_t i = row * (quadSizeX + 1) + x;
+                pPositions[i] = glm::vec3((float)x / (float)quadSizeX * 2.f - 1, (float)y / (float)quadSizeY * 2.f - 1, 0) + posOffset;
+                pUVs[i] = glm::vec3((float)x / (float)quadSizeX, 1 - (float)y / (float)quadSizeY, 0) + uvOffset;
+                pQuadIDs[i] = (float)(row * quadSizeX + x);
+            }
+
+            if (row == quadSizeY) continue;
+
+            for (uint32_t x = 0; x < quadSizeX; x++)
+            {
+                const uint32_t vi = row * (quadSizeX + 1) + x;
+                uint32_t* pQuad = pIndices + (row * quadSizeX + x) * 4;
+                pQuad[3] = vi;
+                pQuad[2] = vi + 1;
+                pQuad[1] = vi + quadSizeX + 2;
+                pQuad[0] = vi + quadSizeX + 1;
+            }
+        }
+    });
+
+    // Vertex layout: position, texcoord and quad ID in separate streams
+    VertexLayout::SharedPtr pLayout = VertexLayout::create();
+    VertexBufferLayout::SharedPtr pVbLayout = VertexBufferLayout::create();
+    pVbLayout->addElement(VERTEX_POSITION_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_POSITION_LOC);
+    pLayout->addBufferLayout(0, pVbLayout);
+    VertexBufferLayout::SharedPtr pUVbLayout = VertexBufferLayout::create();
+    pUVbLayout->addElement(VERTEX_TEXCOORD_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_TEXCOORD_LOC);
+    pLayout->addBufferLayout(1, pUVbLayout);
+    VertexBufferLayout::SharedPtr pQuadIDLayout = VertexBufferLayout::create();
+    pQuadIDLayout->addElement(VERTEX_QUADID_NAME, 0, ResourceFormat::R32Float, 1, VERTEX_QUADID_LOC);
+    pLayout->addBufferLayout(2, pQuadIDLayout);
+
+    Vao::BufferVec pVBs(3);
+    pVBs[0] = Buffer::create(positionBytes, Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, pPositions);
+    pVBs[1] = Buffer::create(uvBytes, Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, pUVs);
+    pVBs[2] = Buffer::create(quadIdBytes, Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, pQuadIDs);
+    Buffer::SharedPtr pIndexBuffer = Buffer::create(indexBytes, Buffer::BindFlags::Index, Buffer::CpuAccess::None, pIndices);
+    pGrid->byteSize = arena.size();
+
+    // Mesh culling is disabled for the grid, the bounding box is not used
+    BoundingBox box;
+    box.center = glm::vec3(0);
+    box.extent = glm::vec3(50);
+
+    Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIndexBuffer, indexCount, pLayout, Vao::Topology::Quad4Patch, Material::create("Empty"), box, false);
+    pGrid->pModel = Model::create();
+    pGrid->pModel->addMeshInstance(pMesh, glm::mat4());
+
+    pGrid->pScene = Scene::create();
+    pGrid->pScene->addModelInstance(pGrid->pModel, "Grid");
+    pGrid->pSceneRenderer = SceneRenderer::create(pGrid->pScene);
+    pGrid->pSceneRenderer->toggleMeshCulling(false);
+
+    return pGrid;
+}
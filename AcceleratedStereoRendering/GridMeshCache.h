@@ -0,0 +1,102 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#pragma once
+#include "Falcor.h"
+
+#include <list>
+#include <map>
+
+using namespace Falcor;
+
+// Cache for the tessellation grid meshes of the reprojection pass.
+// Grids are keyed by resolution, quad divide factor and half pixel offset, so switching back to a known window size
+// or sharing a grid between passes does not rebuild anything. Least recently used grids are evicted once the memory budget is exceeded.
+class GridMeshCache
+{
+public:
+    using SharedPtr = std::shared_ptr<GridMeshCache>;
+
+    struct Grid
+    {
+        using SharedPtr = std::shared_ptr<Grid>;
+
+        uint32_t quadCountX = 0;
+        uint32_t quadCountY = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        size_t byteSize = 0;        // GPU memory of the vertex and index buffers
+
+        Model::SharedPtr pModel;
+        Scene::SharedPtr pScene;
+        SceneRenderer::SharedPtr pSceneRenderer;
+    };
+
+    static const size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+
+    static SharedPtr create(size_t memoryBudget = kDefaultMemoryBudget);
+
+    // Cache shared by all users in the process, alive as long as someone holds a reference
+    static SharedPtr getShared();
+
+    // Returns the cached grid or builds a new one
+    Grid::SharedPtr getGrid(uint32_t width, uint32_t height, uint32_t quadDivideFactor, bool halfPixelOffset);
+
+    // The most recently used grid is always kept, even if it alone exceeds the budget
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const { return mMemoryBudget; }
+    size_t getMemoryUsage() const { return mMemoryUsage; }
+    size_t getGridCount() const { return mLruList.size(); }
+    uint32_t getHitCount() const { return mHitCount; }
+    uint32_t getMissCount() const { return mMissCount; }
+
+    void clear();
+
+private:
+    GridMeshCache(size_t memoryBudget);
+
+    struct Key
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t quadDivideFactor;
+        bool halfPixelOffset;
+
+        bool operator<(const Key& other) const
+        {
+            if (width != other.width) return width < other.width;
+            if (height != other.height) return height < other.height;
+            if (quadDivideFactor != other.quadDivideFactor) return quadDivideFactor < other.quadDivideFactor;
+            return halfPixelOffset < other.halfPixelOffset;
+        }
+    };
+
+    using LruList = std::list<std::pair<Key, Grid::SharedPtr>>;
+
+    Grid::SharedPtr buildGrid(const Key& key);
+    void evict();
+
+    WorkStealingPool::SharedPtr mpPool;
+    LruList mLruList;                               // front is the most recently used grid
+    std::map<Key, LruList::iterator> mLookup;
+    size_t mMemoryBudget;
+    size_t mMemoryUsage = 0;
+    uint32_t mHitCount = 0;
+    uint32_t mMissCount = 0;
+};
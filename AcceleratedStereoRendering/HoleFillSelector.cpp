@@ -0,0 +1,242 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#include "HoleFillSelector.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+    // Measurements a mode needs before its prediction is trusted
+    const uint32_t kMinSamples = 5;
+    const float kInitialCovariance = 100.f;
+    const float kMaxCovarianceTrace = 1.0e4f;
+
+    HoleFillSelector::Mode getOtherMode(HoleFillSelector::Mode mode)
+    {
+        return mode == HoleFillSelector::Mode::RayTrace ? HoleFillSelector::Mode::ReRaster : HoleFillSelector::Mode::RayTrace;
+    }
+}
+
+HoleFillSelector::SharedPtr HoleFillSelector::create()
+{
+    return create(Settings());
+}
+
+HoleFillSelector::SharedPtr HoleFillSelector::create(const Settings& settings)
+{
+    return SharedPtr(new HoleFillSelector(settings));
+}
+
+HoleFillSelector::HoleFillSelector(const Settings& settings) : mSettings(settings)
+{
+    reset();
+}
+
+void HoleFillSelector::reset()
+{
+    resetModel(mModels[0]);
+    resetModel(mModels[1]);
+    mCurrentMode = Mode::RayTrace;
+    mBetterFrames = 0;
+    mLog.clear();
+}
+
+void HoleFillSelector::resetModel(CostModel& model)
+{
+    model.weights.fill(0.f);
+    for (uint32_t i = 0; i < kFeatureCount; i++)
+    {
+        for (uint32_t j = 0; j < kFeatureCount; j++)
+        {
+            model.covariance[i][j] = (i == j) ? kInitialCovariance : 0.f;
+        }
+    }
+    model.sampleCount = 0;
+    model.lastMeasuredFrame = 0;
+}
+
+// Constant, hole pixels (RT cost and shading of the re-raster pass) and scene triangles (re-raster geometry cost), scaled to similar ranges
+HoleFillSelector::Features HoleFillSelector::getFeatures(uint32_t holeCount, uint32_t triangleCount)
+{
+    return { 1.f, (float)holeCount * 1.0e-5f, (float)triangleCount * 1.0e-6f };
+}
+
+// Recursive least squares with exponential forgetting
+void HoleFillSelector::train(CostModel& model, const Features& x, float y)
+{
+    const float lambda = mSettings.forgettingFactor;
+
+    Features px;
+    for (uint32_t i = 0; i < kFeatureCount; i++)
+    {
+        px[i] = 0.f;
+        for (uint32_t j = 0; j < kFeatureCount; j++) px[i] += model.covariance[i][j] * x[j];
+    }
+
+    float denominator = lambda;
+    for (uint32_t i = 0; i < kFeatureCount; i++) denominator += x[i] * px[i];
+
+    float error = y;
+    for (uint32_t i = 0; i < kFeatureCount; i++) error -= model.weights[i] * x[i];
+
+    float trace = 0.f;
+    for (uint32_t i = 0; i < kFeatureCount; i++)
+    {
+        float gain = px[i] / denominator;
+        model.weights[i] += gain * error;
+        for (uint32_t j = 0; j < kFeatureCount; j++)
+        {
+            model.covariance[i][j] = (model.covariance[i][j] - gain * px[j]) / lambda;
+        }
+        trace += model.covariance[i][i];
+    }
+
+    // Features that never change (e.g. a static scene's triangle count) let the covariance grow without bound
+    if (trace > kMaxCovarianceTrace)
+    {
+        for (uint32_t i = 0; i < kFeatureCount; i++)
+        {
+            for (uint32_t j = 0; j < kFeatureCount; j++)
+            {
+                model.covariance[i][j] = (i == j) ? kInitialCovariance : 0.f;
+            }
+        }
+    }
+}
+
+float HoleFillSelector::predict(Mode mode, uint32_t holeCount, uint32_t triangleCount) const
+{
+    const Features x = getFeatures(holeCount, triangleCount);
+    const CostModel& model = mModels[(uint32_t)mode];
+    float cost = 0.f;
+    for (uint32_t i = 0; i < kFeatureCount; i++) cost += model.weights[i] * x[i];
+    return std::max(cost, 0.f);
+}
+
+HoleFillSelector::Mode HoleFillSelector::selectMode(uint64_t frameId, uint32_t holeCount, uint32_t triangleCount, const Measurement& measurement)
+{
+    // The time arrives a few frames late, it is paired with the inputs of the frame it was measured in
+    if (measurement.ms > 0.f)
+    {
+        CostModel& model = mModels[(uint32_t)measurement.mode];
+        train(model, getFeatures(measurement.holeCount, measurement.triangleCount), measurement.ms);
+        model.sampleCount++;
+        model.lastMeasuredFrame = frameId;
+    }
+
+    Record record;
+    record.frameId = frameId;
+    record.holeCount = holeCount;
+    record.triangleCount = triangleCount;
+    record.measurement = measurement;
+    record.predictedMs[0] = predict(Mode::RayTrace, holeCount, triangleCount);
+    record.predictedMs[1] = predict(Mode::ReRaster, holeCount, triangleCount);
+
+    const Mode other = getOtherMode(mCurrentMode);
+    const CostModel& currentModel = mModels[(uint32_t)mCurrentMode];
+    const CostModel& otherModel = mModels[(uint32_t)other];
+
+    record.decision = mCurrentMode;
+    record.reason = Reason::Keep;
+    if (currentModel.sampleCount < kMinSamples)
+    {
+        // Learn the current mode first
+    }
+    else if (otherModel.sampleCount < kMinSamples || frameId >= otherModel.lastMeasuredFrame + mSettings.explorationInterval)
+    {
+        record.decision = other;
+        record.reason = Reason::Explore;
+    }
+    else
+    {
+        const float currentMs = record.predictedMs[(uint32_t)mCurrentMode];
+        const float otherMs = record.predictedMs[(uint32_t)other];
+        mBetterFrames = (otherMs < currentMs * (1.f - mSettings.switchMargin)) ? mBetterFrames + 1 : 0;
+        if (mBetterFrames >= mSettings.switchFrames)
+        {
+            mCurrentMode = other;
+            mBetterFrames = 0;
+            record.decision = other;
+            record.reason = Reason::Switch;
+        }
+    }
+
+    mLog.push_back(record);
+    if (mLog.size() > kMaxLogSize) mLog.pop_front();
+    return record.decision;
+}
+
+bool HoleFillSelector::saveLog(const std::string& filename) const
+{
+    std::ofstream out(filename.c_str());
+    if (!out.is_open()) return false;
+
+    // Enough digits that loadLog() reads back the exact floats and replay() reproduces every decision
+    out.precision(std::numeric_limits<float>::max_digits10);
+    out << "frame,holes,triangles,measuredMode,measuredMs,measuredHoles,measuredTriangles,predictedRayTraceMs,predictedReRasterMs,decision,reason\n";
+    for (const Record& r : mLog)
+    {
+        const Measurement& m = r.measurement;
+        out << r.frameId << "," << r.holeCount << "," << r.triangleCount << "," << (uint32_t)m.mode << "," << m.ms << "," << m.holeCount << "," << m.triangleCount << ","
+            << r.predictedMs[0] << "," << r.predictedMs[1] << "," << (uint32_t)r.decision << "," << (uint32_t)r.reason << "\n";
+    }
+    return true;
+}
+
+bool HoleFillSelector::loadLog(const std::string& filename, std::vector<Record>& log)
+{
+    std::ifstream in(filename.c_str());
+    if (!in.is_open()) return false;
+
+    log.clear();
+    std::string line;
+    std::getline(in, line); // header
+    while (std::getline(in, line))
+    {
+        if (line.empty()) continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream ss(line);
+        Record r;
+        uint32_t measuredMode, decision, reason;
+        ss >> r.frameId >> r.holeCount >> r.triangleCount >> measuredMode >> r.measurement.ms >> r.measurement.holeCount >> r.measurement.triangleCount
+            >> r.predictedMs[0] >> r.predictedMs[1] >> decision >> reason;
+        if (ss.fail()) return false;
+        r.measurement.mode = (Mode)measuredMode;
+        r.decision = (Mode)decision;
+        r.reason = (Reason)reason;
+        log.push_back(r);
+    }
+    return true;
+}
+
+std::vector<HoleFillSelector::Mode> HoleFillSelector::replay(const std::vector<Record>& log, const Settings& settings)
+{
+    HoleFillSelector selector(settings);
+    std::vector<Mode> decisions;
+    decisions.reserve(log.size());
+    for (const Record& r : log)
+    {
+        decisions.push_back(selector.selectMode(r.frameId, r.holeCount, r.triangleCount, r.measurement));
+    }
+    return decisions;
+}
@@ -0,0 +1,130 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#pragma once
+#include "Falcor.h"
+
+#include <array>
+#include <deque>
+
+using namespace Falcor;
+
+// Picks the cheaper hole filling technique per frame.
+// A small online linear model per mode (recursive least squares over hole count and scene triangle count) is trained with the measured
+// GPU time of the mode that actually ran. The other mode is probed now and then to keep its model current. Switching needs a clear
+// and stable advantage (hysteresis). All inputs and decisions are logged, so a session can be replayed offline with different settings.
+class HoleFillSelector
+{
+public:
+    using SharedPtr = std::shared_ptr<HoleFillSelector>;
+
+    enum class Mode : uint32_t
+    {
+        RayTrace = 0,
+        ReRaster = 1
+    };
+
+    enum class Reason : uint32_t
+    {
+        Keep = 0,
+        Switch,
+        Explore
+    };
+
+    struct Settings
+    {
+        float switchMargin = 0.1f;              // the other mode has to be predicted at least this much cheaper (relative)
+        uint32_t switchFrames = 10;             // ... for this many consecutive frames
+        uint32_t explorationInterval = 120;     // probe the unused mode after this many frames
+        float forgettingFactor = 0.97f;         // < 1 lets the model follow scene changes
+    };
+
+    // GPU time of an earlier frame, tagged with the mode that ran and the inputs its decision was based on
+    struct Measurement
+    {
+        Mode mode = Mode::RayTrace;
+        float ms = 0.f;                         // <= 0 if nothing was measured
+        uint32_t holeCount = 0;
+        uint32_t triangleCount = 0;
+    };
+
+    struct Record
+    {
+        uint64_t frameId = 0;
+        uint32_t holeCount = 0;
+        uint32_t triangleCount = 0;
+        Measurement measurement;
+        float predictedMs[2] = { 0.f, 0.f };
+        Mode decision = Mode::RayTrace;
+        Reason reason = Reason::Keep;
+    };
+
+    static const size_t kMaxLogSize = 1 << 16;
+
+    static SharedPtr create();
+    static SharedPtr create(const Settings& settings);
+
+    // Trains the model of the measured mode with the measurement and returns the mode to use this frame
+    Mode selectMode(uint64_t frameId, uint32_t holeCount, uint32_t triangleCount, const Measurement& measurement);
+
+    float predict(Mode mode, uint32_t holeCount, uint32_t triangleCount) const;
+    Mode getCurrentMode() const { return mCurrentMode; }
+    const Record* getLastRecord() const { return mLog.empty() ? nullptr : &mLog.back(); }
+
+    void setSettings(const Settings& settings) { mSettings = settings; }
+    const Settings& getSettings() const { return mSettings; }
+    void reset();
+
+    // Decision log as CSV
+    const std::deque<Record>& getLog() const { return mLog; }
+    bool saveLog(const std::string& filename) const;
+    static bool loadLog(const std::string& filename, std::vector<Record>& log);
+
+    // Feeds the logged inputs into a fresh selector and returns its decisions
+    static std::vector<Mode> replay(const std::vector<Record>& log, const Settings& settings);
+
+private:
+    HoleFillSelector(const Settings& settings);
+
+    static const uint32_t kFeatureCount = 3;
+    using Features = std::array<float, kFeatureCount>;
+
+    struct CostModel
+    {
+        Features weights;
+        float covariance[kFeatureCount][kFeatureCount];
+        uint32_t sampleCount;
+        uint64_t lastMeasuredFrame;
+    };
+
+    static Features getFeatures(uint32_t holeCount, uint32_t triangleCount);
+    static void resetModel(CostModel& model);
+    void train(CostModel& model, const Features& x, float y);
+
+    Settings mSettings;
+    CostModel mModels[2];
+    Mode mCurrentMode = Mode::RayTrace;
+    uint32_t mBetterFrames = 0;
+    std::deque<Record> mLog;
+};
+
+inline std::string to_string(HoleFillSelector::Mode mode)
+{
+    return mode == HoleFillSelector::Mode::RayTrace ? "RayTrace" : "ReRaster";
+}
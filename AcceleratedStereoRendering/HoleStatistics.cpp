@@ -0,0 +1,345 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#include "HoleStatistics.h"
+
+namespace
+{
+    // Element offsets into the gStats buffer, see HoleStatistics.slang
+    struct StatsLayout
+    {
+        uint32_t tileCountX;
+        uint32_t tileCountY;
+        uint32_t histogramOffset;
+        uint32_t tileOffset;
+        uint32_t maskOffset;
+        uint32_t maskWordsPerRow;
+        uint32_t elementCount;
+    };
+
+    StatsLayout getLayout(uint32_t width, uint32_t height)
+    {
+        StatsLayout layout;
+        layout.tileCountX = (width + HoleStatistics::kTileSize - 1) / HoleStatistics::kTileSize;
+        layout.tileCountY = (height + HoleStatistics::kTileSize - 1) / HoleStatistics::kTileSize;
+        layout.histogramOffset = 1;
+        layout.tileOffset = layout.histogramOffset + HoleStatistics::kHistogramBinCount;
+        layout.maskOffset = layout.tileOffset + layout.tileCountX * layout.tileCountY;
+        layout.maskWordsPerRow = (layout.tileCountX + 1) / 2;
+        layout.elementCount = layout.maskOffset + layout.maskWordsPerRow * height;
+        return layout;
+    }
+
+    uint32_t getHistogramBin(uint32_t count)
+    {
+        return count == 0 ? 0 : (count - 1) / HoleStatistics::kTileSize + 1;
+    }
+
+    // Horizontal run of hole pixels in one row
+    struct Run
+    {
+        uint32_t y;
+        uint32_t x0;
+        uint32_t x1;
+    };
+
+    uint32_t findRoot(std::vector<uint32_t>& parents, uint32_t i)
+    {
+        while (parents[i] != i)
+        {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    }
+}
+
+HoleStatistics::SharedPtr HoleStatistics::create(uint32_t readbackLatency)
+{
+    return SharedPtr(new HoleStatistics(readbackLatency));
+}
+
+HoleStatistics::HoleStatistics(uint32_t readbackLatency)
+{
+    mpProgram = ComputeProgram::createFromFile("HoleStatistics.slang", "main");
+    mpState = ComputeState::create();
+    mpState->setProgram(mpProgram);
+    mpVars = ComputeVars::create(mpProgram->getReflector());
+    mpFence = GpuFence::create();
+    mSlots.resize(std::max(1u, readbackLatency));
+}
+
+void HoleStatistics::resize(uint32_t width, uint32_t height)
+{
+    mWidth = width;
+    mHeight = height;
+    StatsLayout layout = getLayout(width, height);
+    mpStatsBuffer = StructuredBuffer::create(mpProgram, "gStats", layout.elementCount);
+
+    ConstantBuffer::SharedPtr pCB = mpVars["PerFrameCB"];
+    pCB["gDims"] = glm::uvec2(width, height);
+    pCB["gTileCountX"] = layout.tileCountX;
+    pCB["gHistogramOffset"] = layout.histogramOffset;
+    pCB["gTileOffset"] = layout.tileOffset;
+    pCB["gMaskOffset"] = layout.maskOffset;
+    pCB["gMaskWordsPerRow"] = layout.maskWordsPerRow;
+}
+
+void HoleStatistics::execute(RenderContext* pContext, const Texture::SharedPtr& pColor, uint64_t frameId)
+{
+    // Pick up finished readbacks, oldest first so mLatest ends up holding the newest frame
+    const uint64_t completedValue = mpFence->getGpuValue();
+    for (uint32_t i = 0; i < mSlots.size(); i++)
+    {
+        Slot& slot = mSlots[(mCurrentSlot + i) % mSlots.size()];
+        if (slot.pending && slot.fenceValue <= completedValue) resolve(slot);
+    }
+
+    // Rather skip a frame than wait for the GPU
+    Slot& slot = mSlots[mCurrentSlot];
+    if (slot.pending)
+    {
+        mDroppedFrames++;
+        return;
+    }
+
+    if (pColor->getWidth() != mWidth || pColor->getHeight() != mHeight)
+    {
+        resize(pColor->getWidth(), pColor->getHeight());
+    }
+
+    const StatsLayout layout = getLayout(mWidth, mHeight);
+    const size_t byteSize = layout.elementCount * sizeof(uint32_t);
+
+    mpVars->setTexture("gInputTex", pColor);
+    mpVars->setStructuredBuffer("gStats", mpStatsBuffer);
+    pContext->clearUAV(mpStatsBuffer->getUAV().get(), uvec4(0));
+    pContext->setComputeState(mpState);
+    pContext->setComputeVars(mpVars);
+    pContext->dispatch(layout.tileCountX, layout.tileCountY, 1);
+
+    if (slot.pReadback == nullptr || slot.pReadback->getSize() != byteSize)
+    {
+        slot.pReadback = Buffer::create(byteSize, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+    }
+    pContext->copyBufferRegion(slot.pReadback.get(), 0, mpStatsBuffer.get(), 0, byteSize);
+
+    // Submit without waiting, the fence tells us later when the copy is done
+    pContext->flush(false);
+    slot.fenceValue = mpFence->gpuSignal(pContext->getLowLevelData()->getCommandQueue());
+    slot.frameId = frameId;
+    slot.width = mWidth;
+    slot.height = mHeight;
+    slot.pending = true;
+    mCurrentSlot = (mCurrentSlot + 1) % mSlots.size();
+}
+
+const HoleStatistics::Result& HoleStatistics::executeAndWait(RenderContext* pContext, const Texture::SharedPtr& pColor, uint64_t frameId)
+{
+    // Once all earlier readbacks are done, execute() resolves them and finds the current slot free
+    mpFence->syncCpu();
+    execute(pContext, pColor, frameId);
+    mpFence->syncCpu();
+    resolve(mSlots[(mCurrentSlot + (uint32_t)mSlots.size() - 1) % mSlots.size()]);
+    return mLatest;
+}
+
+void HoleStatistics::resolve(Slot& slot)
+{
+    const StatsLayout layout = getLayout(slot.width, slot.height);
+    const uint32_t* pData = reinterpret_cast<const uint32_t*>(slot.pReadback->map(Buffer::MapType::Read));
+
+    Result& result = mLatest;
+    result.frameId = slot.frameId;
+    result.width = slot.width;
+    result.height = slot.height;
+    result.tileCountX = layout.tileCountX;
+    result.tileCountY = layout.tileCountY;
+    result.holeCount = pData[0];
+    result.holePercentage = (float)result.holeCount / (float)(slot.width * slot.height) * 100.f;
+    std::copy(pData + layout.histogramOffset, pData + layout.histogramOffset + kHistogramBinCount, result.histogram.begin());
+    result.tileCounts.assign(pData + layout.tileOffset, pData + layout.tileOffset + layout.tileCountX * layout.tileCountY);
+    findRegions(pData + layout.maskOffset, layout.maskWordsPerRow, slot.width, slot.height, result);
+
+    slot.pReadback->unmap();
+    slot.pending = false;
+    mbHasResult = true;
+}
+
+void HoleStatistics::findRegions(const uint32_t* pMask, uint32_t maskWordsPerRow, uint32_t width, uint32_t height, Result& result)
+{
+    // Run based labeling, runs in neighboring rows that overlap belong to the same region
+    std::vector<Run> runs;
+    std::vector<uint32_t> rowStart(height + 1, 0);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        rowStart[y] = (uint32_t)runs.size();
+        const uint32_t* pRow = pMask + y * maskWordsPerRow;
+        bool inRun = false;
+        for (uint32_t w = 0; w < maskWordsPerRow; w++)
+        {
+            uint32_t word = pRow[w];
+            if ((word == 0 && !inRun) || (word == 0xFFFFFFFF && inRun)) continue;
+
+            for (uint32_t bit = 0; bit < 32; bit++)
+            {
+                bool set = (word >> bit) & 1;
+                uint32_t x = w * 32 + bit;
+                if (set && !inRun)
+                {
+                    runs.push_back({ y, x, x });
+                    inRun = true;
+                }
+                else if (!set && inRun)
+                {
+                    runs.back().x1 = x - 1;
+                    inRun = false;
+                }
+            }
+        }
+        if (inRun) runs.back().x1 = std::min(maskWordsPerRow * 32, width) - 1;
+    }
+    rowStart[height] = (uint32_t)runs.size();
+
+    std::vector<uint32_t> parents(runs.size());
+    for (uint32_t i = 0; i < parents.size(); i++) parents[i] = i;
+
+    for (uint32_t y = 1; y < height; y++)
+    {
+        uint32_t prev = rowStart[y - 1];
+        for (uint32_t cur = rowStart[y]; cur < rowStart[y + 1]; cur++)
+        {
+            // Skip runs of the previous row that end left of the current run
+            while (prev < rowStart[y] && runs[prev].x1 < runs[cur].x0) prev++;
+            for (uint32_t p = prev; p < rowStart[y] && runs[p].x0 <= runs[cur].x1; p++)
+            {
+                uint32_t a = findRoot(parents, p);
+                uint32_t b = findRoot(parents, cur);
+                if (a != b) parents[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+
+    std::vector<uint32_t> sizes(runs.size(), 0);
+    std::vector<glm::uvec4> bounds(runs.size(), glm::uvec4(UINT32_MAX, UINT32_MAX, 0, 0));
+    result.regionCount = 0;
+    for (uint32_t i = 0; i < runs.size(); i++)
+    {
+        uint32_t root = findRoot(parents, i);
+        if (root == i) result.regionCount++;
+        sizes[root] += runs[i].x1 - runs[i].x0 + 1;
+        bounds[root] = glm::uvec4(std::min(bounds[root].x, runs[i].x0), std::min(bounds[root].y, runs[i].y), std::max(bounds[root].z, runs[i].x1), std::max(bounds[root].w, runs[i].y));
+    }
+
+    result.largestRegionSize = 0;
+    result.largestRegionBounds = glm::uvec4(0);
+    for (uint32_t i = 0; i < runs.size(); i++)
+    {
+        if (sizes[i] > result.largestRegionSize)
+        {
+            result.largestRegionSize = sizes[i];
+            result.largestRegionBounds = bounds[i];
+        }
+    }
+}
+
+void HoleStatistics::computeReference(const glm::vec4* pColor, uint32_t width, uint32_t height, Result& result)
+{
+    const StatsLayout layout = getLayout(width, height);
+    result.width = width;
+    result.height = height;
+    result.tileCountX = layout.tileCountX;
+    result.tileCountY = layout.tileCountY;
+    result.tileCounts.assign(layout.tileCountX * layout.tileCountY, 0);
+    result.histogram.fill(0);
+    result.holeCount = 0;
+
+    std::vector<uint8_t> holes(width * height, 0);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            if (pColor[y * width + x].w != 0.f) continue;
+            holes[y * width + x] = 1;
+            result.tileCounts[(y / kTileSize) * layout.tileCountX + x / kTileSize]++;
+            result.holeCount++;
+        }
+    }
+    result.holePercentage = (float)result.holeCount / (float)(width * height) * 100.f;
+    for (uint32_t count : result.tileCounts) result.histogram[getHistogramBin(count)]++;
+
+    // Plain flood fill, independent of the run based labeling used for the GPU data
+    result.regionCount = 0;
+    result.largestRegionSize = 0;
+    result.largestRegionBounds = glm::uvec4(0);
+    std::vector<glm::uvec2> stack;
+    for (uint32_t start = 0; start < width * height; start++)
+    {
+        if (holes[start] != 1) continue;
+
+        result.regionCount++;
+        uint32_t size = 0;
+        glm::uvec4 bounds(UINT32_MAX, UINT32_MAX, 0, 0);
+        holes[start] = 2;
+        stack.push_back(glm::uvec2(start % width, start / width));
+        while (!stack.empty())
+        {
+            glm::uvec2 p = stack.back();
+            stack.pop_back();
+            size++;
+            bounds = glm::uvec4(std::min(bounds.x, p.x), std::min(bounds.y, p.y), std::max(bounds.z, p.x), std::max(bounds.w, p.y));
+
+            const glm::ivec2 offsets[4] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+            for (const auto& o : offsets)
+            {
+                glm::ivec2 n = glm::ivec2(p) + o;
+                if (n.x < 0 || n.y < 0 || n.x >= (int32_t)width || n.y >= (int32_t)height) continue;
+                uint8_t& h = holes[n.y * width + n.x];
+                if (h != 1) continue;
+                h = 2;
+                stack.push_back(glm::uvec2(n));
+            }
+        }
+
+        if (size > result.largestRegionSize)
+        {
+            result.largestRegionSize = size;
+            result.largestRegionBounds = bounds;
+        }
+    }
+}
+
+uint32_t HoleStatistics::compare(const Result& reference, const Result& other)
+{
+    uint32_t mismatches = 0;
+    if (reference.holeCount != other.holeCount) mismatches++;
+    if (reference.regionCount != other.regionCount) mismatches++;
+    if (reference.largestRegionSize != other.largestRegionSize) mismatches++;
+    if (reference.largestRegionBounds != other.largestRegionBounds) mismatches++;
+    for (uint32_t i = 0; i < kHistogramBinCount; i++)
+    {
+        if (reference.histogram[i] != other.histogram[i]) mismatches++;
+    }
+    if (reference.tileCounts.size() != other.tileCounts.size()) return mismatches + 1;
+    for (size_t i = 0; i < reference.tileCounts.size(); i++)
+    {
+        if (reference.tileCounts[i] != other.tileCounts[i]) mismatches++;
+    }
+    return mismatches;
+}
@@ -0,0 +1,109 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#pragma once
+#include "Falcor.h"
+
+#include <array>
+#include <vector>
+
+using namespace Falcor;
+
+// Hole statistics of the reprojected image: total count, per tile counts, a tile histogram and the largest connected hole region.
+// The GPU results are copied into a ring of readback buffers and picked up a few frames later, so the CPU never waits on the GPU.
+class HoleStatistics
+{
+public:
+    using SharedPtr = std::shared_ptr<HoleStatistics>;
+
+    static const uint32_t kTileSize = 16;
+    static const uint32_t kHistogramBinCount = kTileSize + 1;   // bin 0: no holes, bin i: (i - 1) * 16 < holes <= i * 16
+    static const uint32_t kDefaultReadbackLatency = 3;
+
+    struct Result
+    {
+        uint64_t frameId = 0;                   // frame the statistics were recorded in
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t tileCountX = 0;
+        uint32_t tileCountY = 0;
+        uint32_t holeCount = 0;
+        float holePercentage = 0.f;
+        std::vector<uint32_t> tileCounts;
+        std::array<uint32_t, kHistogramBinCount> histogram = {};
+        uint32_t regionCount = 0;               // 4-connected hole regions
+        uint32_t largestRegionSize = 0;
+        glm::uvec4 largestRegionBounds = glm::uvec4(0);  // min x, min y, max x, max y
+    };
+
+    static SharedPtr create(uint32_t readbackLatency = kDefaultReadbackLatency);
+
+    // Records the statistics of pColor (alpha 0 marks a hole) and picks up all readbacks that completed in the meantime
+    void execute(RenderContext* pContext, const Texture::SharedPtr& pColor, uint64_t frameId);
+
+    // Records the statistics of pColor and waits for them, used to validate the GPU results against computeReference()
+    const Result& executeAndWait(RenderContext* pContext, const Texture::SharedPtr& pColor, uint64_t frameId);
+
+    // Latest result that arrived on the CPU, readbackLatency frames old (or older)
+    bool hasResult() const { return mbHasResult; }
+    const Result& getLatestResult() const { return mLatest; }
+
+    // Frames that were not recorded because all readback slots were still in flight
+    uint32_t getDroppedFrameCount() const { return mDroppedFrames; }
+
+    // CPU reference, computes all statistics directly from the image
+    static void computeReference(const glm::vec4* pColor, uint32_t width, uint32_t height, Result& result);
+
+    // Connected regions of a hole mask with 1 bit per pixel, rows padded to maskWordsPerRow 32 bit words
+    static void findRegions(const uint32_t* pMask, uint32_t maskWordsPerRow, uint32_t width, uint32_t height, Result& result);
+
+    // Number of values that differ between two results (counts, histogram bins and region data)
+    static uint32_t compare(const Result& reference, const Result& other);
+
+private:
+    HoleStatistics(uint32_t readbackLatency);
+
+    struct Slot
+    {
+        Buffer::SharedPtr pReadback;
+        uint64_t fenceValue = 0;
+        uint64_t frameId = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool pending = false;
+    };
+
+    void resize(uint32_t width, uint32_t height);
+    void resolve(Slot& slot);
+
+    ComputeProgram::SharedPtr mpProgram;
+    ComputeState::SharedPtr mpState;
+    ComputeVars::SharedPtr mpVars;
+    StructuredBuffer::SharedPtr mpStatsBuffer;
+    GpuFence::SharedPtr mpFence;
+
+    std::vector<Slot> mSlots;
+    uint32_t mCurrentSlot = 0;
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+
+    Result mLatest;
+    bool mbHasResult = false;
+    uint32_t mDroppedFrames = 0;
+};
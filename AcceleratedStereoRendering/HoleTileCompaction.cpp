@@ -0,0 +1,208 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#include "HoleTileCompaction.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    const uint32_t kCounterCount = 2;
+
+    void fillStats(uint32_t width, uint32_t height, uint32_t tileCount, uint32_t holeCount, uint32_t launchTileCount, HoleTileCompaction::Stats& stats)
+    {
+        const uint32_t tileCountX = (width + HoleTileCompaction::kTileSize - 1) / HoleTileCompaction::kTileSize;
+        const uint32_t tileCountY = (height + HoleTileCompaction::kTileSize - 1) / HoleTileCompaction::kTileSize;
+        stats.width = width;
+        stats.height = height;
+        stats.totalTileCount = tileCountX * tileCountY;
+        stats.tileCount = tileCount;
+        stats.holeCount = holeCount;
+        stats.launchedRayCount = launchTileCount * HoleTileCompaction::kTileSize * HoleTileCompaction::kTileSize;
+        stats.compactionRatio = (width * height) > 0 ? (float)stats.launchedRayCount / (float)(width * height) : 0.f;
+    }
+}
+
+HoleTileCompaction::SharedPtr HoleTileCompaction::create(uint32_t readbackLatency)
+{
+    return SharedPtr(new HoleTileCompaction(readbackLatency));
+}
+
+HoleTileCompaction::HoleTileCompaction(uint32_t readbackLatency)
+{
+    mpProgram = ComputeProgram::createFromFile("HoleTileCompaction.slang", "main");
+    mpState = ComputeState::create();
+    mpState->setProgram(mpProgram);
+    mpVars = ComputeVars::create(mpProgram->getReflector());
+    mpCounterBuffer = StructuredBuffer::create(mpProgram, "gCounters", kCounterCount);
+    mpFence = GpuFence::create();
+    mSlots.resize(std::max(1u, readbackLatency));
+}
+
+void HoleTileCompaction::resize(uint32_t width, uint32_t height)
+{
+    mWidth = width;
+    mHeight = height;
+    mTileCountX = (width + kTileSize - 1) / kTileSize;
+    mTileCountY = (height + kTileSize - 1) / kTileSize;
+    mpTileBuffer = StructuredBuffer::create(mpProgram, "gTiles", mTileCountX * mTileCountY);
+
+    // Until the first count arrives every tile is covered in a single pass
+    mLaunchTileCount = mTileCountX * mTileCountY;
+
+    ConstantBuffer::SharedPtr pCB = mpVars["PerFrameCB"];
+    pCB["gDims"] = glm::uvec2(width, height);
+}
+
+void HoleTileCompaction::execute(RenderContext* pContext, const Texture::SharedPtr& pColor, uint64_t frameId)
+{
+    const uint64_t completedValue = mpFence->getGpuValue();
+    for (uint32_t i = 0; i < mSlots.size(); i++)
+    {
+        Slot& slot = mSlots[(mCurrentSlot + i) % mSlots.size()];
+        if (slot.pending && slot.fenceValue <= completedValue) resolve(slot);
+    }
+
+    if (pColor->getWidth() != mWidth || pColor->getHeight() != mHeight)
+    {
+        resize(pColor->getWidth(), pColor->getHeight());
+        mbHasStats = false;
+    }
+
+    // Size the launch for the last known count plus some headroom, the shader loops if the holes grew faster
+    if (mbHasStats)
+    {
+        const uint32_t totalTiles = mTileCountX * mTileCountY;
+        mLaunchTileCount = std::min(totalTiles, std::max(kMinLaunchTileCount, mLatest.tileCount + mLatest.tileCount / 4));
+    }
+
+    mpVars->setTexture("gInputTex", pColor);
+    mpVars->setStructuredBuffer("gTiles", mpTileBuffer);
+    mpVars->setStructuredBuffer("gCounters", mpCounterBuffer);
+    pContext->clearUAV(mpCounterBuffer->getUAV().get(), uvec4(0));
+    pContext->setComputeState(mpState);
+    pContext->setComputeVars(mpVars);
+    pContext->dispatch(mTileCountX, mTileCountY, 1);
+
+    // The compaction itself runs every frame, only the stats readback is skipped while all slots are in flight
+    Slot& slot = mSlots[mCurrentSlot];
+    if (slot.pending)
+    {
+        mDroppedFrames++;
+        return;
+    }
+
+    const size_t byteSize = kCounterCount * sizeof(uint32_t);
+    if (slot.pReadback == nullptr)
+    {
+        slot.pReadback = Buffer::create(byteSize, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+    }
+    pContext->copyBufferRegion(slot.pReadback.get(), 0, mpCounterBuffer.get(), 0, byteSize);
+
+    pContext->flush(false);
+    slot.fenceValue = mpFence->gpuSignal(pContext->getLowLevelData()->getCommandQueue());
+    slot.frameId = frameId;
+    slot.width = mWidth;
+    slot.height = mHeight;
+    slot.launchTileCount = mLaunchTileCount;
+    slot.pending = true;
+    mCurrentSlot = (mCurrentSlot + 1) % mSlots.size();
+}
+
+void HoleTileCompaction::executeAndReadTiles(RenderContext* pContext, const Texture::SharedPtr& pColor, uint64_t frameId, std::vector<uint32_t>& tiles, Stats& stats)
+{
+    // Once all earlier readbacks are done, execute() resolves them and finds the current slot free
+    mpFence->syncCpu();
+    execute(pContext, pColor, frameId);
+
+    const uint32_t totalTiles = mTileCountX * mTileCountY;
+    const size_t counterByteSize = kCounterCount * sizeof(uint32_t);
+    const size_t tileByteSize = std::max(1u, totalTiles) * sizeof(uint32_t);
+    Buffer::SharedPtr pCounters = Buffer::create(counterByteSize, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+    Buffer::SharedPtr pTiles = Buffer::create(tileByteSize, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+    pContext->copyBufferRegion(pCounters.get(), 0, mpCounterBuffer.get(), 0, counterByteSize);
+    pContext->copyBufferRegion(pTiles.get(), 0, mpTileBuffer.get(), 0, tileByteSize);
+    pContext->flush(true);
+
+    const uint32_t* pCounterData = reinterpret_cast<const uint32_t*>(pCounters->map(Buffer::MapType::Read));
+    const uint32_t* pTileData = reinterpret_cast<const uint32_t*>(pTiles->map(Buffer::MapType::Read));
+    tiles.assign(pTileData, pTileData + std::min(pCounterData[0], totalTiles));
+    stats.frameId = frameId;
+    fillStats(mWidth, mHeight, pCounterData[0], pCounterData[1], mLaunchTileCount, stats);
+    pTiles->unmap();
+    pCounters->unmap();
+}
+
+void HoleTileCompaction::resolve(Slot& slot)
+{
+    const uint32_t* pData = reinterpret_cast<const uint32_t*>(slot.pReadback->map(Buffer::MapType::Read));
+    mLatest.frameId = slot.frameId;
+    fillStats(slot.width, slot.height, pData[0], pData[1], slot.launchTileCount, mLatest);
+    slot.pReadback->unmap();
+    slot.pending = false;
+
+    // Stats of an old resolution would size the launch wrong
+    mbHasStats = (slot.width == mWidth && slot.height == mHeight);
+}
+
+void HoleTileCompaction::compactReference(const glm::vec4* pColor, uint32_t width, uint32_t height, std::vector<uint32_t>& tiles, Stats& stats)
+{
+    const uint32_t tileCountX = (width + kTileSize - 1) / kTileSize;
+    const uint32_t tileCountY = (height + kTileSize - 1) / kTileSize;
+
+    tiles.clear();
+    uint32_t holeCount = 0;
+    for (uint32_t ty = 0; ty < tileCountY; ty++)
+    {
+        for (uint32_t tx = 0; tx < tileCountX; tx++)
+        {
+            uint32_t tileHoles = 0;
+            const uint32_t x1 = std::min(width, (tx + 1) * kTileSize);
+            const uint32_t y1 = std::min(height, (ty + 1) * kTileSize);
+            for (uint32_t y = ty * kTileSize; y < y1; y++)
+            {
+                const glm::vec4* pRow = pColor + (size_t)y * width;
+                for (uint32_t x = tx * kTileSize; x < x1; x++)
+                {
+                    if (pRow[x].w == 0.f) tileHoles++;
+                }
+            }
+
+            if (tileHoles > 0)
+            {
+                tiles.push_back((ty << 16) | tx);
+                holeCount += tileHoles;
+            }
+        }
+    }
+
+    // The reference launch covers exactly the hole tiles
+    fillStats(width, height, (uint32_t)tiles.size(), holeCount, (uint32_t)tiles.size(), stats);
+}
+
+uint32_t HoleTileCompaction::compare(std::vector<uint32_t> reference, std::vector<uint32_t> other)
+{
+    std::sort(reference.begin(), reference.end());
+    std::sort(other.begin(), other.end());
+
+    std::vector<uint32_t> difference;
+    std::set_symmetric_difference(reference.begin(), reference.end(), other.begin(), other.end(), std::back_inserter(difference));
+    return (uint32_t)difference.size();
+}
@@ -0,0 +1,111 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#pragma once
+#include "Falcor.h"
+
+#include <vector>
+
+using namespace Falcor;
+
+// Compacts the tiles of the reprojected image that contain holes into a list, so the hole filling rays are only launched for those tiles.
+// The tile count reaches the CPU a few frames later and only sizes the next launch and feeds the stats. The ray generation shader loops
+// over the list, so a launch smaller than the list still covers every tile.
+class HoleTileCompaction
+{
+public:
+    using SharedPtr = std::shared_ptr<HoleTileCompaction>;
+
+    static const uint32_t kTileSize = 8;                // keep in sync with HoleTileCompaction.slang and ReprojectionRT.slang
+    static const uint32_t kMinLaunchTileCount = 64;
+    static const uint32_t kDefaultReadbackLatency = 3;
+
+    struct Stats
+    {
+        uint64_t frameId = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t totalTileCount = 0;
+        uint32_t tileCount = 0;                 // tiles with at least one hole
+        uint32_t holeCount = 0;                 // rays actually traced
+        uint32_t launchedRayCount = 0;          // ray generation invocations of the compacted launch
+        float compactionRatio = 0.f;            // launched rays / full screen launch
+    };
+
+    static SharedPtr create(uint32_t readbackLatency = kDefaultReadbackLatency);
+
+    // Compacts the hole tiles of pColor (alpha 0 marks a hole) and picks up all readbacks that completed in the meantime
+    void execute(RenderContext* pContext, const Texture::SharedPtr& pColor, uint64_t frameId);
+
+    // Compacts pColor and waits for the tile list and counters, used to validate the GPU list against compactReference()
+    void executeAndReadTiles(RenderContext* pContext, const Texture::SharedPtr& pColor, uint64_t frameId, std::vector<uint32_t>& tiles, Stats& stats);
+
+    // Tile list, one (y << 16) | x entry per hole tile in no particular order, and the counters ([0] tiles, [1] hole pixels)
+    const StructuredBuffer::SharedPtr& getTileBuffer() const { return mpTileBuffer; }
+    const StructuredBuffer::SharedPtr& getCounterBuffer() const { return mpCounterBuffer; }
+
+    // Tiles covered per launch pass, the launch is kTileSize * kTileSize x getLaunchTileCount()
+    uint32_t getLaunchTileCount() const { return mLaunchTileCount; }
+
+    bool hasStats() const { return mbHasStats; }
+    const Stats& getLatestStats() const { return mLatest; }
+    uint32_t getDroppedFrameCount() const { return mDroppedFrames; }
+
+    // CPU reference, returns the hole tiles in row-major order
+    static void compactReference(const glm::vec4* pColor, uint32_t width, uint32_t height, std::vector<uint32_t>& tiles, Stats& stats);
+
+    // Number of tiles that are in only one of the lists, order independent
+    static uint32_t compare(std::vector<uint32_t> reference, std::vector<uint32_t> other);
+
+private:
+    HoleTileCompaction(uint32_t readbackLatency);
+
+    struct Slot
+    {
+        Buffer::SharedPtr pReadback;
+        uint64_t fenceValue = 0;
+        uint64_t frameId = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t launchTileCount = 0;
+        bool pending = false;
+    };
+
+    void resize(uint32_t width, uint32_t height);
+    void resolve(Slot& slot);
+
+    ComputeProgram::SharedPtr mpProgram;
+    ComputeState::SharedPtr mpState;
+    ComputeVars::SharedPtr mpVars;
+    StructuredBuffer::SharedPtr mpTileBuffer;
+    StructuredBuffer::SharedPtr mpCounterBuffer;
+    GpuFence::SharedPtr mpFence;
+
+    std::vector<Slot> mSlots;
+    uint32_t mCurrentSlot = 0;
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    uint32_t mTileCountX = 0;
+    uint32_t mTileCountY = 0;
+    uint32_t mLaunchTileCount = 0;
+
+    Stats mLatest;
+    bool mbHasStats = false;
+    uint32_t mDroppedFrames = 0;
+};
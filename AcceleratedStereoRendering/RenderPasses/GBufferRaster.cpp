@@ -98,6 +98,8 @@ GBufferRaster::GBufferRaster() : RenderPass("GBufferRaster")
     mRaster.pState->setProgram(mRaster.pProgram);
 
     mpFbo = Fbo::create();
+
+    mLodSettings.peripheryBias = 2.0f;
 }
 
 void GBufferRaster::onResize(uint32_t width, uint32_t height)
@@ -106,7 +108,37 @@ void GBufferRaster::onResize(uint32_t width, uint32_t height)
 
 void GBufferRaster::setScene(const std::shared_ptr<Scene>& pScene)
 {
-    mpSceneRenderer = (pScene == nullptr) ? nullptr : SceneRenderer::create(pScene);
+    mpSceneRenderer = (pScene == nullptr) ? nullptr : StereoSceneRenderer::create(pScene);
+    if (mpSceneRenderer != nullptr)
+    {
+        mpSceneRenderer->setMultiView(mbMultiView);
+        mpSceneRenderer->toggleOcclusionCulling(mbOcclusionCulling);
+        mpSceneRenderer->setLodSettings(mLodSettings);
+    }
+}
+
+void GBufferRaster::setMultiView(bool enable)
+{
+    if (enable == mbMultiView)
+    {
+        return;
+    }
+
+    mbMultiView = enable;
+    if (mbMultiView)
+    {
+        mRaster.pProgram->addDefine("_MULTI_VIEW");
+    }
+    else
+    {
+        mRaster.pProgram->removeDefine("_MULTI_VIEW");
+        mpMultiViewFbo = nullptr;
+    }
+
+    if (mpSceneRenderer != nullptr)
+    {
+        mpSceneRenderer->setMultiView(mbMultiView);
+    }
 }
 
 void GBufferRaster::renderUI(Gui* pGui, const char* uiGroup)
@@ -116,6 +148,46 @@ void GBufferRaster::renderUI(Gui* pGui, const char* uiGroup)
     {
         setCullMode((RasterizerState::CullMode)cullMode);
     }
+
+    if (mpSceneRenderer != nullptr)
+    {
+        std::string statsText = std::string(mbMultiView ? "Single-pass stereo" : "One pass per eye") + ", " + std::to_string(mpSceneRenderer->getDrawCount()) +
+            " draw calls, " + std::to_string(mpSceneRenderer->getInstanceCount()) + " mesh instances";
+        pGui->addText(statsText.c_str());
+
+        if (pGui->addCheckBox("Occlusion Culling", mbOcclusionCulling))
+        {
+            mpSceneRenderer->toggleOcclusionCulling(mbOcclusionCulling);
+        }
+        if (mbOcclusionCulling)
+        {
+            const SoftwareOcclusionCuller::Stats& stats = mpSceneRenderer->getOcclusionCuller()->getStats();
+            std::string occlusionText = std::to_string(stats.occluderCount) + " occluders, " + std::to_string(stats.triangleCount) + " triangles, " +
+                std::to_string(stats.occludedBoxCount) + " of " + std::to_string(stats.testedBoxCount) + " instances occluded";
+            pGui->addText(occlusionText.c_str());
+        }
+
+        if (pGui->beginGroup("Level of Detail"))
+        {
+            bool changed = pGui->addCheckBox("Enable", mLodSettings.enabled);
+            changed |= pGui->addFloatVar("Pixel Error", mLodSettings.maxPixelError, 0.1f, 16.0f, 0.1f);
+            changed |= pGui->addFloatVar("Periphery Bias", mLodSettings.peripheryBias, 0.0f, 16.0f, 0.1f);
+            changed |= pGui->addFloatVar("Periphery Start", mLodSettings.peripheryStart, 0.0f, 0.95f, 0.05f);
+            if (changed)
+            {
+                mpSceneRenderer->setLodSettings(mLodSettings);
+            }
+
+            const SceneRenderer::LodStats& lodStats = mpSceneRenderer->getLodStats();
+            std::string lodText = std::to_string(lodStats.triangleCount) + " of " + std::to_string(lodStats.fullDetailTriangleCount) + " triangles\nInstances per level:";
+            for (uint32_t level = 0; level < Mesh::kMaxLodCount; level++)
+            {
+                lodText += " " + std::to_string(lodStats.instanceCount[level]);
+            }
+            pGui->addText(lodText.c_str());
+            pGui->endGroup();
+        }
+    }
 }
 
 void GBufferRaster::setCullMode(RasterizerState::CullMode mode)
@@ -137,6 +209,34 @@ void GBufferRaster::execute(RenderContext* pContext, const RenderData* pRenderDa
 
     mRaster.pVars["PerImageCB"]["gStereoTarget"] = DeferredRenderer::gStereoTarget;
 
+    if (mbMultiView)
+    {
+        if (DeferredRenderer::gStereoTarget == 0)
+        {
+            const Texture::SharedPtr& pDepth = pRenderData->getTexture("depthStencil");
+            if (mpMultiViewFbo == nullptr || mpMultiViewFbo->getWidth() != pDepth->getWidth() || mpMultiViewFbo->getHeight() != pDepth->getHeight())
+            {
+                Fbo::Desc fboDesc;
+                for (uint32_t i = 0; i < (uint32_t)kGBufferChannelDesc.size(); ++i)
+                {
+                    fboDesc.setColorTarget(i, ResourceFormat::RGBA32Float);
+                }
+                fboDesc.setDepthStencilTarget(ResourceFormat::D32Float);
+                mpMultiViewFbo = FboHelper::create2D(pDepth->getWidth(), pDepth->getHeight(), fboDesc, StereoSceneRenderer::kViewCount);
+            }
+
+            pContext->clearFbo(mpMultiViewFbo.get(), vec4(0), 1.f, 0, FboAttachmentType::All);
+            mRaster.pState->setFbo(mpMultiViewFbo);
+
+            pContext->setGraphicsState(mRaster.pState);
+            pContext->setGraphicsVars(mRaster.pVars);
+            mpSceneRenderer->renderScene(pContext);
+        }
+
+        copyViewToOutputs(pContext, pRenderData, DeferredRenderer::gStereoTarget);
+        return;
+    }
+
     mpFbo->attachDepthStencilTarget(pRenderData->getTexture("depthStencil"));
 
     for (int i = 0; i < kGBufferChannelDesc.size(); ++i)
@@ -149,5 +249,31 @@ void GBufferRaster::execute(RenderContext* pContext, const RenderData* pRenderDa
 
     pContext->setGraphicsState(mRaster.pState);
     pContext->setGraphicsVars(mRaster.pVars);
+    mpSceneRenderer->setEye(DeferredRenderer::gStereoTarget);
     mpSceneRenderer->renderScene(pContext);
 }
+
+void GBufferRaster::recordTelemetry(Telemetry* pTelemetry)
+{
+    if (mpSceneRenderer != nullptr && mbOcclusionCulling)
+    {
+        pTelemetry->record("occludedInstances", (float)mpSceneRenderer->getOcclusionCuller()->getStats().occludedBoxCount);
+    }
+}
+
+void GBufferRaster::copyViewToOutputs(RenderContext* pContext, const RenderData* pRenderData, uint32_t eye)
+{
+    if (mpMultiViewFbo == nullptr)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < (uint32_t)kGBufferChannelDesc.size(); ++i)
+    {
+        const Texture* pView = mpMultiViewFbo->getColorTexture(i).get();
+        pContext->copySubresource(pRenderData->getTexture(kGBufferChannelDesc[i].name).get(), 0, pView, pView->getSubresourceIndex(eye, 0));
+    }
+
+    const Texture* pDepthView = mpMultiViewFbo->getDepthStencilTexture().get();
+    pContext->copySubresource(pRenderData->getTexture("depthStencil").get(), 0, pDepthView, pDepthView->getSubresourceIndex(eye, 0));
+}
@@ -32,6 +32,7 @@
 
 #pragma once
 #include "Falcor.h"
+#include "../StereoSceneRenderer.h"
 
 using namespace Falcor;
 
@@ -45,20 +46,35 @@ public:
     RenderPassReflection reflect() const override;
     void execute(RenderContext* pContext, const RenderData* pRenderData) override;
     void renderUI(Gui* pGui, const char* uiGroup) override;
+    void recordTelemetry(Telemetry* pTelemetry) override;
     Dictionary getScriptingDictionary() const override;
     void onResize(uint32_t width, uint32_t height) override;
     void setScene(const std::shared_ptr<Scene>& pScene) override;
     std::string getDesc(void) override { return "Raster GBuffer generation"; }
+
+    // Rasterizes both eyes with one scene traversal during the left eye execution, the right eye execution only copies its view
+    void setMultiView(bool enable);
+    bool isMultiViewEnabled() const { return mbMultiView; }
 private:
     GBufferRaster();
     void setCullMode(RasterizerState::CullMode mode);
     bool parseDictionary(const Dictionary& dict);
 
     GraphicsState::SharedPtr                mpGraphicsState;
-    SceneRenderer::SharedPtr                mpSceneRenderer;
+    StereoSceneRenderer::SharedPtr          mpSceneRenderer;
     Fbo::SharedPtr                          mpFbo;
     RasterizerState::CullMode               mCullMode = RasterizerState::CullMode::Back;
 
+    // Multi-view resources, slice 0 is the left eye and slice 1 the right eye
+    void copyViewToOutputs(RenderContext* pContext, const RenderData* pRenderData, uint32_t eye);
+    bool                                    mbMultiView = false;
+    Fbo::SharedPtr                          mpMultiViewFbo;
+
+    bool                                    mbOcclusionCulling = false;
+
+    // Stereo views are seen through lenses, the periphery tolerates coarser geometry than the center
+    SceneRenderer::LodSettings              mLodSettings;
+
     // Rasterization resources
     struct
     {
@@ -52,6 +52,7 @@ void Lighting::initialize(const Dictionary & dict)
     mpState = GraphicsState::create();
     mpPass = FullScreenPass::create(kFileOutput);
     mpVars = GraphicsVars::create(mpPass->getProgram()->getReflector());
+    mpPass->getProgram()->setAsyncCompilation(true);
     mpFbo = Fbo::create();
 
     Sampler::Desc samplerDesc;
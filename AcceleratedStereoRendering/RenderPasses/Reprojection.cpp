@@ -19,26 +19,6 @@
 
 #include "Reprojection.h"
 
-struct layoutsData
-{
-    uint32_t pos;
-    std::string name;
-    ResourceFormat format;
-};
-
-static const layoutsData kLayoutData[VERTEX_LOCATION_COUNT] =
-{
-    { VERTEX_POSITION_LOC,      VERTEX_POSITION_NAME,       ResourceFormat::RGB32Float },
-    { VERTEX_NORMAL_LOC,        VERTEX_NORMAL_NAME,         ResourceFormat::RGB32Float },
-    { VERTEX_BITANGENT_LOC,     VERTEX_BITANGENT_NAME,      ResourceFormat::RGB32Float },
-    { VERTEX_TEXCOORD_LOC,      VERTEX_TEXCOORD_NAME,       ResourceFormat::RGB32Float }, //for some reason this is rgb
-    { VERTEX_LIGHTMAP_UV_LOC,   VERTEX_LIGHTMAP_UV_NAME,    ResourceFormat::RGB32Float }, //for some reason this is rgb
-    { VERTEX_BONE_WEIGHT_LOC,   VERTEX_BONE_WEIGHT_NAME,    ResourceFormat::RGBA32Float},
-    { VERTEX_BONE_ID_LOC,       VERTEX_BONE_ID_NAME,        ResourceFormat::RGBA8Uint  },
-    { VERTEX_DIFFUSE_COLOR_LOC, VERTEX_DIFFUSE_COLOR_NAME,  ResourceFormat::RGBA32Float},
-    { VERTEX_QUADID_LOC,        VERTEX_QUADID_NAME,         ResourceFormat::R32Float   },
-};
-
 size_t Reprojection::sLightArrayOffset = ConstantBuffer::kInvalidOffset;
 size_t Reprojection::sLightCountOffset = ConstantBuffer::kInvalidOffset;
 size_t Reprojection::sCameraDataOffset = ConstantBuffer::kInvalidOffset;
@@ -117,6 +97,10 @@ void Reprojection::initialize(const RenderData * pRenderData)
     setDefine("_DISCARD_TRIANGLES", mbUseGeoShader);
 #endif
 
+    // The start versions are linked on first use, toggling a define later compiles in the background
+    mpProgram->setAsyncCompilation(true);
+    mpComputeProgram->setAsyncCompilation(true);
+
     // Wireframe Raster State
     RasterizerState::Desc wireframeDesc;
     wireframeDesc.setFillMode(RasterizerState::FillMode::Wireframe);
@@ -210,6 +194,8 @@ void Reprojection::execute(RenderContext * pContext, const RenderData * pRenderD
     if (!mIsInitialized) initialize(pRenderData);
 
     mThirdPersonCamController.update();
+    mbHoleStatsRecorded = false;
+    mTelemetrySamples.clear();
 
     // Get our output buffer and clear it
     const auto& pDisTex = pRenderData->getTexture("out");
@@ -275,36 +261,31 @@ void Reprojection::execute(RenderContext * pContext, const RenderData * pRenderD
     // Render Screen-Quad only
     if (!mbRayTraceOnly)
     {
-        mpGridSceneRenderer->toggleMeshCulling(false);
-        mpGridSceneRenderer->renderScene(pContext, mpScene->getActiveCamera().get());
+        mpGrid->pSceneRenderer->renderScene(pContext, mpScene->getActiveCamera().get());
 #if _USETRIANGLECOUNTSHADER
         mpTriangleCountBuffer->getVariable(0, 0, mNumTriangles);
-        if (mbWriteTriangleCount)
-        {
-            mTriangleCountData[mTriangleCountDataSteps++] = mNumTriangles;
-            if (mTriangleCountDataSteps == _PROFILING_LOG_BATCH_SIZE)
-            {
-                std::ostringstream logOss, fileOss;
-                logOss << "dumping " << "profile_" << "triangleCount" << "_" << mTriangleCountDataFilesWritten;
-                logInfo(logOss.str());
-                fileOss << "profile_" << "triangleCount" << "_" << mTriangleCountDataFilesWritten++ << ".txt";
-                std::ofstream out(fileOss.str().c_str());
-                for (int i = 0; i < _PROFILING_LOG_BATCH_SIZE; ++i)
-                {
-                    out << mTriangleCountData[i] << "\n";
-                }
-                mTriangleCountDataSteps = 0;
-            }
-        }
+        mTelemetrySamples.push_back({ "gridTriangles", (float)mNumTriangles });
 #endif
     }
 
 
     Profiler::endEvent("render_grid");
 
+    // Validate/benchmark against the CPU implementation before the holes get filled
+    if (mbRunCpuReference || mbRunCpuBenchmark)
+    {
+        runCpuReference(pContext, pRenderData);
+    }
+
     if (mbFillHoles)
     {
-        switch (mHoleFillingMode)
+        uint32_t fillMode = mHoleFillingMode;
+        if (mHoleFillingMode == Reprojection::Adaptive)
+        {
+            fillMode = selectHoleFillMode(pContext, pDisTex);
+        }
+
+        switch (fillMode)
         {
         case Reprojection::RayTrace:
             fillHolesRT(pContext, pRenderData, pDisTex);
@@ -315,6 +296,11 @@ void Reprojection::execute(RenderContext * pContext, const RenderData * pRenderD
         default:
             break;
         }
+
+        if (mHoleFillingMode == Reprojection::Adaptive)
+        {
+            endFillTiming();
+        }
     }
 
     if (mbCHCEnable)
@@ -341,10 +327,18 @@ inline void Reprojection::fillHolesRT(RenderContext * pContext, const RenderData
     pCB["gKernelSize"] = (uint32_t)mpLightPass->mPCFKernelSize;
 
     // Hit Shader Vars (Shadow Map)
+    const Texture::SharedPtr& pShadowMap = pRenderData->getTexture("shadowDepth");
     for (auto pVars : mpRtVars->getHitVars(0))
     {
         pVars->setSampler("gPCFCompSampler", mpLightPass->mpLinearComparisonSampler);
-        pVars->setTexture("gShadowMap", pRenderData->getTexture("shadowDepth"));
+        pVars->setTexture("gShadowMap", pShadowMap);
+    }
+
+    // The hit-group vars are only re-applied with the shader state, a graph recompilation can change the shadow map
+    if (pShadowMap.get() != mpRtShadowMap)
+    {
+        mpRtShadowMap = pShadowMap.get();
+        mpRtRenderer->mUpdateShaderState = true;
     }
 
     if (mpSkyBox != nullptr && mbRenderEnvMap)
@@ -359,8 +353,29 @@ inline void Reprojection::fillHolesRT(RenderContext * pContext, const RenderData
     float angle = glm::atan((2.f*glm::tan(fov / 2.f)) / mpFbo->getHeight());
     pCB["gSpreadAngle"] = angle;
 
+    // Launch rays only for the tiles that contain holes, Ray Trace Only has nothing to compact
+    uvec3 launchDim = uvec3(mpFbo->getWidth(), mpFbo->getHeight(), 1);
+    const bool tiledDispatch = mbTiledRayDispatch && !mbRayTraceOnly;
+    if (tiledDispatch)
+    {
+        if (mpHoleTileCompaction == nullptr) mpHoleTileCompaction = HoleTileCompaction::create();
+        mpHoleTileCompaction->execute(pContext, pTexture, ++mTileCompactionFrameId);
+
+        mpRtVars->getRayGenVars()->setStructuredBuffer("gHoleTiles", mpHoleTileCompaction->getTileBuffer());
+        mpRtVars->getRayGenVars()->setStructuredBuffer("gHoleTileCounters", mpHoleTileCompaction->getCounterBuffer());
+        pCB["gLaunchTileCount"] = mpHoleTileCompaction->getLaunchTileCount();
+        launchDim = uvec3(HoleTileCompaction::kTileSize * HoleTileCompaction::kTileSize, mpHoleTileCompaction->getLaunchTileCount(), 1);
+
+        if (mpHoleTileCompaction->hasStats())
+        {
+            mTelemetrySamples.push_back({ "rays", (float)mpHoleTileCompaction->getLatestStats().holeCount });
+            mTelemetrySamples.push_back({ "raysLaunched", (float)mpHoleTileCompaction->getLatestStats().launchedRayCount });
+        }
+    }
+    pCB["gTiledDispatch"] = tiledDispatch ? 1u : 0u;
+
     mpRtVars->getRayGenVars()->setTexture("gOutput", pTexture);
-    mpRtRenderer->renderScene(pContext, mpRtVars, mpRtState, uvec3(mpFbo->getWidth(), mpFbo->getHeight(), 1));
+    mpRtRenderer->renderScene(pContext, mpRtVars, mpRtState, launchDim);
 
     Profiler::endEvent("fillholes_rt");
 }
@@ -377,6 +392,8 @@ inline void Reprojection::fillHolesRaster(RenderContext * pContext, const Render
     pContext->setGraphicsState(mpReRasterGraphicsState);
     pContext->setGraphicsVars(mpReRasterVars);
     mpReRasterSceneRenderer->renderScene(pContext, mpScene->getActiveCamera().get());
+    mRightOnlyInstanceCount = (uint32_t)mpReRasterSceneRenderer->getRightOnlyInstances().size();
+    mTelemetrySamples.push_back({ "rightOnlyInstances", (float)mRightOnlyInstanceCount });
 
     // Lighting Hole Fill Pass
     mpReRasterLightingFbo->attachColorTarget(pTexture, 0);
@@ -457,49 +474,220 @@ void Reprojection::setPerFrameData(const GraphicsVars * pVars)
     }
 }
 
-void Reprojection::computeHoleCount(RenderContext * pContext, const RenderData * pRenderData)
+uint32_t Reprojection::selectHoleFillMode(RenderContext * pContext, const Texture::SharedPtr& pTexture)
 {
-    if (!mbCHCInitialized) initializeCHC();
+    if (mpHoleFillSelector == nullptr) mpHoleFillSelector = HoleFillSelector::create(mHoleFillSettings);
 
-    mpCHCVars->setTexture("gInputTex", pRenderData->getTexture("out"));
-    mpCHCVars->setStructuredBuffer("gCHCBuffer", mpCHCBuffer);
+    // Holes of the unfilled reprojection, the readback is a few frames old which the hysteresis tolerates
+    updateHoleStatistics(pContext, pTexture);
+    uint32_t holeCount = mpHoleStatistics->hasResult() ? mpHoleStatistics->getLatestResult().holeCount : 0;
 
-    pContext->setComputeState(mpCHCState);
-    pContext->setComputeVars(mpCHCVars);
+    HoleFillSelector::Measurement measurement;
+    collectFillTiming(pContext, measurement);
+    mLastFillMode = mpHoleFillSelector->selectMode(++mAdaptiveFrameId, holeCount, mSceneTriangleCount, measurement);
 
-    uint32_t w = (pRenderData->getTexture("out")->getWidth() / 16) + 1;
-    uint32_t h = (pRenderData->getTexture("out")->getHeight() / 16) + 1;
-    pContext->dispatch(w, h, 1);
+    mTelemetrySamples.push_back({ "holeFillMode", (float)mLastFillMode });
+
+    // The time of this frame's hole filling carries the decision and its inputs, it arrives a few frames later
+    HoleFillSelector::Measurement tag;
+    tag.mode = mLastFillMode;
+    tag.holeCount = holeCount;
+    tag.triangleCount = mSceneTriangleCount;
+    beginFillTiming(pContext, tag);
+
+    return mLastFillMode == HoleFillSelector::Mode::RayTrace ? Reprojection::RayTrace : Reprojection::ReRaster;
+}
 
-    mpCHCBuffer->getVariable(0, 0, mNumHoles);
-    mNumHolesPercentage = (float)mNumHoles / (pRenderData->getTexture("out")->getWidth() * pRenderData->getTexture("out")->getHeight()) * 100.0f;
+void Reprojection::collectFillTiming(RenderContext * pContext, HoleFillSelector::Measurement& measurement)
+{
+    if (mpFillTimingFence == nullptr) mpFillTimingFence = GpuFence::create();
 
-    if (mbCHCWriteToFile)
+    // The timers of the last frame were submitted with it, the fence passes once the GPU executed them
+    for (FillTiming& timing : mFillTimings)
     {
-        mCHCData[mCHCDataSteps++] = mNumHoles;
-        if (mCHCDataSteps == _PROFILING_LOG_BATCH_SIZE)
+        if (timing.state == FillTiming::State::Recorded)
         {
-            std::ostringstream logOss, fileOss;
-            logOss << "dumping " << "profile_" << "holecount" << "_" << mCHCDataFilesWritten;
-            logInfo(logOss.str());
-            fileOss << "profile_" << "holecount" << "_" << mCHCDataFilesWritten++ << ".txt";
-            std::ofstream out(fileOss.str().c_str());
-            for (int i = 0; i < _PROFILING_LOG_BATCH_SIZE; ++i)
-            {
-                out << mCHCData[i] << "\n";
-            }
-            mCHCDataSteps = 0;
+            timing.fenceValue = mpFillTimingFence->gpuSignal(pContext->getLowLevelData()->getCommandQueue());
+            timing.state = FillTiming::State::Submitted;
         }
     }
+
+    // Oldest finished timing first, the current slot is the oldest one
+    const uint64_t completedValue = mpFillTimingFence->getGpuValue();
+    for (uint32_t i = 0; i < kFillTimingLatency; i++)
+    {
+        FillTiming& timing = mFillTimings[(mCurrentFillTiming + i) % kFillTimingLatency];
+        if (timing.state == FillTiming::State::Submitted && timing.fenceValue <= completedValue)
+        {
+            measurement = timing.measurement;
+            measurement.ms = (float)timing.pTimer->getElapsedTime();
+            timing.state = FillTiming::State::Free;
+            return;
+        }
+    }
+}
+
+void Reprojection::beginFillTiming(RenderContext * pContext, const HoleFillSelector::Measurement& tag)
+{
+    // Rather skip a measurement than wait for the GPU
+    FillTiming& timing = mFillTimings[mCurrentFillTiming];
+    if (timing.state != FillTiming::State::Free) return;
+
+    if (timing.pTimer == nullptr || timing.pTimerContext != pContext)
+    {
+        timing.pTimer = GpuTimer::create();
+        timing.pTimerContext = pContext;
+    }
+    timing.measurement = tag;
+    timing.pTimer->begin();
+    mbFillTimingActive = true;
+}
+
+void Reprojection::endFillTiming()
+{
+    if (!mbFillTimingActive) return;
+
+    FillTiming& timing = mFillTimings[mCurrentFillTiming];
+    timing.pTimer->end();
+    timing.pTimer->resolve();
+    timing.state = FillTiming::State::Recorded;
+    mCurrentFillTiming = (mCurrentFillTiming + 1) % kFillTimingLatency;
+    mbFillTimingActive = false;
+}
+
+void Reprojection::updateHoleStatistics(RenderContext * pContext, const Texture::SharedPtr& pTexture)
+{
+    if (mbHoleStatsRecorded) return;
+    mbHoleStatsRecorded = true;
+
+    if (mpHoleStatistics == nullptr) mpHoleStatistics = HoleStatistics::create();
+    mpHoleStatistics->execute(pContext, pTexture, ++mHoleStatsFrameId);
 }
 
-void Reprojection::initializeCHC()
+void Reprojection::computeHoleCount(RenderContext * pContext, const RenderData * pRenderData)
 {
-    mpCHCProgram = ComputeProgram::createFromFile("HoleCountCompute.slang", "main");
-    mpCHCState = ComputeState::create();
-    mpCHCState->setProgram(mpCHCProgram);
-    mpCHCVars = ComputeVars::create(mpCHCProgram->getReflector());
-    mpCHCBuffer = StructuredBuffer::create(mpCHCProgram, "gCHCBuffer", 1);
+    // The adaptive hole filling already ran the statistics before filling, its counts are shown instead of the remaining holes
+    updateHoleStatistics(pContext, pRenderData->getTexture("out"));
+
+    // Results arrive a few frames later, only new ones are taken over
+    if (!mpHoleStatistics->hasResult() || mpHoleStatistics->getLatestResult().frameId == mLastHoleStatsFrameId) return;
+
+    const HoleStatistics::Result& stats = mpHoleStatistics->getLatestResult();
+    mLastHoleStatsFrameId = stats.frameId;
+    mNumHoles = (int32_t)stats.holeCount;
+    mNumHolesPercentage = stats.holePercentage;
+    mNumHoleRegions = (int32_t)stats.regionCount;
+    mLargestHoleRegion = (int32_t)stats.largestRegionSize;
+
+    mTelemetrySamples.push_back({ "holes", (float)mNumHoles });
+    mTelemetrySamples.push_back({ "holeRegions", (float)mNumHoleRegions });
+    mTelemetrySamples.push_back({ "largestHoleRegion", (float)mLargestHoleRegion });
+}
+
+void Reprojection::runCpuReference(RenderContext * pContext, const RenderData * pRenderData)
+{
+    if (mpCpuReprojection == nullptr) mpCpuReprojection = CpuReprojection::create();
+
+    const auto& pOutTex = pRenderData->getTexture("out");
+    std::vector<uint8> depthData = pContext->readTextureSubresource(pRenderData->getTexture("depth").get(), 0);
+    std::vector<uint8> normalData = pContext->readTextureSubresource(pRenderData->getTexture("gbufferNormal").get(), 0);
+    std::vector<uint8> positionData = pContext->readTextureSubresource(pRenderData->getTexture("gbufferPosition").get(), 0);
+    std::vector<uint8> colorData = pContext->readTextureSubresource(pRenderData->getTexture("leftIn").get(), 0);
+
+    const Camera* pCamera = mpScene->getActiveCamera().get();
+    CpuReprojection::Input input;
+    input.width = pOutTex->getWidth();
+    input.height = pOutTex->getHeight();
+    input.pDepth = reinterpret_cast<const float*>(depthData.data());
+    input.pNormal = reinterpret_cast<const glm::vec4*>(normalData.data());
+    input.pPosition = reinterpret_cast<const glm::vec4*>(positionData.data());
+    input.pColor = reinterpret_cast<const glm::vec4*>(colorData.data());
+    input.leftViewProj = pCamera->getViewProjMatrix();
+    input.rightViewProj = pCamera->getRightEyeViewProjMatrix();
+    input.nearZ = pCamera->getNearPlane();
+    input.farZ = pCamera->getFarPlane();
+    input.camPos = pCamera->getPosition();
+
+    CpuReprojection::Settings settings;
+    settings.quadDivideFactor = mQuadDivideFactor;
+    settings.tessFactor = mTessFactor;
+    settings.hullZThreshold = mHullZThreshold;
+    settings.geoZThreshold = mGeoZThreshold;
+    settings.threshold = mThreshold;
+    settings.useBinocularMetric = mbUseBinocularMetric;
+    settings.useEightNeighbor = mbUseEightNeighbor;
+    settings.useGeoShader = _USEGEOSHADER && mbUseGeoShader;
+    settings.showDisocclusion = mbShowDisocclusion;
+    settings.addHalfPixelOffset = mbAddHalfPixelOffset;
+    settings.clearColor = mClearColor;
+
+    std::ostringstream oss;
+    if (mbRunCpuBenchmark)
+    {
+        CpuReprojection::Stats stats = mpCpuReprojection->benchmark(input, settings, (uint32_t)mCpuBenchmarkIterations);
+        oss << "CPU reprojection benchmark (" << mpCpuReprojection->getThreadCount() << " threads, quad divide " << mQuadDivideFactor
+            << ", tessellation " << mTessFactor << ", geo z threshold " << mGeoZThreshold << "): "
+            << stats.totalMs << " ms (quad levels " << stats.quadLevelMs << ", warp " << stats.warpMs << ", raster " << stats.rasterMs << "), "
+            << stats.mpixPerSec << " MPixel/s";
+    }
+    else
+    {
+        CpuReprojection::Output output;
+        mpCpuReprojection->execute(input, settings, output);
+        std::vector<uint8> gpuData = pContext->readTextureSubresource(pOutTex.get(), 0);
+        mCpuMismatchCount = CpuReprojection::compare(output, reinterpret_cast<const glm::vec4*>(gpuData.data()), 1.f / 255.f);
+
+        HoleStatistics::Result gpuHoles;
+        HoleStatistics::computeReference(reinterpret_cast<const glm::vec4*>(gpuData.data()), input.width, input.height, gpuHoles);
+
+        // Statistics pass on the same image, checked against the reference
+        if (mpValidationHoleStatistics == nullptr) mpValidationHoleStatistics = HoleStatistics::create(1);
+        uint32_t statsMismatchCount = HoleStatistics::compare(gpuHoles, mpValidationHoleStatistics->executeAndWait(pContext, pOutTex, mHoleStatsFrameId));
+
+        // Tiles the compacted ray launch would cover
+        std::vector<uint32_t> cpuTiles, gpuTiles;
+        HoleTileCompaction::Stats cpuTileStats, gpuTileStats;
+        HoleTileCompaction::compactReference(output.color.data(), input.width, input.height, cpuTiles, cpuTileStats);
+        HoleTileCompaction::compactReference(reinterpret_cast<const glm::vec4*>(gpuData.data()), input.width, input.height, gpuTiles, gpuTileStats);
+
+        // Tile list of the compaction pass, the list the tiled ray dispatch consumes
+        std::vector<uint32_t> passTiles;
+        HoleTileCompaction::Stats passTileStats;
+        if (mpValidationHoleTileCompaction == nullptr) mpValidationHoleTileCompaction = HoleTileCompaction::create(1);
+        mpValidationHoleTileCompaction->executeAndReadTiles(pContext, pOutTex, mTileCompactionFrameId, passTiles, passTileStats);
+        uint32_t tileMismatchCount = HoleTileCompaction::compare(gpuTiles, passTiles);
+
+        oss << "CPU reprojection reference: " << output.triangleCount << " triangles, " << output.tessellatedQuadCount << " tessellated quads, "
+            << output.holeCount << " holes (GPU " << gpuHoles.holeCount << " in " << gpuHoles.regionCount << " regions, largest " << gpuHoles.largestRegionSize
+            << ", " << statsMismatchCount << " statistics differ from the statistics pass), "
+            << cpuTileStats.tileCount << " hole tiles (GPU " << gpuTileStats.tileCount << ", " << HoleTileCompaction::compare(cpuTiles, gpuTiles) << " differ, "
+            << tileMismatchCount << " differ from the compaction pass, which counted " << passTileStats.holeCount << " holes), "
+            << mCpuMismatchCount << " pixels differ from GPU (" << mpCpuReprojection->getStats().totalMs << " ms)";
+    }
+    logInfo(oss.str());
+
+    mbRunCpuReference = false;
+    mbRunCpuBenchmark = false;
+}
+
+void Reprojection::benchmarkQuadBounds()
+{
+    QuadBoundsReduction::UniquePtr pReduction = QuadBoundsReduction::create();
+    for (const auto& result : pReduction->benchmark())
+    {
+        std::ostringstream oss;
+        oss << "Quad bounds reduction " << result.width << "x" << result.height << " (" << to_string(result.simdLevel) << "): "
+            << result.ms << " ms, " << result.gbPerSec << " GB/s";
+        logInfo(oss.str());
+    }
+}
+
+void Reprojection::recordTelemetry(Telemetry* pTelemetry)
+{
+    for (const auto& sample : mTelemetrySamples)
+    {
+        pTelemetry->record(sample.first, sample.second);
+    }
 }
 
 void Reprojection::renderUI(Gui * pGui, const char * uiGroup)
@@ -522,10 +710,6 @@ void Reprojection::renderUI(Gui * pGui, const char * uiGroup)
 
 #if _USETRIANGLECOUNTSHADER
     pGui->addIntVar("Number of Grid Triangles", mNumTriangles);
-    if (pGui->addCheckBox("Write To File", mbWriteTriangleCount))
-    {
-        mpMainRenderObject->resetFixedTime();
-    }
 #endif
 
     pGui->addSeparator();
@@ -537,6 +721,11 @@ void Reprojection::renderUI(Gui * pGui, const char * uiGroup)
     {
         mpMainRenderObject->onClickResize();
     }
+    if (mpGridCache != nullptr)
+    {
+        std::string cacheText = "Cached Grids: " + std::to_string(mpGridCache->getGridCount()) + " (" + std::to_string(mpGridCache->getMemoryUsage() / (1024 * 1024)) + " MB)";
+        pGui->addText(cacheText.c_str());
+    }
     pGui->addSeparator();
 
     pGui->addRgbColor("Clear Color", mClearColor);
@@ -590,6 +779,21 @@ void Reprojection::renderUI(Gui * pGui, const char * uiGroup)
         }
     }
 
+    // CPU Reference
+    if (pGui->addButton("Validate On CPU"))
+    {
+        mbRunCpuReference = true;
+    }
+    if (pGui->addButton("Benchmark CPU", true))
+    {
+        mbRunCpuBenchmark = true;
+    }
+    pGui->addIntVar("Benchmark Iterations", mCpuBenchmarkIterations, 1);
+    if (pGui->addButton("Benchmark Quad Bounds"))
+    {
+        benchmarkQuadBounds();
+    }
+
     pGui->addSeparator();
     pGui->addCheckBox("Hole Filling", mbFillHoles);
 
@@ -598,9 +802,55 @@ void Reprojection::renderUI(Gui * pGui, const char * uiGroup)
         Gui::DropdownList holeFillingModeList;
         holeFillingModeList.push_back({ 1, "Ray Trace" });
         holeFillingModeList.push_back({ 2, "Re-Raster" });
+        holeFillingModeList.push_back({ 3, "Adaptive" });
         pGui->addDropdown("Hole Filling Mode", holeFillingModeList, (uint32_t&)mHoleFillingMode);
         switch (mHoleFillingMode)
         {
+        case Reprojection::Adaptive:
+            if (mpHoleFillSelector != nullptr)
+            {
+                const HoleFillSelector::Record* pRecord = mpHoleFillSelector->getLastRecord();
+                pGui->addText(("Current: " + to_string(mpHoleFillSelector->getCurrentMode())).c_str());
+                if (pRecord != nullptr)
+                {
+                    std::ostringstream oss;
+                    oss.precision(3);
+                    oss << "Predicted RT: " << pRecord->predictedMs[0] << " ms, Re-Raster: " << pRecord->predictedMs[1] << " ms";
+                    pGui->addText(oss.str().c_str());
+                }
+            }
+            {
+                bool changed = pGui->addFloatVar("Switch Margin", mHoleFillSettings.switchMargin, 0.f, 1.f);
+                changed |= pGui->addIntVar("Switch Frames", (int32_t&)mHoleFillSettings.switchFrames, 1);
+                changed |= pGui->addIntVar("Exploration Interval", (int32_t&)mHoleFillSettings.explorationInterval, 1);
+                changed |= pGui->addFloatVar("Forgetting Factor", mHoleFillSettings.forgettingFactor, 0.5f, 1.f);
+                if (changed && mpHoleFillSelector != nullptr) mpHoleFillSelector->setSettings(mHoleFillSettings);
+            }
+            if (mpHoleFillSelector != nullptr && pGui->addButton("Save Decision Log"))
+            {
+                mpHoleFillSelector->saveLog("holefill_decisions.csv");
+                logInfo("Hole filling decisions written to holefill_decisions.csv");
+            }
+            if (pGui->addButton("Replay Decision Log", mpHoleFillSelector != nullptr))
+            {
+                std::vector<HoleFillSelector::Record> log;
+                if (HoleFillSelector::loadLog("holefill_decisions.csv", log))
+                {
+                    std::vector<HoleFillSelector::Mode> decisions = HoleFillSelector::replay(log, mHoleFillSettings);
+                    mReplayMatchCount = 0;
+                    for (size_t i = 0; i < log.size(); i++)
+                    {
+                        if (decisions[i] == log[i].decision) mReplayMatchCount++;
+                    }
+                    logInfo("Replayed " + std::to_string(log.size()) + " hole filling decisions, " + std::to_string(mReplayMatchCount) + " match");
+                }
+                else
+                {
+                    logWarning("Could not load holefill_decisions.csv");
+                }
+            }
+            if (mReplayMatchCount >= 0) pGui->addIntVar("Replay Matches", mReplayMatchCount);
+            break;
         case Reprojection::RayTrace:
             if(pGui->addCheckBox("Render Env Map", mbRenderEnvMap))
             {
@@ -616,9 +866,34 @@ void Reprojection::renderUI(Gui * pGui, const char * uiGroup)
                 }
             }
             pGui->addCheckBox("Ray Trace Only", mbRayTraceOnly);
+            pGui->addCheckBox("Tiled Ray Dispatch", mbTiledRayDispatch);
+            if (mbTiledRayDispatch && mpHoleTileCompaction != nullptr && mpHoleTileCompaction->hasStats())
+            {
+                const HoleTileCompaction::Stats& stats = mpHoleTileCompaction->getLatestStats();
+                std::ostringstream oss;
+                oss.precision(3);
+                oss << "Hole Tiles: " << stats.tileCount << " / " << stats.totalTileCount << "\n"
+                    << "Rays: " << stats.holeCount << " traced, " << stats.launchedRayCount << " launched\n"
+                    << "Compaction Ratio: " << stats.compactionRatio * 100.f << " %";
+                pGui->addText(oss.str().c_str());
+            }
             break;
         case Reprojection::ReRaster:
             pGui->addCheckBox("Debug Clear", mbDebugClear);
+            pGui->addText(("Right Eye Only Instances: " + std::to_string(mRightOnlyInstanceCount)).c_str());
+            if (pGui->addCheckBox("Occlusion Culling", mbReRasterOcclusionCulling))
+            {
+                mpReRasterSceneRenderer->toggleOcclusionCulling(mbReRasterOcclusionCulling);
+            }
+            {
+                bool changed = pGui->addCheckBox("Level of Detail", mReRasterLodSettings.enabled);
+                changed |= pGui->addFloatVar("LOD Pixel Error", mReRasterLodSettings.maxPixelError, 0.1f, 16.0f, 0.1f);
+                changed |= pGui->addFloatVar("LOD Periphery Bias", mReRasterLodSettings.peripheryBias, 0.0f, 16.0f, 0.1f);
+                if (changed)
+                {
+                    mpReRasterSceneRenderer->setLodSettings(mReRasterLodSettings);
+                }
+            }
             break;
         default:
             break;
@@ -627,14 +902,12 @@ void Reprojection::renderUI(Gui * pGui, const char * uiGroup)
     else
     {
         pGui->addCheckBox("Compute Hole Count", mbCHCEnable);
-        if (pGui->addCheckBox("Write To File", mbCHCWriteToFile))
-        {
-            mpMainRenderObject->resetFixedTime();
-        }
         if (mbCHCEnable)
         {
             pGui->addIntVar("Number of Holes", mNumHoles);
             pGui->addFloatVar("%", mNumHolesPercentage);
+            pGui->addIntVar("Hole Regions", mNumHoleRegions);
+            pGui->addIntVar("Largest Region", mLargestHoleRegion);
         }
     }
 }
@@ -705,141 +978,32 @@ void Reprojection::setScene(const std::shared_ptr<Scene>& pScene)
         mpSkyBox = nullptr;
     }
 
-    mpReRasterSceneRenderer = SceneRenderer::create(mpScene);
-}
+    // The re-raster pass draws the right eye, so it has to be culled with the right eye frustum
+    mpReRasterSceneRenderer = StereoSceneRenderer::create(mpScene);
+    mpReRasterSceneRenderer->setMultiView(false);
+    mpReRasterSceneRenderer->setEye(1);
+    mpReRasterSceneRenderer->toggleOcclusionCulling(mbReRasterOcclusionCulling);
+    mpReRasterSceneRenderer->setLodSettings(mReRasterLodSettings);
 
-void Reprojection::generateGrid(uint32_t width, uint32_t height)
-{
-    mQuadSizeX = width / mQuadDivideFactor;
-    mQuadSizeY = height / mQuadDivideFactor;
-
-    mpGrid = Model::create();
-
-    uint32_t vertexCount = (mQuadSizeX + 1) * (mQuadSizeY + 1);
-    uint32_t indexCount = mQuadSizeX * mQuadSizeY * 4;
-
-    float qID = -1.f; // Quad ID Counter
-    glm::vec3* vertices = new glm::vec3[vertexCount];
-    glm::vec2* uvs = new glm::vec2[vertexCount];
-    glm::vec1* quadIDs = new glm::vec1[vertexCount];
-    for (uint32_t i = 0, y = mQuadSizeY; y >= 0 && y != 4294967295; y--) {
-        for (uint32_t x = 0; x <= mQuadSizeX; x++, i++) {
-            vertices[i] = glm::vec3((float)x / (float)mQuadSizeX * 2.f - 1, (float)y / (float)mQuadSizeY * 2.f - 1, 0);
-            uvs[i] = glm::vec2((float)x / (float)mQuadSizeX, 1 - (float)y / (float)mQuadSizeY);
-            quadIDs[i] = glm::vec1(qID += 1.f);
-
-            // Move vertex position to pixel center
-            if (mbAddHalfPixelOffset)
-            {
-                vertices[i] += glm::vec3(0.5f / (float)width, -0.5f / (float)height, 0);
-                uvs[i] += glm::vec2(0.5f / (float)width, 0.5f / (float)height);
-            }
+    // Re-raster cost scales with the scene, used by the adaptive hole filling
+    mSceneTriangleCount = 0;
+    if (mpScene != nullptr)
+    {
+        for (uint32_t i = 0; i < mpScene->getModelCount(); i++)
+        {
+            mSceneTriangleCount += mpScene->getModel(i)->getPrimitiveCount() * mpScene->getModelInstanceCount(i);
         }
-        qID -= 1.f; // Jump to next row (here might be a bug)
     }
+    if (mpHoleFillSelector != nullptr) mpHoleFillSelector->reset();
+}
 
-    uint32_t* quads = new uint32_t[indexCount];
-    for (uint32_t qu = 0, vi = 0, y = 0; y < mQuadSizeY; y++, vi++) {
-        for (uint32_t x = 0; x < mQuadSizeX; x++, qu += 4, vi++) {
-            quads[qu + 3] = vi;
-            quads[qu + 2] = vi + 1;
-            quads[qu + 1] = vi + mQuadSizeX + 2;
-            quads[qu] = vi + mQuadSizeX + 1;
-        }
-    }
+void Reprojection::generateGrid(uint32_t width, uint32_t height)
+{
+    if (mpGridCache == nullptr) mpGridCache = GridMeshCache::getShared();
 
-    VertexLayout::SharedPtr pLayout = VertexLayout::create();
-
-    // Vertex Layout
-    VertexBufferLayout::SharedPtr pVbLayout = VertexBufferLayout::create();
-    pVbLayout->addElement(kLayoutData[0].name, 0, kLayoutData[0].format, 1, 0);
-    pLayout->addBufferLayout(0, pVbLayout);
-
-    // UV Layout
-    VertexBufferLayout::SharedPtr pUVbLayout = VertexBufferLayout::create();
-    pUVbLayout->addElement(kLayoutData[3].name, 0, kLayoutData[3].format, 1, 3);
-    pLayout->addBufferLayout(1, pUVbLayout);
-
-    // QuadID Layout
-    VertexBufferLayout::SharedPtr pQuadIDLayout = VertexBufferLayout::create();
-    pQuadIDLayout->addElement(kLayoutData[8].name, 0, kLayoutData[8].format, 1, 10);
-    pLayout->addBufferLayout(2, pQuadIDLayout);
-
-    // Setup index buffer
-    std::vector<uint32_t>* indices = new std::vector<uint32_t>;
-    indices->reserve(indexCount);
-    for (uint32_t i = 0; i < indexCount; i++) {
-        indices->push_back(quads[i]);
-    }
-
-    const uint32_t size = (uint32_t)(sizeof(uint32_t) * indices->size());
-    Buffer::BindFlags bindFlags = Buffer::BindFlags::Index;
-    Buffer::SharedPtr pIndexBuffer = Buffer::create(size, bindFlags, Buffer::CpuAccess::None, indices->data());
-
-    // Setup vertex buffer
-    std::vector<float>* vertexPosBufferData = new std::vector<float>;
-    vertexPosBufferData->reserve(vertexCount * 3);
-    for (uint32_t i = 0; i < vertexCount; i++) {
-        vertexPosBufferData->push_back(vertices[i].x);
-        vertexPosBufferData->push_back(vertices[i].y);
-        vertexPosBufferData->push_back(vertices[i].z);
-    }
-
-    const uint32_t sizeVertexPos = (uint32_t)(sizeof(uint32_t) * vertexPosBufferData->size());
-    Buffer::BindFlags bindFlagsVertexPos = Buffer::BindFlags::Index;
-    Buffer::SharedPtr pVertexBuffer = Buffer::create(sizeVertexPos, bindFlagsVertexPos, Buffer::CpuAccess::None, vertexPosBufferData->data());
-
-    // Setup UV buffer
-    std::vector<float>* uvBufferData = new std::vector<float>;
-    uvBufferData->reserve(vertexCount * 3);
-    for (uint32_t i = 0; i < vertexCount; i++) {
-        uvBufferData->push_back(uvs[i].x);
-        uvBufferData->push_back(uvs[i].y);
-        uvBufferData->push_back(0); // third 0 needed because of comment "//for some reason this is rgb"
-    }
-
-    const uint32_t sizeUVs = (uint32_t)(sizeof(uint32_t) * uvBufferData->size());
-    Buffer::BindFlags bindFlagsUVs = Buffer::BindFlags::Index;
-    Buffer::SharedPtr pUVBuffer = Buffer::create(sizeUVs, bindFlagsUVs, Buffer::CpuAccess::None, uvBufferData->data());
-
-    // Setup QuadID Buffer
-    std::vector<float>* quadIDBufferData = new std::vector<float>;
-    quadIDBufferData->reserve(vertexCount);
-    for (uint32_t i = 0; i < vertexCount; i++) {
-        quadIDBufferData->push_back(quadIDs[i].x);
-    }
-
-    const uint32_t sizeQuadIDs = (uint32_t)(sizeof(uint32_t) * quadIDBufferData->size());
-    Buffer::BindFlags bindFlagsQuadIDs = Buffer::BindFlags::Index;
-    Buffer::SharedPtr pQuadIDBuffer = Buffer::create(sizeQuadIDs, bindFlagsQuadIDs, Buffer::CpuAccess::None, quadIDBufferData->data());
-
-    // Set buffers
-    std::vector<Buffer::SharedPtr> pVBs(3);
-    pVBs[0] = pVertexBuffer;
-    pVBs[1] = pUVBuffer;
-    pVBs[2] = pQuadIDBuffer;
-
-    // Set a bounding box - is not needed -> can be empty at the end
-    BoundingBox* box = new BoundingBox();
-    box->center = glm::vec3(0);
-    box->extent = glm::vec3(50);
-
-    // Create Mesh and set as mesh instance into mpGrid
-    Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIndexBuffer, indexCount, pLayout, Vao::Topology::Quad4Patch, Material::create("Empty"), *box, false);
-    mpGrid->addMeshInstance(pMesh, glm::mat4());
-
-    // Create Scene and SceneRenderer for Grid to render
-    mpGridScene = Scene::create();
-    mpGridScene->addModelInstance(mpGrid, "Grid");
-    mpGridSceneRenderer = SceneRenderer::create(mpGridScene);
-
-    delete[] vertices;
-    delete[] uvs;
-    delete[] quads;
-    delete[] quadIDs;
-    delete indices;
-    delete vertexPosBufferData;
-    delete uvBufferData;
+    mpGrid = mpGridCache->getGrid(width, height, mQuadDivideFactor, mbAddHalfPixelOffset);
+    mQuadSizeX = mpGrid->quadCountX;
+    mQuadSizeY = mpGrid->quadCountY;
 }
 
 void Reprojection::setDefine(std::string pName, bool flag)
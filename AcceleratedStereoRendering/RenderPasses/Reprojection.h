@@ -23,7 +23,14 @@
 #include "../DeferredRenderer.h"
 #include "Lighting.h"
 #include "../RtStaticSceneRenderer.h"
-
+#include "../StereoSceneRenderer.h"
+#include "../CpuReprojection.h"
+#include "../GridMeshCache.h"
+#include "../HoleStatistics.h"
+#include "../HoleFillSelector.h"
+#include "../HoleTileCompaction.h"
+
+#include <array>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -49,12 +56,18 @@ public:
     RenderPassReflection reflect() const override;
     void execute(RenderContext* pContext, const RenderData* pRenderData) override;
     void renderUI(Gui* pGui, const char* uiGroup) override;
+    void recordTelemetry(Telemetry* pTelemetry) override;
     Dictionary getScriptingDictionary() const override;
     void onResize(uint32_t width, uint32_t height) override;
     void setScene(const std::shared_ptr<Scene>& pScene) override;
     bool onMouseEvent(const MouseEvent& mouseEvent) override;
     bool onKeyEvent(const KeyboardEvent& keyEvent) override;
 
+    // Used by the benchmark, a new quad divide factor takes effect with the next onResize()
+    void setHoleFilling(bool enable, bool rayTrace) { mbFillHoles = enable; mHoleFillingMode = rayTrace ? RayTrace : ReRaster; }
+    void setQuadDivideFactor(int32_t factor) { mQuadDivideFactor = factor; }
+    void setTessellationFactor(int32_t factor) { mTessFactor = factor; }
+
     DeferredRenderer* mpMainRenderObject;
     Lighting::SharedPtr mpLightPass;
 
@@ -64,7 +77,7 @@ public:
     static size_t sCameraDataOffset;
 
 private:
-    Reprojection() : RenderPass("Reprojection") {}
+    Reprojection() : RenderPass("Reprojection") { mReRasterLodSettings.peripheryBias = 2.0f; }
 
     enum : uint32_t
     {
@@ -75,7 +88,8 @@ private:
     enum : uint32_t
     {
         RayTrace = 1,
-        ReRaster
+        ReRaster,
+        Adaptive
     } mHoleFillingMode = RayTrace;
 
     void initialize(const RenderData * pRenderData);
@@ -96,18 +110,27 @@ private:
     void updateVariableOffsets(const ProgramReflection* pReflector);
     void setPerFrameData(const GraphicsVars* pVars);
 
+    // Adaptive hole-filling, returns RayTrace or ReRaster
+    uint32_t selectHoleFillMode(RenderContext * pContext, const Texture::SharedPtr& pTexture);
+    void collectFillTiming(RenderContext * pContext, HoleFillSelector::Measurement& measurement);
+    void beginFillTiming(RenderContext * pContext, const HoleFillSelector::Measurement& tag);
+    void endFillTiming();
+
     // Compute Hole Count
+    void updateHoleStatistics(RenderContext * pContext, const Texture::SharedPtr& pTexture);
     void computeHoleCount(RenderContext * pContext, const RenderData * pRenderData);
-    void initializeCHC();
+
+    // CPU Reference (validation and benchmark of the grid warp)
+    void runCpuReference(RenderContext * pContext, const RenderData * pRenderData);
+    void benchmarkQuadBounds();
 
     RtScene::SharedPtr          mpScene;
     SkyBox::SharedPtr           mpSkyBox;
 
     // Reprojection - Grid Warp
     uint32_t                    mQuadSizeX = 0, mQuadSizeY = 0;
-    Model::SharedPtr            mpGrid;
-    Scene::SharedPtr            mpGridScene;
-    SceneRenderer::SharedPtr    mpGridSceneRenderer;
+    GridMeshCache::SharedPtr    mpGridCache;
+    GridMeshCache::Grid::SharedPtr mpGrid;
     Fbo::SharedPtr              mpFbo;
     GraphicsVars::SharedPtr     mpVars;
     GraphicsProgram::SharedPtr  mpProgram;
@@ -133,13 +156,17 @@ private:
     RtProgramVars::SharedPtr mpRtVars;
     RtState::SharedPtr mpRtState;
     RtStaticSceneRenderer::SharedPtr mpRtRenderer;
+    const Texture* mpRtShadowMap = nullptr;   // shadow map the hit-group vars were last applied with
 
     // Re-Raster G-Buffer
-    SceneRenderer::SharedPtr                mpReRasterSceneRenderer;
+    StereoSceneRenderer::SharedPtr          mpReRasterSceneRenderer;
     Fbo::SharedPtr                          mpReRasterFbo;
     GraphicsProgram::SharedPtr              mpReRasterProgram;
     GraphicsVars::SharedPtr                 mpReRasterVars;
     GraphicsState::SharedPtr                mpReRasterGraphicsState;
+    uint32_t                                mRightOnlyInstanceCount = 0;   // mesh instances only the right eye can see
+    bool                                    mbReRasterOcclusionCulling = false;
+    SceneRenderer::LodSettings              mReRasterLodSettings;          // should match the left eye G-buffer, so the filled holes line up with the reprojected geometry
 
     // Re-Raster Lighting
     Fbo::SharedPtr              mpReRasterLightingFbo;
@@ -151,25 +178,56 @@ private:
     // Buffer to count processed triangles
     StructuredBuffer::SharedPtr mpTriangleCountBuffer;
     int32_t mNumTriangles = 0;
-    bool mbWriteTriangleCount = false;
-    int32_t mTriangleCountData[_PROFILING_LOG_BATCH_SIZE];
-    int mTriangleCountDataSteps = 0;
-    int mTriangleCountDataFilesWritten = 0;
 #endif
 
     // Compute Program for Hole Count
-    ComputeProgram::SharedPtr mpCHCProgram;
-    ComputeState::SharedPtr mpCHCState;
-    ComputeVars::SharedPtr mpCHCVars;
-    StructuredBuffer::SharedPtr mpCHCBuffer;
-    bool mbCHCInitialized = false;
+    HoleStatistics::SharedPtr mpHoleStatistics;
+    uint64_t mHoleStatsFrameId = 0;
+    uint64_t mLastHoleStatsFrameId = 0;
+    bool mbHoleStatsRecorded = false;   // the statistics pass already ran this frame
+    std::vector<std::pair<const char*, float>> mTelemetrySamples;   // counters of the last execute(), execute() can run on a worker thread
     bool mbCHCEnable = false;
     int32_t mNumHoles = 0;
     float mNumHolesPercentage = 0.0f;
-    bool mbCHCWriteToFile = false;
-    int32_t mCHCData[_PROFILING_LOG_BATCH_SIZE];
-    int mCHCDataSteps = 0;
-    int mCHCDataFilesWritten = 0;
+    int32_t mNumHoleRegions = 0;
+    int32_t mLargestHoleRegion = 0;
+
+    // Tiled Ray Dispatch
+    HoleTileCompaction::SharedPtr mpHoleTileCompaction;
+    uint64_t mTileCompactionFrameId = 0;
+    bool mbTiledRayDispatch = true;
+
+    // Adaptive Hole Filling
+    struct FillTiming
+    {
+        enum class State { Free, Recorded, Submitted };
+        GpuTimer::SharedPtr pTimer;
+        const RenderContext* pTimerContext = nullptr;   // the timer writes into the command list of this context
+        HoleFillSelector::Measurement measurement;      // mode and inputs of the frame the timer ran in
+        uint64_t fenceValue = 0;
+        State state = State::Free;
+    };
+    static const uint32_t kFillTimingLatency = 3;
+
+    HoleFillSelector::SharedPtr mpHoleFillSelector;
+    HoleFillSelector::Settings mHoleFillSettings;
+    uint64_t mAdaptiveFrameId = 0;
+    HoleFillSelector::Mode mLastFillMode = HoleFillSelector::Mode::RayTrace;
+    std::array<FillTiming, kFillTimingLatency> mFillTimings;
+    uint32_t mCurrentFillTiming = 0;
+    bool mbFillTimingActive = false;
+    GpuFence::SharedPtr mpFillTimingFence;
+    uint32_t mSceneTriangleCount = 0;
+    int32_t mReplayMatchCount = -1;
+
+    // CPU Reference
+    CpuReprojection::SharedPtr mpCpuReprojection;
+    bool mbRunCpuReference = false;
+    bool mbRunCpuBenchmark = false;
+    int32_t mCpuBenchmarkIterations = 10;
+    uint32_t mCpuMismatchCount = 0;
+    HoleStatistics::SharedPtr mpValidationHoleStatistics;
+    HoleTileCompaction::SharedPtr mpValidationHoleTileCompaction;
 
     // Third Person Debug Camera
     Camera::SharedPtr           mpThirdPersonCam = nullptr;
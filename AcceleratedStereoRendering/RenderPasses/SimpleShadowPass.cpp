@@ -43,7 +43,7 @@ SimpleShadowPass::SimpleShadowPass() : RenderPass("SimpleShadowPass")
 RenderPassReflection SimpleShadowPass::reflect() const
 {
     RenderPassReflection r;
-    r.addOutput("depthStencil", "Depth and Stencil from light source").texture2D(mShadowMapSize, mShadowMapSize).format(ResourceFormat::D32Float).bindFlags(Resource::BindFlags::DepthStencil).mipLevels(1);
+    r.addOutput("depthStencil", "Depth and Stencil from light source").texture2D(mShadowMapSize, mShadowMapSize).format(ResourceFormat::D32Float).bindFlags(Resource::BindFlags::DepthStencil).mipLevels(1).flags(RenderPassReflection::Field::Flags::Persistent);
     return r;
 }
 
@@ -73,6 +73,9 @@ void SimpleShadowPass::execute(RenderContext * pContext, const RenderData * pRen
 
     if (mbEnableShadows && mpDirectionalLight != nullptr)
     {
+        // The graph can hand us a different shadow map after a recompilation
+        if (pRenderData->getTexture("depthStencil") != mpFbo->getDepthStencilTexture()) mbShadowMatDirty = true;
+
         if (mbShadowMatDirty)
         {
             mpFbo->attachDepthStencilTarget(pRenderData->getTexture("depthStencil"));
@@ -113,9 +116,26 @@ void SimpleShadowPass::renderUI(Gui * pGui, const char * uiGroup)
         {
             mpMainRenderObject->onClickResize();
         }
+        if (pGui->addCheckBox("Occlusion Culling", mbOcclusionCulling))
+        {
+            mpSceneRenderer->toggleOcclusionCulling(mbOcclusionCulling);
+            mbShadowMatDirty = true;
+        }
+        if (pGui->addFloatVar("LOD Bias", mLodBias, 1.0f, 64.0f))
+        {
+            setLodBias();
+            mbShadowMatDirty = true;
+        }
     }
 }
 
+void SimpleShadowPass::setLodBias()
+{
+    SceneRenderer::LodSettings settings = mpSceneRenderer->getLodSettings();
+    settings.bias = mLodBias;
+    mpSceneRenderer->setLodSettings(settings);
+}
+
 Dictionary SimpleShadowPass::getScriptingDictionary() const
 {
 	return Dictionary();
@@ -131,6 +151,8 @@ void SimpleShadowPass::setScene(const std::shared_ptr<Scene>& pScene)
     mpDirectionalLight = nullptr;
     mpScene = pScene;
     mpSceneRenderer = SceneRenderer::create(mpScene);
+    mpSceneRenderer->toggleOcclusionCulling(mbOcclusionCulling);
+    setLodBias();
     if (mpScene != nullptr && mpScene->getLight(0)->getType() == LightDirectional)
     {
         mpDirectionalLight = std::dynamic_pointer_cast<DirectionalLight>(mpScene->getLight(0));
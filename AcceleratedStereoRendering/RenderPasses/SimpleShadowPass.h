@@ -47,6 +47,7 @@ private:
 
     void createShadowMatrix(const DirectionalLight* pLight, glm::mat4& shadowVP);
     void compareLightDirections();
+    void setLodBias();
 
     GraphicsState::SharedPtr                mpGraphicsState;
     Scene::SharedPtr                        mpScene;
@@ -57,6 +58,8 @@ private:
     float                                   mAABRadiusPadding = 0;
     int32_t                                 mShadowMapSize = 2048;
     bool                                    mbEnableShadows = true;
+    bool                                    mbOcclusionCulling = false;  // objects hidden from the light cast no visible shadow
+    float                                   mLodBias = 4.0f;             // shadow map texels tolerate coarser geometry than the camera view
 
     DirectionalLight::SharedPtr             mpDirectionalLight;
     glm::vec3                               mLastLightDirW;
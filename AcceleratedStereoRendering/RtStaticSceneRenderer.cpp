@@ -56,6 +56,7 @@ void RtStaticSceneRenderer::renderScene(RenderContext * pContext, std::shared_pt
 
     InstanceData data;
     data.currentData.pCamera = pCamera == nullptr ? mpScene->getActiveCamera().get() : pCamera;
+    data.currentData.pTransforms = &mpScene->getTransformTable();
     uint32_t hitCount = pRtVars->getHitProgramsCount();
     if (hitCount)
     {
@@ -154,6 +155,10 @@ void RtStaticSceneRenderer::setHitShaderData(RtProgramVars * pRtVars, InstanceDa
         const Scene::ModelInstance* pModelInstance = mpScene->getModelInstance(data.model, data.modelInstance).get();
         const Mesh* pMesh = pModel->getMesh(data.mesh).get();
         const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(data.mesh, data.meshInstance).get();
+        data.currentData.modelID = data.model;
+        data.currentData.modelInstanceID = data.modelInstance;
+        data.currentData.meshID = data.mesh;
+        data.currentData.meshInstanceID = data.meshInstance;
 
         setPerFrameData(pRtVars, data);
         setPerModelData(data.currentData);
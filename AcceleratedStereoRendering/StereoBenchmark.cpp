@@ -0,0 +1,381 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+
+#include "StereoBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/prettywriter.h"
+
+namespace
+{
+    using JsonWriter = rapidjson::PrettyWriter<rapidjson::StringBuffer>;
+
+    bool parseMode(const std::string& name, StereoBenchmark::Mode& mode)
+    {
+        if (name == "plain") mode = StereoBenchmark::Mode::PlainStereo;
+        else if (name == "rt") mode = StereoBenchmark::Mode::ReprojectionRayTrace;
+        else if (name == "reraster") mode = StereoBenchmark::Mode::ReprojectionReRaster;
+        else return false;
+        return true;
+    }
+
+    std::vector<int32_t> getPositiveInts(const ArgList& args, const std::string& key, int32_t defaultValue)
+    {
+        std::vector<int32_t> values;
+        for (const auto& arg : args.getValues(key))
+        {
+            int32_t value = arg.asInt();
+            if (value > 0)
+            {
+                values.push_back(value);
+            }
+            else
+            {
+                logWarning("StereoBenchmark: ignoring invalid value '" + arg.asString() + "' for -" + key);
+            }
+        }
+        if (values.empty()) values.push_back(defaultValue);
+        return values;
+    }
+
+    void writePercentiles(JsonWriter& writer, const char* key, const StereoBenchmark::Percentiles& p)
+    {
+        writer.Key(key);
+        writer.StartObject();
+        writer.Key("samples"); writer.Uint(p.sampleCount);
+        writer.Key("mean"); writer.Double(p.mean);
+        writer.Key("min"); writer.Double(p.min);
+        writer.Key("p50"); writer.Double(p.p50);
+        writer.Key("p90"); writer.Double(p.p90);
+        writer.Key("p95"); writer.Double(p.p95);
+        writer.Key("p99"); writer.Double(p.p99);
+        writer.Key("max"); writer.Double(p.max);
+        writer.EndObject();
+    }
+}
+
+std::string StereoBenchmark::Config::getName() const
+{
+    switch (mode)
+    {
+    case Mode::PlainStereo:
+        return "plain";
+    case Mode::ReprojectionRayTrace:
+        return "rt_q" + std::to_string(quadDivideFactor) + "_t" + std::to_string(tessFactor);
+    case Mode::ReprojectionReRaster:
+        return "reraster_q" + std::to_string(quadDivideFactor) + "_t" + std::to_string(tessFactor);
+    default:
+        should_not_get_here();
+        return "";
+    }
+}
+
+StereoBenchmark::UniquePtr StereoBenchmark::create(const ArgList& args)
+{
+    if (!args.argExists("benchmark"))
+    {
+        return nullptr;
+    }
+
+    Settings settings;
+    if (args.argExists("scene")) settings.sceneFilename = args["scene"].asString();
+    if (args.argExists("staticcamera")) settings.useCameraPath = false;
+    if (args.argExists("benchstep") && args["benchstep"].asFloat() > 0.f) settings.fixedSpeed = args["benchstep"].asFloat();
+    if (args.argExists("warmup")) settings.warmupFrames = args["warmup"].asUint();
+    if (args.argExists("frames") && args["frames"].asInt() > 0) settings.framesPerCycle = args["frames"].asUint();
+    if (args.argExists("cycles") && args["cycles"].asInt() > 0) settings.cycles = args["cycles"].asUint();
+    if (args.argExists("report")) settings.reportFilename = args["report"].asString();
+    if (args.argExists("baseline")) settings.baselineFilename = args["baseline"].asString();
+    if (args.argExists("tolerance") && args["tolerance"].asFloat() >= 0.f) settings.tolerance = args["tolerance"].asFloat();
+
+    std::vector<Mode> modes;
+    for (const auto& arg : args.getValues("modes"))
+    {
+        Mode mode;
+        if (parseMode(arg.asString(), mode))
+        {
+            if (std::find(modes.begin(), modes.end(), mode) == modes.end()) modes.push_back(mode);
+        }
+        else
+        {
+            logWarning("StereoBenchmark: unknown mode '" + arg.asString() + "', expected plain, rt or reraster");
+        }
+    }
+    if (modes.empty())
+    {
+        modes = { Mode::PlainStereo, Mode::ReprojectionRayTrace, Mode::ReprojectionReRaster };
+    }
+
+    // Plain stereo does not use the grid, so it runs once. The reprojection modes sweep all grid settings.
+    std::vector<int32_t> quadDivideFactors = getPositiveInts(args, "quaddivide", 16);
+    std::vector<int32_t> tessFactors = getPositiveInts(args, "tess", 16);
+    for (Mode mode : modes)
+    {
+        Config config;
+        config.mode = mode;
+        if (mode == Mode::PlainStereo)
+        {
+            settings.configs.push_back(config);
+            continue;
+        }
+
+        for (int32_t quadDivideFactor : quadDivideFactors)
+        {
+            for (int32_t tessFactor : tessFactors)
+            {
+                config.quadDivideFactor = quadDivideFactor;
+                config.tessFactor = tessFactor;
+                settings.configs.push_back(config);
+            }
+        }
+    }
+
+    return create(settings);
+}
+
+StereoBenchmark::UniquePtr StereoBenchmark::create(const Settings& settings)
+{
+    return UniquePtr(new StereoBenchmark(settings));
+}
+
+StereoBenchmark::StereoBenchmark(const Settings& settings) : mSettings(settings)
+{
+    mResults.resize(mSettings.configs.size());
+    for (size_t i = 0; i < mSettings.configs.size(); i++)
+    {
+        mResults[i].config = mSettings.configs[i];
+        mResults[i].frameMs.reserve(mSettings.framesPerCycle * mSettings.cycles);
+        mResults[i].cpuMs.reserve(mSettings.framesPerCycle * mSettings.cycles);
+        mResults[i].gpuMs.reserve(mSettings.framesPerCycle * mSettings.cycles);
+    }
+}
+
+StereoBenchmark::Frame StereoBenchmark::beginFrame()
+{
+    Frame frame;
+    if (mConfigIndex >= mSettings.configs.size())
+    {
+        return frame;
+    }
+
+    const uint32_t measuredFrames = mSettings.framesPerCycle * mSettings.cycles;
+    if (mConfigFrame >= mSettings.warmupFrames + measuredFrames)
+    {
+        mConfigFrame = 0;
+        mConfigIndex++;
+        if (mConfigIndex >= mSettings.configs.size())
+        {
+            return frame;
+        }
+    }
+
+    frame.pConfig = &mSettings.configs[mConfigIndex];
+    frame.configChanged = mConfigFrame == 0;
+    frame.restartCycle = mConfigFrame == 0 ||
+        (mConfigFrame >= mSettings.warmupFrames && (mConfigFrame - mSettings.warmupFrames) % mSettings.framesPerCycle == 0);
+
+    if (frame.configChanged)
+    {
+        logInfo("StereoBenchmark: running " + frame.pConfig->getName() + " (" + std::to_string(mConfigIndex + 1) + "/" + std::to_string(mSettings.configs.size()) + ")");
+    }
+
+    mbFramePending = true;
+    mbFrameRecorded = mConfigFrame >= mSettings.warmupFrames;
+    mConfigFrame++;
+    return frame;
+}
+
+void StereoBenchmark::endFrame(float frameMs, float cpuMs, float gpuMs)
+{
+    if (!mbFramePending)
+    {
+        return;
+    }
+    mbFramePending = false;
+
+    if (mbFrameRecorded)
+    {
+        Result& result = mResults[mConfigIndex];
+        result.frameMs.push_back(frameMs);
+        result.cpuMs.push_back(cpuMs);
+        // Zero if the GPU timer was not resolved yet
+        if (gpuMs > 0.f) result.gpuMs.push_back(gpuMs);
+    }
+
+    // Finish after the last frame of the last configuration was measured
+    const uint32_t measuredFrames = mSettings.framesPerCycle * mSettings.cycles;
+    if (mConfigIndex + 1 == mSettings.configs.size() && mConfigFrame >= mSettings.warmupFrames + measuredFrames)
+    {
+        mConfigIndex++;
+    }
+}
+
+float StereoBenchmark::getProgress() const
+{
+    if (mSettings.configs.empty()) return 1.f;
+    const uint32_t framesPerConfig = mSettings.warmupFrames + mSettings.framesPerCycle * mSettings.cycles;
+    float done = (float)std::min(mConfigIndex, mSettings.configs.size()) * framesPerConfig + (mConfigIndex < mSettings.configs.size() ? mConfigFrame : 0);
+    return done / ((float)mSettings.configs.size() * framesPerConfig);
+}
+
+StereoBenchmark::Percentiles StereoBenchmark::computePercentiles(std::vector<float> samples)
+{
+    Percentiles p;
+    if (samples.empty())
+    {
+        return p;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const size_t n = samples.size();
+    auto rank = [&](float percent)
+    {
+        size_t index = (size_t)std::ceil(percent / 100.f * (float)n);
+        return samples[std::min(std::max(index, (size_t)1), n) - 1];
+    };
+
+    p.sampleCount = (uint32_t)n;
+    p.mean = (float)(std::accumulate(samples.begin(), samples.end(), 0.0) / (double)n);
+    p.min = samples.front();
+    p.p50 = rank(50.f);
+    p.p90 = rank(90.f);
+    p.p95 = rank(95.f);
+    p.p99 = rank(99.f);
+    p.max = samples.back();
+    return p;
+}
+
+bool StereoBenchmark::loadBaseline(const std::string& filename, std::map<std::string, float>& gpuP95)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+
+    rapidjson::Document document;
+    document.Parse(ss.str().c_str());
+    if (document.HasParseError() || !document.IsObject() || !document.HasMember("configs") || !document["configs"].IsArray())
+    {
+        return false;
+    }
+
+    for (const auto& config : document["configs"].GetArray())
+    {
+        if (!config.IsObject() || !config.HasMember("name") || !config.HasMember("gpuMs")) continue;
+        const auto& gpu = config["gpuMs"];
+        if (!gpu.IsObject() || !gpu.HasMember("p95") || !gpu["p95"].IsNumber()) continue;
+        gpuP95[config["name"].GetString()] = (float)gpu["p95"].GetDouble();
+    }
+    return true;
+}
+
+bool StereoBenchmark::writeReport(const Telemetry::Metadata& metadata)
+{
+    // Without its baseline the gate can't pass, the report is still written so the run isn't wasted
+    bool passed = true;
+    std::map<std::string, float> baseline;
+    const bool hasBaseline = !mSettings.baselineFilename.empty();
+    if (hasBaseline && !loadBaseline(mSettings.baselineFilename, baseline))
+    {
+        logError("StereoBenchmark: can't read baseline " + mSettings.baselineFilename, false);
+        passed = false;
+    }
+
+    rapidjson::StringBuffer buffer;
+    JsonWriter writer(buffer);
+    writer.StartObject();
+
+    for (const auto& entry : metadata)
+    {
+        writer.Key(entry.first.c_str());
+        writer.String(entry.second.c_str());
+    }
+    writer.Key("warmupFrames"); writer.Uint(mSettings.warmupFrames);
+    writer.Key("framesPerCycle"); writer.Uint(mSettings.framesPerCycle);
+    writer.Key("cycles"); writer.Uint(mSettings.cycles);
+    writer.Key("fixedSpeed"); writer.Double(mSettings.fixedSpeed);
+    writer.Key("cameraPath"); writer.Bool(mSettings.useCameraPath);
+    if (hasBaseline)
+    {
+        writer.Key("baseline"); writer.String(mSettings.baselineFilename.c_str());
+        writer.Key("tolerance"); writer.Double(mSettings.tolerance);
+        writer.Key("baselineLoaded"); writer.Bool(passed);
+    }
+
+    writer.Key("configs");
+    writer.StartArray();
+    for (Result& result : mResults)
+    {
+        const std::string name = result.config.getName();
+        Percentiles gpu = computePercentiles(result.gpuMs);
+
+        auto it = baseline.find(name);
+        result.hasBaseline = it != baseline.end();
+        result.baselineGpuP95 = result.hasBaseline ? it->second : 0.f;
+        result.regression = result.hasBaseline && gpu.p95 > result.baselineGpuP95 * (1.f + mSettings.tolerance);
+        if (result.regression)
+        {
+            passed = false;
+            logWarning("StereoBenchmark: " + name + " regressed, GPU p95 " + std::to_string(gpu.p95) + " ms vs. baseline " + std::to_string(result.baselineGpuP95) + " ms");
+        }
+
+        writer.StartObject();
+        writer.Key("name"); writer.String(name.c_str());
+        writer.Key("mode"); writer.String(to_string(result.config.mode).c_str());
+        if (result.config.mode != Mode::PlainStereo)
+        {
+            writer.Key("quadDivideFactor"); writer.Int(result.config.quadDivideFactor);
+            writer.Key("tessFactor"); writer.Int(result.config.tessFactor);
+        }
+        writePercentiles(writer, "frameMs", computePercentiles(result.frameMs));
+        writePercentiles(writer, "cpuMs", computePercentiles(result.cpuMs));
+        writePercentiles(writer, "gpuMs", gpu);
+        if (result.hasBaseline)
+        {
+            writer.Key("baselineGpuP95"); writer.Double(result.baselineGpuP95);
+            writer.Key("regression"); writer.Bool(result.regression);
+        }
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.Key("passed"); writer.Bool(passed);
+    writer.EndObject();
+
+    std::ofstream file(mSettings.reportFilename);
+    if (!file.is_open())
+    {
+        logError("StereoBenchmark: can't write report " + mSettings.reportFilename, false);
+        return false;
+    }
+    file << buffer.GetString() << std::endl;
+    logInfo("StereoBenchmark: report written to " + mSettings.reportFilename + (passed ? "" : " (regressions found)"));
+    return passed;
+}
@@ -0,0 +1,149 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+
+#pragma once
+#include "Falcor.h"
+
+#include <map>
+
+using namespace Falcor;
+
+// Deterministic command line benchmark of the stereo configurations.
+// Every configuration runs warmup frames and then a number of fixed timestep cycles along the scene camera path. Frame, CPU and GPU
+// times are reduced to percentiles and written as a JSON report. An optional baseline report turns it into a regression gate, a baseline
+// that can't be read fails the run.
+//
+// Command line (all but -benchmark are optional):
+//   -benchmark -scene <file.fscene> -modes plain rt reraster -quaddivide 8 16 -tess 8 16
+//   -warmup 60 -frames 1000 -cycles 5 -benchstep 1 -staticcamera -report <file.json> -baseline <file.json> -tolerance 0.05
+// -benchstep is the scene time step per frame. It is separate from the sample's own -fixedtimedelta, which keeps its meaning.
+// The scene is imported with the renderer's settings, add -optimizescene to benchmark with occluders, vertex reordering and LODs.
+class StereoBenchmark
+{
+public:
+    using UniquePtr = std::unique_ptr<StereoBenchmark>;
+
+    enum class Mode : uint32_t
+    {
+        PlainStereo = 0,
+        ReprojectionRayTrace,
+        ReprojectionReRaster
+    };
+
+    struct Config
+    {
+        Mode mode = Mode::ReprojectionRayTrace;
+        int32_t quadDivideFactor = 16;      // unused by plain stereo
+        int32_t tessFactor = 16;            // unused by plain stereo
+
+        // Unique key used in the report and to match baseline entries, e.g. "rt_q16_t16"
+        std::string getName() const;
+    };
+
+    struct Settings
+    {
+        std::string sceneFilename;
+        bool useCameraPath = true;
+        float fixedSpeed = 1.0f;            // fixed scene time step per frame
+        std::vector<Config> configs;
+        uint32_t warmupFrames = 60;
+        uint32_t framesPerCycle = _PROFILING_MEASUREMENT_FRAMES;
+        uint32_t cycles = 5;
+        std::string reportFilename = "benchmark_report.json";
+        std::string baselineFilename;
+        float tolerance = 0.05f;            // allowed relative increase of the GPU p95 against the baseline
+    };
+
+    struct Percentiles
+    {
+        uint32_t sampleCount = 0;
+        float mean = 0.f;
+        float min = 0.f;
+        float p50 = 0.f;
+        float p90 = 0.f;
+        float p95 = 0.f;
+        float p99 = 0.f;
+        float max = 0.f;
+    };
+
+    struct Result
+    {
+        Config config;
+        std::vector<float> frameMs;
+        std::vector<float> cpuMs;
+        std::vector<float> gpuMs;
+        bool hasBaseline = false;
+        float baselineGpuP95 = 0.f;
+        bool regression = false;
+    };
+
+    // What the renderer has to do before rendering the current frame
+    struct Frame
+    {
+        const Config* pConfig = nullptr;
+        bool configChanged = false;         // apply pConfig
+        bool restartCycle = false;          // reset the fixed time, so every cycle renders the same frames
+    };
+
+    // Returns nullptr if -benchmark is not on the command line
+    static UniquePtr create(const ArgList& args);
+    static UniquePtr create(const Settings& settings);
+
+    Frame beginFrame();
+
+    // Times of the frame started by the last beginFrame(). The profiler reports the previous frame, so this is called before beginFrame()
+    void endFrame(float frameMs, float cpuMs, float gpuMs);
+
+    bool isFinished() const { return mConfigIndex >= mSettings.configs.size() && !mbFramePending; }
+    float getProgress() const;
+
+    // Writes the JSON report and compares against the baseline. Returns false if a configuration regressed or the report could not be written
+    bool writeReport(const Telemetry::Metadata& metadata);
+
+    const Settings& getSettings() const { return mSettings; }
+    const std::vector<Result>& getResults() const { return mResults; }
+
+    // Nearest-rank percentiles
+    static Percentiles computePercentiles(std::vector<float> samples);
+
+    // Reads the GPU p95 of every configuration of a previous report
+    static bool loadBaseline(const std::string& filename, std::map<std::string, float>& gpuP95);
+
+private:
+    StereoBenchmark(const Settings& settings);
+
+    Settings mSettings;
+    std::vector<Result> mResults;
+    size_t mConfigIndex = 0;
+    uint32_t mConfigFrame = 0;
+    bool mbFramePending = false;
+    bool mbFrameRecorded = false;
+};
+
+inline std::string to_string(StereoBenchmark::Mode mode)
+{
+    switch (mode)
+    {
+    case StereoBenchmark::Mode::PlainStereo: return "PlainStereo";
+    case StereoBenchmark::Mode::ReprojectionRayTrace: return "ReprojectionRayTrace";
+    case StereoBenchmark::Mode::ReprojectionReRaster: return "ReprojectionReRaster";
+    default: should_not_get_here(); return "";
+    }
+}
@@ -0,0 +1,86 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+
+#include "Framework.h"
+#include "StereoSceneRenderer.h"
+
+StereoSceneRenderer::SharedPtr StereoSceneRenderer::create(const Scene::SharedPtr& pScene)
+{
+    return SharedPtr(new StereoSceneRenderer(pScene));
+}
+
+void StereoSceneRenderer::renderScene(RenderContext* pContext, const Camera* pCamera)
+{
+    mDrawCount = 0;
+    mInstanceCount = 0;
+    mCulledInstanceCount = 0;
+    SceneRenderer::renderScene(pContext, pCamera);
+}
+
+void StereoSceneRenderer::cullScene(const CurrentWorkingData& currentData)
+{
+    // The scene keeps the world space boxes and the BVH over them current (only moved instances are refit), so nothing is transformed here.
+    // Whole subtrees are accepted or rejected for both eyes at once, only instances near a frustum border are tested one by one.
+    mCuller.setFrustums(currentData.pCamera->getViewProjMatrix(), currentData.pCamera->getRightEyeViewProjMatrix());
+    mpScene->getMeshInstanceBvh().cull(mCuller, mMasks);
+
+    // Both eyes are tested against one set of rasterized occluders. Instances the left eye only loses to occlusion end up right-only as well.
+    if (mOcclusionCullEnabled)
+    {
+        glm::mat4 viewProj[kViewCount] = { currentData.pCamera->getViewProjMatrix(), currentData.pCamera->getRightEyeViewProjMatrix() };
+        cullOccludedInstances(viewProj, kViewCount, mMasks);
+    }
+
+    mRightOnlyInstances.clear();
+    for (uint32_t i = 0; i < (uint32_t)mMasks.size(); i++)
+    {
+        if (mMasks[i] == StereoFrustumCuller::kVisibleRight)
+        {
+            mRightOnlyInstances.push_back(mpScene->getMeshInstanceRef(i));
+        }
+    }
+}
+
+bool StereoSceneRenderer::cullMeshInstance(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance)
+{
+    uint32_t index = mpScene->getMeshInstanceIndex(currentData.modelID, currentData.modelInstanceID, currentData.meshID, currentData.meshInstanceID);
+    assert(index < mMasks.size());
+    uint8_t mask = mMasks[index];
+
+    // One submission serves both eyes in multi-view mode, so only cull what neither eye can see
+    bool culled = mbMultiView ? (mask == 0) : ((mask & (1 << mEye)) == 0);
+    if (culled) mCulledInstanceCount++;
+    return culled;
+}
+
+void StereoSceneRenderer::executeDraw(const CurrentWorkingData& currentData, uint32_t startIndex, uint32_t indexCount, uint32_t instanceCount)
+{
+    mDrawCount++;
+    mInstanceCount += instanceCount;
+
+    // Instance 2i is mesh instance i seen by the left eye, 2i + 1 the same instance seen by the right eye
+    uint32_t viewCount = mbMultiView ? kViewCount : 1;
+    currentData.pContext->drawIndexedInstanced(indexCount, instanceCount * viewCount, startIndex, 0, 0);
+}
+
+glm::mat4 StereoSceneRenderer::getLodViewProjMatrix(const CurrentWorkingData& currentData) const
+{
+    return (mbMultiView == false && mEye == 1) ? currentData.pCamera->getRightEyeViewProjMatrix() : currentData.pCamera->getViewProjMatrix();
+}
@@ -0,0 +1,80 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+
+#pragma once
+#include "Graphics/Scene/SceneRenderer.h"
+#include "Utils/Math/StereoFrustumCuller.h"
+
+using namespace Falcor;
+
+// Scene renderer for stereo views.
+// Before the scene is traversed, the scene's mesh instance BVH is culled against both eye frustums together (StereoFrustumCuller for
+// the instances of border leaves), optionally followed by occlusion culling for both eyes (see SceneRenderer::toggleOcclusionCulling()).
+// The resulting 2-bit masks decide what gets drawn:
+// - multi-view: instances visible to either eye are drawn with twice the instance count, the vertex shader derives the eye from
+//   SV_InstanceID (see StereoVS.slang, _MULTI_VIEW), so the per-instance transforms are uploaded once and serve both eyes
+// - single view: instances visible to the eye set with setEye() are drawn
+// The level of detail is selected for the left eye in multi-view mode, which is close enough for the right eye, otherwise for the eye set with setEye().
+class StereoSceneRenderer : public SceneRenderer, inherit_shared_from_this<SceneRenderer, StereoSceneRenderer>
+{
+public:
+    using SharedPtr = std::shared_ptr<StereoSceneRenderer>;
+    using SharedConstPtr = std::shared_ptr<const StereoSceneRenderer>;
+
+    static const uint32_t kViewCount = 2;
+
+    static SharedPtr create(const Scene::SharedPtr& pScene);
+
+    using SceneRenderer::renderScene;
+    void renderScene(RenderContext* pContext, const Camera* pCamera) override;
+
+    void setMultiView(bool enable) { mbMultiView = enable; }
+    bool isMultiViewEnabled() const { return mbMultiView; }
+
+    // Eye (0 = left, 1 = right) to cull for if multi-view is disabled
+    void setEye(uint32_t eye) { mEye = eye; }
+
+    // Mesh instances of the last renderScene() call that only the right eye can see (they are always holes in the reprojected image)
+    const std::vector<Scene::MeshInstanceRef>& getRightOnlyInstances() const { return mRightOnlyInstances; }
+
+    // Submission statistics of the last renderScene() call
+    uint32_t getDrawCount() const { return mDrawCount; }
+    uint32_t getInstanceCount() const { return mInstanceCount; }
+    uint32_t getCulledInstanceCount() const { return mCulledInstanceCount; }
+
+protected:
+    StereoSceneRenderer(const Scene::SharedPtr& pScene) : SceneRenderer(pScene) {}
+
+    bool cullMeshInstance(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance) override;
+    void executeDraw(const CurrentWorkingData& currentData, uint32_t startIndex, uint32_t indexCount, uint32_t instanceCount) override;
+    glm::mat4 getLodViewProjMatrix(const CurrentWorkingData& currentData) const override;
+
+    void cullScene(const CurrentWorkingData& currentData) override;
+
+    StereoFrustumCuller mCuller;
+    std::vector<uint8_t> mMasks;
+    std::vector<Scene::MeshInstanceRef> mRightOnlyInstances;
+
+    bool mbMultiView = true;
+    uint32_t mEye = 0;
+    uint32_t mDrawCount = 0;
+    uint32_t mInstanceCount = 0;
+    uint32_t mCulledInstanceCount = 0;
+};
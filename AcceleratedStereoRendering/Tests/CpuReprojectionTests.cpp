@@ -0,0 +1,122 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+
+#include "UnitTest.h"
+#include "../CpuReprojection.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kWidth = 64;
+        const uint32_t kHeight = 32;
+
+        // Constant depth (no disocclusion) and a distinct color per texel
+        void buildLeftEye(std::vector<float>& depth, std::vector<glm::vec4>& color, CpuReprojection::Input& input)
+        {
+            depth.assign(kWidth * kHeight, 0.5f);
+            color.resize(kWidth * kHeight);
+            for (uint32_t y = 0; y < kHeight; y++)
+            {
+                for (uint32_t x = 0; x < kWidth; x++)
+                {
+                    color[y * kWidth + x] = glm::vec4((float)x / kWidth, (float)y / kHeight, 0.25f, 1.f);
+                }
+            }
+
+            input.width = kWidth;
+            input.height = kHeight;
+            input.pDepth = depth.data();
+            input.pColor = color.data();
+            input.leftViewProj = glm::mat4(1.f);
+            input.rightViewProj = glm::mat4(1.f);
+        }
+
+        // Pixel centers sample texel centers exactly without the half pixel offset of the GPU grid
+        CpuReprojection::Settings getSettings()
+        {
+            CpuReprojection::Settings settings;
+            settings.addHalfPixelOffset = false;
+            return settings;
+        }
+    }
+
+    // With identical eyes every texel lands on itself and the untessellated grid leaves no hole
+    CPU_TEST(CpuReprojectionIdentity)
+    {
+        std::vector<float> depth;
+        std::vector<glm::vec4> color;
+        CpuReprojection::Input input;
+        buildLeftEye(depth, color, input);
+
+        CpuReprojection::SharedPtr pReprojection = CpuReprojection::create(2);
+        CpuReprojection::Output output;
+        pReprojection->execute(input, getSettings(), output);
+
+        EXPECT_EQ(output.holeCount, 0u);
+        EXPECT_EQ(output.tessellatedQuadCount, 0u);
+        EXPECT_EQ(output.triangleCount, 2u * (kWidth / 16) * (kHeight / 16));
+        EXPECT_EQ(output.quadLevels.size(), (size_t)(kWidth / 16) * (kHeight / 16));
+        for (uint32_t i = 0; i < kWidth * kHeight; i++)
+        {
+            EXPECT_EQ(output.holeMask[i], 0) << "i = " << i;
+            EXPECT_LE(glm::length(output.color[i] - color[i]), 1e-4f) << "i = " << i;
+        }
+        EXPECT_EQ(CpuReprojection::compare(output, color.data(), 1e-4f), 0u);
+    }
+
+    // Shifting the right eye by a few pixels moves the image and uncovers a band of holes at the left border
+    CPU_TEST(CpuReprojectionShift)
+    {
+        const int32_t shift = 8;
+        std::vector<float> depth;
+        std::vector<glm::vec4> color;
+        CpuReprojection::Input input;
+        buildLeftEye(depth, color, input);
+        input.rightViewProj[3][0] = 2.f * shift / kWidth;
+
+        CpuReprojection::SharedPtr pReprojection = CpuReprojection::create(2);
+        CpuReprojection::Output output;
+        pReprojection->execute(input, getSettings(), output);
+
+        EXPECT_EQ(output.holeCount, shift * kHeight);
+        for (uint32_t y = 0; y < kHeight; y++)
+        {
+            for (int32_t x = 0; x < (int32_t)kWidth; x++)
+            {
+                const uint32_t i = y * kWidth + x;
+                if (x < shift)
+                {
+                    EXPECT_EQ(output.holeMask[i], 1) << "x = " << x << ", y = " << y;
+                    EXPECT_EQ(output.color[i].w, 0.f) << "x = " << x << ", y = " << y;
+                }
+                else
+                {
+                    EXPECT_EQ(output.holeMask[i], 0) << "x = " << x << ", y = " << y;
+                    EXPECT_LE(glm::length(output.color[i] - color[i - shift]), 1e-4f) << "x = " << x << ", y = " << y;
+                }
+            }
+        }
+
+        // The unshifted image matches everywhere but in the holes and the texels that moved
+        EXPECT_EQ(CpuReprojection::compare(output, output.color.data(), 0.f), 0u);
+        EXPECT_EQ(CpuReprojection::compare(output, color.data(), 1e-4f), kWidth * kHeight);
+    }
+}  // namespace Falcor
@@ -0,0 +1,87 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#include "UnitTest.h"
+#include "../HoleStatistics.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        // Image with alpha 0 at the hole pixels and the matching mask with 1 bit per pixel, the layout the statistics pass reads back
+        void buildHoles(uint32_t width, uint32_t height, const std::vector<glm::uvec2>& holes, std::vector<glm::vec4>& color, std::vector<uint32_t>& mask, uint32_t& maskWordsPerRow)
+        {
+            maskWordsPerRow = (width + 31) / 32;
+            color.assign(width * height, glm::vec4(1.f));
+            mask.assign(maskWordsPerRow * height, 0);
+            for (const auto& p : holes)
+            {
+                color[p.y * width + p.x].w = 0.f;
+                mask[p.y * maskWordsPerRow + p.x / 32] |= 1u << (p.x % 32);
+            }
+        }
+    }
+
+    CPU_TEST(HoleStatisticsRegions)
+    {
+        // Two runs of the first row, one crossing a mask word, joined by a run of the second row
+        std::vector<glm::uvec2> holes = { { 30, 0 }, { 31, 0 }, { 32, 0 }, { 33, 0 }, { 36, 0 }, { 33, 1 }, { 34, 1 }, { 35, 1 }, { 36, 1 }, { 10, 3 } };
+        std::vector<glm::vec4> color;
+        std::vector<uint32_t> mask;
+        uint32_t maskWordsPerRow;
+        buildHoles(40, 4, holes, color, mask, maskWordsPerRow);
+
+        HoleStatistics::Result result;
+        HoleStatistics::findRegions(mask.data(), maskWordsPerRow, 40, 4, result);
+        EXPECT_EQ(result.regionCount, 2u);
+        EXPECT_EQ(result.largestRegionSize, 9u);
+        EXPECT(result.largestRegionBounds == glm::uvec4(30, 0, 36, 1));
+    }
+
+    CPU_TEST(HoleStatisticsReference)
+    {
+        // Two L-shaped regions, two pixels which only touch diagonally and a full row
+        std::vector<glm::uvec2> holes = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 5, 2 }, { 6, 2 }, { 6, 3 }, { 3, 0 }, { 4, 1 } };
+        for (uint32_t x = 0; x < 20; x++) holes.push_back(glm::uvec2(x, 5));
+        std::vector<glm::vec4> color;
+        std::vector<uint32_t> mask;
+        uint32_t maskWordsPerRow;
+        buildHoles(20, 6, holes, color, mask, maskWordsPerRow);
+
+        HoleStatistics::Result reference;
+        HoleStatistics::computeReference(color.data(), 20, 6, reference);
+        EXPECT_EQ(reference.holeCount, 28u);
+        EXPECT_EQ(reference.regionCount, 5u);
+        EXPECT_EQ(reference.largestRegionSize, 20u);
+        EXPECT(reference.largestRegionBounds == glm::uvec4(0, 5, 19, 5));
+
+        // 16 pixel tiles: 24 holes in the left tile, 4 in the right one
+        EXPECT_EQ(reference.tileCountX, 2u);
+        EXPECT_EQ(reference.tileCountY, 1u);
+        EXPECT_EQ(reference.tileCounts[0], 24u);
+        EXPECT_EQ(reference.tileCounts[1], 4u);
+        EXPECT_EQ(reference.histogram[1], 1u);
+        EXPECT_EQ(reference.histogram[2], 1u);
+
+        // The run based labeling of the mask finds the same regions as the flood fill
+        HoleStatistics::Result regions = reference;
+        HoleStatistics::findRegions(mask.data(), maskWordsPerRow, 20, 6, regions);
+        EXPECT_EQ(HoleStatistics::compare(reference, regions), 0u);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#include "UnitTest.h"
+#include "../HoleTileCompaction.h"
+
+namespace Falcor
+{
+    CPU_TEST(HoleTileCompactionReference)
+    {
+        // 3x2 tiles, the right column and bottom row are partial
+        const uint32_t width = 20, height = 12;
+        std::vector<glm::vec4> color(width * height, glm::vec4(1.f));
+        std::vector<glm::uvec2> holes = { { 19, 11 }, { 9, 3 }, { 0, 0 }, { 7, 7 } };
+        for (const auto& p : holes) color[p.y * width + p.x].w = 0.f;
+
+        std::vector<uint32_t> tiles;
+        HoleTileCompaction::Stats stats;
+        HoleTileCompaction::compactReference(color.data(), width, height, tiles, stats);
+
+        // Row-major (y << 16) | x, each tile once no matter how many holes it has
+        std::vector<uint32_t> expected = { 0, 1, (1u << 16) | 2 };
+        EXPECT(tiles == expected);
+        EXPECT_EQ(stats.totalTileCount, 6u);
+        EXPECT_EQ(stats.tileCount, 3u);
+        EXPECT_EQ(stats.holeCount, 4u);
+        EXPECT_EQ(stats.launchedRayCount, 3u * HoleTileCompaction::kTileSize * HoleTileCompaction::kTileSize);
+        EXPECT_EQ(stats.compactionRatio, 192.f / 240.f);
+
+        // The GPU list comes in no particular order
+        std::vector<uint32_t> shuffled = { (1u << 16) | 2, 0, 1 };
+        EXPECT_EQ(HoleTileCompaction::compare(expected, shuffled), 0u);
+        shuffled.back() = (1u << 16) | 1;
+        EXPECT_EQ(HoleTileCompaction::compare(expected, shuffled), 2u);
+    }
+}
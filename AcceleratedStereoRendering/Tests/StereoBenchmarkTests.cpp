@@ -0,0 +1,110 @@
+/*
+  Copyrighted(c) 2020, TH Köln.All rights reserved. Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met :
+
+  * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the distribution.
+  * Neither the name of TH Köln nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT OWNER
+  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  Authors: Niko Wissmann
+ */
+
+#include "UnitTest.h"
+#include "../StereoBenchmark.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        const std::string kBaseline =
+            "{\n"
+            "    \"benchmark\": \"StereoBenchmark\",\n"
+            "    \"configs\": [\n"
+            "        { \"name\": \"plain\", \"gpuMs\": { \"sampleCount\": 10, \"p95\": 4.5 } },\n"
+            "        { \"name\": \"rt_q16_t16\", \"gpuMs\": { \"sampleCount\": 10, \"p95\": 2.25 } }\n"
+            "    ],\n"
+            "    \"passed\": true\n"
+            "}\n";
+
+        void writeFile(const std::string& filename, const std::string& content)
+        {
+            std::ofstream file(filename, std::ios::binary);
+            file << content;
+        }
+    }
+
+    CPU_TEST(StereoBenchmarkPercentilesOdd)
+    {
+        StereoBenchmark::Percentiles p = StereoBenchmark::computePercentiles({ 5.f, 1.f, 4.f, 2.f, 3.f });
+        EXPECT_EQ(p.sampleCount, 5u);
+        EXPECT_EQ(p.mean, 3.f);
+        EXPECT_EQ(p.min, 1.f);
+        EXPECT_EQ(p.p50, 3.f);
+        EXPECT_EQ(p.p90, 5.f);
+        EXPECT_EQ(p.p99, 5.f);
+        EXPECT_EQ(p.max, 5.f);
+    }
+
+    CPU_TEST(StereoBenchmarkPercentilesEven)
+    {
+        // Nearest rank, the median of an even count is the lower of the two middle samples
+        StereoBenchmark::Percentiles p = StereoBenchmark::computePercentiles({ 4.f, 1.f, 3.f, 2.f });
+        EXPECT_EQ(p.sampleCount, 4u);
+        EXPECT_EQ(p.mean, 2.5f);
+        EXPECT_EQ(p.p50, 2.f);
+        EXPECT_EQ(p.p90, 4.f);
+
+        std::vector<float> samples;
+        for (uint32_t i = 20; i > 0; i--)
+        {
+            samples.push_back((float)i);
+        }
+        p = StereoBenchmark::computePercentiles(samples);
+        EXPECT_EQ(p.p50, 10.f);
+        EXPECT_EQ(p.p90, 18.f);
+        EXPECT_EQ(p.p95, 19.f);
+        EXPECT_EQ(p.p99, 20.f);
+        EXPECT_EQ(p.max, 20.f);
+    }
+
+    CPU_TEST(StereoBenchmarkPercentilesEmpty)
+    {
+        StereoBenchmark::Percentiles p = StereoBenchmark::computePercentiles({});
+        EXPECT_EQ(p.sampleCount, 0u);
+        EXPECT_EQ(p.mean, 0.f);
+        EXPECT_EQ(p.p95, 0.f);
+        EXPECT_EQ(p.max, 0.f);
+    }
+
+    CPU_TEST(StereoBenchmarkBaseline)
+    {
+        const std::string filename = "stereo_benchmark_baseline_test.json";
+
+        writeFile(filename, kBaseline);
+        std::map<std::string, float> gpuP95;
+        EXPECT(StereoBenchmark::loadBaseline(filename, gpuP95));
+        EXPECT_EQ(gpuP95.size(), 2u);
+        EXPECT_EQ(gpuP95["plain"], 4.5f);
+        EXPECT_EQ(gpuP95["rt_q16_t16"], 2.25f);
+
+        // A report cut off while it was written must fail the run instead of silently comparing against fewer configurations
+        writeFile(filename, kBaseline.substr(0, kBaseline.find("rt_q16_t16")));
+        gpuP95.clear();
+        EXPECT(!StereoBenchmark::loadBaseline(filename, gpuP95));
+        EXPECT(gpuP95.empty());
+
+        std::remove(filename.c_str());
+        EXPECT(!StereoBenchmark::loadBaseline(filename, gpuP95));
+    }
+}
@@ -0,0 +1,152 @@
+"""Loads a telemetry file written by Falcor::Telemetry (binary or CSV), prints per counter statistics and optionally converts it to CSV.
+
+Usage: python LoadTelemetry.py <file> [--csv <output.csv>] [--counters name1,name2]
+"""
+import argparse
+import math
+import struct
+import sys
+
+MAGIC = b'FTLM'
+VERSION = 1
+TAG_COUNTER = 1
+TAG_FRAME = 2
+
+
+class TelemetryLog(object):
+    def __init__(self):
+        self.metadata = []
+        self.counters = []
+        self.frame_ids = []
+        self.columns = []
+
+    def add_counter(self, name):
+        self.counters.append(name)
+        self.columns.append([float('nan')] * len(self.frame_ids))
+        return len(self.counters) - 1
+
+    def add_frame(self, frame_id):
+        self.frame_ids.append(frame_id)
+        for column in self.columns:
+            column.append(float('nan'))
+
+    def column(self, name):
+        return self.columns[self.counters.index(name)]
+
+
+def read_string(data, offset):
+    length, = struct.unpack_from('<I', data, offset)
+    offset += 4
+    return data[offset:offset + length].decode('utf-8'), offset + length
+
+
+def load_binary(data, log):
+    offset = len(MAGIC)
+    version, metadata_count = struct.unpack_from('<II', data, offset)
+    offset += 8
+    if version != VERSION:
+        raise ValueError('unsupported telemetry version %d' % version)
+    for _ in range(metadata_count):
+        key, offset = read_string(data, offset)
+        value, offset = read_string(data, offset)
+        log.metadata.append((key, value))
+
+    while offset < len(data):
+        tag = data[offset]
+        offset += 1
+        if tag == TAG_COUNTER:
+            counter_id, = struct.unpack_from('<I', data, offset)
+            name, offset = read_string(data, offset + 4)
+            if counter_id != len(log.counters):
+                raise ValueError('counter ids out of order')
+            log.add_counter(name)
+        elif tag == TAG_FRAME:
+            frame_id, sample_count = struct.unpack_from('<QI', data, offset)
+            offset += 12
+            log.add_frame(frame_id)
+            for _ in range(sample_count):
+                counter_id, value = struct.unpack_from('<If', data, offset)
+                offset += 8
+                log.columns[counter_id][-1] = value
+        else:
+            raise ValueError('unknown record tag %d at offset %d' % (tag, offset - 1))
+
+
+def load_csv(text, log):
+    column_ids = []
+    for line in text.splitlines():
+        if not line:
+            continue
+        if line.startswith('#'):
+            key, _, value = line[2:].partition('=')
+            log.metadata.append((key, value))
+            continue
+        fields = line.split(',')
+        if fields[0] == 'frame':
+            column_ids = [log.counters.index(name) if name in log.counters else log.add_counter(name) for name in fields[1:]]
+            continue
+        log.add_frame(int(fields[0]))
+        for counter_id, field in zip(column_ids, fields[1:]):
+            if field:
+                log.columns[counter_id][-1] = float(field)
+
+
+def load(filename):
+    log = TelemetryLog()
+    with open(filename, 'rb') as f:
+        data = f.read()
+    if data.startswith(MAGIC):
+        load_binary(data, log)
+    else:
+        load_csv(data.decode('utf-8'), log)
+    return log
+
+
+def save_csv(log, filename):
+    with open(filename, 'w') as f:
+        for key, value in log.metadata:
+            f.write('# %s=%s\n' % (key, value))
+        f.write(','.join(['frame'] + log.counters) + '\n')
+        for i, frame_id in enumerate(log.frame_ids):
+            values = ['' if math.isnan(column[i]) else repr(column[i]) for column in log.columns]
+            f.write(','.join([str(frame_id)] + values) + '\n')
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return float('nan')
+    index = min(len(sorted_values) - 1, int(math.ceil(p / 100.0 * len(sorted_values))) - 1)
+    return sorted_values[max(0, index)]
+
+
+def print_summary(log, counters):
+    for key, value in log.metadata:
+        print('%s: %s' % (key, value))
+    print('%d frames, %d counters' % (len(log.frame_ids), len(log.counters)))
+    print('%-40s %8s %10s %10s %10s %10s %10s %10s' % ('counter', 'samples', 'mean', 'min', 'p50', 'p95', 'p99', 'max'))
+    for name in counters:
+        values = sorted(v for v in log.column(name) if not math.isnan(v))
+        if not values:
+            continue
+        mean = sum(values) / len(values)
+        print('%-40s %8d %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f' % (name, len(values), mean, values[0],
+              percentile(values, 50), percentile(values, 95), percentile(values, 99), values[-1]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Load a Falcor telemetry file')
+    parser.add_argument('filename')
+    parser.add_argument('--csv', help='convert to columnar CSV')
+    parser.add_argument('--counters', help='comma separated counters to summarize (default: all)')
+    args = parser.parse_args()
+
+    log = load(args.filename)
+    counters = args.counters.split(',') if args.counters else log.counters
+    print_summary(log, counters)
+    if args.csv:
+        save_csv(log, args.csv)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -85,6 +85,17 @@ namespace Falcor
         */
         virtual void uavBarrier(const Resource* pResource);
 
+        /** Insert an aliasing barrier. Required before using a placed texture whose memory was used by another texture, see ResourceHeap.
+            \param[in] pBefore The texture that used the memory before, or nullptr for any texture overlapping pAfter
+            \param[in] pAfter The texture that uses the memory next
+        */
+        void aliasingBarrier(const Resource* pBefore, const Resource* pAfter);
+
+        /** Mark the contents of a render-target or depth-stencil texture as undefined.
+            This initializes a placed texture after an aliasing barrier, in case the next pass doesn't clear it.
+        */
+        void discardResource(const Texture* pTexture);
+
         /** Copy an entire resource
         */
         void copyResource(const Resource* pDst, const Resource* pSrc);
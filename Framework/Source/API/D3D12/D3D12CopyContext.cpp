@@ -180,7 +180,7 @@ namespace Falcor
 
         //Get buffer data
         std::vector<uint8> result;
-        uint32_t actualRowSize = footprint.Footprint.Width * getFormatBytesPerBlock(mTextureFormat);
+        uint32_t actualRowSize = (footprint.Footprint.Width / getFormatWidthCompressionRatio(mTextureFormat)) * getFormatBytesPerBlock(mTextureFormat);
         result.resize(mRowCount * actualRowSize);
         uint8* pData = reinterpret_cast<uint8*>(mpBuffer->map(Buffer::MapType::Read));
 
@@ -274,6 +274,27 @@ namespace Falcor
         mCommandsPending = true;
     }
 
+    void CopyContext::aliasingBarrier(const Resource* pBefore, const Resource* pAfter)
+    {
+        D3D12_RESOURCE_BARRIER barrier;
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+        barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier.Aliasing.pResourceBefore = pBefore ? pBefore->getApiHandle().GetInterfacePtr() : nullptr;
+        barrier.Aliasing.pResourceAfter = pAfter->getApiHandle();
+        mpLowLevelData->getCommandList()->ResourceBarrier(1, &barrier);
+        mCommandsPending = true;
+    }
+
+    void CopyContext::discardResource(const Texture* pTexture)
+    {
+        // Discarding requires the texture to be bound for output
+        bool isDepth = is_set(pTexture->getBindFlags(), Resource::BindFlags::DepthStencil);
+        assert(isDepth || is_set(pTexture->getBindFlags(), Resource::BindFlags::RenderTarget));
+        resourceBarrier(pTexture, isDepth ? Resource::State::DepthStencil : Resource::State::RenderTarget);
+        mpLowLevelData->getCommandList()->DiscardResource(pTexture->getApiHandle(), nullptr);
+        mCommandsPending = true;
+    }
+
     void CopyContext::copyResource(const Resource* pDst, const Resource* pSrc)
     {
         resourceBarrier(pDst, Resource::State::CopyDest);
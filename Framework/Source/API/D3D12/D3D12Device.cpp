@@ -185,8 +185,19 @@ namespace Falcor
     {
         Device::SupportedFeatures supported = Device::SupportedFeatures::None;
 
+        D3D12_FEATURE_DATA_D3D12_OPTIONS features;
+        HRESULT hr = pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &features, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS));
+        if (FAILED(hr) || features.VPAndRTArrayIndexFromAnyShaderFeedingRasterizerSupportedWithoutGSEmulation == FALSE)
+        {
+            logInfo("Render target array index from the vertex shader is not supported on this device.");
+        }
+        else
+        {
+            supported |= Device::SupportedFeatures::RenderTargetArrayIndexFromVertexShader;
+        }
+
         D3D12_FEATURE_DATA_D3D12_OPTIONS2 features2;
-        HRESULT hr = pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS2, &features2, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS2));
+        hr = pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS2, &features2, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS2));
         if (FAILED(hr) || features2.ProgrammableSamplePositionsTier == D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_NOT_SUPPORTED)
         {
             logInfo("Programmable sample positions is not supported on this device.");
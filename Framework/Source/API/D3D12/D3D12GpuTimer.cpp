@@ -42,9 +42,13 @@ namespace Falcor
         mpLowLevelData->getCommandList()->EndQuery(mpHeap, D3D12_QUERY_TYPE_TIMESTAMP, mEnd);
     }
 
-    void GpuTimer::apiResolve(uint64_t result[2])
+    void GpuTimer::apiResolve()
     {
         mpLowLevelData->getCommandList()->ResolveQueryData(mpHeap, D3D12_QUERY_TYPE_TIMESTAMP, mStart, 2, mpResolveBuffer->getApiHandle(), 0);
+    }
+
+    void GpuTimer::apiReadResult(uint64_t result[2])
+    {
         uint64_t* pRes = (uint64*)mpResolveBuffer->map(Buffer::MapType::Read);
         result[0] = pRes[0];
         result[1] = pRes[1];
@@ -97,33 +97,45 @@ namespace Falcor
         }
     }
 
-    void Texture::apinit(const void* pData, bool autoGenMips)
+    static D3D12_RESOURCE_DESC getResourceDesc(Texture::Type type, uint32_t width, uint32_t height, uint32_t depth, uint32_t arraySize, uint32_t mipLevels, ResourceFormat format, uint32_t sampleCount, Texture::BindFlags bindFlags)
     {
         D3D12_RESOURCE_DESC desc = {};
 
-        desc.MipLevels = mMipLevels;
-        desc.Format = getDxgiFormat(mFormat);
-        desc.Width = align_to(getFormatWidthCompressionRatio(mFormat), mWidth);
-        desc.Height = align_to(getFormatHeightCompressionRatio(mFormat), mHeight);
-        desc.Flags = getD3D12ResourceFlags(mBindFlags);
-        desc.SampleDesc.Count = mSampleCount;
+        desc.MipLevels = mipLevels;
+        desc.Format = getDxgiFormat(format);
+        desc.Width = align_to(getFormatWidthCompressionRatio(format), width);
+        desc.Height = align_to(getFormatHeightCompressionRatio(format), height);
+        desc.Flags = getD3D12ResourceFlags(bindFlags);
+        desc.SampleDesc.Count = sampleCount;
         desc.SampleDesc.Quality = 0;
-        desc.Dimension = getResourceDimension(mType);
+        desc.Dimension = getResourceDimension(type);
         desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
         desc.Alignment = 0;
 
-        if (mType == Texture::Type::TextureCube)
+        if (type == Texture::Type::TextureCube)
         {
-            desc.DepthOrArraySize = mArraySize * 6;
+            desc.DepthOrArraySize = arraySize * 6;
         }
-        else if (mType == Texture::Type::Texture3D)
+        else if (type == Texture::Type::Texture3D)
         {
-            desc.DepthOrArraySize = mDepth;
+            desc.DepthOrArraySize = depth;
         }
         else
         {
-            desc.DepthOrArraySize = mArraySize;
+            desc.DepthOrArraySize = arraySize;
+        }
+
+        //If depth and either ua or sr, set to typeless
+        if (isDepthFormat(format) && is_set(bindFlags, Texture::BindFlags::ShaderResource | Texture::BindFlags::UnorderedAccess))
+        {
+            desc.Format = getTypelessFormatFromDepthFormat(format);
         }
+        return desc;
+    }
+
+    void Texture::apinit(const void* pData, bool autoGenMips)
+    {
+        D3D12_RESOURCE_DESC desc = getResourceDesc(mType, mWidth, mHeight, mDepth, mArraySize, mMipLevels, mFormat, mSampleCount, mBindFlags);
 
         D3D12_CLEAR_VALUE clearValue = {};
         D3D12_CLEAR_VALUE* pClearVal = nullptr;
@@ -137,14 +149,20 @@ namespace Falcor
             pClearVal = &clearValue;
         }
 
-        //If depth and either ua or sr, set to typeless
+        // Typeless depth textures have no optimized clear value
         if (isDepthFormat(mFormat) && is_set(mBindFlags, Texture::BindFlags::ShaderResource | Texture::BindFlags::UnorderedAccess))
         {
-            desc.Format = getTypelessFormatFromDepthFormat(mFormat);
             pClearVal = nullptr;
         }
 
-        d3d_call(gpDevice->getApiHandle()->CreateCommittedResource(&kDefaultHeapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, pClearVal, IID_PPV_ARGS(&mApiHandle)));
+        if (mpHeap)
+        {
+            d3d_call(gpDevice->getApiHandle()->CreatePlacedResource(mpHeap->getApiHandle(), mHeapOffset, &desc, D3D12_RESOURCE_STATE_COMMON, pClearVal, IID_PPV_ARGS(&mApiHandle)));
+        }
+        else
+        {
+            d3d_call(gpDevice->getApiHandle()->CreateCommittedResource(&kDefaultHeapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, pClearVal, IID_PPV_ARGS(&mApiHandle)));
+        }
 
         if (pData)
         {
@@ -152,6 +170,21 @@ namespace Falcor
         }
     }
 
+    ResourceHeap::AllocationInfo Texture::getPlacementInfo(Type type, uint32_t width, uint32_t height, uint32_t depth, ResourceFormat format, uint32_t sampleCount, BindFlags bindFlags)
+    {
+        D3D12_RESOURCE_DESC desc = getResourceDesc(type, width, height, depth, 1, 1, format, sampleCount, bindFlags);
+        D3D12_RESOURCE_ALLOCATION_INFO d3dInfo = gpDevice->getApiHandle()->GetResourceAllocationInfo(0, 1, &desc);
+
+        ResourceHeap::AllocationInfo info;
+        // An invalid description reports a size of UINT64_MAX
+        if (d3dInfo.SizeInBytes != UINT64_MAX)
+        {
+            info.size = d3dInfo.SizeInBytes;
+            info.alignment = d3dInfo.Alignment;
+        }
+        return info;
+    }
+
     Texture::~Texture()
     {
         gpDevice->releaseResource(mApiHandle);
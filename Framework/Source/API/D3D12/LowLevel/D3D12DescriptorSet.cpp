@@ -63,6 +63,7 @@ namespace Falcor
         }
 
         D3D12DescriptorHeap* pHeap = getHeap(mpPool.get(), falcorType);
+        std::lock_guard<std::recursive_mutex> lock(mpPool->mMutex);
         mpApiData->pAllocation = pHeap->allocateDescriptors(count);
         if (mpApiData->pAllocation == false)
         {
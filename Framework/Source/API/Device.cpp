@@ -31,6 +31,8 @@
 
 namespace Falcor
 {
+    static thread_local RenderContext* spThreadRenderContext = nullptr;
+
     Device::SharedPtr Device::create(Window::SharedPtr& pWindow, const Device::Desc& desc)
     {
         if (gpDevice)
@@ -133,6 +135,16 @@ namespace Falcor
         return mpSwapChainFbos[mCurrentBackBufferIndex];
     }
 
+    RenderContext* Device::getRenderContext() const
+    {
+        return spThreadRenderContext ? spThreadRenderContext : mpRenderContext.get();
+    }
+
+    void Device::setThreadRenderContext(RenderContext* pContext)
+    {
+        spThreadRenderContext = pContext;
+    }
+
     void Device::releaseResource(ApiObjectHandle pResource)
     {
         if (pResource)
@@ -140,6 +152,7 @@ namespace Falcor
             // Some static objects get here when the application exits
             if(this)
             {
+                std::lock_guard<std::mutex> lock(mReleaseMutex);
                 mDeferredReleases.push({ mpFrameFence->getCpuValue(), pResource });
             }
         }
@@ -154,9 +167,12 @@ namespace Falcor
     {
         mpResourceAllocator->executeDeferredReleases();
         uint64_t gpuVal = mpFrameFence->getGpuValue();
-        while (mDeferredReleases.size() && mDeferredReleases.front().frameID <= gpuVal)
         {
-            mDeferredReleases.pop();
+            std::lock_guard<std::mutex> lock(mReleaseMutex);
+            while (mDeferredReleases.size() && mDeferredReleases.front().frameID <= gpuVal)
+            {
+                mDeferredReleases.pop();
+            }
         }
         mpCpuDescPool->executeDeferredReleases();
         mpGpuDescPool->executeDeferredReleases();
@@ -33,6 +33,7 @@
 #include "API/LowLevel/DescriptorPool.h"
 #include "API/LowLevel/ResourceAllocator.h"
 #include "API/QueryHeap.h"
+#include <mutex>
 
 namespace Falcor
 {
@@ -79,7 +80,8 @@ namespace Falcor
             None = 0x0,
             ProgrammableSamplePositionsPartialOnly = 0x1, // On D3D12, this means tier 1 support. Allows one sample position to be set.
             ProgrammableSamplePositionsFull = 0x2,        // On D3D12, this means tier 2 support. Allows up to 4 sample positions to be set.
-            Raytracing = 0x4                              // On D3D12, DirectX Raytracing is supported. It is up to the user to not use raytracing functions when not supported.
+            Raytracing = 0x4,                             // On D3D12, DirectX Raytracing is supported. It is up to the user to not use raytracing functions when not supported.
+            RenderTargetArrayIndexFromVertexShader = 0x8  // SV_RenderTargetArrayIndex and SV_ViewportArrayIndex can be written by the vertex shader without a geometry shader.
         };
 
         /** Create a new device.
@@ -114,8 +116,14 @@ namespace Falcor
 
         /** Get the default render-context.
             The default render-context is managed completely by the device. The user should just queue commands into it, the device will take care of allocation, submission and synchronization
+            Returns the context set with setThreadRenderContext() instead if the calling thread has one.
         */
-        RenderContext* getRenderContext() const { return mpRenderContext.get(); }
+        RenderContext* getRenderContext() const;
+
+        /** Redirect getRenderContext() on the calling thread, nullptr restores the default render-context.
+            Used while recording render graph passes on worker threads, so implicit work like buffer uploads goes into the command list of the pass instead of the shared default context.
+        */
+        static void setThreadRenderContext(RenderContext* pContext);
 
         /** Get the command queue handle
         */
@@ -176,6 +184,7 @@ namespace Falcor
             ApiObjectHandle pApiObject;
         };
         std::queue<ResourceRelease> mDeferredReleases;
+        std::mutex mReleaseMutex;
 
         uint32_t mCurrentBackBufferIndex;
         std::vector<Fbo::SharedPtr> mpSwapChainFbos;
@@ -64,7 +64,7 @@ namespace Falcor
             return;
         }
 
-        if (mStatus == Status::End)
+        if (mStatus == Status::End || mStatus == Status::Resolved)
         {
             logWarning("GpuTimer::begin() was followed by a call to GpuTimer::end() without querying the data first. The previous results will be discarded.");
         }
@@ -91,10 +91,11 @@ namespace Falcor
             logWarning("GpuTimer::getElapsedTime() was called but the GpuTimer::end() wasn't called. No data to fetch.");
             return 0;
         }
-        else if (mStatus == Status::End)
+        else if (mStatus == Status::End || mStatus == Status::Resolved)
         {
+            if (mStatus == Status::End) apiResolve();
             uint64_t result[2];
-            apiResolve(result);
+            apiReadResult(result);
 
             double start = (double)result[0];
             double end = (double)result[1];
@@ -105,4 +106,15 @@ namespace Falcor
         assert(mStatus == Status::Idle);
         return mElapsedTime;
     }
+
+    void GpuTimer::resolve()
+    {
+        if (mStatus != Status::End)
+        {
+            logWarning("GpuTimer::resolve() was called but the GpuTimer::end() wasn't called. Ignoring call.");
+            return;
+        }
+        apiResolve();
+        mStatus = Status::Resolved;
+    }
 }
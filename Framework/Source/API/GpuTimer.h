@@ -65,12 +65,18 @@ namespace Falcor
         */
         double getElapsedTime();
 
+        /** Record the copy of the query results right after end() without reading them. \n
+            Once the GPU executed the copy (e.g. checked with a fence), getElapsedTime() returns the time of this Begin()/End() pair without waiting.
+        */
+        void resolve();
+
     private:
         GpuTimer();
         enum Status
         {
             Begin,
             End,
+            Resolved,
             Idle
         } mStatus = Idle;
 
@@ -81,7 +87,8 @@ namespace Falcor
         double mElapsedTime;
         void apiBegin();
         void apiEnd();
-        void apiResolve(uint64_t result[2]);
+        void apiResolve();
+        void apiReadResult(uint64_t result[2]);
 
 #ifdef FALCOR_D3D12
         Buffer::SharedPtr mpResolveBuffer; // Yes, I know it's against my policy to put API specific code in common headers, but it's not worth the complications
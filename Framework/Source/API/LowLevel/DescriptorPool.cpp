@@ -42,6 +42,7 @@ namespace Falcor
 
     void DescriptorPool::executeDeferredReleases()
     {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
         uint64_t gpuVal = mpFence->getGpuValue();
         while (mpDeferredReleases.size() && mpDeferredReleases.top().fenceValue <= gpuVal)
         {
@@ -51,6 +52,7 @@ namespace Falcor
 
     void DescriptorPool::releaseAllocation(std::shared_ptr<DescriptorSetApiData> pData)
     {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
         DeferredRelease d;
         d.pData = pData;
         d.fenceValue = mpFence->getCpuValue();
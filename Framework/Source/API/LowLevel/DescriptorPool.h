@@ -30,6 +30,7 @@
 #include <queue>
 #include "API/LowLevel/GpuFence.h"
 #include <functional>
+#include <mutex>
 
 namespace Falcor
 {
@@ -112,5 +113,9 @@ namespace Falcor
         };
 
         std::priority_queue<DeferredRelease, std::vector<DeferredRelease>, std::greater<DeferredRelease>> mpDeferredReleases;
+
+        // Guards the heaps and the deferred releases. Descriptor sets are created and released by render graph passes recorded on worker threads.
+        // Recursive, since a failed allocation executes the deferred releases and tries again.
+        std::recursive_mutex mMutex;
     };
 }
@@ -69,6 +69,7 @@ namespace Falcor
 
     ResourceAllocator::AllocationData ResourceAllocator::allocate(size_t size, size_t alignment)
     {
+        std::lock_guard<std::mutex> lock(mMutex);
         AllocationData data;
         if (size > mPageSize)
         {
@@ -100,11 +101,13 @@ namespace Falcor
     void ResourceAllocator::release(AllocationData& data)
     {
         assert(data.pResourceHandle);
+        std::lock_guard<std::mutex> lock(mMutex);
         mDeferredReleases.push(data);
     }
 
     void ResourceAllocator::executeDeferredReleases()
     {
+        std::lock_guard<std::mutex> lock(mMutex);
         uint64_t gpuVal = mpFence->getGpuValue();
         while (mDeferredReleases.size() && mDeferredReleases.top().fenceValue <= gpuVal)
         {
@@ -28,6 +28,7 @@
 #pragma once
 #include <unordered_map>
 #include <queue>
+#include <mutex>
 #include "GpuFence.h"
 
 namespace Falcor
@@ -80,6 +81,9 @@ namespace Falcor
         std::unordered_map<size_t, PageData::UniquePtr> mUsedPages;
         std::queue<PageData::UniquePtr> mAvailablePages;
 
+        // Render graph passes can be recorded on worker threads, all of them allocate from the device allocator
+        std::mutex mMutex;
+
         void allocateNewPage();
         static void initBasePageData(BaseData& data, size_t size);
     };
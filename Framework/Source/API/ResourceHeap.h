@@ -0,0 +1,81 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/Resource.h"
+
+namespace Falcor
+{
+    /** A block of GPU memory which textures can be placed in, see Texture::createPlaced().
+        Textures placed at overlapping ranges of a heap alias each other, only one of them holds valid data at a time. Before switching to another
+        texture, call CopyContext::aliasingBarrier() and initialize the texture with a clear, a copy or CopyContext::discardResource().
+    */
+    class ResourceHeap : public std::enable_shared_from_this<ResourceHeap>
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ResourceHeap>;
+        using ApiHandle = ResourceHeapHandle;
+
+        /** The kind of textures a heap holds. Not all GPUs can mix render-target and depth-stencil textures with other textures in one heap.
+        */
+        enum class Type
+        {
+            RenderTargets,  ///< Textures with the RenderTarget or DepthStencil bind flag
+            Textures,       ///< All other textures
+        };
+
+        struct AllocationInfo
+        {
+            uint64_t size = 0;          ///< Bytes a texture needs in a heap, 0 if it can't be placed
+            uint64_t alignment = 0;     ///< Required alignment of the texture offset
+        };
+
+        /** Create a heap
+            \return A new heap, or nullptr if the API doesn't support placed resources or the allocation failed
+        */
+        static SharedPtr create(Type type, uint64_t size);
+
+        /** Get the heap type textures with the given bind flags need
+        */
+        static Type getHeapType(Resource::BindFlags bindFlags)
+        {
+            return is_set(bindFlags, Resource::BindFlags::RenderTarget | Resource::BindFlags::DepthStencil) ? Type::RenderTargets : Type::Textures;
+        }
+
+        ~ResourceHeap();
+
+        const ApiHandle& getApiHandle() const { return mApiHandle; }
+        Type getType() const { return mType; }
+        uint64_t getSize() const { return mSize; }
+
+    private:
+        ResourceHeap(Type type, uint64_t size) : mType(type), mSize(size) {}
+        ApiHandle mApiHandle;
+        Type mType;
+        uint64_t mSize;
+    };
+}
@@ -113,6 +113,17 @@ namespace Falcor
         return pTexture->mApiHandle ? pTexture : nullptr;
     }
 
+    Texture::SharedPtr Texture::createPlaced(const ResourceHeap::SharedPtr& pHeap, uint64_t offset, Type type, uint32_t width, uint32_t height, uint32_t depth, ResourceFormat format, uint32_t sampleCount, BindFlags bindFlags)
+    {
+        assert(pHeap && offset < pHeap->getSize());
+        assert(type != Type::TextureCube && (type == Type::Texture2DMultisample || sampleCount == 1));
+        Texture::SharedPtr pTexture = SharedPtr(new Texture(width, height, depth, 1, 1, sampleCount, format, type, bindFlags));
+        pTexture->mpHeap = pHeap;
+        pTexture->mHeapOffset = offset;
+        pTexture->apinit(nullptr, false);
+        return pTexture->mApiHandle ? pTexture : nullptr;
+    }
+
     Texture::Texture(uint32_t width, uint32_t height, uint32_t depth, uint32_t arraySize, uint32_t mipLevels, uint32_t sampleCount, ResourceFormat format, Type type, BindFlags bindFlags)
         : Resource(type, bindFlags), mWidth(width), mHeight(height), mDepth(depth), mMipLevels(mipLevels), mSampleCount(sampleCount), mArraySize(arraySize), mFormat(format)
     {
@@ -29,6 +29,7 @@
 #include <map>
 #include "API/Formats.h"
 #include "Resource.h"
+#include "ResourceHeap.h"
 #include "Utils/Bitmap.h"
 
 namespace Falcor
@@ -153,6 +154,23 @@ namespace Falcor
         */
 
         static SharedPtr create2DMS(uint32_t width, uint32_t height, ResourceFormat format, uint32_t sampleCount, uint32_t arraySize = 1, BindFlags bindFlags = BindFlags::ShaderResource);
+
+        /** Get the memory a texture needs in a resource heap. The parameters match createPlaced().
+            \return The size and alignment of the texture, or a size of 0 if the API doesn't support placed textures
+        */
+        static ResourceHeap::AllocationInfo getPlacementInfo(Type type, uint32_t width, uint32_t height, uint32_t depth, ResourceFormat format, uint32_t sampleCount, BindFlags bindFlags);
+
+        /** Create a texture in a resource heap. Placed textures have a single mip-level and array-slice and no initial data.
+            Textures placed at overlapping ranges alias each other, see ResourceHeap.
+            \param[in] pHeap The heap. The texture keeps a reference to it.
+            \param[in] offset Offset into the heap, a multiple of the alignment returned by getPlacementInfo()
+            \return A pointer to a new texture, or nullptr if creation failed
+        */
+        static SharedPtr createPlaced(const ResourceHeap::SharedPtr& pHeap, uint64_t offset, Type type, uint32_t width, uint32_t height, uint32_t depth, ResourceFormat format, uint32_t sampleCount, BindFlags bindFlags);
+
+        /** Get the heap the texture was placed in, or nullptr if the texture has its own memory
+        */
+        const ResourceHeap::SharedPtr& getHeap() const { return mpHeap; }
         
         /** Capture the texture to an image file.
             \param[in] mipLevel Requested mip-level
@@ -198,5 +216,7 @@ namespace Falcor
         ResourceFormat mFormat = ResourceFormat::Unknown;
         bool mIsSparse = false;
         glm::i32vec3 mSparsePageRes = glm::i32vec3(0);
+        ResourceHeap::SharedPtr mpHeap;
+        uint64_t mHeapOffset = 0;
     };
 }
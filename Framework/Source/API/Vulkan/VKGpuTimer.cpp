@@ -42,7 +42,12 @@ namespace Falcor
         vkCmdWriteTimestamp(mpLowLevelData->getCommandList(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, mpHeap, mEnd);
     }
 
-    void GpuTimer::apiResolve(uint64_t result[2])
+    void GpuTimer::apiResolve()
+    {
+        // The results are read directly from the query pool
+    }
+
+    void GpuTimer::apiReadResult(uint64_t result[2])
     {
         vk_call(vkGetQueryPoolResults(gpDevice->getApiHandle(), mpHeap, mStart, 2, sizeof(uint64_t) * 2, result, sizeof(result[0]), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
     }
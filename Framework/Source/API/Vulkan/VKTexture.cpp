@@ -176,4 +176,10 @@ namespace Falcor
             uploadInitData(pData, autoGenMips);
         }
     }
+
+    ResourceHeap::AllocationInfo Texture::getPlacementInfo(Type type, uint32_t width, uint32_t height, uint32_t depth, ResourceFormat format, uint32_t sampleCount, BindFlags bindFlags)
+    {
+        // ResourceHeap is not implemented for Vulkan
+        return ResourceHeap::AllocationInfo();
+    }
 }
@@ -48,6 +48,10 @@ namespace Falcor
             const Scene::ModelInstance* pModelInstance = mpScene->getModelInstance(data.model, data.modelInstance).get();
             const Mesh* pMesh = pModel->getMesh(data.mesh).get();
             const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(data.mesh, data.meshInstance).get();
+            data.currentData.modelID = data.model;
+            data.currentData.modelInstanceID = data.modelInstance;
+            data.currentData.meshID = data.mesh;
+            data.currentData.meshInstanceID = data.meshInstance;
 
             setPerFrameData(pRtVars, data);
             setPerModelData(data.currentData);
@@ -164,6 +168,7 @@ namespace Falcor
     {
         InstanceData data;
         data.currentData.pCamera = pCamera == nullptr ? mpScene->getActiveCamera().get() : pCamera;
+        data.currentData.pTransforms = &mpScene->getTransformTable();
         uint32_t hitCount = pRtVars->getHitProgramsCount();
         if (hitCount)
         {   
@@ -28,8 +28,11 @@
 #include "Framework.h"
 #include "RenderGraph.h"
 #include "API/FBO.h"
+#include "API/Device.h"
 #include "Utils/DirectedGraphTraversal.h"
 #include "Utils/Gui.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/Telemetry.h"
 #include "Graphics/Scene/Scene.h"
 #include "Experimental/RenderGraph/RenderPassLibrary.h"
 #include "Experimental/RenderPasses/ResolvePass.h"
@@ -78,6 +81,7 @@ namespace Falcor
         {
             it.second.pPass->setScene(pScene);
         }
+        mSerialExecution = true;
     }
 
     uint32_t RenderGraph::addPass(const RenderPass::SharedPtr& pPass, const std::string& passName, PassFlags passFlags)
@@ -448,9 +452,100 @@ namespace Falcor
             }
         }
 
+        // Sort by dependency level, so passes which can be recorded at the same time are next to each other. The order stays topological.
+        // The resource lifetimes are based on this order, so they hold for the order the levels are submitted in as well. Within a level, passes
+        // whose transients share memory end up in the same recording group, see buildRecordingLevels().
+        std::vector<uint32_t> levels = getDependencyLevels();
+        std::vector<std::pair<uint32_t, uint32_t>> sorted;
+        for (size_t i = 0; i < mExecutionList.size(); i++) sorted.push_back({ levels[i], mExecutionList[i] });
+        std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) { return a.first < b.first; });
+        for (size_t i = 0; i < sorted.size(); i++) mExecutionList[i] = sorted[i].second;
+
         return true;
     }
 
+    std::vector<uint32_t> RenderGraph::getDependencyLevels() const
+    {
+        // A pass is one level after the last pass it depends on. The execution list is in topological order, so those were visited before.
+        std::unordered_map<uint32_t, uint32_t> nodeLevels;
+        std::vector<uint32_t> levels(mExecutionList.size(), 0);
+        for (size_t i = 0; i < mExecutionList.size(); i++)
+        {
+            const DirectedGraph::Node* pNode = mpGraph->getNode(mExecutionList[i]);
+            for (uint32_t e = 0; e < pNode->getIncomingEdgeCount(); e++)
+            {
+                const auto& it = nodeLevels.find(mpGraph->getEdge(pNode->getIncomingEdge(e))->getSourceNode());
+                if (it != nodeLevels.end()) levels[i] = std::max(levels[i], it->second + 1);
+            }
+            nodeLevels[mExecutionList[i]] = levels[i];
+        }
+        return levels;
+    }
+
+    void RenderGraph::buildRecordingLevels()
+    {
+        mRecordingLevels.clear();
+        mExecutionLevels = getDependencyLevels();
+
+        std::unordered_map<const Resource*, size_t> resourceGroups;
+        for (uint32_t i = 0; i < (uint32_t)mExecutionList.size(); i++)
+        {
+            if (i == 0 || mExecutionLevels[i] != mExecutionLevels[i - 1])
+            {
+                mRecordingLevels.emplace_back();
+                resourceGroups.clear();
+            }
+            auto& groups = mRecordingLevels.back();
+
+            const NodeData& node = mNodeData.at(mExecutionList[i]);
+            RenderPassReflection reflection = node.pPass->reflect();
+            std::vector<const Resource*> resources;
+            for (size_t f = 0; f < reflection.getFieldCount(); f++)
+            {
+                const Resource* pResource = mpResourcesCache->getResource(node.nodeName + '.' + reflection.getField(f).getName()).get();
+                if (pResource) resources.push_back(pResource);
+            }
+
+            // Join the groups of all passes sharing a resource or the memory of an aliased transient with this one. A group records its passes
+            // in execution order into one context, which is the order the aliasing barriers and lifetimes were computed for.
+            std::vector<const Resource*> shared = resources;
+            for (const Resource* pResource : resources)
+            {
+                const auto& aliases = mpResourcesCache->getAliasedResources(pResource);
+                shared.insert(shared.end(), aliases.begin(), aliases.end());
+            }
+
+            size_t group = groups.size();
+            for (const Resource* pResource : shared)
+            {
+                const auto& it = resourceGroups.find(pResource);
+                if (it == resourceGroups.end() || it->second == group) continue;
+                if (group == groups.size())
+                {
+                    group = it->second;
+                    continue;
+                }
+
+                size_t merged = it->second;
+                groups[group].insert(groups[group].end(), groups[merged].begin(), groups[merged].end());
+                std::sort(groups[group].begin(), groups[group].end());
+                groups[merged].clear();
+                for (auto& r : resourceGroups) if (r.second == merged) r.second = group;
+            }
+
+            if (group == groups.size()) groups.emplace_back();
+            groups[group].push_back(i);
+            for (const Resource* pResource : resources) resourceGroups[pResource] = group;
+        }
+
+        // Groups don't share memory, the submission order only has to be deterministic. Flush them in the order of their first pass.
+        for (auto& groups : mRecordingLevels)
+        {
+            groups.erase(std::remove_if(groups.begin(), groups.end(), [](const std::vector<uint32_t>& g) { return g.empty(); }), groups.end());
+            std::sort(groups.begin(), groups.end(), [](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) { return a.front() < b.front(); });
+        }
+    }
+
     bool RenderGraph::insertAutoPasses()
     {
         bool addedPasses = false;
@@ -559,7 +654,7 @@ namespace Falcor
         return outputs;
     }
 
-    bool RenderGraph::resolveResourceTypes()
+    bool RenderGraph::resolveResourceTypes(const ResourceCache* pPrevious)
     {
         // Build list to look up execution order index from the pass
         std::unordered_map<RenderPass*, uint32_t> passToIndex;
@@ -625,31 +720,142 @@ namespace Falcor
                 const auto& pSrcPass = mNodeData[pEdge->getSourceNode()].pPass;
                 auto srcReflection = pSrcPass->reflect();
                 assert(passToIndex.count(pSrcPass.get()) > 0);
-                mpResourcesCache->registerField(dstFieldName, dstField, passToIndex[pSrcPass.get()], srcFieldName);
+                mpResourcesCache->registerField(dstFieldName, dstField, uint32_t(i), srcFieldName);
             }
         }
 
-        mpResourcesCache->allocateResources(mSwapChainData);
+        mpResourcesCache->allocateResources(mSwapChainData, pPrevious);
         return true;
     }
 
+    static std::string getFieldKey(const RenderPassReflection::Field& field)
+    {
+        return field.getName() + ':' + std::to_string((uint32_t)field.getVisibility()) + ',' + std::to_string((uint32_t)field.getFlags()) + ',' +
+            std::to_string((uint32_t)field.getType()) + ',' + std::to_string(field.getWidth()) + ',' + std::to_string(field.getHeight()) + ',' +
+            std::to_string(field.getDepth()) + ',' + std::to_string(field.getSampleCount()) + ',' + std::to_string(field.getArraySize()) + ',' +
+            std::to_string(field.getMipLevels()) + ',' + std::to_string((uint32_t)field.getFormat()) + ',' + std::to_string((uint32_t)field.getBindFlags()) + ';';
+    }
+
+    std::string RenderGraph::getCompilationKey() const
+    {
+        std::string key = std::to_string(mSwapChainData.width) + 'x' + std::to_string(mSwapChainData.height) + ',' + std::to_string((uint32_t)mSwapChainData.format) +
+            (mResourceAliasing ? ",aliased\n" : "\n");
+
+        for (uint32_t i = 0; i < mpGraph->getCurrentNodeId(); i++)
+        {
+            const auto& nodeIt = mNodeData.find(i);
+            if (mpGraph->doesNodeExist(i) == false || nodeIt == mNodeData.end()) continue;
+
+            const NodeData& node = nodeIt->second;
+            key += std::to_string(i) + ' ' + node.nodeName + ' ' + std::to_string((uintptr_t)node.pPass.get()) + ' ' + std::to_string((uint32_t)node.passFlags) + ' ';
+            RenderPassReflection reflection = node.pPass->reflect();
+            for (size_t f = 0; f < reflection.getFieldCount(); f++) key += getFieldKey(reflection.getField(f));
+            key += '\n';
+        }
+
+        for (uint32_t e = 0; e < mpGraph->getCurrentEdgeId(); e++)
+        {
+            if (mpGraph->doesEdgeExist(e) == false) continue;
+            const DirectedGraph::Edge* pEdge = mpGraph->getEdge(e);
+            const EdgeData& edgeData = mEdgeData.at(e);
+            key += std::to_string(pEdge->getSourceNode()) + '.' + edgeData.srcField + '>' + std::to_string(pEdge->getDestNode()) + '.' + edgeData.dstField + '\n';
+        }
+
+        // The order the outputs were marked in doesn't matter
+        std::vector<std::string> outputs;
+        for (const auto& o : mOutputs) outputs.push_back(std::to_string(o.nodeId) + '.' + o.field);
+        std::sort(outputs.begin(), outputs.end());
+        for (const auto& o : outputs) key += o + '\n';
+
+        return key;
+    }
+
+    bool RenderGraph::restoreCompiledVariant(const std::string& key)
+    {
+        for (auto it = mCompiledVariants.begin(); it != mCompiledVariants.end(); it++)
+        {
+            if (it->key == key)
+            {
+                mExecutionList = it->executionList;
+                mpResourcesCache = it->pResourcesCache;
+                mCompiledKey = key;
+                mCompiledVariants.splice(mCompiledVariants.begin(), mCompiledVariants, it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void RenderGraph::storeCompiledVariant(const std::string& key)
+    {
+        // Versions for other back-buffer sizes are only left behind by resizing, don't keep their resources alive
+        const auto& params = mSwapChainData;
+        mCompiledVariants.remove_if([&params](const CompiledVariant& v) { return v.swapChainData.width != params.width || v.swapChainData.height != params.height || v.swapChainData.format != params.format; });
+
+        if (mCompiledVariantCacheSize == 0) return;
+        mCompiledVariants.push_front({ key, mSwapChainData, mExecutionList, mpResourcesCache });
+        while (mCompiledVariants.size() > mCompiledVariantCacheSize) mCompiledVariants.pop_back();
+    }
+
+    void RenderGraph::clearCompiledVariants()
+    {
+        mCompiledVariants.clear();
+        mCompiledKey.clear();
+        mpResourcesCache->reset();
+        mRecompile = true;
+    }
+
+    void RenderGraph::setCompiledVariantCacheSize(uint32_t count)
+    {
+        mCompiledVariantCacheSize = count;
+        while (mCompiledVariants.size() > mCompiledVariantCacheSize) mCompiledVariants.pop_back();
+    }
+
     bool RenderGraph::compile(std::string& log)
     {
         if (mRecompile)
         {
-            mpResourcesCache->reset();
             restoreCompilationChanges();
 
-            if (resolveExecutionOrder() == false) return false;
-            // If passes were added, resolve execution order again
-            if (insertAutoPasses()) if (resolveExecutionOrder() == false) return false;
-            if (resolveResourceTypes() == false) return false;
-            if (isValid(log) == false) return false;
+            // Edits and passes request a recompilation without knowing if anything changed, so compare against the state the graph was compiled for
+            std::string key = getCompilationKey();
+            if (key != mCompiledKey && restoreCompiledVariant(key) == false)
+            {
+                // Resources which didn't change are taken over from the previous compilation
+                ResourceCache::SharedPtr pPrevious = mpResourcesCache;
+                mpResourcesCache = ResourceCache::create();
+                mpResourcesCache->setAliasingEnabled(mResourceAliasing);
+                for (const auto& input : pPrevious->getExternalInputs()) mpResourcesCache->registerExternalInput(input.first, input.second);
+                mCompiledKey.clear();
+
+                if (resolveExecutionOrder() == false) return false;
+                // If passes were added, resolve execution order again
+                bool addedPasses = insertAutoPasses();
+                if (addedPasses) if (resolveExecutionOrder() == false) return false;
+                if (resolveResourceTypes(pPrevious.get()) == false) return false;
+                if (isValid(log) == false) return false;
+
+                // The auto-generated passes are part of the graph and removed on the next compilation, such versions can't be restored
+                if (addedPasses == false)
+                {
+                    mCompiledKey = key;
+                    storeCompiledVariant(key);
+                }
+            }
+            buildRecordingLevels();
+            mSerialExecution = true;
         }
         mRecompile = false;
         return true;
     }
 
+    void RenderGraph::setResourceAliasing(bool enabled)
+    {
+        if (mResourceAliasing == enabled) return;
+        mResourceAliasing = enabled;
+        mRecompile = true;
+    }
+
     void RenderGraph::execute(RenderContext* pContext)
     {
         bool profile = mProfileGraph && gProfileEnabled;
@@ -663,17 +869,84 @@ namespace Falcor
             return;
         }
 
-        for (const auto& node : mExecutionList)
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        mPassTimings.resize(mExecutionList.size());
+        if (mParallelRecording && mSerialExecution == false)
         {
-            if (profile) Profiler::startEvent(mNodeData[node].nodeName);
-            RenderData renderData(mNodeData[node].nodeName, mpResourcesCache, mpPassDictionary);
-            mNodeData[node].pPass->execute(pContext, &renderData);
-            if (profile) Profiler::endEvent(mNodeData[node].nodeName);
+            executeParallel(pContext);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < (uint32_t)mExecutionList.size(); i++)
+            {
+                const std::string& nodeName = mNodeData[mExecutionList[i]].nodeName;
+                if (profile) Profiler::startEvent(nodeName);
+                executePass(pContext, i);
+                if (profile) Profiler::endEvent(nodeName);
+            }
+            mSerialExecution = false;
+        }
+        mRecordingTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+        // The telemetry sink takes samples from one thread only
+        if (Telemetry* pTelemetry = Telemetry::getActive())
+        {
+            for (uint32_t nodeIndex : mExecutionList) mNodeData[nodeIndex].pPass->recordTelemetry(pTelemetry);
         }
 
         if (profile) Profiler::endEvent("RenderGraph::execute()");
     }
 
+    void RenderGraph::executePass(RenderContext* pContext, uint32_t index)
+    {
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        const NodeData& node = mNodeData.at(mExecutionList[index]);
+        mpResourcesCache->prepareResources(pContext, index);
+        RenderData renderData(node.nodeName, mpResourcesCache, mpPassDictionary);
+        node.pPass->execute(pContext, &renderData);
+
+        PassTiming& timing = mPassTimings[index];
+        timing.passName = node.nodeName;
+        timing.level = mExecutionLevels[index];
+        timing.recordingTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    }
+
+    void RenderGraph::executeParallel(RenderContext* pContext)
+    {
+        if (mpRecordingPool == nullptr) mpRecordingPool = WorkStealingPool::getShared();
+        if (mpScene) mpScene->prepareForParallelAccess(pContext);
+
+        // The passes are submitted on their own, the commands recorded so far have to execute before them
+        pContext->flush();
+
+        for (const auto& groups : mRecordingLevels)
+        {
+            while (mRecordingContexts.size() < groups.size())
+            {
+                RenderContext::SharedPtr pGroupContext = RenderContext::create(gpDevice->getCommandQueueHandle(LowLevelContextData::CommandQueueType::Direct, 0));
+                pGroupContext->bindDescriptorHeaps();
+                mRecordingContexts.push_back(pGroupContext);
+            }
+
+            mpRecordingPool->parallelFor((uint32_t)groups.size(), 1, [&](uint32_t begin, uint32_t end)
+            {
+                Profiler::setThreadSuspended(true);
+                for (uint32_t g = begin; g < end; g++)
+                {
+                    // Implicit uploads of the passes go into the group's command list as well
+                    RenderContext* pGroupContext = mRecordingContexts[g].get();
+                    Device::setThreadRenderContext(pGroupContext);
+                    for (uint32_t index : groups[g]) executePass(pGroupContext, index);
+                }
+                Device::setThreadRenderContext(nullptr);
+                Profiler::setThreadSuspended(false);
+            });
+
+            // All contexts use the same queue, submitting the levels in order keeps the dependencies between them
+            for (size_t g = 0; g < groups.size(); g++) mRecordingContexts[g]->flush();
+        }
+    }
+
     void RenderGraph::update(const SharedPtr& pGraph)
     {
         // fill in missing passes from referenced graph
@@ -743,6 +1016,7 @@ namespace Falcor
         RenderPass* pPass = getRenderPassAndNamePair<true>(this, name, "RenderGraph::setInput()", strPair);
         if (pPass == nullptr) return false;
         mpResourcesCache->registerExternalInput(name, pResource);
+        for (auto& variant : mCompiledVariants) variant.pResourcesCache->registerExternalInput(name, pResource);
         return true;
     }
 
@@ -990,6 +1264,8 @@ namespace Falcor
 
             pGui->addCheckBox("Profile Passes", mProfileGraph);
             pGui->addTooltip("Profile the render-passes. The results will be shown in the profiler window. If you can't see it, click 'P'");
+            pGui->addCheckBox("Parallel Recording", mParallelRecording);
+            pGui->addTooltip("Record passes which don't depend on each other on worker threads. Passes recorded in parallel don't show up in the profiler window");
 
             for (const auto& passId : mExecutionList)
             {
@@ -29,6 +29,8 @@
 #include "RenderPass.h"
 #include "Utils/DirectedGraph.h"
 #include "ResourceCache.h"
+#include "Utils/WorkStealingPool.h"
+#include <list>
 
 namespace Falcor
 {
@@ -171,6 +173,60 @@ namespace Falcor
         */
         void profileGraph(bool enabled) { mProfileGraph = enabled; }
 
+        /** Enable/disable recording the passes on worker threads.
+            Passes which don't depend on each other, directly or through other passes, are recorded in parallel into command lists of their own, which are submitted in dependency order.
+            Passes sharing a resource are recorded one after the other on the same thread, since resource states are tracked globally.
+            The first execution after a compilation or a scene change is recorded serially, so views, state objects and other data created on first use don't have to be thread-safe.
+            Passes must not change shared objects like the scene or the passes dictionary while recording. Profiler events of the passes are ignored, see getPassTimings() instead.
+            Objects passes share are only read while recording, so lazily updated state has to be clean before. Before every parallel execution, Scene::prepareForParallelAccess()
+            updates the scene data, the active camera and the material parameter blocks. The parameter blocks include their constant buffers and descriptor sets, see the list there.
+            Anything else a pass reads lazily from a shared object, e.g. a camera other than the active one, has to be brought up to date by whoever changes it.
+        */
+        void setParallelRecording(bool enabled) { mParallelRecording = enabled; }
+
+        /** Check if the passes are recorded on worker threads
+        */
+        bool isParallelRecordingEnabled() const { return mParallelRecording; }
+
+        /** CPU time spent recording a pass
+        */
+        struct PassTiming
+        {
+            std::string passName;
+            uint32_t level = 0;             ///< Dependency level. Passes of the same level can be recorded at the same time.
+            float recordingTime = 0;        ///< Milliseconds
+        };
+
+        /** Get the recording times of the passes during the last execution, in execution order
+        */
+        const std::vector<PassTiming>& getPassTimings() const { return mPassTimings; }
+
+        /** Get the CPU time in milliseconds spent recording all passes during the last execution
+        */
+        float getRecordingTime() const { return mRecordingTime; }
+
+        /** Enable/disable memory aliasing of the transient resources. Disabled by default. Triggers a recompilation.
+        */
+        void setResourceAliasing(bool enabled);
+
+        /** Check if memory aliasing of the transient resources is enabled
+        */
+        bool isResourceAliasingEnabled() const { return mResourceAliasing; }
+
+        /** Set how many compiled versions of the graph are kept. When the graph returns to a state it was compiled for, for example when an output is marked again,
+            the execution order and resources of that version are reused without recompiling. Only versions for the current back-buffer size are kept.
+            Every version keeps its resources alive, 0 disables the cache.
+        */
+        void setCompiledVariantCacheSize(uint32_t count);
+
+        /** Get the number of compiled versions of the graph which are kept
+        */
+        uint32_t getCompiledVariantCount() const { return (uint32_t)mCompiledVariants.size(); }
+
+        /** Get the memory used by the graph resources at the last compilation
+        */
+        const ResourceCache::MemoryStats& getResourceMemoryStats() const { return mpResourcesCache->getMemoryStats(); }
+
         /** Mouse event handler.
             Returns true if the event was handled by the object, false otherwise
         */
@@ -203,7 +259,15 @@ namespace Falcor
         bool compile(std::string& log);
         bool resolveExecutionOrder();
         bool insertAutoPasses();
-        bool resolveResourceTypes();
+        bool resolveResourceTypes(const ResourceCache* pPrevious);
+        std::string getCompilationKey() const;
+        bool restoreCompiledVariant(const std::string& key);
+        void storeCompiledVariant(const std::string& key);
+        void clearCompiledVariants();
+        std::vector<uint32_t> getDependencyLevels() const;
+        void buildRecordingLevels();
+        void executePass(RenderContext* pContext, uint32_t index);
+        void executeParallel(RenderContext* pContext);
         
         struct EdgeData
         {
@@ -257,6 +321,19 @@ namespace Falcor
 
         std::vector<uint32_t> mExecutionList;
         ResourceCache::SharedPtr mpResourcesCache;
+        bool mResourceAliasing = false;
+
+        // Compiled versions of the graph, most recently used first. The key describes everything the compilation depends on.
+        struct CompiledVariant
+        {
+            std::string key;
+            ResourceCache::DefaultProperties swapChainData;
+            std::vector<uint32_t> executionList;
+            ResourceCache::SharedPtr pResourcesCache;
+        };
+        std::list<CompiledVariant> mCompiledVariants;
+        std::string mCompiledKey;
+        uint32_t mCompiledVariantCacheSize = 4;
 
         // TODO Better way to track history, or avoid changing the original graph altogether?
         struct {
@@ -266,6 +343,16 @@ namespace Falcor
 
         bool mProfileGraph = true;
         Dictionary::SharedPtr mpPassDictionary;
+
+        // Passes grouped by dependency level. Every group holds indices into mExecutionList which are recorded one after the other on the same thread.
+        std::vector<std::vector<std::vector<uint32_t>>> mRecordingLevels;
+        std::vector<uint32_t> mExecutionLevels;
+        std::vector<RenderContext::SharedPtr> mRecordingContexts;   // One per group of a level, reused by every level
+        WorkStealingPool::SharedPtr mpRecordingPool;
+        bool mParallelRecording = false;
+        bool mSerialExecution = true;   // Set after compilations and scene changes
+        std::vector<PassTiming> mPassTimings;
+        float mRecordingTime = 0;
     };
 
     dlldecl std::vector<RenderGraph*> gRenderGraphs;
@@ -36,6 +36,7 @@ namespace Falcor
     class Texture;
     class RenderContext;
     class ResourceCache;
+    class Telemetry;
 
     class RenderData
     {
@@ -65,6 +66,12 @@ namespace Falcor
         */
         virtual void execute(RenderContext* pRenderContext, const RenderData* pData) = 0;
 
+        /** Record the statistics of the last execute() call into a telemetry sink.
+            Called by the graph on its own thread after all passes executed. execute() may run on a worker thread when the graph records in parallel,
+            so passes keep their statistics in members and record them here.
+        */
+        virtual void recordTelemetry(Telemetry* pTelemetry) {}
+
         /** Get a dictionary that can be used to reconstruct the object
         */
         virtual Dictionary getScriptingDictionary() const { return {}; }
@@ -264,7 +264,7 @@ namespace Falcor
                     {
                         passesToReplace.push_back({ pGraph, passDesc.first, node.first });
                         node.second.pPass = nullptr;
-                        pGraph->mpResourcesCache->reset();
+                        pGraph->clearCompiledVariants();
                     }
                 }
             }
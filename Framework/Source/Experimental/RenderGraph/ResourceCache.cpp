@@ -27,6 +27,9 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "ResourceCache.h"
+#include "TransientHeapAllocator.h"
+#include "API/RenderContext.h"
+#include <algorithm>
 
 namespace Falcor
 {
@@ -39,6 +42,18 @@ namespace Falcor
     {
         mNameToIndex.clear();
         mResourceData.clear();
+        mHeaps.clear();
+        mActivations.clear();
+        mAliases.clear();
+        mTransientLayout.clear();
+        mMemoryStats = MemoryStats();
+    }
+
+    void ResourceCache::setAliasingEnabled(bool enabled)
+    {
+        if (mAliasingEnabled == enabled) return;
+        mAliasingEnabled = enabled;
+        for (auto& data : mResourceData) data.dirty = true;
     }
 
     const std::shared_ptr<Resource>& ResourceCache::getResource(const std::string& name) const
@@ -221,6 +236,7 @@ namespace Falcor
             mergeFields(baseResData.field, newResData.field, name);
             mergeTimePoint(baseResData.firstUsed, baseResData.lastUsed, newResData.firstUsed);
             mergeTimePoint(baseResData.firstUsed, baseResData.lastUsed, newResData.lastUsed);
+            baseResData.persistent = baseResData.persistent || newResData.persistent;
 
             // Clear data that has been merged
             mResourceData[nameIt->second] = ResourceData();
@@ -229,11 +245,14 @@ namespace Falcor
             nameIt->second = aliasIt->second;
         }
 
+        bool persistent = is_set(field.getFlags(), RenderPassReflection::Field::Flags::Persistent);
+
         // If name exists, update time range
         if (mNameToIndex.count(name) > 0)
         {
             uint32_t index = mNameToIndex[name];
             mergeTimePoint(mResourceData[index].firstUsed, mResourceData[index].lastUsed, timePoint);
+            mResourceData[index].persistent = mResourceData[index].persistent || persistent;
             return;
         }
 
@@ -249,7 +268,13 @@ namespace Falcor
         {
             assert(mNameToIndex.count(name) == 0);
             mNameToIndex[name] = (uint32_t)mResourceData.size();
-            mResourceData.push_back({ field, true, timePoint, timePoint, nullptr });
+            ResourceData data;
+            data.name = name;
+            data.field = field;
+            data.persistent = persistent;
+            data.firstUsed = timePoint;
+            data.lastUsed = timePoint;
+            mResourceData.push_back(data);
         }
         // Add alias
         else
@@ -259,55 +284,276 @@ namespace Falcor
 
             mergeFields(mResourceData[index].field, field, name);
             mergeTimePoint(mResourceData[index].firstUsed, mResourceData[index].lastUsed, timePoint);
+            mResourceData[index].persistent = mResourceData[index].persistent || persistent;
 
             mResourceData[index].dirty = true;
         }
     }
 
-    Texture::SharedPtr createTextureForPass(const ResourceCache::DefaultProperties& params, const RenderPassReflection::Field& field)
+    bool ResourceCache::TextureDesc::operator==(const TextureDesc& other) const
+    {
+        return type == other.type && width == other.width && height == other.height && depth == other.depth &&
+            sampleCount == other.sampleCount && format == other.format && bindFlags == other.bindFlags;
+    }
+
+    ResourceCache::TextureDesc ResourceCache::getTextureDesc(const DefaultProperties& params, const RenderPassReflection::Field& field)
+    {
+        TextureDesc desc;
+        desc.width = field.getWidth() ? field.getWidth() : params.width;
+        desc.height = field.getHeight() ? field.getHeight() : params.height;
+        desc.depth = field.getDepth() ? field.getDepth() : 1;
+        desc.sampleCount = field.getSampleCount() ? field.getSampleCount() : 1;
+        desc.format = field.getFormat() == ResourceFormat::Unknown ? params.format : field.getFormat();
+        desc.bindFlags = getBindFlagsFromFormat(field.getBindFlags(), desc.format, field.getVisibility());
+
+        if (desc.depth > 1)
+        {
+            assert(desc.sampleCount == 1);
+            desc.type = Texture::Type::Texture3D;
+        }
+        else if (desc.height > 1 || desc.sampleCount > 1)
+        {
+            desc.type = (desc.sampleCount > 1) ? Texture::Type::Texture2DMultisample : Texture::Type::Texture2D;
+        }
+        else
+        {
+            desc.type = Texture::Type::Texture1D;
+        }
+        return desc;
+    }
+
+    Texture::SharedPtr ResourceCache::createTexture(const TextureDesc& desc)
+    {
+        switch (desc.type)
+        {
+        case Texture::Type::Texture3D:
+            return Texture::create3D(desc.width, desc.height, desc.depth, desc.format, 1, nullptr, desc.bindFlags);
+        case Texture::Type::Texture2DMultisample:
+            return Texture::create2DMS(desc.width, desc.height, desc.format, desc.sampleCount, 1, desc.bindFlags);
+        case Texture::Type::Texture2D:
+            return Texture::create2D(desc.width, desc.height, desc.format, 1, 1, nullptr, desc.bindFlags);
+        default:
+            return Texture::create1D(desc.width, desc.format, 1, 1, nullptr, desc.bindFlags);
+        }
+    }
+
+    std::shared_ptr<Resource> ResourceCache::findDedicatedResource(const std::string& name, const TextureDesc& desc) const
     {
-        uint32_t width = field.getWidth() ? field.getWidth() : params.width;
-        uint32_t height = field.getHeight() ? field.getHeight() : params.height;
-        uint32_t depth = field.getDepth() ? field.getDepth() : 1;
-        uint32_t sampleCount = field.getSampleCount() ? field.getSampleCount() : 1;
-        ResourceFormat format = field.getFormat() == ResourceFormat::Unknown ? params.format : field.getFormat();
+        auto it = mNameToIndex.find(name);
+        if (it == mNameToIndex.end()) return nullptr;
 
-        auto bindFlags = getBindFlagsFromFormat(field.getBindFlags(), format, field.getVisibility());
+        const ResourceData& data = mResourceData[it->second];
+        const Texture* pTexture = dynamic_cast<const Texture*>(data.pResource.get());
+        if (pTexture == nullptr || pTexture->getHeap() || data.dirty || (data.desc == desc) == false) return nullptr;
+        return data.pResource;
+    }
+
+    bool ResourceCache::isTransient(const ResourceData& data) const
+    {
+        // Graph outputs are registered at time point -1, they are read after the graph executed
+        return mAliasingEnabled && data.field.isValid() && (data.persistent == false) && (data.lastUsed != uint32_t(-1)) &&
+            (is_set(data.field.getVisibility(), RenderPassReflection::Field::Visibility::Internal) == false);
+    }
 
-        Texture::SharedPtr pTexture;
-        if (depth > 1)
+    void ResourceCache::allocateTransientResources(const DefaultProperties& params, const ResourceCache* pPrevious)
+    {
+        // Release the old textures before creating the new heaps
+        std::vector<uint32_t> transients;
+        std::vector<TransientData> layout;
+        for (uint32_t i = 0; i < (uint32_t)mResourceData.size(); i++)
         {
-            assert(sampleCount == 1);
-            pTexture = Texture::create3D(width, height, depth, format, 1, nullptr, bindFlags);
+            ResourceData& data = mResourceData[i];
+            if (isTransient(data) == false) continue;
+            transients.push_back(i);
+            data.pResource = nullptr;
+            data.desc = getTextureDesc(params, data.field);
+            data.dirty = false;
+            layout.push_back({ data.name, data.desc, data.firstUsed, data.lastUsed });
         }
-        else if (height > 1 || sampleCount > 1)
+        std::sort(layout.begin(), layout.end(), [](const TransientData& a, const TransientData& b) { return a.name < b.name; });
+
+        mHeaps.clear();
+        mActivations.clear();
+        mAliases.clear();
+        mTransientLayout = layout;
+        mMemoryStats.transientCount = 0;
+        mMemoryStats.heapCount = 0;
+        mMemoryStats.transientSize = 0;
+        mMemoryStats.heapSize = 0;
+
+        // Nothing that affects the packing changed, share the heaps with the previous compilation
+        if (pPrevious && pPrevious->mAliasingEnabled && pPrevious->mTransientLayout == layout)
         {
-            if (sampleCount > 1)
+            for (uint32_t index : transients)
             {
-                pTexture = Texture::create2DMS(width, height, format, sampleCount, 1, bindFlags);
+                ResourceData& data = mResourceData[index];
+                data.pResource = pPrevious->mResourceData[pPrevious->mNameToIndex.at(data.name)].pResource;
             }
-            else
+            mHeaps = pPrevious->mHeaps;
+            mActivations = pPrevious->mActivations;
+            mAliases = pPrevious->mAliases;
+            mMemoryStats = pPrevious->mMemoryStats;
+            return;
+        }
+
+        // Render-targets and other textures can't share a heap on all hardware, pack them separately
+        struct HeapGroup
+        {
+            std::vector<uint32_t> resources;
+            std::vector<TransientHeapAllocator::Allocation> allocations;
+        };
+        HeapGroup groups[2];
+
+        for (uint32_t index : transients)
+        {
+            ResourceData& data = mResourceData[index];
+            const TextureDesc& desc = data.desc;
+            ResourceHeap::AllocationInfo info = Texture::getPlacementInfo(desc.type, desc.width, desc.height, desc.depth, desc.format, desc.sampleCount, desc.bindFlags);
+            if (info.size == 0)
             {
-                pTexture = Texture::create2D(width, height, format, 1, 1, nullptr, bindFlags);
+                data.pResource = createTexture(desc);
+                continue;
             }
+
+            TransientHeapAllocator::Allocation allocation;
+            allocation.size = info.size;
+            allocation.alignment = info.alignment;
+            allocation.firstUsed = data.firstUsed;
+            allocation.lastUsed = data.lastUsed;
+
+            HeapGroup& group = groups[(uint32_t)ResourceHeap::getHeapType(desc.bindFlags)];
+            group.resources.push_back(index);
+            group.allocations.push_back(allocation);
         }
-        else
+
+        for (uint32_t g = 0; g < arraysize(groups); g++)
         {
-            pTexture = Texture::create1D(width, format, 1, 1, nullptr, bindFlags);
+            HeapGroup& group = groups[g];
+            if (group.resources.empty()) continue;
+
+            uint64_t heapSize = TransientHeapAllocator::pack(group.allocations);
+            ResourceHeap::SharedPtr pHeap = ResourceHeap::create((ResourceHeap::Type)g, heapSize);
+            std::vector<const Resource*> placed(group.resources.size(), nullptr);
+
+            for (size_t r = 0; r < group.resources.size(); r++)
+            {
+                const TransientHeapAllocator::Allocation& allocation = group.allocations[r];
+                ResourceData& data = mResourceData[group.resources[r]];
+                const TextureDesc& desc = data.desc;
+
+                Texture::SharedPtr pTexture;
+                if (pHeap) pTexture = Texture::createPlaced(pHeap, allocation.offset, desc.type, desc.width, desc.height, desc.depth, desc.format, desc.sampleCount, desc.bindFlags);
+                if (pTexture == nullptr)
+                {
+                    data.pResource = createTexture(desc);
+                    continue;
+                }
+                data.pResource = pTexture;
+                placed[r] = pTexture.get();
+                mMemoryStats.transientCount++;
+                mMemoryStats.transientSize += allocation.size;
+
+                // Textures sharing memory with another texture need an aliasing barrier when they become active
+                for (size_t o = 0; o < group.allocations.size(); o++)
+                {
+                    if (o != r && TransientHeapAllocator::memoryOverlaps(allocation, group.allocations[o]))
+                    {
+                        if (mActivations.size() <= data.firstUsed) mActivations.resize(data.firstUsed + 1);
+                        mActivations[data.firstUsed].push_back(pTexture.get());
+                        break;
+                    }
+                }
+            }
+
+            for (size_t r = 0; r < placed.size(); r++)
+            {
+                for (size_t o = r + 1; o < placed.size(); o++)
+                {
+                    if (placed[r] && placed[o] && TransientHeapAllocator::memoryOverlaps(group.allocations[r], group.allocations[o]))
+                    {
+                        mAliases[placed[r]].push_back(placed[o]);
+                        mAliases[placed[o]].push_back(placed[r]);
+                    }
+                }
+            }
+
+            if (pHeap)
+            {
+                mHeaps.push_back(pHeap);
+                mMemoryStats.heapCount++;
+                mMemoryStats.heapSize += heapSize;
+            }
         }
 
-        return pTexture;
+        if (mMemoryStats.transientCount)
+        {
+            logInfo("ResourceCache: " + std::to_string(mMemoryStats.transientCount) + " transient textures placed in " + std::to_string(mMemoryStats.heapCount) + " heaps, saved " +
+                std::to_string(mMemoryStats.getSavedSize() / (1024 * 1024)) + " of " + std::to_string(mMemoryStats.transientSize / (1024 * 1024)) + " MB");
+        }
     }
 
-    void ResourceCache::allocateResources(const DefaultProperties& params)
+    void ResourceCache::allocateResources(const DefaultProperties& params, const ResourceCache* pPrevious)
     {
+        // The transient textures share heaps, so a change to one of them changes the layout of all of them
+        bool rebuildTransients = false;
         for (auto& data : mResourceData)
         {
             if ((data.pResource == nullptr || data.dirty) && data.field.isValid())
             {
-                data.pResource = createTextureForPass(params, data.field);
+                if (isTransient(data))
+                {
+                    rebuildTransients = true;
+                    continue;
+                }
+
+                data.desc = getTextureDesc(params, data.field);
+                data.pResource = pPrevious ? pPrevious->findDedicatedResource(data.name, data.desc) : nullptr;
+                if (data.pResource == nullptr) data.pResource = createTexture(data.desc);
                 data.dirty = false;
             }
         }
+
+        if (rebuildTransients)
+        {
+            allocateTransientResources(params, pPrevious);
+        }
+        else if (mAliasingEnabled == false)
+        {
+            mHeaps.clear();
+            mActivations.clear();
+            mAliases.clear();
+            mTransientLayout.clear();
+            mMemoryStats = MemoryStats();
+        }
+
+        mMemoryStats.dedicatedCount = 0;
+        for (const auto& data : mResourceData)
+        {
+            const Texture* pTexture = dynamic_cast<const Texture*>(data.pResource.get());
+            if (pTexture && pTexture->getHeap() == nullptr) mMemoryStats.dedicatedCount++;
+        }
+    }
+
+    const std::vector<const Resource*>& ResourceCache::getAliasedResources(const Resource* pResource) const
+    {
+        static const std::vector<const Resource*> kNone;
+        const auto& it = mAliases.find(pResource);
+        return (it == mAliases.end()) ? kNone : it->second;
+    }
+
+    void ResourceCache::prepareResources(RenderContext* pContext, uint32_t timePoint)
+    {
+        if (timePoint >= mActivations.size()) return;
+
+        for (const Texture* pTexture : mActivations[timePoint])
+        {
+            pContext->aliasingBarrier(nullptr, pTexture);
+
+            // Render-targets and depth-buffers must be initialized with a discard, clear or full copy after aliasing
+            if (is_set(pTexture->getBindFlags(), Resource::BindFlags::RenderTarget | Resource::BindFlags::DepthStencil))
+            {
+                pContext->discardResource(pTexture);
+            }
+        }
     }
 }
@@ -33,6 +33,7 @@ namespace Falcor
 {
     class RenderPass;
     class Resource;
+    class RenderContext;
     
     class ResourceCache : public std::enable_shared_from_this<ResourceCache>
     {
@@ -52,6 +53,7 @@ namespace Falcor
         // Add/Remove reference to a graph input resource not owned by the cache
         void registerExternalInput(const std::string& name, const std::shared_ptr<Resource>& pResource);
         void removeExternalInput(const std::string& name);
+        const std::unordered_map<std::string, std::shared_ptr<Resource>>& getExternalInputs() const { return mExternalInputs; }
 
         /** Register a field that requires resources to be allocated.
             \param[in] name String in the format of PassName.FieldName
@@ -72,27 +74,98 @@ namespace Falcor
 
         /** Allocate all resources that need to be created/updated. 
             This includes new resources, resources whose properties have been updated since last allocation call.
+            \param[in] pPrevious Optional. A cache allocated for an earlier compilation of the graph. Resources with the same name and description are shared with it instead of being created.
+                The transient resources are shared only if all of them are unchanged, since they are packed together.
         */
-        void allocateResources(const DefaultProperties& params);
+        void allocateResources(const DefaultProperties& params, const ResourceCache* pPrevious = nullptr);
+
+        /** Prepare the resources which become active at a time point. Must be called before executing the pass at that time point.
+            Textures which share memory with other textures get an aliasing barrier, and render-targets and depth-buffers are discarded.
+        */
+        void prepareResources(RenderContext* pContext, uint32_t timePoint);
 
         /** Clears all registered field/resource properties and allocated resources.
         */
         void reset();
 
+        /** Enable or disable memory aliasing of transient resources. Takes effect on the next allocateResources() call.
+            A resource is transient if it is only used by the passes of the graph within a single execution.
+            Transient textures are placed in shared heaps and textures with disjoint lifetimes share memory. Disabled by default.
+        */
+        void setAliasingEnabled(bool enabled);
+
+        /** Check if memory aliasing of transient resources is enabled
+        */
+        bool isAliasingEnabled() const { return mAliasingEnabled; }
+
+        /** Get the transient textures whose memory overlaps with a resource's memory. Empty if the resource doesn't share memory.
+        */
+        const std::vector<const Resource*>& getAliasedResources(const Resource* pResource) const;
+
+        /** Memory used by the resources of the last allocateResources() call
+        */
+        struct MemoryStats
+        {
+            uint32_t transientCount = 0;    ///< Textures placed in shared heaps
+            uint32_t dedicatedCount = 0;    ///< Textures with their own memory
+            uint32_t heapCount = 0;
+            uint64_t transientSize = 0;     ///< Sum of the sizes of the placed textures
+            uint64_t heapSize = 0;          ///< Sum of the heap sizes
+
+            /** Memory saved by aliasing, compared to giving every placed texture its own memory
+            */
+            uint64_t getSavedSize() const { return transientSize > heapSize ? transientSize - heapSize : 0; }
+        };
+
+        const MemoryStats& getMemoryStats() const { return mMemoryStats; }
+
     private:
         ResourceCache() = default;
 
+        struct TextureDesc
+        {
+            Texture::Type type = Texture::Type::Texture2D;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t depth = 0;
+            uint32_t sampleCount = 0;
+            ResourceFormat format = ResourceFormat::Unknown;
+            Resource::BindFlags bindFlags = Resource::BindFlags::None;
+
+            bool operator==(const TextureDesc& other) const;
+        };
+
         struct ResourceData
         {
+            std::string name; // Name the resource was first registered with
             RenderPassReflection::Field field; // Holds merged properties for aliased resources
+            TextureDesc desc; // Description the resource was created with
             bool dirty = true; // Whether field data has been changed since last resource creation
 
+            bool persistent = false; // Whether any of the merged fields has the Persistent flag
+
             // Time range where this resource is being used
             uint32_t firstUsed = 0;
             uint32_t lastUsed = 0;
 
             std::shared_ptr<Resource> pResource;
         };
+
+        struct TransientData
+        {
+            std::string name;
+            TextureDesc desc;
+            uint32_t firstUsed;
+            uint32_t lastUsed;
+
+            bool operator==(const TransientData& other) const { return name == other.name && desc == other.desc && firstUsed == other.firstUsed && lastUsed == other.lastUsed; }
+        };
+
+        static TextureDesc getTextureDesc(const DefaultProperties& params, const RenderPassReflection::Field& field);
+        static Texture::SharedPtr createTexture(const TextureDesc& desc);
+        std::shared_ptr<Resource> findDedicatedResource(const std::string& name, const TextureDesc& desc) const;
+        bool isTransient(const ResourceData& data) const;
+        void allocateTransientResources(const DefaultProperties& params, const ResourceCache* pPrevious);
         
         // Resources and properties for fields within (and therefore owned by) a render graph
         std::unordered_map<std::string, uint32_t> mNameToIndex;
@@ -100,6 +173,14 @@ namespace Falcor
 
         // References to output resources not to be allocated by the render graph
         std::unordered_map<std::string, std::shared_ptr<Resource>> mExternalInputs;
+
+        // Heaps holding the transient textures, and for every time point the textures sharing memory which become active at it
+        bool mAliasingEnabled = false;
+        std::vector<ResourceHeap::SharedPtr> mHeaps;
+        std::vector<std::vector<const Texture*>> mActivations;
+        std::unordered_map<const Resource*, std::vector<const Resource*>> mAliases;
+        std::vector<TransientData> mTransientLayout; // Sorted by name
+        MemoryStats mMemoryStats;
     };
 
 }
\ No newline at end of file
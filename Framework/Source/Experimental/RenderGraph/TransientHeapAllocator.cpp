@@ -0,0 +1,83 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TransientHeapAllocator.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    static uint64_t alignOffset(uint64_t offset, uint64_t alignment)
+    {
+        return alignment > 1 ? (offset + alignment - 1) / alignment * alignment : offset;
+    }
+
+    uint64_t TransientHeapAllocator::pack(std::vector<Allocation>& allocations)
+    {
+        // Large resources first leaves the gaps between them for the small ones
+        std::vector<uint32_t> order(allocations.size());
+        for (uint32_t i = 0; i < (uint32_t)order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&allocations](uint32_t a, uint32_t b) { return allocations[a].size > allocations[b].size; });
+
+        struct Range
+        {
+            uint64_t begin;
+            uint64_t end;
+            bool operator<(const Range& other) const { return begin < other.begin; }
+        };
+
+        std::vector<uint32_t> placed;
+        std::vector<Range> ranges;
+        uint64_t heapSize = 0;
+        for (uint32_t i : order)
+        {
+            Allocation& allocation = allocations[i];
+
+            // Memory taken by the placed resources which are alive at the same time
+            ranges.clear();
+            for (uint32_t p : placed)
+            {
+                const Allocation& other = allocations[p];
+                if (lifetimesOverlap(allocation, other)) ranges.push_back({ other.offset, other.offset + other.size });
+            }
+            std::sort(ranges.begin(), ranges.end());
+
+            // First fit, the ranges can overlap each other
+            uint64_t offset = alignOffset(0, allocation.alignment);
+            for (const Range& r : ranges)
+            {
+                if (offset + allocation.size <= r.begin) break;
+                if (r.end > offset) offset = alignOffset(r.end, allocation.alignment);
+            }
+
+            allocation.offset = offset;
+            heapSize = std::max(heapSize, offset + allocation.size);
+            placed.push_back(i);
+        }
+        return heapSize;
+    }
+}
@@ -0,0 +1,63 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Assigns heap offsets to resources with known lifetimes, so that resources which are never used at the same time share memory.
+        The lifetimes are intervals of the execution order, so two resources conflict exactly when their intervals intersect (an interval graph).
+        Resources are placed largest first, each at the lowest aligned offset that doesn't overlap a conflicting resource placed before it.
+    */
+    class TransientHeapAllocator
+    {
+    public:
+        struct Allocation
+        {
+            uint64_t size = 0;
+            uint64_t alignment = 1;     ///< Required alignment of the offset, 0 is treated as 1
+            uint32_t firstUsed = 0;     ///< First time point the resource is used at
+            uint32_t lastUsed = 0;      ///< Last time point the resource is used at, inclusive
+            uint64_t offset = 0;        ///< Assigned by pack()
+        };
+
+        /** Assign an offset to every allocation
+            \return The heap size needed for the allocations
+        */
+        static uint64_t pack(std::vector<Allocation>& allocations);
+
+        /** Check if two allocations are used at the same time point
+        */
+        static bool lifetimesOverlap(const Allocation& a, const Allocation& b) { return a.firstUsed <= b.lastUsed && b.firstUsed <= a.lastUsed; }
+
+        /** Check if two packed allocations share memory
+        */
+        static bool memoryOverlaps(const Allocation& a, const Allocation& b) { return a.offset < b.offset + b.size && b.offset < a.offset + a.size; }
+    };
+}
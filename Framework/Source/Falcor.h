@@ -53,6 +53,7 @@
 #include "API/Shader.h"
 #include "API/StructuredBuffer.h"
 #include "API/Texture.h"
+#include "API/ResourceHeap.h"
 #include "API/ConstantBuffer.h"
 #include "API/VAO.h"
 #include "API/VertexLayout.h"
@@ -89,6 +90,8 @@
 #include "Graphics/Program/GraphicsProgram.h"
 #include "Graphics/Program/ComputeProgram.h"
 #include "Graphics/Program/ParameterBlock.h"
+#include "Graphics/Program/ShaderCache.h"
+#include "Graphics/Program/ProgramCompiler.h"
 
 // Material
 #include "Graphics/Material/Material.h"
@@ -97,9 +100,11 @@
 #include "Graphics/Model/Mesh.h"
 #include "Graphics/Model/Model.h"
 #include "Graphics/Model/ModelRenderer.h"
+#include "Graphics/Model/ModelImportCache.h"
 
 // Scene
 #include "Graphics/Scene/Scene.h"
+#include "Graphics/Scene/RenderQueue.h"
 #include "Graphics/Scene/SceneRenderer.h"
 #include "Graphics/Scene/Editor/SceneEditor.h"
 
@@ -107,6 +112,13 @@
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/CubicSpline.h"
 #include "Utils/Math/ParallelReduction.h"
+#include "Utils/Math/QuadBoundsReduction.h"
+#include "Utils/Math/StereoFrustumCuller.h"
+#include "Utils/Math/BoundingVolumeHierarchy.h"
+#include "Utils/Math/TransformTable.h"
+#include "Utils/Math/SoftwareOcclusionCuller.h"
+#include "Utils/Math/MeshOptimizer.h"
+#include "Utils/Math/MeshSimplifier.h"
 
 // Utils
 #include "Utils/Bitmap.h"
@@ -126,6 +138,10 @@
 #include "Utils/Platform/OS.h"
 #include "Utils/Platform/ProgressBar.h"
 #include "Utils/ThreadPool.h"
+#include "Utils/WorkStealingPool.h"
+#include "Utils/SpscQueue.h"
+#include "Utils/Telemetry.h"
+#include "Utils/DiskCacheIndex.h"
 #include "Utils/PatternGenerators/DxSamplePattern.h"
 #include "Utils/PatternGenerators/HaltonSamplePattern.h"
 
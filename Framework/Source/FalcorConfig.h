@@ -34,8 +34,9 @@
 #endif 
 
 #define _PROFILING_ENABLED 1                // Set this to 1 to enable CPU/GPU profiling
-#define _PROFILING_LOG 0                    // Set this to 1 to dump profiling data while profiler is active.
+#define _PROFILING_LOG 0                    // Set this to 1 to record the profiler events into the active Telemetry sink while profiler is active.
 #define _PROFILING_LOG_BATCH_SIZE 1024 * 1  // This can be used to control how many samples are accumulated before they are dumped to file.
+#define _PROFILING_MEASUREMENT_FRAMES 1024 * 1  // Number of frames in one measurement cycle of the samples that run timed measurements.
 
 #define _ENABLE_NVAPI false // Controls NVIDIA specific DX extensions. If it is set to true, make sure you have the NVAPI package in your 'Externals' directory. View the readme for more information.
 
@@ -333,4 +333,13 @@ namespace Falcor
         }
         return mpParameterBlock;
     }
+
+    void Material::prepareForParallelAccess(CopyContext* pContext) const
+    {
+        getParameterBlock();
+        mpParameterBlock->prepareForDraw(pContext);
+
+        // Sets allocated just now are written already. The vars still rebind them, SceneRenderer sets the block again in every frame.
+        for (auto& set : mpParameterBlock->getRootSets()) set.dirty = false;
+    }
 }
@@ -265,6 +265,11 @@ namespace Falcor
         /** Get the ParameterBlock object for the material. Each material is created with a parameter-block. Using it is more efficient than assigning data to a custom constant-buffer.
         */
         ParameterBlock::SharedConstPtr getParameterBlock() const;
+
+        /** Update the parameter block, upload its constants and write its descriptor sets. Binding the block afterwards only reads it, as long as the material doesn't change.
+            Called by Scene::prepareForParallelAccess() before passes sharing the material are recorded on several threads.
+        */
+        void prepareForParallelAccess(CopyContext* pContext) const;
     private:
         void updateBaseColorType();
         void updateSpecularType();
@@ -43,9 +43,14 @@
 #include "Data/VertexAttrib.h"
 #include "Utils/StringUtils.h"
 #include "API/Device.h"
+#include "Utils/WorkStealingPool.h"
+#include "Utils/CpuTimer.h"
+#include <future>
 
 namespace Falcor
 {
+    static const size_t kUploadBatchSize = 256 * 1024 * 1024;
+
     static_assert(Mesh::kMaxBonesPerVertex == 4, "Fix the weights and IDs container below");
     using VertexWeightsVec = std::vector<float4>;
     struct uvec8_4
@@ -66,6 +71,8 @@ namespace Falcor
         uint32_t texCrdCount,
         glm::vec3* bitangentData);
 
+    std::vector<uint8_t> createVertexBufferData(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights);
+
 
     void loadBones(const aiMesh* pAiMesh, VertexWeightsVec& weights, VertexIdsVec& ids, uint32_t vertexCount, const std::map<std::string, uint32_t>& boneNameToIdMap)
     {
@@ -287,7 +294,6 @@ namespace Falcor
                 aiString path;
                 pAiMaterial->GetTexture(aiType, 0, &path);
                 std::string s(path.data);
-                Texture::SharedPtr pTex = nullptr;
 
                 if (s.empty())
                 {
@@ -295,31 +301,61 @@ namespace Falcor
                     continue;
                 }
 
-                // Check if the texture was already loaded
-                const auto& a = mTextureCache.find(s);
-                if (a != mTextureCache.end())
-                {
-                    pTex = a->second;
-                }
-                else
+                // Only collect the file here, all files are decoded together by decodeTextures()
+                auto file = mTextureFileIds.emplace(s, (uint32_t)mTextureFiles.size());
+                if (file.second)
                 {
-                    // create a new texture
                     std::string fullpath = folder + '/' + s;
                     fullpath = replaceSubstring(fullpath, "\\", "/");
-                    pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb, pMaterial->getShadingModel()));
-                    if (pTex)
-                    {
-                        mTextureCache[s] = pTex;
-                    }
+                    mTextureFiles.push_back({ fullpath, isSrgbRequired(aiType, useSrgb, pMaterial->getShadingModel()), nullptr });
                 }
+                mTextureSlots.push_back({ pMaterial, (uint32_t)aiType, file.first->second });
+            }
+        }
+    }
+
+    void AssimpModelImporter::decodeTextures()
+    {
+        // Decoding is independent per file, the textures are created later on the calling thread
+        WorkStealingPool::SharedPtr pPool = WorkStealingPool::getShared();
+        pPool->parallelFor((uint32_t)mTextureFiles.size(), 1, [this](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                mTextureFiles[i].pData = TextureFileData::load(mTextureFiles[i].path, true, mTextureFiles[i].loadAsSrgb);
+            }
+        });
+    }
 
-                assert(pTex != nullptr);
-                setTexture(aiType, isObjFile, pMaterial, pTex);
+    void AssimpModelImporter::createTextures(bool isObjFile)
+    {
+        std::vector<Texture::SharedPtr> textures(mTextureFiles.size());
+        for (size_t i = 0; i < mTextureFiles.size(); i++)
+        {
+            TextureFile& file = mTextureFiles[i];
+            if (file.pData)
+            {
+                textures[i] = file.pData->createTexture();
+                addPendingUpload(file.pData->getDataSize());
+                file.pData = nullptr;
             }
         }
 
-        // Flush upload heap after every material so we don't accumulate a ton of memory usage when loading a model with a lot of textures
-        gpDevice->flushAndSync();
+        for (const TextureSlot& slot : mTextureSlots)
+        {
+            assert(textures[slot.file] != nullptr);
+            setTexture((aiTextureType)slot.aiType, isObjFile, slot.pMaterial, textures[slot.file]);
+        }
+    }
+
+    void AssimpModelImporter::addPendingUpload(size_t size)
+    {
+        mPendingUploadSize += size;
+        if (mPendingUploadSize >= kUploadBatchSize)
+        {
+            gpDevice->flushAndSync();
+            mPendingUploadSize = 0;
+        }
     }
 
     Material::SharedPtr AssimpModelImporter::createMaterial(const aiMaterial* pAiMaterial, const std::string& folder, bool isObjFile, bool useSrgb)
@@ -440,6 +476,7 @@ namespace Falcor
 
     bool AssimpModelImporter::createAllMaterials(const aiScene* pScene, const std::string& modelFolder, bool isObjFile, bool useSrgb)
     {
+        mCreatedMaterials.resize(pScene->mNumMaterials);
         for (uint32_t i = 0; i < pScene->mNumMaterials; i++)
         {
             const aiMaterial* pAiMaterial = pScene->mMaterials[i];
@@ -449,6 +486,18 @@ namespace Falcor
                 logError("Can't allocate memory for material");
                 return false;
             }
+            mCreatedMaterials[i] = pMaterial;
+        }
+
+        return true;
+    }
+
+    void AssimpModelImporter::addAllMaterials()
+    {
+        // Materials can only be compared once their textures are set
+        for (uint32_t i = 0; i < (uint32_t)mCreatedMaterials.size(); i++)
+        {
+            auto pMaterial = mCreatedMaterials[i];
             auto pAdded = checkForExistingMaterial(pMaterial);
             if (pMaterial != pAdded)
             {
@@ -457,8 +506,7 @@ namespace Falcor
             }
             mAiMaterialToFalcor[i] = pMaterial;
         }
-
-        return true;
+        mCreatedMaterials.clear();
     }
 
     bool AssimpModelImporter::parseAiSceneNode(const aiNode* pCurrent, const aiScene* pScene, IdToMesh& aiToFalcorMesh)
@@ -483,7 +531,7 @@ namespace Falcor
                 if (aiToFalcorMesh.find(aiId) == aiToFalcorMesh.end())
                 {
                     // Cache mesh
-                    aiToFalcorMesh[aiId] = createMesh(pScene->mMeshes[aiId]);
+                    aiToFalcorMesh[aiId] = createMesh(pScene->mMeshes[aiId], mMeshData[aiId]);
                 }
 
                 mModel.addMeshInstance(aiToFalcorMesh[aiId], aiMatToGLM(transform));
@@ -501,14 +549,15 @@ namespace Falcor
 
     bool AssimpModelImporter::createDrawList(const aiScene* pScene)
     {
-        createAnimationController(pScene);
         IdToMesh aiToFalcorMeshId;
         aiNode* pRoot = pScene->mRootNode;
-        return parseAiSceneNode(pRoot, pScene, aiToFalcorMeshId);
+        bool b = parseAiSceneNode(pRoot, pScene, aiToFalcorMeshId);
+        return b;
     }
 
     bool AssimpModelImporter::initModel(const std::string& filename)
     {
+        CpuTimer::TimePoint startTime = CpuTimer::getCurrentTimePoint();
         std::string fullpath;
         if (findFileInDataDirectories(filename, fullpath) == false)
         {
@@ -542,6 +591,8 @@ namespace Falcor
         // Extract the folder name
         auto last = fullpath.find_last_of("/\\");
         std::string modelFolder = fullpath.substr(0, last);
+        CpuTimer::TimePoint phaseTime = CpuTimer::getCurrentTimePoint();
+        mTimings.read = CpuTimer::calcDuration(startTime, phaseTime);
 
         // Order of initialization matters, materials, bones and animations need to loaded before mesh initialization
         bool isObjFile = hasSuffix(filename, ".obj", false);
@@ -551,13 +602,70 @@ namespace Falcor
             logError(std::string("Can't create materials for model ") + filename, true);
             return false;
         }
+        createAnimationController(pScene);
+        mTimings.materials = CpuTimer::calcDuration(phaseTime, CpuTimer::getCurrentTimePoint());
 
+        // Texture files are decoded in the background while the meshes are prepared, both only touch CPU memory
+        std::future<void> textureDecode = std::async(std::launch::async, [this]()
+        {
+            CpuTimer::TimePoint decodeStart = CpuTimer::getCurrentTimePoint();
+            decodeTextures();
+            mTimings.textureDecode = CpuTimer::calcDuration(decodeStart, CpuTimer::getCurrentTimePoint());
+        });
+
+        phaseTime = CpuTimer::getCurrentTimePoint();
+        prepareMeshes(pScene);
+        mTimings.meshPrepare = CpuTimer::calcDuration(phaseTime, CpuTimer::getCurrentTimePoint());
+        textureDecode.wait();
+
+        phaseTime = CpuTimer::getCurrentTimePoint();
+        createTextures(isObjFile);
+        addAllMaterials();
+        mTimings.textureUpload = CpuTimer::calcDuration(phaseTime, CpuTimer::getCurrentTimePoint());
+
+        phaseTime = CpuTimer::getCurrentTimePoint();
         if (createDrawList(pScene) == false)
         {
             logError(std::string("Can't create draw lists for model ") + filename, true);
             return false;
         }
+        gpDevice->flushAndSync();
+        mTimings.meshUpload = CpuTimer::calcDuration(phaseTime, CpuTimer::getCurrentTimePoint());
 
+        const float total = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+        logInfo("AssimpModelImporter: loaded '" + filename + "' in " + std::to_string(total) + " ms (read " + std::to_string(mTimings.read) +
+            " ms, materials " + std::to_string(mTimings.materials) + " ms, " + std::to_string(pScene->mNumMeshes) + " meshes prepared in " + std::to_string(mTimings.meshPrepare) +
+            " ms, " + std::to_string(mTextureFiles.size()) + " textures decoded in " + std::to_string(mTimings.textureDecode) + " ms, texture upload " + std::to_string(mTimings.textureUpload) +
+            " ms, mesh upload " + std::to_string(mTimings.meshUpload) + " ms)");
+
+        if (is_set(mFlags, Model::LoadFlags::OptimizeVertexOrder))
+        {
+            MeshOptimizer::VertexCacheStats before, after;
+            uint32_t optimizedCount = 0;
+            for (const auto& data : mMeshData)
+            {
+                if (data.optimized == false) continue;
+                before += data.cacheStatsBefore;
+                after += data.cacheStatsAfter;
+                optimizedCount++;
+            }
+            logInfo("AssimpModelImporter: optimized the vertex order of " + std::to_string(optimizedCount) + " meshes, ACMR " + std::to_string(before.getAcmr()) + " -> " +
+                std::to_string(after.getAcmr()) + ", ATVR " + std::to_string(before.getAtvr()) + " -> " + std::to_string(after.getAtvr()) +
+                " (FIFO cache of " + std::to_string(MeshOptimizer::kDefaultCacheSize) + " vertices)");
+        }
+
+        if (is_set(mFlags, Model::LoadFlags::GenerateLods))
+        {
+            uint32_t meshCount = 0;
+            size_t lodCount = 0;
+            for (const auto& data : mMeshData)
+            {
+                meshCount += data.lods.empty() ? 0 : 1;
+                lodCount += data.lods.size();
+            }
+            logInfo("AssimpModelImporter: generated " + std::to_string(lodCount) + " levels of detail for " + std::to_string(meshCount) + " of " + std::to_string(mMeshData.size()) + " meshes");
+        }
+        mMeshData.clear();
         return true;
     }
 
@@ -768,28 +876,38 @@ namespace Falcor
         return BoundingBox::fromMinMax(boxMin, boxMax);
     }
 
-    Mesh::SharedPtr AssimpModelImporter::createMesh(aiMesh* pAiMesh)
+    void AssimpModelImporter::prepareMeshes(const aiScene* pScene)
+    {
+        // Meshes only read the model's bone map, everything else is per mesh
+        mMeshData.resize(pScene->mNumMeshes);
+        WorkStealingPool::SharedPtr pPool = WorkStealingPool::getShared();
+        pPool->parallelFor(pScene->mNumMeshes, 1, [this, pScene](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                prepareMesh(pScene->mMeshes[i], mMeshData[i]);
+            }
+        });
+    }
+
+    void AssimpModelImporter::prepareMesh(aiMesh* pAiMesh, MeshData& data) const
     {
         uint32_t vertexCount = pAiMesh->mNumVertices;
-        uint32_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
-        auto pIB = createIndexBuffer(pAiMesh);
-        BoundingBox boundingBox = createMeshBbox(pAiMesh);
+        data.indices = createIndexBufferData(pAiMesh);
+        data.boundingBox = createMeshBbox(pAiMesh);
 
-        const bool generateTangentSpace = (pAiMesh->HasTangentsAndBitangents() == false) && (is_set(mFlags, Model::LoadFlags::DontGenerateTangentSpace) == false);
-        if (generateTangentSpace)
+        data.generatedTangents = (pAiMesh->HasTangentsAndBitangents() == false) && (is_set(mFlags, Model::LoadFlags::DontGenerateTangentSpace) == false);
+        if (data.generatedTangents)
         {
             genTangentSpace(pAiMesh);
         }
 
-        VertexLayout::SharedPtr pLayout = createVertexLayout(pAiMesh);
-        if (pLayout == nullptr)
+        data.pLayout = createVertexLayout(pAiMesh);
+        if (data.pLayout == nullptr)
         {
-            assert(0);
-            return nullptr;
+            return;
         }
 
-        std::vector<Buffer::SharedPtr> pVBs(pLayout->getBufferCount());
-
         // Initialize the bones data
         VertexWeightsVec weights;
         VertexIdsVec ids;
@@ -798,12 +916,100 @@ namespace Falcor
             loadBones(pAiMesh, weights, ids, vertexCount, mBoneNameToIdMap);
         }
 
+        // Fill the corresponding vertex buffers
+        data.vertexData.resize(data.pLayout->getBufferCount());
+        for (uint32_t i = 0; i < data.pLayout->getBufferCount(); i++)
+        {
+            const VertexBufferLayout* pVbLayout = data.pLayout->getBufferLayout(i).get();
+            data.vertexData[i] = createVertexBufferData(pAiMesh, pVbLayout, (uint8_t*)ids.data(), weights.data());
+        }
+
+        // The LODs are simplified from the optimized triangle order, the vertex fetch order is computed from all levels at the end
+        const bool triangleList = (pAiMesh->mFaces[0].mNumIndices == 3);
+        const bool optimize = is_set(mFlags, Model::LoadFlags::OptimizeVertexOrder) && triangleList;
+        if (optimize)
+        {
+            data.cacheStatsBefore = MeshOptimizer::analyzeVertexCache(data.indices.data(), data.indices.size(), vertexCount);
+            MeshOptimizer::optimizeVertexCache(data.indices.data(), data.indices.size(), vertexCount);
+            MeshOptimizer::optimizeOverdraw(data.indices.data(), data.indices.size(), &pAiMesh->mVertices[0].x, sizeof(aiVector3D), vertexCount);
+        }
+        if (is_set(mFlags, Model::LoadFlags::GenerateLods) && triangleList && (pAiMesh->HasBones() == false))
+        {
+            LodVertexData vertices;
+            vertices.vertexCount = vertexCount;
+            vertices.pPositions = &pAiMesh->mVertices[0].x;
+            vertices.positionStride = sizeof(aiVector3D);
+            if (pAiMesh->HasNormals())
+            {
+                vertices.pNormals = &pAiMesh->mNormals[0].x;
+                vertices.normalStride = sizeof(aiVector3D);
+            }
+            if (pAiMesh->HasTextureCoords(0))
+            {
+                vertices.pTexCoords = &pAiMesh->mTextureCoords[0][0].x;
+                vertices.texCoordStride = sizeof(aiVector3D);
+                vertices.texCoordComponentCount = pAiMesh->mNumUVComponents[0];
+            }
+            data.lods = generateLods(data.indices, vertices, optimize);
+        }
+        if (optimize)
+        {
+            optimizeVertexFetch(pAiMesh, data);
+        }
+    }
+
+    void AssimpModelImporter::optimizeVertexFetch(aiMesh* pAiMesh, MeshData& data) const
+    {
+        uint32_t vertexCount = pAiMesh->mNumVertices;
+        uint32_t* pIndices = data.indices.data();
+        size_t indexCount = data.indices.size();
+
+        // Coarser levels only use vertices of the full detail level, so they don't change its order
+        std::vector<uint32_t> remap = MeshOptimizer::optimizeVertexFetch(pIndices, indexCount, vertexCount);
+        MeshOptimizer::remapIndices(pIndices, indexCount, remap);
+        for (auto& vertexData : data.vertexData)
+        {
+            MeshOptimizer::remapVertices(vertexData.data(), vertexData.size() / vertexCount, remap);
+        }
+        // The occluder geometry is created from the Assimp positions
+        MeshOptimizer::remapVertices(pAiMesh->mVertices, sizeof(aiVector3D), remap);
+
+        size_t fullDetailIndexCount = data.lods.empty() ? indexCount : data.lods[0].startIndex;
+        data.cacheStatsAfter = MeshOptimizer::analyzeVertexCache(pIndices, fullDetailIndexCount, vertexCount);
+        data.optimized = true;
+    }
+
+    Buffer::SharedPtr AssimpModelImporter::createBuffer(const void* pData, size_t size, Buffer::BindFlags bindFlags)
+    {
+        if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
+        {
+            bindFlags |= Buffer::BindFlags::ShaderResource;
+        }
+        addPendingUpload(size);
+        return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, pData);
+    }
+
+    Mesh::SharedPtr AssimpModelImporter::createMesh(aiMesh* pAiMesh, MeshData& data)
+    {
+        uint32_t vertexCount = pAiMesh->mNumVertices;
+        uint32_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
+        VertexLayout::SharedPtr pLayout = data.pLayout;
+        if (pLayout == nullptr)
+        {
+            assert(0);
+            return nullptr;
+        }
+
+        auto pIB = createBuffer(data.indices.data(), sizeof(uint32_t) * data.indices.size(), Buffer::BindFlags::Index);
+
         // Create corresponding vertex buffers
+        std::vector<Buffer::SharedPtr> pVBs(pLayout->getBufferCount());
         for (uint32_t i = 0; i < pLayout->getBufferCount(); i++)
         {
-            const VertexBufferLayout* pVbLayout = pLayout->getBufferLayout(i).get();
-            pVBs[i] = createVertexBuffer(pAiMesh, pVbLayout, (uint8_t*)ids.data(), weights.data());
+            pVBs[i] = createBuffer(data.vertexData[i].data(), data.vertexData[i].size(), Buffer::BindFlags::Vertex);
         }
+        data.vertexData.clear();
+        BoundingBox boundingBox = data.boundingBox;
 
         Vao::Topology topology = Vao::Topology::TriangleList;
         switch (pAiMesh->mFaces[0].mNumIndices)
@@ -826,25 +1032,24 @@ namespace Falcor
         assert(pMaterial);
 
         Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIB, indexCount, pLayout, topology, pMaterial, boundingBox, pAiMesh->HasBones());
+        pMesh->setLods(data.lods);
 
-        if (generateTangentSpace)
+        if (is_set(mFlags, Model::LoadFlags::GenerateOccluders) && (topology == Vao::Topology::TriangleList) && (pAiMesh->HasBones() == false))
         {
-            safe_delete_array(pAiMesh->mBitangents);
+            auto pOccluder = std::make_shared<Mesh::OccluderGeometry>();
+            pOccluder->positions.assign((const glm::vec3*)pAiMesh->mVertices, (const glm::vec3*)pAiMesh->mVertices + vertexCount);
+            data.indices.resize(indexCount);
+            pOccluder->indices = std::move(data.indices);
+            pMesh->setOccluderGeometry(pOccluder);
         }
+        data.indices.clear();
 
-        return pMesh;
-    }
-
-    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh)
-    {
-        std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
-        const uint32_t size = (uint32_t)(sizeof(uint32_t) * indices.size());
-        Buffer::BindFlags bindFlags = Buffer::BindFlags::Index;
-        if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
+        if (data.generatedTangents)
         {
-            bindFlags |= Buffer::BindFlags::ShaderResource;
+            safe_delete_array(pAiMesh->mBitangents);
         }
-        return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, indices.data());;
+
+        return pMesh;
     }
 
 
@@ -875,7 +1080,7 @@ namespace Falcor
         }
     }
 
-    VertexLayout::SharedPtr AssimpModelImporter::createVertexLayout(const aiMesh* pAiMesh)
+    VertexLayout::SharedPtr AssimpModelImporter::createVertexLayout(const aiMesh* pAiMesh) const
     {
         static const uint32_t kMaxSupportedUVs = 2;
         // Must have position!!!
@@ -916,7 +1121,7 @@ namespace Falcor
         return pLayout;
     }
 
-    Buffer::SharedPtr AssimpModelImporter::createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights)
+    std::vector<uint8_t> createVertexBufferData(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights)
     {
         const uint32_t vertexStride = pLayout->getStride();
         std::vector<uint8_t> initData(vertexStride * pAiMesh->mNumVertices, 0);
@@ -983,12 +1188,6 @@ namespace Falcor
                 memcpy(pDst, pSrc, size);
             }
         }
-        Buffer::BindFlags bindFlags = Buffer::BindFlags::Vertex;
-        if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
-        {
-            bindFlags |= Buffer::BindFlags::ShaderResource;
-        }
-
-        return Buffer::create(vertexStride * pAiMesh->mNumVertices, bindFlags, Buffer::CpuAccess::None, initData.data());;
+        return initData;
     }
 }
\ No newline at end of file
@@ -33,6 +33,7 @@
 #include "../AnimationController.h"
 #include "../Mesh.h"
 #include "../Model.h"
+#include "Utils/Math/MeshOptimizer.h"
 
 struct aiScene;
 struct aiNode;
@@ -50,9 +51,12 @@ namespace Falcor
     class Buffer;
     class VertexBufferLayout;
     class Texture;
+    class TextureFileData;
 
     /** Implements model import functionality through ASSIMP.
         Typically, the user should use Model::createFromFile() to load a model instead of this class.
+        Texture files are decoded on a thread pool in the background while the CPU side data of all meshes is prepared in parallel. GPU resources
+        are then created on the calling thread and uploaded in batches. The time spent in each phase is logged.
     */
     class AssimpModelImporter : public ModelImporter
     {
@@ -73,10 +77,61 @@ namespace Falcor
         AssimpModelImporter(const AssimpModelImporter&) = delete;
         void operator=(const AssimpModelImporter&) = delete;
 
+        // CPU side data of a mesh, prepared for all meshes in parallel before the GPU buffers are created
+        struct MeshData
+        {
+            std::vector<uint32_t> indices;
+            VertexLayout::SharedPtr pLayout;
+            std::vector<std::vector<uint8_t>> vertexData;   // One per buffer of the layout
+            BoundingBox boundingBox;
+            bool generatedTangents = false;
+            std::vector<Mesh::Lod> lods;                    // Levels after the full detail mesh, their indices follow the full detail indices
+            bool optimized = false;
+            MeshOptimizer::VertexCacheStats cacheStatsBefore;
+            MeshOptimizer::VertexCacheStats cacheStatsAfter;
+        };
+
+        // A texture file used by the model
+        struct TextureFile
+        {
+            std::string path;
+            bool loadAsSrgb;
+            std::shared_ptr<TextureFileData> pData;
+        };
+
+        // A material texture waiting for its file to be decoded
+        struct TextureSlot
+        {
+            Material* pMaterial;
+            uint32_t aiType;
+            uint32_t file;
+        };
+
+        // Duration of the import phases in milliseconds
+        struct LoadTimings
+        {
+            float read = 0;
+            float materials = 0;
+            float textureDecode = 0;    // Runs in the background, overlaps with meshPrepare
+            float meshPrepare = 0;
+            float textureUpload = 0;
+            float meshUpload = 0;
+        };
+
         bool initModel(const std::string& filename);
         bool createDrawList(const aiScene* pScene);
         bool parseAiSceneNode(const aiNode* pCurrent, const aiScene* pScene, IdToMesh& aiToFalcorMesh);
         bool createAllMaterials(const aiScene* pScene, const std::string& modelFolder, bool isObjFile, bool useSrgb);
+        void addAllMaterials();
+
+        void decodeTextures();
+        void createTextures(bool isObjFile);
+        void prepareMeshes(const aiScene* pScene);
+        void prepareMesh(aiMesh* pAiMesh, MeshData& data) const;
+        void optimizeVertexFetch(aiMesh* pAiMesh, MeshData& data) const;
+
+        // Flushes the upload heap once enough data is pending, so large models don't accumulate a ton of memory usage
+        void addPendingUpload(size_t size);
 
         void createAnimationController(const aiScene* pScene);
         void initializeBones(const aiScene* pScene);
@@ -85,10 +140,9 @@ namespace Falcor
 
         Animation::UniquePtr createAnimation(const aiAnimation* pAiAnim);
 
-        Mesh::SharedPtr createMesh(aiMesh* pAiMesh);
-        VertexLayout::SharedPtr createVertexLayout(const aiMesh* pAiMesh);
-        Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh);
-        Buffer::SharedPtr createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights);
+        Mesh::SharedPtr createMesh(aiMesh* pAiMesh, MeshData& data);
+        VertexLayout::SharedPtr createVertexLayout(const aiMesh* pAiMesh) const;
+        Buffer::SharedPtr createBuffer(const void* pData, size_t size, Buffer::BindFlags bindFlags);
         void loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, Material* pMaterial, bool isObjFile, bool useSrgb);
         Material::SharedPtr createMaterial(const aiMaterial* pAiMaterial, const std::string& folder, bool isObjFile, bool useSrgb);
 
@@ -100,11 +154,17 @@ namespace Falcor
         std::unordered_set<const aiNode*> mAdditionalUsedNodes;
 
         std::map<uint32_t, Material::SharedPtr> mAiMaterialToFalcor;
+        std::vector<Material::SharedPtr> mCreatedMaterials;     // Indexed by the Assimp material index, before merging identical materials
 
         Model& mModel;
 
         std::vector<Bone> mBones;
         Model::LoadFlags mFlags;
-        std::map<const std::string, Texture::SharedPtr> mTextureCache;
+        std::map<const std::string, uint32_t> mTextureFileIds;
+        std::vector<TextureFile> mTextureFiles;
+        std::vector<TextureSlot> mTextureSlots;
+        std::vector<MeshData> mMeshData;            // Indexed by the Assimp mesh index
+        size_t mPendingUploadSize = 0;
+        LoadTimings mTimings;
     };
 }
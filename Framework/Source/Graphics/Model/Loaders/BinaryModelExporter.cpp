@@ -36,6 +36,7 @@
 #include "BinaryImage.hpp"
 #include "Data/VertexAttrib.h"
 #include "API/Device.h"
+#include <cstring>
 
 namespace Falcor
 {
@@ -81,7 +82,7 @@ namespace Falcor
         case ResourceFormat::BC5Unorm:
             return FW::ImageFormat::RGTC_RG;
         default:
-            should_not_get_here();
+            // Not supported by the binary file, the caller reports it
             return FW::ImageFormat::ID_Max;
         }
     }
@@ -103,6 +104,30 @@ namespace Falcor
         }
     }
 
+    static Texture::SharedPtr getTexture(const Material* pMaterial, MaterialSlot slot)
+    {
+        switch(slot)
+        {
+        case MaterialSlot_BaseColor:
+            return pMaterial->getBaseColorTexture();
+        case MaterialSlot_Specular:
+            return pMaterial->getSpecularTexture();
+        case MaterialSlot_Emissive:
+            return pMaterial->getEmissiveTexture();
+        case MaterialSlot_Normal:
+            return pMaterial->getNormalMap();
+        case MaterialSlot_Occlusion:
+            return pMaterial->getOcclusionMap();
+        case MaterialSlot_LightMap:
+            return pMaterial->getLightMap();
+        case MaterialSlot_Height:
+            return pMaterial->getHeightMap();
+        default:
+            should_not_get_here();
+            return nullptr;
+        }
+    }
+
     static AttribType getBinaryAttribType(const std::string& name)
     {
         if(name == VERTEX_POSITION_NAME)
@@ -144,10 +169,9 @@ namespace Falcor
         }
     }
 
-    void writeString(BinaryFileStream& stream, const std::string& str)
+    static uint64_t alignOffset(uint64_t offset, uint64_t alignment)
     {
-        stream << (int32_t)str.size();
-        stream.write(str.c_str(), str.size());;
+        return (offset + alignment - 1) / alignment * alignment;
     }
 
     void BinaryModelExporter::exportToFile(const std::string& filename, const Model* pModel)
@@ -155,6 +179,37 @@ namespace Falcor
         BinaryModelExporter(filename, pModel);
     }
 
+    bool BinaryModelExporter::canExport(const Model* pModel, std::string& reason)
+    {
+        if(pModel->hasBones() || pModel->hasAnimations())
+        {
+            reason = "the binary format doesn't support bones and animations";
+            return false;
+        }
+
+        for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+        {
+            const Material* pMaterial = pModel->getMesh(meshID)->getMaterial().get();
+            for(uint32_t i = 0; i < MaterialSlot_Max; i++)
+            {
+                Texture::SharedPtr pTexture = getTexture(pMaterial, MaterialSlot(i));
+                if(pTexture == nullptr) continue;
+
+                if(pTexture->getType() != Texture::Type::Texture2D || pTexture->getArraySize() > 1)
+                {
+                    reason = "the binary format only supports 2D textures";
+                    return false;
+                }
+                if(getBinaryFormatID(pTexture->getFormat()) == FW::ImageFormat::ID_Max)
+                {
+                    reason = "the binary format doesn't support texture format " + to_string(pTexture->getFormat());
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
     void BinaryModelExporter::error(const std::string& msg)
     {
         logError("Error when exporting model \"" + mFilename + "\".\n" + msg);
@@ -184,10 +239,10 @@ namespace Falcor
         }
 
         if(prepareSubmeshes() == false) return;
-        if(writeHeader()      == false) return;
         if(writeTextures()    == false) return;
         if(writeMeshes()      == false) return;
         if(writeInstances()   == false) return;
+        if(writeFile()        == false) return;
     }
 
     bool BinaryModelExporter::prepareSubmeshes()
@@ -208,44 +263,46 @@ namespace Falcor
             submesh.push_back(i);
         }
 
-        // Calculate the number of mesh instances
-        for(const auto& m : mMeshes)
-        {
-            mInstanceCount += mpModel->getMeshInstanceCount(m.second[0]);
-        }
-
         return true;
     }
 
-    bool BinaryModelExporter::writeHeader()
+    uint64_t BinaryModelExporter::appendData(const void* pData, size_t size)
     {
-        mStream.write("BinScene", 8);
-        mStream << (int32_t)8 << (int32_t)mpModel->getTextureCount() << (int32_t)mMeshes.size() << (int32_t)mInstanceCount;
-        return true;
+        uint64_t offset = alignOffset(mData.size(), kBinScene9DataAlignment);
+        mData.resize(offset + size);
+        std::memcpy(mData.data() + offset, pData, size);
+        return offset;
+    }
+
+    int32_t BinaryModelExporter::appendString(const std::string& str)
+    {
+        int32_t offset = (int32_t)mStrings.size();
+        mStrings += str;
+        return offset;
     }
 
     bool BinaryModelExporter::writeTextures()
     {
         mTextureHash[nullptr] = -1;
 
-        uint32_t texID = 0;
-        for (uint32_t meshID = 0; meshID < mpModel->getMeshCount(); meshID++)
+        // Only the textures the materials reference are exported
+        for(const auto& mesh : mMeshes)
         {
-            bool succeeded = true;
-
-            // Write all material textures
-            const auto& pMaterial = mpModel->getMesh(meshID)->getMaterial();
-            succeeded &= writeMaterialTexture(texID, pMaterial->getBaseColorTexture());
-            succeeded &= writeMaterialTexture(texID, pMaterial->getSpecularTexture());
-            succeeded &= writeMaterialTexture(texID, pMaterial->getEmissiveTexture());
-            succeeded &= writeMaterialTexture(texID, pMaterial->getNormalMap());
-            succeeded &= writeMaterialTexture(texID, pMaterial->getOcclusionMap());
-            succeeded &= writeMaterialTexture(texID, pMaterial->getLightMap());
-            succeeded &= writeMaterialTexture(texID, pMaterial->getHeightMap());
-
-            if (succeeded == false)
+            for(uint32_t meshID : mesh.second)
             {
-                return false;
+                const auto& pMaterial = mpModel->getMesh(meshID)->getMaterial();
+                for(uint32_t i = 0; i < MaterialSlot_Max; i++)
+                {
+                    Texture::SharedPtr pTexture = getTexture(pMaterial.get(), MaterialSlot(i));
+                    if(pTexture && mTextureHash.find(pTexture.get()) == mTextureHash.end())
+                    {
+                        mTextureHash[pTexture.get()] = (int32_t)mTextures.size();
+                        if(exportBinaryImage(pTexture.get()) == false)
+                        {
+                            return false;
+                        }
+                    }
+                }
             }
         }
 
@@ -255,25 +312,25 @@ namespace Falcor
     bool BinaryModelExporter::writeCommonMeshData(const Mesh::SharedPtr& pMesh, uint32_t submeshCount)
     {
         auto pVao = pMesh->getVao();
-        const uint32_t vertexBufferCount = pMesh->getVao()->getVertexBuffersCount();
-        mStream << (int32_t)vertexBufferCount << (int32_t)pMesh->getVertexCount() << (int32_t)submeshCount;
+        const uint32_t vertexBufferCount = pVao->getVertexBuffersCount();
 
-        struct vertexBufferInfo 
-        {
-            Buffer::SharedPtr pBuffer;
-            size_t            pData; //this had the p flag because it represents the pointer to the vertex buffers data
-            uint32_t          stride;
-        };
-            
-        std::vector<vertexBufferInfo> vbInfo(vertexBufferCount);
+        BinScene9Mesh mesh = {};
+        mesh.numVertices = (int32_t)pMesh->getVertexCount();
+        mesh.firstStream = (int32_t)mStreams.size();
+        mesh.numStreams = (int32_t)vertexBufferCount;
+        mesh.firstSubmesh = (int32_t)mSubmeshes.size();
+        mesh.numSubmeshes = (int32_t)submeshCount;
+
+        bool hasNormals = false;
+        bool hasBitangents = false;
 
-        for (uint32_t i = 0; i < vertexBufferCount; i++)
+        // Each vertex buffer is already laid out the way the loader binds it, so it's stored as-is
+        for(uint32_t i = 0; i < vertexBufferCount; i++)
         {
             const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(i).get();
             assert(pLayout->getElementCount() == 1);
             AttribType type = getBinaryAttribType(pLayout->getElementName(0));
             AttribFormat format = GetBinaryAttribFormat(pLayout->getElementFormat(0));
-            uint32_t channels = getFormatChannelCount(pLayout->getElementFormat(0));
 
             if(type == AttribType_Max)
             {
@@ -286,28 +343,30 @@ namespace Falcor
                 error("Unsupported attribute format");
                 return false;
             }
-            mStream << (int32_t)type << (int32_t)format << (int32_t)channels;
 
-            vbInfo[i].pBuffer = pVao->getVertexBuffer(i);
-            vbInfo[i].stride = pLayout->getStride();
-            vbInfo[i].pData = (size_t)vbInfo[i].pBuffer->map(Buffer::MapType::Read);
-        }
+            hasNormals |= (type == AttribType_Normal);
+            hasBitangents |= (type == AttribType_Bitangent);
 
-        // Write the vertex buffer
-        for (uint32_t i = 0; i < pMesh->getVertexCount(); ++i)
-        {
-            for (auto& a : vbInfo)
-            { 			
-                mStream.write((void*)a.pData, a.stride);
-                a.pData += a.stride;
-            }
+            BinScene9Stream stream = {};
+            stream.type = type;
+            stream.format = format;
+            stream.length = (int32_t)getFormatChannelCount(pLayout->getElementFormat(0));
+            stream.stride = (int32_t)pLayout->getStride();
+            stream.dataSize = uint64_t(pMesh->getVertexCount()) * stream.stride;
+
+            const auto& pBuffer = pVao->getVertexBuffer(i);
+            stream.dataOffset = appendData(pBuffer->map(Buffer::MapType::Read), (size_t)stream.dataSize);
+            pBuffer->unmap();
+
+            mStreams.push_back(stream);
         }
 
-        for (auto& a : vbInfo)
+        if(hasNormals && hasBitangents == false)
         {
-            a.pBuffer->unmap();
+            warning("Mesh " + std::to_string(mMeshRecords.size()) + " doesn't have tangent space. Load the model without Model::LoadFlags::DontGenerateTangentSpace before exporting it.");
         }
 
+        mMeshRecords.push_back(mesh);
         return true;
     }
 
@@ -315,69 +374,98 @@ namespace Falcor
     {
         const auto pMaterial = pMesh->getMaterial();
 
-        glm::vec3 ambient(0,0,0);
-        glm::vec4 diffuse = pMaterial->getBaseColor();
-        glm::vec3 specular = vec3(pMaterial->getSpecularParams());
-        float glossiness = pMaterial->getSpecularParams().a;
-
-        mStream << ambient << diffuse << specular << glossiness;
-
-        float displacementCoeff = pMaterial->getHeightScale();
-        float displacementBias = pMaterial->getHeightOffset();
+        BinScene9Submesh submesh = {};
+        glm::vec4 baseColor = pMaterial->getBaseColor();
+        glm::vec4 specular = pMaterial->getSpecularParams();
+        std::memcpy(submesh.baseColor, &baseColor, sizeof(submesh.baseColor));
+        std::memcpy(submesh.specular, &specular, sizeof(submesh.specular));
+        submesh.glossiness = specular.a;
+        submesh.displacementCoef = pMaterial->getHeightScale();
+        submesh.displacementBias = pMaterial->getHeightOffset();
 
-        mStream << displacementCoeff << displacementBias;
-        
         for(uint32_t i = 0; i < TextureType_Max; i++)
         {
             Texture::SharedPtr pTexture = getTexture(pMaterial, TextureType(i));
-            uint32_t index = -1;
-            if(pTexture)
+            submesh.textures[i] = mTextureHash[pTexture.get()];
+        }
+
+        // The full material, the Submesh record only has room for the legacy fields
+        BinScene9Material material = {};
+        glm::vec3 emissive = pMaterial->getEmissiveColor();
+        material.nameOffset = appendString(pMaterial->getName());
+        material.nameLength = (int32_t)pMaterial->getName().size();
+        std::memcpy(material.baseColor, &baseColor, sizeof(material.baseColor));
+        std::memcpy(material.specular, &specular, sizeof(material.specular));
+        std::memcpy(material.emissive, &emissive, sizeof(material.emissive));
+        material.indexOfRefraction = pMaterial->getIndexOfRefraction();
+        material.alphaThreshold = pMaterial->getAlphaThreshold();
+        material.heightScaleOffset[0] = pMaterial->getHeightScale();
+        material.heightScaleOffset[1] = pMaterial->getHeightOffset();
+        material.shadingModel = (int32_t)pMaterial->getShadingModel();
+        material.alphaMode = (int32_t)pMaterial->getAlphaMode();
+        material.doubleSided = pMaterial->isDoubleSided() ? 1 : 0;
+        for(uint32_t i = 0; i < MaterialSlot_Max; i++)
+        {
+            Texture::SharedPtr pTexture = getTexture(pMaterial.get(), MaterialSlot(i));
+            material.textures[i] = mTextureHash[pTexture.get()];
+            if(pTexture && isSrgbFormat(pTexture->getFormat()))
             {
-                index = mTextureHash[pTexture.get()];
+                material.srgbMask |= 1u << i;
             }
-
-            mStream << index;
         }
+        mMaterials.push_back(material);
+
+        const BoundingBox& box = pMesh->getBoundingBox();
+        glm::vec3 boundsMin = box.getMinPos();
+        glm::vec3 boundsMax = box.getMaxPos();
+        std::memcpy(submesh.boundsMin, &boundsMin, sizeof(submesh.boundsMin));
+        std::memcpy(submesh.boundsMax, &boundsMax, sizeof(submesh.boundsMax));
 
         uint32_t indexCount = pMesh->getIndexCount();
         assert(indexCount % 3 == 0);
-        uint32_t primCount = indexCount / 3;
+        submesh.numIndices = (int32_t)indexCount;
 
-        mStream << (int32_t)primCount;
+        // The reduced levels of detail follow the full detail indices in the same IB
+        uint32_t totalIndexCount = indexCount;
+        for(uint32_t level = 1; level < pMesh->getLodCount(); level++)
+        {
+            const Mesh::Lod& lod = pMesh->getLod(level);
+            totalIndexCount = std::max(totalIndexCount, lod.startIndex + lod.indexCount);
+
+            BinScene9Lod record = {};
+            record.submeshIdx = (int32_t)mSubmeshes.size();
+            record.startIndex = (int32_t)lod.startIndex;
+            record.indexCount = (int32_t)lod.indexCount;
+            record.error = lod.error;
+            mLods.push_back(record);
+        }
 
-        // Output the index buffer
-        const void* pIndices = pMesh->getVao()->getIndexBuffer()->map(Buffer::MapType::Read);
-        mStream.write(pIndices, indexCount * sizeof(uint32_t));
-        pMesh->getVao()->getIndexBuffer()->unmap();
+        const auto& pIB = pMesh->getVao()->getIndexBuffer();
+        submesh.indexOffset = appendData(pIB->map(Buffer::MapType::Read), totalIndexCount * sizeof(uint32_t));
+        pIB->unmap();
 
+        mSubmeshes.push_back(submesh);
         return true;
     }
 
     bool BinaryModelExporter::writeMeshes()
     {
-        uint32_t inst = 0;
         for(const auto& mesh : mMeshes)
         {
             const auto& submeshes = mesh.second;
 
-            for(uint32_t meshID : submeshes)
+            // All submeshes share the same VB and same layout. We use the first submesh for that.
+            if(writeCommonMeshData(mpModel->getMesh(submeshes[0]), (uint32_t)submeshes.size()) == false)
             {
-                const Mesh::SharedPtr& pMesh = mpModel->getMesh(meshID);
-
-                if(meshID == submeshes[0])
-                {
-                    // All submeshes share the same VB and same layout. We use the first submesh for that.
-                    if(writeCommonMeshData(pMesh, (uint32_t)submeshes.size()) == false)
-                    {
-                        return false;
-                    }
-                }
+                return false;
+            }
 
-                if(writeSubmesh(pMesh) == false)
+            for(uint32_t meshID : submeshes)
+            {
+                if(writeSubmesh(mpModel->getMesh(meshID)) == false)
                 {
                     return false;
                 }
-                inst += mpModel->getMeshInstanceCount(meshID);
             }
         }
 
@@ -387,17 +475,19 @@ namespace Falcor
     bool BinaryModelExporter::writeInstances()
     {
         int32_t meshIdx = 0;
-        int32_t enabled = 1;
         for(const auto& mesh : mMeshes)
         {
             const uint32_t meshID = mesh.second[0];
 
             for(uint32_t i = 0; i < mpModel->getMeshInstanceCount(meshID); i++)
             {
+                BinScene9Instance instance = {};
                 glm::mat4 transformation = mpModel->getMeshInstance(meshID, i)->getTransformMatrix();
-                mStream << meshIdx << enabled << transformation;
-                writeString(mStream, "");   // Name
-                writeString(mStream, "");   // Meta-data
+                instance.meshIdx = meshIdx;
+                instance.enabled = 1;
+                std::memcpy(instance.meshToWorld, &transformation, sizeof(instance.meshToWorld));
+                instance.nameOffset = appendString("");
+                mInstances.push_back(instance);
             }
 
             meshIdx++;
@@ -405,18 +495,71 @@ namespace Falcor
         return true;
     }
 
-    bool BinaryModelExporter::writeMaterialTexture(uint32_t& texID, const Texture::SharedPtr& pTexture)
+    bool BinaryModelExporter::writeFile()
     {
-        if (pTexture != nullptr)
+        struct ChunkSource
         {
-            // If not exported yet
-            if (mTextureHash.find(pTexture.get()) == mTextureHash.end())
-            {
-                mTextureHash[pTexture.get()] = texID++;
-                return exportBinaryImage(pTexture.get());
-            }
+            BinScene9ChunkType type;
+            size_t recordCount;
+            const void* pData;
+            size_t size;
+        };
+
+        const ChunkSource sources[] =
+        {
+            { ChunkType_Textures, mTextures.size(), mTextures.data(), mTextures.size() * sizeof(BinScene9Texture) },
+            { ChunkType_Meshes, mMeshRecords.size(), mMeshRecords.data(), mMeshRecords.size() * sizeof(BinScene9Mesh) },
+            { ChunkType_Streams, mStreams.size(), mStreams.data(), mStreams.size() * sizeof(BinScene9Stream) },
+            { ChunkType_Submeshes, mSubmeshes.size(), mSubmeshes.data(), mSubmeshes.size() * sizeof(BinScene9Submesh) },
+            { ChunkType_Instances, mInstances.size(), mInstances.data(), mInstances.size() * sizeof(BinScene9Instance) },
+            { ChunkType_Strings, 0, mStrings.data(), mStrings.size() },
+            { ChunkType_Data, 0, mData.data(), mData.size() },
+            { ChunkType_Materials, mMaterials.size(), mMaterials.data(), mMaterials.size() * sizeof(BinScene9Material) },
+            { ChunkType_Lods, mLods.size(), mLods.data(), mLods.size() * sizeof(BinScene9Lod) },
+        };
+        const uint32_t chunkCount = arraysize(sources);
+
+        // Lay the chunks out after the header, the chunk table goes last
+        std::vector<BinScene9ChunkEntry> chunks(chunkCount);
+        uint64_t offset = sizeof(BinScene9Header);
+        for(uint32_t i = 0; i < chunkCount; i++)
+        {
+            offset = alignOffset(offset, kBinScene9ChunkAlignment);
+            chunks[i].type = sources[i].type;
+            chunks[i].recordCount = (int32_t)sources[i].recordCount;
+            chunks[i].offset = offset;
+            chunks[i].size = sources[i].size;
+            offset += sources[i].size;
         }
 
+        BinScene9Header header = {};
+        std::memcpy(header.formatID, "BinScene", sizeof(header.formatID));
+        header.formatVersion = (int32_t)kBinScene9Version;
+        header.numChunks = (int32_t)chunkCount;
+        header.chunkTableOffset = alignOffset(offset, sizeof(uint64_t));
+
+        const std::vector<uint8_t> padding(kBinScene9ChunkAlignment, 0);
+        uint64_t written = 0;
+        auto writeAt = [&](uint64_t target, const void* pData, size_t size)
+        {
+            assert(target >= written && target - written <= padding.size());
+            mStream.write(padding.data(), (size_t)(target - written));
+            mStream.write(pData, size);
+            written = target + size;
+        };
+
+        writeAt(0, &header, sizeof(header));
+        for(uint32_t i = 0; i < chunkCount; i++)
+        {
+            writeAt(chunks[i].offset, sources[i].pData, sources[i].size);
+        }
+        writeAt(header.chunkTableOffset, chunks.data(), chunks.size() * sizeof(BinScene9ChunkEntry));
+
+        if(mStream.isFail())
+        {
+            error("Failed to write the file.");
+            return false;
+        }
         return true;
     }
 
@@ -434,22 +577,38 @@ namespace Falcor
             return false;
         }
 
-        uint32_t width = pTexture->getWidth();
-        uint32_t height = pTexture->getHeight();
-        ResourceFormat format = pTexture->getFormat();
-        uint32_t bpp = getFormatBytesPerBlock(format);
-
-        int32_t formatID = getBinaryFormatID(pTexture->getFormat());
+        BinScene9Texture tex = {};
+        tex.formatID = getBinaryFormatID(pTexture->getFormat());
+        if(tex.formatID == FW::ImageFormat::ID_Max)
+        {
+            error("Unsupported texture format " + to_string(pTexture->getFormat()) + ".");
+            return false;
+        }
+        tex.width = (int32_t)pTexture->getWidth();
+        tex.height = (int32_t)pTexture->getHeight();
+        tex.mipCount = (int32_t)pTexture->getMipCount();
 
-        // Write the data
-        std::vector<uint8_t> data = gpDevice->getRenderContext()->readTextureSubresource(pTexture, 0);
+        const std::string& name = pTexture->getSourceFilename();
+        tex.nameOffset = appendString(name);
+        tex.nameLength = (int32_t)name.size();
 
-        writeString(mStream, pTexture->getSourceFilename());
-        mStream.write("BinImage", 8);
-        // Version, width, height, bytes-per-pixel, channel count, FormatID, DataSize
-        mStream << (int32_t)2 << (int32_t)width << (int32_t)height << bpp << (int32_t)0 << formatID << (int32_t)data.size();
+        // Store the whole mip chain in the texture's own format, so compressed textures don't need to be re-encoded or have their mips regenerated on load
+        for(uint32_t mip = 0; mip < pTexture->getMipCount(); mip++)
+        {
+            std::vector<uint8_t> data = gpDevice->getRenderContext()->readTextureSubresource(pTexture, pTexture->getSubresourceIndex(0, mip));
+            if(mip == 0)
+            {
+                tex.dataOffset = appendData(data.data(), data.size());
+            }
+            else
+            {
+                // Mips follow each other without padding
+                mData.insert(mData.end(), data.begin(), data.end());
+            }
+            tex.dataSize += data.size();
+        }
 
-        mStream.write(data.data(), data.size());
+        mTextures.push_back(tex);
         return true;
     }
-}
\ No newline at end of file
+}
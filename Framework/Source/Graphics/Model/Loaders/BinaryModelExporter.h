@@ -31,6 +31,7 @@
 #include <map>
 #include <vector>
 #include "Graphics/Model/Mesh.h"
+#include "BinaryModelSpec.h"
 
 namespace Falcor
 {
@@ -48,29 +49,49 @@ namespace Falcor
         */
         static void exportToFile(const std::string& filename, const Model* pModel);
 
+        /** Check if a model can be exported without errors
+            \param[in] pModel The model to check
+            \param[out] reason Why the model can't be exported
+        */
+        static bool canExport(const Model* pModel, std::string& reason);
+
     private:
         BinaryModelExporter(const std::string& filename, const Model* pModel);
         const Model* mpModel = nullptr;
         BinaryFileStream mStream;
         const std::string& mFilename;
 
-        bool writeHeader();
+        bool prepareSubmeshes();
         bool writeTextures();
         bool writeMeshes();
         bool writeCommonMeshData(const Mesh::SharedPtr& pMesh, uint32_t submeshCount);
         bool writeSubmesh(const Mesh::SharedPtr& pMesh);
         bool writeInstances();
+        bool writeFile();
 
-        bool writeMaterialTexture(uint32_t& texID, const Texture::SharedPtr& pTexture);
-        
         bool exportBinaryImage(const Texture* pTexture);
 
+        /** Append a blob to the Data chunk.
+            \return The blob's offset in the chunk
+        */
+        uint64_t appendData(const void* pData, size_t size);
+        int32_t appendString(const std::string& str);
+
         void error(const std::string& Msg);
         void warning(const std::string& Msg);
 
-        bool prepareSubmeshes();
         std::map<const Vao*, std::vector<uint32_t>> mMeshes; // Maps to meshID in model
         std::map<const Texture*, int32_t> mTextureHash;
-        uint32_t mInstanceCount = 0; // Not the same as Model::Instance count. Model keeps the total instance count, while the binary format has a concept of meshes and submeshes, and the instance count there is the mesh instance count.
+
+        // The v9 chunks, written out by writeFile()
+        std::vector<BinScene9Texture> mTextures;
+        std::vector<BinScene9Mesh> mMeshRecords;
+        std::vector<BinScene9Stream> mStreams;
+        std::vector<BinScene9Submesh> mSubmeshes;
+        std::vector<BinScene9Instance> mInstances;
+        std::vector<BinScene9Material> mMaterials;
+        std::vector<BinScene9Lod> mLods;
+        std::string mStrings;
+        std::vector<uint8_t> mData;
     };
 }
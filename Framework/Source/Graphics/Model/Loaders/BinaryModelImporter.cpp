@@ -39,6 +39,9 @@
 #include "API/Texture.h"
 #include "Graphics/Material/Material.h"
 #include "API/Device.h"
+#include "Utils/Math/MeshOptimizer.h"
+#include "glm/gtc/type_ptr.hpp"
+#include <algorithm>
 #include <numeric>
 #include <cstring>
 
@@ -194,6 +197,36 @@ namespace Falcor
 
     }
 
+    static void setMaterialTexture(Material* pMaterial, Texture::SharedPtr pTexture, MaterialSlot slot)
+    {
+        switch(slot)
+        {
+        case MaterialSlot_BaseColor:
+            pMaterial->setBaseColorTexture(pTexture);
+            break;
+        case MaterialSlot_Specular:
+            pMaterial->setSpecularTexture(pTexture);
+            break;
+        case MaterialSlot_Emissive:
+            pMaterial->setEmissiveTexture(pTexture);
+            break;
+        case MaterialSlot_Normal:
+            pMaterial->setNormalMap(pTexture);
+            break;
+        case MaterialSlot_Occlusion:
+            pMaterial->setOcclusionMap(pTexture);
+            break;
+        case MaterialSlot_LightMap:
+            pMaterial->setLightMap(pTexture);
+            break;
+        case MaterialSlot_Height:
+            pMaterial->setHeightMap(pTexture);
+            break;
+        default:
+            should_not_get_here();
+        }
+    }
+
     static const std::string getSemanticName(AttribType type)
     {
         switch(type)
@@ -511,7 +544,7 @@ namespace Falcor
     {
         if(std::string(formatID) == "BinScene")
         {
-            if(version < 6 || version > 8)
+            if(version < 6 || version > kBinScene9Version)
             {
                 std::string Msg = "Error when loading model " + modelName + ".\nUnsupported binary scene version " + std::to_string(version);
                 logError(Msg);
@@ -570,6 +603,13 @@ namespace Falcor
             return false;
         }
 
+        // v9 is designed to be memory-mapped, there's nothing to stream
+        if(version == kBinScene9Version)
+        {
+            mStream.close();
+            return importMappedModel(model, flags);
+        }
+
         int numTextureSlots;
         int numAttributesType = AttribType_AORadius + 1;
 
@@ -635,6 +675,8 @@ namespace Falcor
 
         // This importer loads mesh/submesh data before instance data, so the meshes are cached here.
         std::vector<Mesh::SharedPtr> falcorMeshCache;
+        MeshOptimizer::VertexCacheStats cacheStatsBefore, cacheStatsAfter;
+        uint32_t lodCount = 0;
         
         struct TexSignature
         {
@@ -887,13 +929,47 @@ namespace Falcor
                 uint32_t ibSize = 3 * numTriangles * sizeof(uint32_t);
                 mStream.read(&indices[0], ibSize);
 
+                // The vertex buffers are shared by all submeshes of the mesh and already created, so only the triangles are reordered
+                if (is_set(flags, Model::LoadFlags::OptimizeVertexOrder) && (positionBufferIndex != kInvalidBufferIndex))
+                {
+                    cacheStatsBefore += MeshOptimizer::analyzeVertexCache(indices.data(), numIndices, (uint32_t)numVertices);
+                    MeshOptimizer::optimizeVertexCache(indices.data(), numIndices, (uint32_t)numVertices);
+                    MeshOptimizer::optimizeOverdraw(indices.data(), numIndices, (const float*)buffers[positionBufferIndex].vec.data(),
+                        pLayout->getBufferLayout(positionBufferIndex)->getStride(), (uint32_t)numVertices);
+                    cacheStatsAfter += MeshOptimizer::analyzeVertexCache(indices.data(), numIndices, (uint32_t)numVertices);
+                }
+
+                // The levels of detail follow the full detail indices in the index buffer. 'indices' keeps the full detail indices for the tangents, bounds and occluders.
+                std::vector<uint32_t> ibData;
+                std::vector<Mesh::Lod> lods;
+                if (is_set(flags, Model::LoadFlags::GenerateLods) && (positionBufferIndex != kInvalidBufferIndex))
+                {
+                    LodVertexData vertices;
+                    vertices.vertexCount = (uint32_t)numVertices;
+                    vertices.pPositions = (const float*)buffers[positionBufferIndex].vec.data();
+                    vertices.positionStride = pLayout->getBufferLayout(positionBufferIndex)->getStride();
+                    if (normalBufferIndex != kInvalidBufferIndex)
+                    {
+                        vertices.pNormals = (const float*)buffers[normalBufferIndex].vec.data();
+                        vertices.normalStride = pLayout->getBufferLayout(normalBufferIndex)->getStride();
+                    }
+                    if (texCoordBufferIndex != kInvalidBufferIndex)
+                    {
+                        vertices.pTexCoords = (const float*)buffers[texCoordBufferIndex].vec.data();
+                        vertices.texCoordStride = pLayout->getBufferLayout(texCoordBufferIndex)->getStride();
+                    }
+                    ibData = indices;
+                    lods = generateLods(ibData, vertices, is_set(flags, Model::LoadFlags::OptimizeVertexOrder));
+                    lodCount += (uint32_t)lods.size();
+                }
+                const std::vector<uint32_t>& ibIndices = lods.empty() ? indices : ibData;
 
                 Buffer::BindFlags ibBindFlags = Buffer::BindFlags::Index;
                 if (is_set(flags, Model::LoadFlags::BuffersAsShaderResource))
                 {
                     ibBindFlags |= Buffer::BindFlags::ShaderResource;
                 }
-                auto pIB = Buffer::create(ibSize, ibBindFlags, Buffer::CpuAccess::None, indices.data());
+                auto pIB = Buffer::create(ibIndices.size() * sizeof(uint32_t), ibBindFlags, Buffer::CpuAccess::None, ibIndices.data());
 
                 // Generate tangent space data if needed
                 if(genTangentForMesh)
@@ -939,6 +1015,21 @@ namespace Falcor
 
                 // create the mesh
                 auto pMesh = Mesh::create(pVBs, numVertices, pIB, numIndices, pLayout, Vao::Topology::TriangleList, pMaterial, box, false);
+                pMesh->setLods(lods);
+
+                if (is_set(flags, Model::LoadFlags::GenerateOccluders))
+                {
+                    auto pOccluder = std::make_shared<Mesh::OccluderGeometry>();
+                    pOccluder->positions.resize(numVertices);
+                    uint32_t posStride = pLayout->getBufferLayout(positionBufferIndex)->getStride();
+                    for (uint32_t i = 0; i < numVertices; i++)
+                    {
+                        const float* pPosition = (const float*)(buffers[positionBufferIndex].vec.data() + posStride * i);
+                        pOccluder->positions[i] = glm::vec3(pPosition[0], pPosition[1], pPosition[2]);
+                    }
+                    pOccluder->indices = indices;
+                    pMesh->setOccluderGeometry(pOccluder);
+                }
 
                 if (version >= 6)
                 {
@@ -974,7 +1065,417 @@ namespace Falcor
                 }
             }
         }
-        
+
+        if (is_set(flags, Model::LoadFlags::OptimizeVertexOrder))
+        {
+            logInfo("BinaryModelImporter: optimized the triangle order of '" + mModelName + "', ACMR " + std::to_string(cacheStatsBefore.getAcmr()) + " -> " +
+                std::to_string(cacheStatsAfter.getAcmr()) + ", ATVR " + std::to_string(cacheStatsBefore.getAtvr()) + " -> " + std::to_string(cacheStatsAfter.getAtvr()));
+        }
+        if (is_set(flags, Model::LoadFlags::GenerateLods))
+        {
+            logInfo("BinaryModelImporter: generated " + std::to_string(lodCount) + " levels of detail for '" + mModelName + "'");
+        }
+        return true;
+    }
+
+    /** Validated view of a memory-mapped v9 file
+    */
+    struct BinScene9View
+    {
+        const uint8_t* pFile = nullptr;
+        size_t fileSize = 0;
+        const BinScene9ChunkEntry* pChunks[ChunkType_Max] = {};
+
+        bool init(const uint8_t* pData, size_t size)
+        {
+            pFile = pData;
+            fileSize = size;
+            if(fileSize < sizeof(BinScene9Header)) return false;
+
+            const BinScene9Header* pHeader = (const BinScene9Header*)pFile;
+            if(pHeader->numChunks < 0 || pHeader->chunkTableOffset > fileSize || (fileSize - pHeader->chunkTableOffset) / sizeof(BinScene9ChunkEntry) < (uint64_t)pHeader->numChunks) return false;
+
+            const BinScene9ChunkEntry* pTable = (const BinScene9ChunkEntry*)(pFile + pHeader->chunkTableOffset);
+            for(int32_t i = 0; i < pHeader->numChunks; i++)
+            {
+                const BinScene9ChunkEntry& chunk = pTable[i];
+                if(chunk.offset > fileSize || chunk.size > fileSize - chunk.offset || chunk.recordCount < 0) return false;
+                // Unknown chunk types are skipped so that later revisions can add chunks
+                if(chunk.type >= 0 && chunk.type < ChunkType_Max)
+                {
+                    pChunks[chunk.type] = &chunk;
+                }
+            }
+            return true;
+        }
+
+        template<typename RecordType>
+        bool getRecords(BinScene9ChunkType type, const RecordType*& pRecords, uint32_t& count) const
+        {
+            pRecords = nullptr;
+            count = 0;
+            const BinScene9ChunkEntry* pChunk = pChunks[type];
+            if(pChunk == nullptr) return true;
+            if(pChunk->size / sizeof(RecordType) < (uint64_t)pChunk->recordCount) return false;
+            pRecords = (const RecordType*)(pFile + pChunk->offset);
+            count = (uint32_t)pChunk->recordCount;
+            return true;
+        }
+
+        /** Returns nullptr if the range is outside of the chunk
+        */
+        const uint8_t* getData(BinScene9ChunkType type, uint64_t offset, uint64_t size) const
+        {
+            const BinScene9ChunkEntry* pChunk = pChunks[type];
+            if(pChunk == nullptr || offset > pChunk->size || size > pChunk->size - offset) return nullptr;
+            return pFile + pChunk->offset + offset;
+        }
+
+        std::string getString(int32_t offset, int32_t length) const
+        {
+            const char* pString = (length > 0 && offset >= 0) ? (const char*)getData(ChunkType_Strings, offset, length) : nullptr;
+            return pString ? std::string(pString, length) : std::string();
+        }
+    };
+
+    /** Size of a tightly packed mip chain, as expected by Texture::create2D()
+    */
+    static uint64_t getMipChainSize(ResourceFormat format, uint32_t width, uint32_t height, uint32_t mipCount)
+    {
+        const uint32_t widthRatio = getFormatWidthCompressionRatio(format);
+        const uint32_t heightRatio = getFormatHeightCompressionRatio(format);
+        uint64_t size = 0;
+        for(uint32_t mip = 0; mip < mipCount; mip++)
+        {
+            uint32_t mipWidth = std::max(1u, width >> mip);
+            uint32_t mipHeight = std::max(1u, height >> mip);
+            size += uint64_t((mipWidth + widthRatio - 1) / widthRatio) * ((mipHeight + heightRatio - 1) / heightRatio) * getFormatBytesPerBlock(format);
+        }
+        return size;
+    }
+
+    bool BinaryModelImporter::importMappedModel(Model& model, Model::LoadFlags flags)
+    {
+        size_t fileSize = 0;
+        const uint8_t* pFile = (const uint8_t*)mapFileForRead(mModelName, fileSize);
+        if(pFile == nullptr)
+        {
+            logError("Error when loading model " + mModelName + ".\nCan't map the file into memory.");
+            return false;
+        }
+
+        // Buffers and textures copy their initial data into the upload heap when they are created, so the view can be released right away
+        bool result = importMappedModel(model, flags, pFile, fileSize);
+        unmapFile(pFile, fileSize);
+        return result;
+    }
+
+    bool BinaryModelImporter::importMappedModel(Model& model, Model::LoadFlags flags, const uint8_t* pFile, size_t fileSize)
+    {
+        const std::string corruptMsg = "Error when loading model " + mModelName + ".\nFile is corrupted.";
+
+        BinScene9View view;
+        const BinScene9Texture* pTextures;
+        const BinScene9Mesh* pMeshes;
+        const BinScene9Stream* pStreams;
+        const BinScene9Submesh* pSubmeshes;
+        const BinScene9Instance* pInstances;
+        const BinScene9Material* pMaterials;
+        const BinScene9Lod* pLods;
+        uint32_t textureCount, meshCount, streamCount, submeshCount, instanceCount, materialCount, lodRecordCount;
+
+        if(view.init(pFile, fileSize) == false ||
+            view.getRecords(ChunkType_Textures, pTextures, textureCount) == false ||
+            view.getRecords(ChunkType_Meshes, pMeshes, meshCount) == false ||
+            view.getRecords(ChunkType_Streams, pStreams, streamCount) == false ||
+            view.getRecords(ChunkType_Submeshes, pSubmeshes, submeshCount) == false ||
+            view.getRecords(ChunkType_Instances, pInstances, instanceCount) == false ||
+            view.getRecords(ChunkType_Materials, pMaterials, materialCount) == false ||
+            (pMaterials && materialCount != submeshCount) ||
+            view.getRecords(ChunkType_Lods, pLods, lodRecordCount) == false)
+        {
+            logError(corruptMsg);
+            return false;
+        }
+
+        // Level 0 of every submesh is implicit. The reduced levels extend the index range of their submesh.
+        std::vector<std::vector<Mesh::Lod>> submeshLods(pLods ? submeshCount : 0);
+        std::vector<uint64_t> submeshIndexCounts(submeshCount);
+        for(uint32_t i = 0; i < submeshCount; i++)
+        {
+            submeshIndexCounts[i] = (uint64_t)std::max(pSubmeshes[i].numIndices, 0);
+        }
+
+        for(uint32_t i = 0; pLods && i < lodRecordCount; i++)
+        {
+            const BinScene9Lod& lod = pLods[i];
+            if(lod.submeshIdx < 0 || lod.submeshIdx >= (int32_t)submeshCount || lod.startIndex < 0 || lod.indexCount <= 0 || lod.indexCount % 3 != 0)
+            {
+                logError(corruptMsg);
+                return false;
+            }
+
+            auto& lods = submeshLods[lod.submeshIdx];
+            const uint32_t prevCount = lods.empty() ? (uint32_t)std::max(pSubmeshes[lod.submeshIdx].numIndices, 0) : lods.back().indexCount;
+            if((uint32_t)lod.indexCount > prevCount || lods.size() + 1 >= Mesh::kMaxLodCount)
+            {
+                logError(corruptMsg);
+                return false;
+            }
+
+            Mesh::Lod meshLod;
+            meshLod.startIndex = lod.startIndex;
+            meshLod.indexCount = lod.indexCount;
+            meshLod.error = lod.error;
+            lods.push_back(meshLod);
+            submeshIndexCounts[lod.submeshIdx] = std::max(submeshIndexCounts[lod.submeshIdx], (uint64_t)lod.startIndex + lod.indexCount);
+        }
+
+        const bool shouldGenerateTangents = is_set(flags, Model::LoadFlags::DontGenerateTangentSpace) == false;
+        const bool loadTexAsSrgb = !is_set(flags, Model::LoadFlags::AssumeLinearSpaceTextures);
+
+        Buffer::BindFlags vbBindFlags = Buffer::BindFlags::Vertex;
+        Buffer::BindFlags ibBindFlags = Buffer::BindFlags::Index;
+        if(is_set(flags, Model::LoadFlags::BuffersAsShaderResource))
+        {
+            vbBindFlags |= Buffer::BindFlags::ShaderResource;
+            ibBindFlags |= Buffer::BindFlags::ShaderResource;
+        }
+
+        // Textures are created when a material references them, since the sRGB conversion depends on the slot
+        std::map<std::pair<int32_t, ResourceFormat>, Texture::SharedPtr> textures;
+        auto getTexture = [&](int32_t texID, const std::function<ResourceFormat(ResourceFormat)>& getSlotFormat) -> Texture::SharedPtr
+        {
+            const BinScene9Texture& tex = pTextures[texID];
+            if(tex.formatID < 0 || tex.formatID >= FW::ImageFormat::ID_Generic || tex.width <= 0 || tex.height <= 0 || tex.mipCount <= 0) return nullptr;
+
+            ResourceFormat format = getSlotFormat(getTextureFormat(FW::ImageFormat::ID(tex.formatID)));
+            auto& pTexture = textures[std::make_pair(texID, format)];
+            if(pTexture == nullptr)
+            {
+                if(tex.dataSize != getMipChainSize(format, tex.width, tex.height, tex.mipCount)) return nullptr;
+                const uint8_t* pData = view.getData(ChunkType_Data, tex.dataOffset, tex.dataSize);
+                if(pData == nullptr) return nullptr;
+
+                // A single level means the exporter didn't have a mip chain, let the texture generate it
+                uint32_t mipLevels = (tex.mipCount == 1) ? Texture::kMaxPossible : tex.mipCount;
+                pTexture = Texture::create2D(tex.width, tex.height, format, 1, mipLevels, pData);
+                pTexture->setSourceFilename(view.getString(tex.nameOffset, tex.nameLength));
+            }
+            return pTexture;
+        };
+
+        std::vector<std::vector<Mesh::SharedPtr>> meshToSubmeshes(meshCount);
+
+        for(uint32_t meshIdx = 0; meshIdx < meshCount; meshIdx++)
+        {
+            const BinScene9Mesh& mesh = pMeshes[meshIdx];
+            if(mesh.numVertices < 0 || mesh.firstStream < 0 || mesh.numStreams < 0 || mesh.firstSubmesh < 0 || mesh.numSubmeshes < 0 ||
+                (uint64_t)mesh.firstStream + mesh.numStreams > streamCount || (uint64_t)mesh.firstSubmesh + mesh.numSubmeshes > submeshCount)
+            {
+                logError(corruptMsg);
+                return false;
+            }
+
+            Vao::BufferVec pVBs(mesh.numStreams);
+            VertexLayout::SharedPtr pLayout = VertexLayout::create();
+            const uint8_t* pPositions = nullptr;
+            uint32_t positionStride = 0;
+            bool hasNormals = false;
+            bool hasBitangents = false;
+
+            for(int32_t i = 0; i < mesh.numStreams; i++)
+            {
+                const BinScene9Stream& stream = pStreams[mesh.firstStream + i];
+                VertexBufferLayout::SharedPtr pBufferLayout = VertexBufferLayout::create();
+                pLayout->addBufferLayout(i, pBufferLayout);
+
+                if(stream.type < 0 || stream.type >= AttribType_Max || stream.format < 0 || stream.format >= AttribFormat_Max || stream.length < 1 || stream.length > 4)
+                {
+                    logError(corruptMsg);
+                    return false;
+                }
+
+                ResourceFormat falcorFormat = getFalcorFormat(AttribFormat(stream.format), stream.length);
+                uint32_t shaderLocation = getShaderLocation(AttribType(stream.type));
+                if(shaderLocation == kUnusedShaderElement)
+                {
+                    continue;
+                }
+
+                // The stream is uploaded as-is, so it has to match the element exactly
+                const uint64_t size = uint64_t(mesh.numVertices) * stream.stride;
+                const uint8_t* pData = view.getData(ChunkType_Data, stream.dataOffset, size);
+                if((uint32_t)stream.stride != getFormatBytesPerBlock(falcorFormat) || pData == nullptr)
+                {
+                    logError(corruptMsg);
+                    return false;
+                }
+
+                pBufferLayout->addElement(getSemanticName(AttribType(stream.type)), 0, falcorFormat, 1, shaderLocation);
+                pVBs[i] = Buffer::create(size, vbBindFlags, Buffer::CpuAccess::None, pData);
+
+                switch(shaderLocation)
+                {
+                case VERTEX_POSITION_LOC:
+                    // The occluder geometry and the bounds read the first three floats of every position
+                    if(falcorFormat != ResourceFormat::RGB32Float && falcorFormat != ResourceFormat::RGBA32Float)
+                    {
+                        logError(corruptMsg);
+                        return false;
+                    }
+                    pPositions = pData;
+                    positionStride = stream.stride;
+                    break;
+                case VERTEX_NORMAL_LOC:
+                    hasNormals = true;
+                    break;
+                case VERTEX_BITANGENT_LOC:
+                    hasBitangents = true;
+                    break;
+                }
+            }
+
+            if(shouldGenerateTangents && hasNormals && hasBitangents == false)
+            {
+                logWarning("Mesh " + std::to_string(meshIdx) + " in model " + mModelName + " was exported without tangent space. Re-export the model to generate it.");
+            }
+
+            for(int32_t submeshIdx = 0; submeshIdx < mesh.numSubmeshes; submeshIdx++)
+            {
+                const BinScene9Submesh& submesh = pSubmeshes[mesh.firstSubmesh + submeshIdx];
+
+                Material::SharedPtr pMaterial;
+                if(pMaterials)
+                {
+                    const BinScene9Material& material = pMaterials[mesh.firstSubmesh + submeshIdx];
+                    pMaterial = Material::create(view.getString(material.nameOffset, material.nameLength));
+                    pMaterial->setShadingModel(material.shadingModel);
+                    pMaterial->setBaseColor(glm::make_vec4(material.baseColor));
+                    pMaterial->setSpecularParams(glm::make_vec4(material.specular));
+                    pMaterial->setEmissiveColor(glm::make_vec3(material.emissive));
+                    pMaterial->setIndexOfRefraction(material.indexOfRefraction);
+                    pMaterial->setAlphaThreshold(material.alphaThreshold);
+                    pMaterial->setAlphaMode(material.alphaMode);
+                    pMaterial->setDoubleSided(material.doubleSided != 0);
+                    pMaterial->setHeightScaleOffset(material.heightScaleOffset[0], material.heightScaleOffset[1]);
+
+                    for(int32_t i = 0; i < MaterialSlot_Max; i++)
+                    {
+                        int32_t texID = material.textures[i];
+                        if(texID < -1 || texID >= (int32_t)textureCount)
+                        {
+                            logError(corruptMsg);
+                            return false;
+                        }
+                        else if(texID != -1)
+                        {
+                            const bool srgb = loadTexAsSrgb && (material.srgbMask & (1u << i));
+                            Texture::SharedPtr pTexture = getTexture(texID, [srgb](ResourceFormat format) { return srgb ? linearToSrgbFormat(format) : format; });
+                            if(pTexture == nullptr)
+                            {
+                                logError(corruptMsg);
+                                return false;
+                            }
+                            setMaterialTexture(pMaterial.get(), pTexture, MaterialSlot(i));
+                        }
+                    }
+                }
+                else
+                {
+                    pMaterial = Material::create("");
+                    pMaterial->setBaseColor(glm::make_vec4(submesh.baseColor));
+                    pMaterial->setSpecularParams(vec4(glm::make_vec3(submesh.specular), submesh.glossiness));
+                    pMaterial->setHeightScaleOffset(submesh.displacementCoef, submesh.displacementBias);
+
+                    for(int32_t i = 0; i < TextureType_Max; i++)
+                    {
+                        int32_t texID = submesh.textures[i];
+                        if(texID < -1 || texID >= (int32_t)textureCount)
+                        {
+                            logError(corruptMsg);
+                            return false;
+                        }
+                        else if(texID != -1)
+                        {
+                            Texture::SharedPtr pTexture = getTexture(texID, [&](ResourceFormat format) { return getFormatFromMapType(loadTexAsSrgb, format, TextureType(i)); });
+                            if(pTexture == nullptr)
+                            {
+                                logError(corruptMsg);
+                                return false;
+                            }
+                            setTexture(pMaterial.get(), pTexture, TextureType(i), mModelName);
+                        }
+                    }
+                }
+                pMaterial = checkForExistingMaterial(pMaterial);
+
+                const uint64_t ibSize = submeshIndexCounts[mesh.firstSubmesh + submeshIdx] * sizeof(uint32_t);
+                const uint32_t* pIndices = (submesh.numIndices >= 0) ? (const uint32_t*)view.getData(ChunkType_Data, submesh.indexOffset, ibSize) : nullptr;
+                if(pIndices == nullptr || pPositions == nullptr)
+                {
+                    logError(corruptMsg);
+                    return false;
+                }
+
+                // The GPU would read out of bounds, and the occluder copy below indexes the positions. This covers the reduced levels as well.
+                const uint32_t* pIndicesEnd = pIndices + ibSize / sizeof(uint32_t);
+                if(std::any_of(pIndices, pIndicesEnd, [&mesh](uint32_t index) { return index >= (uint32_t)mesh.numVertices; }))
+                {
+                    logError(corruptMsg);
+                    return false;
+                }
+
+                auto pIB = Buffer::create(ibSize, ibBindFlags, Buffer::CpuAccess::None, pIndices);
+                BoundingBox box = BoundingBox::fromMinMax(glm::make_vec3(submesh.boundsMin), glm::make_vec3(submesh.boundsMax));
+                auto pMesh = Mesh::create(pVBs, mesh.numVertices, pIB, submesh.numIndices, pLayout, Vao::Topology::TriangleList, pMaterial, box, false);
+                if(submeshLods.empty() == false)
+                {
+                    pMesh->setLods(submeshLods[mesh.firstSubmesh + submeshIdx]);
+                }
+
+                if(is_set(flags, Model::LoadFlags::GenerateOccluders))
+                {
+                    auto pOccluder = std::make_shared<Mesh::OccluderGeometry>();
+                    pOccluder->positions.resize(mesh.numVertices);
+                    for(int32_t i = 0; i < mesh.numVertices; i++)
+                    {
+                        const float* pPosition = (const float*)(pPositions + positionStride * i);
+                        pOccluder->positions[i] = glm::vec3(pPosition[0], pPosition[1], pPosition[2]);
+                    }
+                    pOccluder->indices.assign(pIndices, pIndices + submesh.numIndices);
+                    pMesh->setOccluderGeometry(pOccluder);
+                }
+
+                meshToSubmeshes[meshIdx].push_back(pMesh);
+            }
+        }
+
+        // Validate all instances first, a failed load should leave the model empty
+        for(uint32_t instanceID = 0; instanceID < instanceCount; instanceID++)
+        {
+            if(pInstances[instanceID].meshIdx < -1 || pInstances[instanceID].meshIdx >= (int32_t)meshCount)
+            {
+                logError(corruptMsg);
+                return false;
+            }
+        }
+
+        for(uint32_t instanceID = 0; instanceID < instanceCount; instanceID++)
+        {
+            const BinScene9Instance& instance = pInstances[instanceID];
+            if(instance.enabled && instance.meshIdx != -1)
+            {
+                glm::mat4 transformation = glm::make_mat4(instance.meshToWorld);
+                for(const auto& pMesh : meshToSubmeshes[instance.meshIdx])
+                {
+                    model.addMeshInstance(pMesh, transformation);
+                }
+            }
+        }
+
+        // Same as the v8 path, don't keep the upload heap around after loading the model
+        gpDevice->flushAndSync();
         return true;
     }
 }
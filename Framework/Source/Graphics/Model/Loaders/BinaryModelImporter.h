@@ -49,6 +49,8 @@ namespace Falcor
     private:
         BinaryModelImporter(const std::string& fullpath);
         bool importModel(Model& model, Model::LoadFlags flags);
+        bool importMappedModel(Model& model, Model::LoadFlags flags);
+        bool importMappedModel(Model& model, Model::LoadFlags flags, const uint8_t* pFile, size_t fileSize);
 
         std::string mModelName;
         BinaryFileStream mStream;
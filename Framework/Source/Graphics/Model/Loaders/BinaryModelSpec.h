@@ -26,6 +26,7 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #pragma once
+#include <cstdint>
 
 //------------------------------------------------------------------------
 /*
@@ -115,6 +116,111 @@ Instance
 ?       ?       string  v6  metadataString
 ?
 
+*/
+//------------------------------------------------------------------------
+/*
+
+Binary scene file format v9
+---------------------------
+
+- v9 is a chunked layout designed to be memory-mapped. Nothing needs to be parsed or converted on load; every record is a fixed-size POD struct (see below) and
+  vertex, index and texel data are stored exactly as they are uploaded to the GPU.
+- The basic units of data are 32-bit little-endian ints and floats. Offsets and sizes are 64-bit, in bytes, and relative to the start of the file unless noted otherwise.
+- Every chunk starts on a kBinScene9ChunkAlignment boundary. Blobs inside the Data chunk start on a kBinScene9DataAlignment boundary.
+- Vertex data is stored as one stream per attribute, matching the VertexLayout the loader creates (one VertexBufferLayout per attribute).
+  Tangent space (AttribType_Bitangent) is precomputed by the exporter. Per-submesh bounds are stored so the indices don't need to be scanned.
+- Textures store their complete mip chain in the texture's own format (block-compressed textures stay compressed), tightly packed, mip 0 first.
+
+File
+0       2       string8 v9  formatID            ("BinScene")
+2       1       int     v9  formatVersion       (9)
+3       1       int     v9  numChunks
+4       2       uint64  v9  chunkTableOffset
+6
+
+ChunkEntry (BinScene9ChunkEntry)
+0       1       int     v9  type                (see BinScene9ChunkType)
+1       1       int     v9  recordCount         (number of records for record chunks, 0 for blobs)
+2       2       uint64  v9  offset
+4       2       uint64  v9  size
+6
+
+Texture (BinScene9Texture, ChunkType_Textures)
+0       1       int     v9  nameOffset          (into the Strings chunk)
+1       1       int     v9  nameLength
+2       1       int     v9  formatID            (FW::ImageFormat::ID)
+3       1       int     v9  width
+4       1       int     v9  height
+5       1       int     v9  mipCount            (1 if the loader should generate the mip chain)
+6       2       uint64  v9  dataOffset          (into the Data chunk)
+8       2       uint64  v9  dataSize
+10
+
+Mesh (BinScene9Mesh, ChunkType_Meshes)
+0       1       int     v9  numVertices
+1       1       int     v9  firstStream
+2       1       int     v9  numStreams
+3       1       int     v9  firstSubmesh
+4       1       int     v9  numSubmeshes
+5       1       int     v9  reserved
+6
+
+Stream (BinScene9Stream, ChunkType_Streams)
+0       1       int     v9  type                (see AttribType)
+1       1       int     v9  format              (see AttribFormat)
+2       1       int     v9  length
+3       1       int     v9  stride
+4       2       uint64  v9  dataOffset          (into the Data chunk, numVertices * stride bytes)
+6       2       uint64  v9  dataSize
+8
+
+Submesh (BinScene9Submesh, ChunkType_Submeshes)
+0       4       float   v9  baseColor
+4       3       float   v9  specular
+7       1       float   v9  glossiness
+8       1       float   v9  displacementCoef
+9       1       float   v9  displacementBias
+10      7       int     v9  textures            (indexed by TextureType, -1 if none)
+17      1       int     v9  numIndices
+18      3       float   v9  boundsMin
+21      3       float   v9  boundsMax
+24      2       uint64  v9  indexOffset         (into the Data chunk, numIndices 32-bit indices)
+26
+
+Material (BinScene9Material, ChunkType_Materials, optional)
+- One record per Submesh, in the same order. When the chunk is present it replaces the material fields of the Submesh records.
+0       1       int     v9  nameOffset          (into the Strings chunk)
+1       1       int     v9  nameLength
+2       4       float   v9  baseColor
+6       4       float   v9  specular            (specular color and glossiness, or the Metal-Rough parameters)
+10      3       float   v9  emissive
+13      1       float   v9  indexOfRefraction
+14      1       float   v9  alphaThreshold
+15      2       float   v9  heightScaleOffset
+17      1       int     v9  shadingModel
+18      1       int     v9  alphaMode
+19      1       int     v9  doubleSided
+20      7       int     v9  textures            (indexed by MaterialSlot, -1 if none)
+27      1       int     v9  srgbMask            (bit per MaterialSlot, set if the texture is sampled as sRGB)
+28
+
+Instance (BinScene9Instance, ChunkType_Instances)
+0       1       int     v9  meshIdx
+1       1       bool    v9  enabled
+2       16      float   v9  meshToWorld         (column-major 4x4 matrix)
+18      1       int     v9  nameOffset          (into the Strings chunk)
+19      1       int     v9  nameLength
+20
+
+Lod (BinScene9Lod, ChunkType_Lods, optional)
+- Reduced levels of detail, sorted by submesh and from fine to coarse. Level 0 of every submesh is its numIndices indices.
+- The indices of the reduced levels follow the full detail indices of their submesh in the Data chunk, so all levels share one index buffer.
+0       1       int     v9  submeshIdx
+1       1       int     v9  startIndex          (relative to the indexOffset of the submesh)
+2       1       int     v9  indexCount
+3       1       float   v9  error               (object space distance to the full detail surface)
+4
+
 */
 //------------------------------------------------------------------------
 
@@ -154,3 +260,139 @@ enum TextureType
     TextureType_Glossiness,     // Glossiness map.
     TextureType_Max
 };
+
+enum BinScene9ChunkType
+{
+    ChunkType_Textures = 0,
+    ChunkType_Meshes,
+    ChunkType_Streams,
+    ChunkType_Submeshes,
+    ChunkType_Instances,
+    ChunkType_Strings,
+    ChunkType_Data,
+    ChunkType_Materials,
+    ChunkType_Lods,
+    ChunkType_Max
+};
+
+enum MaterialSlot
+{
+    MaterialSlot_BaseColor = 0,
+    MaterialSlot_Specular,
+    MaterialSlot_Emissive,
+    MaterialSlot_Normal,
+    MaterialSlot_Occlusion,
+    MaterialSlot_LightMap,
+    MaterialSlot_Height,
+    MaterialSlot_Max
+};
+
+static const uint32_t kBinScene9Version = 9;
+static const uint64_t kBinScene9ChunkAlignment = 4096;
+static const uint64_t kBinScene9DataAlignment = 256;
+
+struct BinScene9Header
+{
+    char formatID[8];
+    int32_t formatVersion;
+    int32_t numChunks;
+    uint64_t chunkTableOffset;
+};
+
+struct BinScene9ChunkEntry
+{
+    int32_t type;
+    int32_t recordCount;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct BinScene9Texture
+{
+    int32_t nameOffset;
+    int32_t nameLength;
+    int32_t formatID;
+    int32_t width;
+    int32_t height;
+    int32_t mipCount;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+struct BinScene9Mesh
+{
+    int32_t numVertices;
+    int32_t firstStream;
+    int32_t numStreams;
+    int32_t firstSubmesh;
+    int32_t numSubmeshes;
+    int32_t reserved;
+};
+
+struct BinScene9Stream
+{
+    int32_t type;
+    int32_t format;
+    int32_t length;
+    int32_t stride;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+struct BinScene9Submesh
+{
+    float baseColor[4];
+    float specular[3];
+    float glossiness;
+    float displacementCoef;
+    float displacementBias;
+    int32_t textures[TextureType_Max];
+    int32_t numIndices;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint64_t indexOffset;
+};
+
+struct BinScene9Material
+{
+    int32_t nameOffset;
+    int32_t nameLength;
+    float baseColor[4];
+    float specular[4];
+    float emissive[3];
+    float indexOfRefraction;
+    float alphaThreshold;
+    float heightScaleOffset[2];
+    int32_t shadingModel;
+    int32_t alphaMode;
+    int32_t doubleSided;
+    int32_t textures[MaterialSlot_Max];
+    uint32_t srgbMask;
+};
+
+struct BinScene9Instance
+{
+    int32_t meshIdx;
+    int32_t enabled;
+    float meshToWorld[16];
+    int32_t nameOffset;
+    int32_t nameLength;
+};
+
+struct BinScene9Lod
+{
+    int32_t submeshIdx;
+    int32_t startIndex;
+    int32_t indexCount;
+    float error;
+};
+
+static_assert(sizeof(BinScene9Header) == 24, "BinScene9Header doesn't match the spec");
+static_assert(sizeof(BinScene9ChunkEntry) == 24, "BinScene9ChunkEntry doesn't match the spec");
+static_assert(sizeof(BinScene9Texture) == 40, "BinScene9Texture doesn't match the spec");
+static_assert(sizeof(BinScene9Mesh) == 24, "BinScene9Mesh doesn't match the spec");
+static_assert(sizeof(BinScene9Stream) == 32, "BinScene9Stream doesn't match the spec");
+static_assert(sizeof(BinScene9Submesh) == 104, "BinScene9Submesh doesn't match the spec");
+static_assert(sizeof(BinScene9Material) == 112, "BinScene9Material doesn't match the spec");
+static_assert(sizeof(BinScene9Instance) == 80, "BinScene9Instance doesn't match the spec");
+static_assert(sizeof(BinScene9Lod) == 16, "BinScene9Lod doesn't match the spec");
@@ -28,9 +28,17 @@
 
 #include "Framework.h"
 #include "Graphics/Model/Loaders/ModelImporter.h"
+#include "Utils/Math/MeshOptimizer.h"
+#include "Utils/Math/MeshSimplifier.h"
 
 namespace Falcor
 {
+    // The attribute weights scale attribute differences to position errors relative to the mesh extent, see MeshSimplifier
+    static const uint32_t kLodMinTriangleCount = 64;
+    static const float kLodMaxError = 0.05f;
+    static const float kLodNormalWeight = 0.05f;
+    static const float kLodTexCoordWeight = 0.02f;
+
     Material::SharedPtr ModelImporter::checkForExistingMaterial(const Material::SharedPtr& pMaterial)
     {
         // Check if the material already exists
@@ -46,4 +54,38 @@ namespace Falcor
         mLoadedMaterials.push_back(pMaterial);
         return pMaterial;
     }
+
+    std::vector<Mesh::Lod> ModelImporter::generateLods(std::vector<uint32_t>& indices, const LodVertexData& vertices, bool optimizeTriangleOrder)
+    {
+        std::vector<MeshSimplifier::Attribute> attributes;
+        if (vertices.pNormals)
+        {
+            attributes.push_back({ vertices.pNormals, vertices.normalStride, 3, kLodNormalWeight });
+        }
+        if (vertices.pTexCoords)
+        {
+            attributes.push_back({ vertices.pTexCoords, vertices.texCoordStride, vertices.texCoordComponentCount, kLodTexCoordWeight });
+        }
+
+        std::vector<MeshSimplifier::Lod> levels = MeshSimplifier::generateLods(indices.data(), indices.size(), vertices.pPositions, vertices.positionStride,
+            vertices.vertexCount, attributes, Mesh::kMaxLodCount - 1, kLodMinTriangleCount, kLodMaxError);
+
+        // Every level is a range of the index buffer after the full detail indices
+        std::vector<Mesh::Lod> lods;
+        for (auto& level : levels)
+        {
+            if (optimizeTriangleOrder)
+            {
+                MeshOptimizer::optimizeVertexCache(level.indices.data(), level.indices.size(), vertices.vertexCount);
+                MeshOptimizer::optimizeOverdraw(level.indices.data(), level.indices.size(), vertices.pPositions, vertices.positionStride, vertices.vertexCount);
+            }
+            Mesh::Lod lod;
+            lod.startIndex = (uint32_t)indices.size();
+            lod.indexCount = (uint32_t)level.indices.size();
+            lod.error = level.error;
+            lods.push_back(lod);
+            indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+        }
+        return lods;
+    }
 }
@@ -30,6 +30,7 @@
 
 #include <vector>
 #include "Graphics/Material/Material.h"
+#include "Graphics/Model/Mesh.h"
 
 namespace Falcor
 {
@@ -47,6 +48,27 @@ namespace Falcor
         */
         Material::SharedPtr checkForExistingMaterial(const Material::SharedPtr& pMaterial);
 
+        /** Vertex data of a triangle list, see generateLods()
+        */
+        struct LodVertexData
+        {
+            uint32_t vertexCount = 0;
+            const float* pPositions = nullptr;
+            size_t positionStride = 0;
+            const float* pNormals = nullptr;        ///< Optional
+            size_t normalStride = 0;
+            const float* pTexCoords = nullptr;      ///< Optional
+            size_t texCoordStride = 0;
+            uint32_t texCoordComponentCount = 2;
+        };
+
+        /** Generate the levels of detail of a triangle list for Model::LoadFlags::GenerateLods. Normals and texture coordinates are preserved if available.
+            \param[in,out] indices Full detail indices, the indices of the levels are appended
+            \param[in] optimizeTriangleOrder Optimize every level for the vertex cache and overdraw, like Model::LoadFlags::OptimizeVertexOrder does for the full detail mesh
+            \return The appended levels, ordered from fine to coarse
+        */
+        static std::vector<Mesh::Lod> generateLods(std::vector<uint32_t>& indices, const LodVertexData& vertices, bool optimizeTriangleOrder);
+
         std::vector<Material::SharedPtr> mLoadedMaterials; // vector because we make use of operator==, and it's only for the importers
     };
 }
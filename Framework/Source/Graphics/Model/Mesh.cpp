@@ -43,6 +43,7 @@
 namespace Falcor
 { 
     uint32_t Mesh::sMeshCounter = 0;
+    const uint32_t Mesh::kMaxLodCount;
     Mesh::~Mesh() = default;
 
     Mesh::SharedPtr Mesh::create(const Vao::BufferVec& vertexBuffers,
@@ -96,6 +97,22 @@ namespace Falcor
         mPrimitiveCount = mIndexCount / VertsPerPrim;
 
         mpVao = Vao::create(topology, pLayout, vertexBuffers, pIndexBuffer, ResourceFormat::R32Uint);
+
+        Lod fullDetail;
+        fullDetail.indexCount = indexCount;
+        mLods.push_back(fullDetail);
+    }
+
+    void Mesh::setLods(const std::vector<Lod>& lods)
+    {
+        assert(lods.size() < kMaxLodCount);
+        mLods.resize(1);
+        for (const Lod& lod : lods)
+        {
+            assert(uint64_t(lod.startIndex + lod.indexCount) * sizeof(uint32_t) <= mpVao->getIndexBuffer()->getSize());
+            assert(lod.indexCount < mLods.back().indexCount);
+            mLods.push_back(lod);
+        }
     }
 
     void Mesh::resetGlobalIdCounter()
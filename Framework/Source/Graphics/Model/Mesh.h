@@ -56,6 +56,26 @@ namespace Falcor
         using SharedPtr = std::shared_ptr<Mesh>;
         using SharedConstPtr = std::shared_ptr<const Mesh>;
 
+        /** CPU copy of a triangle list mesh, used to rasterize the mesh as an occluder with the SoftwareOcclusionCuller
+        */
+        struct OccluderGeometry
+        {
+            using SharedConstPtr = std::shared_ptr<const OccluderGeometry>;
+            std::vector<glm::vec3> positions;   ///< Object space
+            std::vector<uint32_t> indices;      ///< Three per triangle
+        };
+
+        /** A level of detail, a range of the index buffer drawn with the vertex buffers of the mesh
+        */
+        struct Lod
+        {
+            uint32_t startIndex = 0;
+            uint32_t indexCount = 0;
+            float error = 0.0f;                 ///< Object space distance to the full detail mesh
+        };
+
+        static const uint32_t kMaxLodCount = 8;
+
         /** create a new mesh
             \param[in] VertexBuffers Vector of vertex buffer descriptors
             \param[in] VertexCount Number of vertices in the vertex buffer
@@ -96,6 +116,19 @@ namespace Falcor
         */
         uint32_t getIndexCount() const { return mIndexCount; }
 
+        /** Set the levels of detail after the full detail mesh, ordered from fine to coarse. The index ranges have to be inside the index buffer.
+            Meshes are created with a single level covering getIndexCount() indices from the start of the index buffer.
+        */
+        void setLods(const std::vector<Lod>& lods);
+
+        /** Get the number of levels of detail, including the full detail mesh
+        */
+        uint32_t getLodCount() const { return (uint32_t)mLods.size(); }
+
+        /** Get a level of detail. Level 0 is the full detail mesh.
+        */
+        const Lod& getLod(uint32_t level) const { return mLods[level]; }
+
         /** Get a pointer to the mesh's material
         */
         const Material::SharedPtr& getMaterial() const { return mpMaterial; }
@@ -108,6 +141,14 @@ namespace Falcor
         */
         void setMaterial(const Material::SharedPtr& pMaterial) { mpMaterial = pMaterial; }
 
+        /** Set the occluder geometry. Meshes with occluder geometry are rasterized as occluders if occlusion culling is enabled in the SceneRenderer.
+        */
+        void setOccluderGeometry(const OccluderGeometry::SharedConstPtr& pGeometry) { mpOccluderGeometry = pGeometry; }
+
+        /** Get the occluder geometry. nullptr unless it was set or the model was loaded with Model::LoadFlags::GenerateOccluders.
+        */
+        const OccluderGeometry::SharedConstPtr& getOccluderGeometry() const { return mpOccluderGeometry; }
+
         /** Get the vertex array object matching the mesh
         */
         const Vao::SharedPtr& getVao() const { return mpVao; }
@@ -152,5 +193,7 @@ namespace Falcor
         Material::SharedPtr mpMaterial;
         BoundingBox mBoundingBox;
         Vao::SharedPtr mpVao;
+        OccluderGeometry::SharedConstPtr mpOccluderGeometry;
+        std::vector<Lod> mLods;
     };
 }
\ No newline at end of file
@@ -30,6 +30,7 @@
 #include "Loaders/AssimpModelImporter.h"
 #include "Loaders/BinaryModelImporter.h"
 #include "Loaders/BinaryModelExporter.h"
+#include "ModelImportCache.h"
 #include "Utils/Platform/OS.h"
 #include "Mesh.h"
 #include "AnimationController.h"
@@ -131,7 +132,8 @@ namespace Falcor
         }
         else
         {
-            res = AssimpModelImporter::import(*pModel, filename, flags);
+            // Assimp post-processing is the expensive part, serve it from the import cache when the source didn't change
+            res = ModelImportCache::import(*pModel, filename, flags, [&](Model& model) { return AssimpModelImporter::import(model, filename, flags); });
         }
 
         if(res)
@@ -68,6 +68,9 @@ namespace Falcor
             RemoveInstancing            = 0x20,   ///< Flatten mesh instances
             UseSpecGlossMaterials       = 0x40,   ///< Set materials to use Spec-Gloss shading model. Otherwise default is Metal-Rough for FBX, Spec-Gloss for OBJ.
             UseMetalRoughMaterials      = 0x80,   ///< Set materials to use Metal-Rough shading model. Otherwise default is Metal-Rough for FBX, Spec-Gloss for OBJ.
+            GenerateOccluders           = 0x100,  ///< Keep a CPU copy of the positions and indices of static triangle meshes, so that they can be used as occluders for software occlusion culling
+            OptimizeVertexOrder         = 0x200,  ///< Reorder triangles for the post-transform cache and for less overdraw, and vertices for sequential vertex fetch
+            GenerateLods                = 0x400,  ///< Generate a chain of simplified index ranges for static triangle meshes, selected at draw time by their screen-space error
         };
 
         /** Create a new model from file
@@ -0,0 +1,351 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ModelImportCache.h"
+#include "Loaders/BinaryModelImporter.h"
+#include "Loaders/BinaryModelExporter.h"
+#include "Loaders/BinaryModelSpec.h"
+#include "Mesh.h"
+#include "Utils/DiskCacheIndex.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/Platform/OS.h"
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
+
+namespace Falcor
+{
+    const uint32_t ModelImportCache::kImporterVersion;
+    const uint64_t ModelImportCache::kDefaultSizeLimit;
+
+    struct ImportCacheState
+    {
+        std::mutex mutex;
+        bool enabled = true;
+        bool indexLoaded = false;
+        std::string directory;
+        uint64_t sizeLimit = ModelImportCache::kDefaultSizeLimit;
+        DiskCacheIndex index;
+        ModelImportCache::Stats stats;
+    };
+
+    static ImportCacheState& getState()
+    {
+        static ImportCacheState state;
+        return state;
+    }
+
+    static std::string getEntryPath(const ImportCacheState& state, const std::string& key)
+    {
+        return state.directory + "/" + key + ".bin";
+    }
+
+    static std::string getIndexPath(const ImportCacheState& state)
+    {
+        return state.directory + "/index.txt";
+    }
+
+    // The caller holds the lock
+    static void loadIndex(ImportCacheState& state)
+    {
+        if (state.indexLoaded) return;
+        state.indexLoaded = true;
+
+        if (state.directory.empty())
+        {
+            state.directory = getExecutableDirectory() + "/ModelCache";
+        }
+        if (isDirectoryExists(state.directory) == false)
+        {
+            createDirectory(state.directory);
+        }
+
+        std::string indexPath = getIndexPath(state);
+        if (doesFileExist(indexPath) && state.index.deserialize(readFile(indexPath)) == false)
+        {
+            logWarning("Model import cache index " + indexPath + " is corrupted. Starting with an empty cache.");
+        }
+
+        // Drop entries whose file was deleted behind our back
+        std::vector<std::string> missing;
+        for (const auto& key : state.index.getKeys())
+        {
+            if (doesFileExist(getEntryPath(state, key)) == false) missing.push_back(key);
+        }
+        for (const auto& key : missing)
+        {
+            state.index.remove(key);
+        }
+    }
+
+    // The caller holds the lock
+    static void saveIndex(const ImportCacheState& state)
+    {
+        std::ofstream stream(getIndexPath(state), std::ios::binary | std::ios::trunc);
+        stream << state.index.serialize();
+    }
+
+    static void removeEntry(ImportCacheState& state, const std::string& key)
+    {
+        state.index.remove(key);
+        std::remove(getEntryPath(state, key).c_str());
+    }
+
+    static bool computeKey(const std::string& fullpath, Model::LoadFlags flags, std::string& key)
+    {
+        size_t size = 0;
+        const void* pData = mapFileForRead(fullpath, size);
+        if (pData == nullptr) return false;
+        uint64_t hash = DiskCacheIndex::hash(pData, size);
+        unmapFile(pData, size);
+
+        // Relative texture references resolve against the source directory, so identical files in different directories get different entries
+        std::string directory = getDirectoryFromFile(fullpath);
+        const uint32_t versions[] = { ModelImportCache::kImporterVersion, kBinScene9Version, (uint32_t)flags };
+        hash = DiskCacheIndex::hash(directory.data(), directory.size(), hash);
+        hash = DiskCacheIndex::hash(versions, sizeof(versions), hash);
+        key = DiskCacheIndex::keyToString(hash);
+        return true;
+    }
+
+    static std::vector<std::pair<std::string, int64_t>> getDependencies(const Model& model)
+    {
+        std::set<std::string> files;
+        for (uint32_t meshID = 0; meshID < model.getMeshCount(); meshID++)
+        {
+            const Material* pMaterial = model.getMesh(meshID)->getMaterial().get();
+            const Texture::SharedPtr textures[] = { pMaterial->getBaseColorTexture(), pMaterial->getSpecularTexture(), pMaterial->getEmissiveTexture(),
+                pMaterial->getNormalMap(), pMaterial->getOcclusionMap(), pMaterial->getLightMap(), pMaterial->getHeightMap() };
+            for (const auto& pTexture : textures)
+            {
+                if (pTexture && doesFileExist(pTexture->getSourceFilename())) files.insert(pTexture->getSourceFilename());
+            }
+        }
+
+        std::vector<std::pair<std::string, int64_t>> dependencies;
+        for (const auto& f : files)
+        {
+            dependencies.push_back({ f, (int64_t)getFileModifiedTime(f) });
+        }
+        return dependencies;
+    }
+
+    static bool isUpToDate(const DiskCacheIndex::Entry& entry)
+    {
+        for (const auto& d : entry.dependencies)
+        {
+            if (doesFileExist(d.first) == false || (int64_t)getFileModifiedTime(d.first) != d.second) return false;
+        }
+        return true;
+    }
+
+    static void storeEntry(ImportCacheState& state, const Model& model, const std::string& key, const std::string& fullpath)
+    {
+        std::string reason;
+        if (BinaryModelExporter::canExport(&model, reason) == false)
+        {
+            logInfo("Model import cache: not caching " + fullpath + ", " + reason + ".");
+            return;
+        }
+
+        std::string entryPath, tempPath;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            entryPath = getEntryPath(state, key);
+            tempPath = entryPath + ".tmp";
+        }
+
+        // Export to a temporary file and rename, so another process never sees a partial entry
+        BinaryModelExporter::exportToFile(tempPath, &model);
+        std::ifstream file(tempPath, std::ios::binary | std::ios::ate);
+        if (file.is_open() == false)
+        {
+            logWarning("Model import cache: failed to store " + fullpath + ".");
+            return;
+        }
+        DiskCacheIndex::Entry entry;
+        entry.size = (uint64_t)file.tellg();
+        entry.dependencies = getDependencies(model);
+        file.close();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (replaceFile(tempPath, entryPath) == false)
+        {
+            std::remove(tempPath.c_str());
+            return;
+        }
+
+        std::vector<std::string> evicted = state.index.insert(key, entry, state.sizeLimit);
+        for (const auto& e : evicted)
+        {
+            std::remove(getEntryPath(state, e).c_str());
+        }
+        state.stats.stores++;
+        state.stats.evictions += (uint32_t)evicted.size();
+        saveIndex(state);
+    }
+
+    bool ModelImportCache::import(Model& model, const std::string& filename, Model::LoadFlags flags, const ImportFunc& importFunc)
+    {
+        ImportCacheState& state = getState();
+        std::string fullpath;
+        std::string key;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.enabled == false) return importFunc(model);
+        }
+
+        // Let the importer report missing files
+        if (findFileInDataDirectories(filename, fullpath) == false || computeKey(fullpath, flags, key) == false)
+        {
+            return importFunc(model);
+        }
+
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        std::string entryPath;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            loadIndex(state);
+            const DiskCacheIndex::Entry* pEntry = state.index.find(key);
+            if (pEntry && isUpToDate(*pEntry))
+            {
+                entryPath = getEntryPath(state, key);
+            }
+            else if (pEntry)
+            {
+                removeEntry(state, key);
+            }
+        }
+
+        if (entryPath.empty() == false)
+        {
+            if (BinaryModelImporter::import(model, entryPath, flags))
+            {
+                double time = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.index.touch(key);
+                state.stats.hits++;
+                state.stats.hitTime += time;
+                saveIndex(state);
+                logInfo("Model import cache: loaded " + fullpath + " from " + entryPath + " in " + std::to_string(time) + " ms");
+                return true;
+            }
+
+            // Unreadable entry. The binary importer validates everything before adding instances, so the model is still empty.
+            std::lock_guard<std::mutex> lock(state.mutex);
+            removeEntry(state, key);
+        }
+
+        bool result = importFunc(model);
+        if (result)
+        {
+            storeEntry(state, model, key, fullpath);
+        }
+
+        double time = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stats.misses++;
+        state.stats.missTime += time;
+        return result;
+    }
+
+    void ModelImportCache::setEnabled(bool enabled)
+    {
+        ImportCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.enabled = enabled;
+    }
+
+    bool ModelImportCache::isEnabled()
+    {
+        ImportCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        return state.enabled;
+    }
+
+    void ModelImportCache::setDirectory(const std::string& directory)
+    {
+        ImportCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.directory = directory;
+        state.index.clear();
+        state.indexLoaded = false;
+    }
+
+    std::string ModelImportCache::getDirectory()
+    {
+        ImportCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        loadIndex(state);
+        return state.directory;
+    }
+
+    void ModelImportCache::setSizeLimit(uint64_t sizeLimit)
+    {
+        ImportCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        loadIndex(state);
+        state.sizeLimit = sizeLimit;
+        std::vector<std::string> evicted = state.index.evict(sizeLimit);
+        for (const auto& e : evicted)
+        {
+            std::remove(getEntryPath(state, e).c_str());
+        }
+        if (evicted.size())
+        {
+            state.stats.evictions += (uint32_t)evicted.size();
+            saveIndex(state);
+        }
+    }
+
+    ModelImportCache::Stats ModelImportCache::getStats()
+    {
+        ImportCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        loadIndex(state);
+        Stats stats = state.stats;
+        stats.entryCount = state.index.getCount();
+        stats.size = state.index.getTotalSize();
+        stats.sizeLimit = state.sizeLimit;
+        return stats;
+    }
+
+    void ModelImportCache::clear()
+    {
+        ImportCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        loadIndex(state);
+        for (const auto& key : state.index.getKeys())
+        {
+            std::remove(getEntryPath(state, key).c_str());
+        }
+        state.index.clear();
+        saveIndex(state);
+    }
+}
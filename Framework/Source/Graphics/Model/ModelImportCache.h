@@ -0,0 +1,93 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/Model/Model.h"
+#include <functional>
+
+namespace Falcor
+{
+    /** Persistent on-disk cache of imported models.
+        Entries are keyed by a hash of the source file contents, the source directory (relative texture references resolve against it), the
+        Model::LoadFlags and the importer version. They are stored in the BinScene v9 format, which loads through a memory-mapped view without
+        any post-processing. The texture files an entry was built from are recorded with their modification times, and an entry is rebuilt when
+        one of them changes. The total size is kept under a limit by evicting the least recently used entries.
+        Models with bones or animations are not cached, since the binary format can't store them.
+    */
+    class ModelImportCache
+    {
+    public:
+        using ImportFunc = std::function<bool(Model& model)>;
+
+        struct Stats
+        {
+            uint32_t hits = 0;          ///< Loads served from the cache
+            uint32_t misses = 0;        ///< Loads that had to run the importer
+            uint32_t stores = 0;        ///< Entries written
+            uint32_t evictions = 0;     ///< Entries removed to stay under the size limit
+            uint32_t entryCount = 0;    ///< Entries currently in the cache
+            uint64_t size = 0;          ///< Current size of the cache in bytes
+            uint64_t sizeLimit = 0;     ///< Size limit in bytes
+            double hitTime = 0;         ///< Total time spent loading from the cache, in milliseconds
+            double missTime = 0;        ///< Total time spent importing and storing on misses, in milliseconds
+        };
+
+        /** Bump whenever an importer changes its output, so that stale entries are rebuilt
+        */
+        static const uint32_t kImporterVersion = 1;
+        static const uint64_t kDefaultSizeLimit = 4ull << 30;
+
+        /** Import a model through the cache. On a miss, importFunc runs the regular importer and the result is stored.
+            \param[in] model The model to load into
+            \param[in] filename Model's filename. The cache looks for it in the data directories.
+            \param[in] flags Flags controlling model creation, part of the cache key
+            \param[in] importFunc Imports the model from the source file
+            \return The result of the cached load or of importFunc
+        */
+        static bool import(Model& model, const std::string& filename, Model::LoadFlags flags, const ImportFunc& importFunc);
+
+        /** Enable or disable the cache. Enabled by default.
+        */
+        static void setEnabled(bool enabled);
+        static bool isEnabled();
+
+        /** Set the cache directory. Defaults to 'ModelCache' in the executable directory.
+        */
+        static void setDirectory(const std::string& directory);
+        static std::string getDirectory();
+
+        /** Set the size limit in bytes. Least recently used entries are evicted immediately if the cache is larger.
+        */
+        static void setSizeLimit(uint64_t sizeLimit);
+
+        static Stats getStats();
+
+        /** Delete all entries
+        */
+        static void clear();
+    };
+}
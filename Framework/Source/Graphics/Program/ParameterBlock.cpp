@@ -645,9 +645,10 @@ namespace Falcor
         // Allocate the missing sets
         for (uint32_t i = 0; i < mRootSets.size(); i++)
         {
-            mRootSets[i].dirty = (mRootSets[i].pSet == nullptr);
+            // The flag is only written for new sets and cleared by the vars binding them, so preparing a clean block doesn't write to it
             if (mRootSets[i].pSet == nullptr)
             {
+                mRootSets[i].dirty = true;
                 DescriptorSet::Layout layout;
                 const auto& set = mpReflector->getDescriptorSetLayouts()[i];
                 mRootSets[i].pSet = DescriptorSet::create(gpDevice->getGpuDescriptorPool(), set);
@@ -218,7 +218,7 @@ namespace Falcor
         ConstantBuffer::SharedPtr getConstantBuffer(uint32_t) const = delete;
 
         // #PARAMBLOCK I don't like it. This should be private
-        /** Data structure describing a descriptor set. The dirty flag will tell us whether or not the set has changed since the last call to prepareForDraw()
+        /** Data structure describing a descriptor set. The dirty flag will tell us whether or not prepareForDraw() created a new set which wasn't bound yet
         */
         struct RootSet
         {
@@ -38,6 +38,11 @@
 #include "API/RenderContext.h"
 #include "Utils/StringUtils.h"
 #include "ShaderLibrary.h"
+#include "ShaderCache.h"
+#include "Utils/DiskCacheIndex.h"
+#include "Utils/CpuTimer.h"
+#include <mutex>
+#include <set>
 
 namespace Falcor
 {
@@ -168,6 +173,21 @@ namespace Falcor
     {
         mDesc = desc;
         mDefineList = programDefines;
+
+        // Programs created from strings have no stable name, so they don't take part in the manifest
+        for (uint32_t i = 0; i < kShaderCount; i++)
+        {
+            const auto& entryPoint = mDesc.mEntryPoints[i];
+            if (entryPoint.isValid() == false) continue;
+            const auto& src = mDesc.mSources[entryPoint.index];
+            if (src.type != Desc::Source::Type::File)
+            {
+                mManifestName.clear();
+                break;
+            }
+            if (mManifestName.size()) mManifestName += " ";
+            mManifestName += src.pLibrary->getFilename() + ":" + entryPoint.name;
+        }
     }
 
     Program::~Program()
@@ -327,35 +347,133 @@ namespace Falcor
             const auto& it = mProgramVersions.find(mDefineList);
             if(it == mProgramVersions.end())
             {
-                if(link() == false)
+                bool firstVersion = (mActiveProgram.pVersion == nullptr);
+                bool async = mAsyncCompilation && (firstVersion == false) && ProgramCompiler::isEnabled();
+
+                auto pending = mPendingVariants.find(mDefineList);
+                if (pending == mPendingVariants.end() && async)
+                {
+                    pending = queueVariant(mDefineList);
+                }
+
+                bool linked = false;
+                if (pending != mPendingVariants.end())
+                {
+                    if (async && pending->second.pJob->isReady() == false)
+                    {
+                        // Keep rendering with the previous version until the new one is ready
+                        ProgramCompiler::recordFallback();
+                        return mActiveProgram.pVersion;
+                    }
+                    linked = installPendingVariant(pending);
+                }
+
+                // A failed background compilation is linked again here, which reports the error
+                if (linked == false && link() == false)
                 {
                     return nullptr;
                 }
-                else
+                mProgramVersions[mDefineList] = mActiveProgram;
+                ProgramCompiler::recordVariant(mManifestName, mDefineList);
+
+                if (firstVersion && mManifestName.size())
                 {
-                    mProgramVersions[mDefineList] = mActiveProgram;
+                    for (const auto& defines : ProgramCompiler::getManifestVariants(mManifestName))
+                    {
+                        prewarm(defines);
+                    }
                 }
             }
             else
             {
-                mActiveProgram = mProgramVersions[mDefineList];
+                mActiveProgram = it->second;
             }
         }
 
         return mActiveProgram.pVersion;
     }
 
+    bool Program::isActiveVersionReady() const
+    {
+        const auto& it = mProgramVersions.find(mDefineList);
+        return it != mProgramVersions.end() && it->second.pVersion == mActiveProgram.pVersion;
+    }
+
+    void Program::prewarm(const DefineList& defines) const
+    {
+        if (ProgramCompiler::isEnabled() == false) return;
+        if (mProgramVersions.find(defines) != mProgramVersions.end() || mPendingVariants.find(defines) != mPendingVariants.end()) return;
+        queueVariant(defines);
+    }
+
+    Program::PendingVariantMap::iterator Program::queueVariant(const DefineList& defines) const
+    {
+        PendingVariant pending;
+        pending.pVariant = std::make_shared<CompiledVariant>();
+
+        // The job works on copies, so it doesn't matter if the program is destroyed before it runs
+        Desc desc = mDesc;
+        auto pVariant = pending.pVariant;
+        pending.pJob = ProgramCompiler::submit([desc, defines, pVariant]() { compileVariant(desc, defines, true, *pVariant); });
+        return mPendingVariants.emplace(defines, pending).first;
+    }
+
+    bool Program::installPendingVariant(PendingVariantMap::iterator it) const
+    {
+        PendingVariant pending = it->second;
+        mPendingVariants.erase(it);
+
+        if (pending.pJob->isReady() == false)
+        {
+            CpuTimer::TimePoint waitStart = CpuTimer::getCurrentTimePoint();
+            pending.pJob->wait();
+            ProgramCompiler::recordWait(CpuTimer::calcDuration(waitStart, CpuTimer::getCurrentTimePoint()));
+        }
+
+        // Failed compilations have no reflection data
+        if (pending.pVariant->reflectors.pReflector == nullptr) return false;
+
+        std::string log;
+        VersionData version = createVersion(*pending.pVariant, log);
+        if (version.pVersion == nullptr) return false;
+        mActiveProgram = version;
+        return true;
+    }
+
+    struct SlangBuiltins
+    {
+        std::mutex mutex;
+        std::vector<std::pair<std::string, std::string>> modules;
+    };
+
+    static SlangBuiltins& getSlangBuiltins()
+    {
+        static SlangBuiltins builtins;
+        return builtins;
+    }
+
     SlangSession* getSlangSession()
     {
         // TODO: figure out a strategy for finalizing the Slang session, if desired
 
-        static SlangSession* slangSession = spCreateSession(NULL);
+        // Sessions are not thread-safe, so every thread which compiles programs has its own. Builtins are added to all of them.
+        thread_local SlangSession* slangSession = spCreateSession(NULL);
+        thread_local size_t builtinCount = 0;
+
+        SlangBuiltins& builtins = getSlangBuiltins();
+        std::lock_guard<std::mutex> lock(builtins.mutex);
+        for (; builtinCount < builtins.modules.size(); builtinCount++)
+        {
+            spAddBuiltins(slangSession, builtins.modules[builtinCount].first.c_str(), builtins.modules[builtinCount].second.c_str());
+        }
         return slangSession;
     }
 
     void loadSlangBuiltins(char const* name, char const* text)
     {
-        spAddBuiltins(getSlangSession(), name, text);
+        SlangBuiltins& builtins = getSlangBuiltins();
+        std::lock_guard<std::mutex> lock(builtins.mutex);
+        builtins.modules.push_back({ name, text });
     }
 
     // Translation a Falcor `ShaderType` to the corresponding `SlangStage`
@@ -394,9 +512,125 @@ namespace Falcor
 #endif
     }
 
-    Program::VersionData Program::preprocessAndCreateProgramVersion(std::string& log) const
+    static uint64_t hashString(const std::string& str, uint64_t seed)
     {
-        mFileTimeMap.clear();
+        uint64_t size = str.size();
+        return DiskCacheIndex::hash(str.data(), str.size(), DiskCacheIndex::hash(&size, sizeof(size), seed));
+    }
+
+    std::string Program::computeShaderCacheKey(const Desc& desc, const DefineList& defines)
+    {
+        const uint32_t versions[] = { ShaderCache::kFormatVersion, (uint32_t)desc.getCompilerFlags(), (uint32_t)desc.mSources.size() };
+        uint64_t hash = DiskCacheIndex::hash(versions, sizeof(versions));
+#ifdef FALCOR_VK
+        hash = hashString("FALCOR_VK", hash);
+#elif defined FALCOR_D3D12
+        hash = hashString("FALCOR_D3D", hash);
+#endif
+        hash = hashString(desc.mShaderModel, hash);
+
+        // The source files are hashed by content. Included files are validated against the entry's dependency list when it's loaded.
+        for (const auto& src : desc.mSources)
+        {
+            if (src.type == Desc::Source::Type::File)
+            {
+                std::string fullpath;
+                uint64_t fileHash;
+                if (findFileInDataDirectories(src.pLibrary->getFilename(), fullpath) == false || ShaderCache::hashFile(fullpath, fileHash) == false) return "";
+                hash = hashString(fullpath, hash);
+                hash = DiskCacheIndex::hash(&fileHash, sizeof(fileHash), hash);
+            }
+            else
+            {
+                hash = hashString(src.str, hash);
+            }
+        }
+
+        for (uint32_t i = 0; i < kShaderCount; i++)
+        {
+            const auto& entryPoint = desc.mEntryPoints[i];
+            hash = DiskCacheIndex::hash(&entryPoint.index, sizeof(entryPoint.index), hash);
+            if (entryPoint.isValid()) hash = hashString(entryPoint.name, hash);
+        }
+
+        for (const auto& define : defines)
+        {
+            hash = hashString(define.first, hash);
+            hash = hashString(define.second, hash);
+        }
+
+        // Include resolution depends on the search paths
+        for (const auto& path : getDataDirectoriesList())
+        {
+            hash = hashString(path, hash);
+        }
+        return DiskCacheIndex::keyToString(hash);
+    }
+
+    bool Program::loadFromShaderCache(const std::string& key, CompiledVariant& variant)
+    {
+        ShaderCache::Entry entry;
+        if (ShaderCache::load(key, entry) == false) return false;
+
+        for (uint32_t i = 0; i < kShaderCount; i++)
+        {
+            if (entry.code[i].size() != 0) variant.shaderBlob[i] = ShaderCache::createBlob(entry.code[i]);
+        }
+
+        size_t offset = 0;
+        ProgramReflectors& reflectors = variant.reflectors;
+        reflectors.pReflector = ProgramReflection::deserialize(entry.reflection, offset);
+        reflectors.pLocalReflector = reflectors.pReflector ? ProgramReflection::deserialize(entry.reflection, offset) : nullptr;
+        reflectors.pGlobalReflector = reflectors.pLocalReflector ? ProgramReflection::deserialize(entry.reflection, offset) : nullptr;
+        if (reflectors.pGlobalReflector == nullptr)
+        {
+            logWarning("Shader cache entry " + key + " has invalid reflection data. Recompiling.");
+            variant = CompiledVariant();
+            return false;
+        }
+
+        for (const auto& d : entry.dependencies)
+        {
+            variant.fileTimes[d] = getFileModifiedTime(d);
+        }
+        variant.fromCache = true;
+        return true;
+    }
+
+    void Program::storeInShaderCache(const std::string& key, const Desc& desc, const CompiledVariant& variant, double compileTime)
+    {
+        ShaderCache::Entry entry;
+        for (uint32_t i = 0; i < kShaderCount; i++)
+        {
+            if (variant.shaderBlob[i]) entry.code[i].assign((const char*)variant.shaderBlob[i]->getBufferPointer(), variant.shaderBlob[i]->getBufferSize());
+        }
+        variant.reflectors.pReflector->serialize(entry.reflection);
+        variant.reflectors.pLocalReflector->serialize(entry.reflection);
+        variant.reflectors.pGlobalReflector->serialize(entry.reflection);
+
+        // Slang reports the included files. Add the source files in case they are not part of the list.
+        std::set<std::string> dependencies;
+        for (const auto& f : variant.fileTimes) dependencies.insert(f.first);
+        for (const auto& src : desc.mSources)
+        {
+            std::string fullpath;
+            if (src.type == Desc::Source::Type::File && findFileInDataDirectories(src.pLibrary->getFilename(), fullpath)) dependencies.insert(fullpath);
+        }
+        entry.dependencies.assign(dependencies.begin(), dependencies.end());
+        ShaderCache::store(key, entry, compileTime);
+    }
+
+    bool Program::compileVariant(const Desc& desc, const DefineList& defines, bool useCache, CompiledVariant& variant)
+    {
+        // Intermediates are only dumped by an actual compilation, so bypass the cache when they are requested
+        bool dumpIR = is_set(desc.getCompilerFlags(), Shader::CompilerFlags::DumpIntermediates);
+        std::string cacheKey;
+        if (useCache && dumpIR == false && ShaderCache::isEnabled())
+        {
+            cacheKey = computeShaderCacheKey(desc, defines);
+            if (cacheKey.size() && loadFromShaderCache(cacheKey, variant)) return true;
+        }
+        CpuTimer::TimePoint compileStart = CpuTimer::getCurrentTimePoint();
 
         // Run all of the shaders through Slang, so that we can get final code,
         // reflection data, etc.
@@ -419,12 +653,11 @@ namespace Falcor
         }
 
         // Enable/disable intermediates dump
-        bool dumpIR = is_set(mDesc.getCompilerFlags(), Shader::CompilerFlags::DumpIntermediates);
         spSetDumpIntermediates(slangRequest, dumpIR);
 
         // Pass any `#define` flags along to Slang, since we aren't doing our
         // own preprocessing any more.
-        for(auto shaderDefine : mDefineList)
+        for(auto shaderDefine : defines)
         {
             spAddPreprocessorDefine(slangRequest, shaderDefine.first.c_str(), shaderDefine.second.c_str());
         }
@@ -438,17 +671,17 @@ namespace Falcor
 #elif defined FALCOR_D3D12
         preprocessorDefine = "FALCOR_D3D";
         // If the profile string starts with a `4_` or a `5_`, use DXBC. Otherwise, use DXIL
-        if (hasPrefix(mDesc.mShaderModel, "4_") || hasPrefix(mDesc.mShaderModel, "5_")) slangTarget = SLANG_DXBC;
+        if (hasPrefix(desc.mShaderModel, "4_") || hasPrefix(desc.mShaderModel, "5_")) slangTarget = SLANG_DXBC;
         else                                                                            slangTarget = SLANG_DXIL;
 #else
 #error unknown shader compilation target
 #endif
         spSetCodeGenTarget(slangRequest, slangTarget);
         spAddPreprocessorDefine(slangRequest, preprocessorDefine, "1");
-        std::string sm = "__SM_" + mDesc.mShaderModel + "__";
+        std::string sm = "__SM_" + desc.mShaderModel + "__";
         spAddPreprocessorDefine(slangRequest, sm.c_str(), "1");
 
-        spSetTargetProfile(slangRequest, 0, spFindProfile(slangSession, getSlangProfileString(mDesc.mShaderModel).c_str()));
+        spSetTargetProfile(slangRequest, 0, spFindProfile(slangSession, getSlangProfileString(desc.mShaderModel).c_str()));
 
         // We always use row-major matrix layout (and when we invoke fxc/dxc we pass in the
         // appropriate flags to request this behavior), so we need to inform Slang that
@@ -457,8 +690,8 @@ namespace Falcor
         spSetTargetMatrixLayoutMode(slangRequest, 0, SLANG_MATRIX_LAYOUT_ROW_MAJOR);
 
         // Set floating point mode. If no shader compiler flags for this were set, we use Slang's default mode.
-        bool flagFast = is_set(mDesc.getCompilerFlags(), Shader::CompilerFlags::FloatingPointModeFast);
-        bool flagPrecise = is_set(mDesc.getCompilerFlags(), Shader::CompilerFlags::FloatingPointModePrecise);
+        bool flagFast = is_set(desc.getCompilerFlags(), Shader::CompilerFlags::FloatingPointModeFast);
+        bool flagPrecise = is_set(desc.getCompilerFlags(), Shader::CompilerFlags::FloatingPointModePrecise);
         if (flagFast && flagPrecise)
         {
             logWarning("Shader compiler flags 'FloatingPointModeFast' and 'FloatingPointModePrecise' can't be used simultaneously. Ignoring 'FloatingPointModeFast'.");
@@ -480,7 +713,7 @@ namespace Falcor
         // Now lets add all our input shader code, one-by-one
         int translationUnitsAdded = 0;
 
-        for(auto src : mDesc.mSources)
+        for(auto src : desc.mSources)
         {
             // Register the translation unit with Slang
             int translationUnitIndex = spAddTranslationUnit(slangRequest, SLANG_SOURCE_LANGUAGE_SLANG, nullptr);
@@ -498,8 +731,9 @@ namespace Falcor
                 std::string fullpath;
                 if (!findFileInDataDirectories(src.pLibrary->getFilename(), fullpath))
                 {
-                    logError(std::string("Can't find file ") + src.pLibrary->getFilename(), true);
-                    return VersionData();
+                    variant.log += std::string("Can't find file ") + src.pLibrary->getFilename() + "\n";
+                    spDestroyCompileRequest(slangRequest);
+                    return false;
                 }
                 spAddTranslationUnitSourceFile(slangRequest, translationUnitIndex, fullpath.c_str());
             }
@@ -516,7 +750,7 @@ namespace Falcor
         // indices directly.
         for(uint32_t i = 0; i < kShaderCount; ++i)
         {
-            auto& entryPoint = mDesc.mEntryPoints[i];
+            auto& entryPoint = desc.mEntryPoints[i];
 
             // Skip unused entry points
             if(entryPoint.index < 0)
@@ -530,20 +764,19 @@ namespace Falcor
         }
 
         int anySlangErrors = spCompile(slangRequest);
-        log += spGetDiagnosticOutput(slangRequest);
+        variant.log += spGetDiagnosticOutput(slangRequest);
         if(anySlangErrors)
         {
             spDestroyCompileRequest(slangRequest);
-            return VersionData();
+            return false;
         }
 
         // Extract the generated code for each stage
         int entryPointCounter = 0;
-        Shader::Blob shaderBlob[kShaderCount];
 
         for (uint32_t i = 0; i < kShaderCount; i++)
         {
-            auto& entryPoint = mDesc.mEntryPoints[i];
+            auto& entryPoint = desc.mEntryPoints[i];
             // Skip unused entry points
             if(entryPoint.index < 0)
                 continue;
@@ -551,30 +784,41 @@ namespace Falcor
             int entryPointIndex = entryPointCounter++;
             int targetIndex = 0; // We always compile for a single target
 
-            spGetEntryPointCodeBlob(slangRequest, entryPointIndex, targetIndex, shaderBlob[i].writeRef());
+            spGetEntryPointCodeBlob(slangRequest, entryPointIndex, targetIndex, variant.shaderBlob[i].writeRef());
         }
 
-        VersionData programVersion;
-
         // Extract the reflection data
-        programVersion.reflectors.pReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::All, log);
-        programVersion.reflectors.pLocalReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::Local, log);
-        programVersion.reflectors.pGlobalReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::Global, log);
+        variant.reflectors.pReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::All, variant.log);
+        variant.reflectors.pLocalReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::Local, variant.log);
+        variant.reflectors.pGlobalReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::Global, variant.log);
 
         // Extract list of files referenced, for dependency-tracking purposes
         int depFileCount = spGetDependencyFileCount(slangRequest);
         for(int ii = 0; ii < depFileCount; ++ii)
         {
             std::string depFilePath = spGetDependencyFilePath(slangRequest, ii);
-            mFileTimeMap[depFilePath] = getFileModifiedTime(depFilePath);
+            variant.fileTimes[depFilePath] = getFileModifiedTime(depFilePath);
         }
 
         spDestroyCompileRequest(slangRequest);
 
-        // Now that we've preprocessed things, dispatch to the actual program creation logic,
-        // which may vary in subclasses of `Program`
-        programVersion.pVersion = createProgramVersion(log, shaderBlob, programVersion.reflectors);
+        if (cacheKey.size())
+        {
+            storeInShaderCache(cacheKey, desc, variant, CpuTimer::calcDuration(compileStart, CpuTimer::getCurrentTimePoint()));
+        }
+        return true;
+    }
 
+    Program::VersionData Program::createVersion(const CompiledVariant& variant, std::string& log) const
+    {
+        // Dispatch to the actual program creation logic, which may vary in subclasses of `Program`
+        VersionData programVersion;
+        programVersion.reflectors = variant.reflectors;
+        programVersion.pVersion = createProgramVersion(log, variant.shaderBlob, variant.reflectors);
+        if (programVersion.pVersion)
+        {
+            for (const auto& f : variant.fileTimes) mFileTimeMap[f.first] = f.second;
+        }
         return programVersion;
     }
 
@@ -616,7 +860,21 @@ namespace Falcor
         {
             // create the program
             std::string log;
-            VersionData programVersion = preprocessAndCreateProgramVersion(log);
+            VersionData programVersion;
+            CompiledVariant variant;
+            if (compileVariant(mDesc, mDefineList, true, variant))
+            {
+                programVersion = createVersion(variant, log);
+
+                // Creating the shaders can still fail, e.g. if the driver rejects cached code. Fall back to compiling in that case.
+                if (programVersion.pVersion == nullptr && variant.fromCache)
+                {
+                    log.clear();
+                    variant = CompiledVariant();
+                    if (compileVariant(mDesc, mDefineList, false, variant)) programVersion = createVersion(variant, log);
+                }
+            }
+            log = variant.log + log;
 
             if(programVersion.pVersion == nullptr)
             {
@@ -647,6 +905,7 @@ namespace Falcor
     {
         mActiveProgram = VersionData();
         mProgramVersions.clear();
+        mPendingVariants.clear();
         mFileTimeMap.clear();
         mLinkRequired = true;
     }
@@ -30,6 +30,7 @@
 #include <map>
 #include <vector>
 #include "Graphics/Program//ProgramVersion.h"
+#include "Graphics/Program/ProgramCompiler.h"
 
 namespace Falcor
 {
@@ -215,10 +216,30 @@ namespace Falcor
 
         virtual ~Program() = 0;
 
-        /** Get the API handle of the active program
+        /** Get the API handle of the active program.
+            With async compilation enabled, this returns the previous version while the version matching the current defines is compiled in the background.
         */
         ProgramVersion::SharedConstPtr getActiveVersion() const;
 
+        /** Enable or disable async compilation. When enabled, a define change doesn't block getActiveVersion(). The new version is compiled by the ProgramCompiler,
+            and the previous version stays active until it's ready. The first version is always linked synchronously.
+            Only enable this for programs which can render with stale defines for a few frames, and whose variants share the same resource layout.
+        */
+        void setAsyncCompilation(bool enable) { mAsyncCompilation = enable; }
+        bool isAsyncCompilationEnabled() const { return mAsyncCompilation; }
+
+        /** Check if the active version matches the current defines. False while getActiveVersion() returns the previous version.
+        */
+        bool isActiveVersionReady() const;
+
+        /** Queue a variant for background compilation, so that switching to it later doesn't stall. Does nothing if the variant exists or is already queued.
+        */
+        void prewarm(const DefineList& defines) const;
+
+        /** Get the name identifying the program in the variant manifest, or an empty string if the program was created from a string
+        */
+        const std::string& getManifestName() const { return mManifestName; }
+
         /** Adds a macro definition to the program. If the macro already exists, it will be replaced.
             \param[in] name The name of define.
             \param[in] value Optional. The value of the define string.
@@ -289,10 +310,38 @@ namespace Falcor
             ProgramReflectors reflectors;
         };
 
+        using string_time_map = std::unordered_map<std::string, time_t>;
+
+        // The result of compiling a variant, before the API objects are created
+        struct CompiledVariant
+        {
+            Shader::Blob shaderBlob[kShaderCount];
+            ProgramReflectors reflectors;
+            string_time_map fileTimes;
+            bool fromCache = false;
+            std::string log;
+        };
+
+        struct PendingVariant
+        {
+            ProgramCompiler::Job::SharedPtr pJob;
+            std::shared_ptr<CompiledVariant> pVariant;
+        };
+        using PendingVariantMap = std::map<DefineList, PendingVariant>;
+
         bool link() const;
-        VersionData preprocessAndCreateProgramVersion(std::string& log) const;
+
+        // Compiles a variant with Slang or loads it from the shader cache. Doesn't touch the program, so it can run on any thread.
+        static bool compileVariant(const Desc& desc, const DefineList& defines, bool useCache, CompiledVariant& variant);
+        static std::string computeShaderCacheKey(const Desc& desc, const DefineList& defines);
+        static bool loadFromShaderCache(const std::string& key, CompiledVariant& variant);
+        static void storeInShaderCache(const std::string& key, const Desc& desc, const CompiledVariant& variant, double compileTime);
+        VersionData createVersion(const CompiledVariant& variant, std::string& log) const;
         virtual ProgramVersion::SharedPtr createProgramVersion(std::string& log, const Shader::Blob shaderBlob[kShaderCount], const ProgramReflectors& reflectors) const;
 
+        PendingVariantMap::iterator queueVariant(const DefineList& defines) const;
+        bool installPendingVariant(PendingVariantMap::iterator it) const;
+
         // The description used to create this program
         Desc mDesc;
 
@@ -302,11 +351,13 @@ namespace Falcor
         mutable bool mLinkRequired = true;
         mutable std::map<const DefineList, VersionData> mProgramVersions;
         mutable VersionData mActiveProgram;
+        mutable PendingVariantMap mPendingVariants;
+        bool mAsyncCompilation = false;
+        std::string mManifestName;
 
         std::string getProgramDescString() const;
         static std::vector<Program*> sPrograms;
 
-        using string_time_map = std::unordered_map<std::string, time_t>;
         mutable string_time_map mFileTimeMap;
 
         bool checkIfFilesChanged();
@@ -0,0 +1,356 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ProgramCompiler.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/WorkStealingPool.h"
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace Falcor
+{
+    struct ProgramCompilerState
+    {
+        // Taken in the constructor, so the shared pool is destroyed after the state and the destructor can wait for the workers
+        WorkStealingPool::SharedPtr pPool = WorkStealingPool::getShared();
+        std::mutex mutex;
+        std::condition_variable condition;  ///< Signaled when a worker stops
+        std::deque<ProgramCompiler::Job::SharedPtr> queue;
+        uint32_t workerCount = 0;           ///< Background jobs of the pool working on the queue
+        uint32_t threadCount = 0;
+        bool enabled = true;
+        std::map<std::string, std::set<ProgramCompiler::DefineList>> manifest;
+        ProgramCompiler::Stats stats;
+
+        ~ProgramCompilerState();
+    };
+
+    static ProgramCompilerState& getState()
+    {
+        static ProgramCompilerState state;
+        return state;
+    }
+
+    static uint32_t getDefaultThreadCount()
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        return std::max(1u, std::min(4u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u));
+    }
+
+    static void workerLoop();
+
+    // The caller holds the lock. Starts a worker per queued job, as long as fewer than threadCount are running.
+    static void startWorkers(ProgramCompilerState& state, std::unique_lock<std::mutex>& lock)
+    {
+        if (state.threadCount == 0) state.threadCount = getDefaultThreadCount();
+        uint32_t startCount = 0;
+        while (state.workerCount < state.threadCount && startCount < state.queue.size())
+        {
+            state.workerCount++;
+            startCount++;
+        }
+
+        // A pool without worker threads runs the job right here, and the worker takes the lock
+        lock.unlock();
+        for (uint32_t i = 0; i < startCount; i++) state.pPool->submitBackground(workerLoop);
+        lock.lock();
+    }
+
+    ProgramCompilerState::~ProgramCompilerState()
+    {
+        // Jobs which haven't started are dropped, the running ones finish
+        std::unique_lock<std::mutex> lock(mutex);
+        queue.clear();
+        condition.wait(lock, [this]() { return workerCount == 0; });
+    }
+
+    static void runJob(const std::function<void()>& func)
+    {
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        func();
+        double time = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+        ProgramCompilerState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stats.completed++;
+        state.stats.compileTime += time;
+    }
+
+    // Runs as a background job of the shared pool, and gives the pool thread back once the queue is empty
+    static void workerLoop()
+    {
+        ProgramCompilerState& state = getState();
+        while (true)
+        {
+            ProgramCompiler::Job::SharedPtr pJob;
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (state.queue.empty() || state.workerCount > state.threadCount)
+                {
+                    state.workerCount--;
+                    state.condition.notify_all();
+                    return;
+                }
+                pJob = state.queue.front();
+                state.queue.pop_front();
+            }
+            // Jobs which were already taken by a waiting thread are skipped
+            pJob->wait();
+        }
+    }
+
+    bool ProgramCompiler::Job::isReady() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mState == State::Done;
+    }
+
+    bool ProgramCompiler::Job::tryRun()
+    {
+        std::function<void()> func;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mState != State::Queued) return false;
+            mState = State::Running;
+            func.swap(mFunc);
+        }
+
+        runJob(func);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mState = State::Done;
+        }
+        mCondition.notify_all();
+        return true;
+    }
+
+    void ProgramCompiler::Job::wait()
+    {
+        // Running the job here is never slower than waiting for a worker to get to it
+        if (tryRun()) return;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() { return mState == State::Done; });
+    }
+
+    ProgramCompiler::Job::SharedPtr ProgramCompiler::submit(const std::function<void()>& func)
+    {
+        Job::SharedPtr pJob = std::make_shared<Job>();
+        pJob->mFunc = func;
+
+        ProgramCompilerState& state = getState();
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.queue.push_back(pJob);
+        state.stats.queued++;
+        startWorkers(state, lock);
+        return pJob;
+    }
+
+    void ProgramCompiler::setEnabled(bool enabled)
+    {
+        ProgramCompilerState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.enabled = enabled;
+    }
+
+    bool ProgramCompiler::isEnabled()
+    {
+        ProgramCompilerState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        return state.enabled;
+    }
+
+    void ProgramCompiler::setThreadCount(uint32_t threadCount)
+    {
+        ProgramCompilerState& state = getState();
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.threadCount = threadCount ? threadCount : getDefaultThreadCount();
+
+        // Workers above the new count stop after their current job
+        startWorkers(state, lock);
+    }
+
+    void ProgramCompiler::waitIdle()
+    {
+        std::vector<Job::SharedPtr> jobs;
+        {
+            ProgramCompilerState& state = getState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            jobs.assign(state.queue.begin(), state.queue.end());
+        }
+
+        for (auto& pJob : jobs) pJob->wait();
+
+        // Jobs a worker took before the copy above
+        ProgramCompilerState& state = getState();
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (state.stats.completed == state.stats.queued) return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    static bool isWritableToken(const std::string& s)
+    {
+        return s.empty() == false && s.find_first_of(" \t\r\n|=#") == std::string::npos;
+    }
+
+    static bool isWritableValue(const std::string& s)
+    {
+        return s.find_first_of(" \t\r\n|") == std::string::npos;
+    }
+
+    bool ProgramCompiler::loadManifest(const std::string& filename)
+    {
+        std::ifstream stream(filename);
+        if (stream.good() == false) return false;
+
+        std::map<std::string, std::set<DefineList>> loaded;
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            if (line.empty() == false && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            size_t separator = line.find(" |");
+            if (separator == std::string::npos)
+            {
+                logWarning("ProgramCompiler: ignoring malformed manifest line '" + line + "' in " + filename);
+                continue;
+            }
+
+            std::string programName = line.substr(0, separator);
+            DefineList defines;
+            std::istringstream defineStream(line.substr(separator + 2));
+            std::string token;
+            while (defineStream >> token)
+            {
+                size_t equal = token.find('=');
+                if (equal == std::string::npos)
+                {
+                    defines.add(token);
+                }
+                else
+                {
+                    defines.add(token.substr(0, equal), token.substr(equal + 1));
+                }
+            }
+            loaded[programName].insert(defines);
+        }
+
+        ProgramCompilerState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (auto& l : loaded)
+        {
+            state.manifest[l.first] = std::move(l.second);
+        }
+        return true;
+    }
+
+    bool ProgramCompiler::saveManifest(const std::string& filename)
+    {
+        std::string data = "# Shader variants prewarmed at load, one per line: <program> | <define>[=<value>] ...\n";
+        {
+            ProgramCompilerState& state = getState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            for (const auto& program : state.manifest)
+            {
+                for (const auto& defines : program.second)
+                {
+                    data += program.first + " |";
+                    for (const auto& d : defines)
+                    {
+                        data += " " + d.first;
+                        if (d.second.empty() == false) data += "=" + d.second;
+                    }
+                    data += "\n";
+                }
+            }
+        }
+
+        std::ofstream stream(filename, std::ios::trunc);
+        stream << data;
+        return stream.good();
+    }
+
+    std::vector<ProgramCompiler::DefineList> ProgramCompiler::getManifestVariants(const std::string& programName)
+    {
+        ProgramCompilerState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto it = state.manifest.find(programName);
+        if (it == state.manifest.end()) return {};
+        return std::vector<DefineList>(it->second.begin(), it->second.end());
+    }
+
+    void ProgramCompiler::recordVariant(const std::string& programName, const DefineList& defines)
+    {
+        if (programName.empty() || programName.find(" |") != std::string::npos || programName[0] == '#') return;
+        for (const auto& d : defines)
+        {
+            if (isWritableToken(d.first) == false || isWritableValue(d.second) == false) return;
+        }
+
+        ProgramCompilerState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.manifest[programName].insert(defines);
+    }
+
+    void ProgramCompiler::recordFallback()
+    {
+        ProgramCompilerState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stats.fallbacks++;
+    }
+
+    void ProgramCompiler::recordWait(double waitTime)
+    {
+        ProgramCompilerState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stats.waits++;
+        state.stats.waitTime += waitTime;
+    }
+
+    ProgramCompiler::Stats ProgramCompiler::getStats()
+    {
+        ProgramCompilerState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        Stats stats = state.stats;
+        stats.pending = stats.queued - stats.completed;
+        stats.threadCount = state.workerCount;
+        return stats;
+    }
+}
@@ -0,0 +1,140 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/Shader.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Falcor
+{
+    /** Compiles program variants on background jobs of the shared WorkStealingPool, so that define changes don't stall the render thread.
+        Programs hand variants to the compiler when they are prewarmed, and when a program with async compilation enabled switches to a variant
+        which doesn't exist yet. See Program::prewarm() and Program::setAsyncCompilation().
+        The compiler also keeps a variant manifest, a list of define combinations per program. Every program queues the variants listed for it
+        once its first version is linked. The manifest can be written by hand or recorded from a session with saveManifest().
+    */
+    class ProgramCompiler
+    {
+    public:
+        using DefineList = Shader::DefineList;
+
+        /** Handle to a queued compilation
+        */
+        class Job
+        {
+        public:
+            using SharedPtr = std::shared_ptr<Job>;
+
+            /** Check if the job has finished
+            */
+            bool isReady() const;
+
+            /** Block until the job has finished. A job which hasn't started yet runs on the calling thread instead of waiting for a worker.
+            */
+            void wait();
+
+        private:
+            friend class ProgramCompiler;
+            enum class State
+            {
+                Queued,
+                Running,
+                Done
+            };
+
+            bool tryRun();
+
+            std::function<void()> mFunc;
+            mutable std::mutex mMutex;
+            std::condition_variable mCondition;
+            State mState = State::Queued;
+        };
+
+        struct Stats
+        {
+            uint32_t queued = 0;        ///< Jobs handed to the compiler
+            uint32_t completed = 0;     ///< Jobs that finished, on a worker or on a waiting thread
+            uint32_t pending = 0;       ///< Jobs queued or running
+            uint32_t fallbacks = 0;     ///< Program::getActiveVersion() calls answered with the previous version
+            uint32_t waits = 0;         ///< Program::getActiveVersion() calls which had to wait for a job
+            uint32_t threadCount = 0;   ///< Pool workers currently taking jobs from the queue
+            double compileTime = 0;     ///< Total time spent in jobs, in milliseconds
+            double waitTime = 0;        ///< Total time Program::getActiveVersion() was blocked by jobs, in milliseconds
+        };
+
+        /** Queue a function for the worker threads
+        */
+        static Job::SharedPtr submit(const std::function<void()>& func);
+
+        /** Enable or disable background compilation. When disabled, programs link every variant synchronously and prewarming does nothing. Enabled by default.
+        */
+        static void setEnabled(bool enabled);
+        static bool isEnabled();
+
+        /** Set how many workers of the shared pool may compile at the same time. 0 picks a default based on the hardware thread count,
+            leaving a core for the render thread. Every compiling worker is missing from WorkStealingPool::parallelFor() calls.
+        */
+        static void setThreadCount(uint32_t threadCount);
+
+        /** Block until all queued jobs have finished
+        */
+        static void waitIdle();
+
+        /** Load a variant manifest. Replaces the variants of the programs listed in the file.
+            Every line describes one variant as '<program> | <define>[=<value>] ...'. The program is identified by Program::getManifestName(). Lines starting with '#' are ignored.
+            \return false if the file can't be read
+        */
+        static bool loadManifest(const std::string& filename);
+
+        /** Write the manifest, including every variant recorded in this session
+        */
+        static bool saveManifest(const std::string& filename);
+
+        /** Get the manifest variants of a program
+        */
+        static std::vector<DefineList> getManifestVariants(const std::string& programName);
+
+        /** Add a variant to the manifest. Variants whose defines can't be written to a manifest line are ignored.
+        */
+        static void recordVariant(const std::string& programName, const DefineList& defines);
+
+        /** Count a Program::getActiveVersion() call which returned the previous version
+        */
+        static void recordFallback();
+
+        /** Count a Program::getActiveVersion() call which had to wait for a job
+            \param[in] waitTime Time the call was blocked, in milliseconds
+        */
+        static void recordWait(double waitTime);
+
+        static Stats getStats();
+    };
+}
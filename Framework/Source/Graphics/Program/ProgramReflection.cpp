@@ -28,6 +28,7 @@
 #include "Framework.h"
 #include "ProgramReflection.h"
 #include "Utils/StringUtils.h"
+#include <cstring>
 using namespace slang;
 
 namespace Falcor
@@ -1462,4 +1463,342 @@ namespace Falcor
         const auto& offsetIt = mOffsetDescMap.find(offset);
         return (offsetIt == mOffsetDescMap.end()) ? empty : offsetIt->second;
     }
+
+    /** Binary writer and reader for ProgramReflection::serialize()/deserialize().
+        Types and variables referenced from several places are written once and referenced by index afterwards, so the object graph is restored
+        as it was. Objects get their index after their children, which lets the reader create every object in one go.
+    */
+    class ReflectionSerializer
+    {
+    public:
+        ReflectionSerializer(std::string& data) : mpOut(&data) {}
+        ReflectionSerializer(const std::string& data, size_t offset) : mpIn(&data), mOffset(offset) {}
+
+        void write(const void* pData, size_t size) { mpOut->append((const char*)pData, size); }
+        template<typename T> void write(T value) { write(&value, sizeof(T)); }
+
+        void writeString(const std::string& str)
+        {
+            write((uint32_t)str.size());
+            write(str.data(), str.size());
+        }
+
+        void writeType(const ReflectionType::SharedConstPtr& pType)
+        {
+            if (writeReference(pType.get(), mWrittenTypes)) return;
+
+            write((uint32_t)pType->getType());
+            write((uint64_t)pType->mOffset);
+            switch (pType->getType())
+            {
+            case ReflectionType::Type::Array:
+            {
+                const ReflectionArrayType* pArray = pType->asArrayType();
+                write(pArray->getArraySize());
+                write(pArray->getArrayStride());
+                writeType(pArray->getType());
+            }
+            break;
+            case ReflectionType::Type::Struct:
+            {
+                const ReflectionStructType* pStruct = pType->asStructType();
+                write((uint64_t)pStruct->getSize());
+                writeString(pStruct->getName());
+                write(pStruct->getMemberCount());
+                for (const auto& pMember : *pStruct) writeVar(pMember);
+            }
+            break;
+            case ReflectionType::Type::Basic:
+            {
+                const ReflectionBasicType* pBasic = pType->asBasicType();
+                write((int32_t)pBasic->getType());
+                write((uint8_t)pBasic->isRowMajor());
+                write((uint64_t)pBasic->getSize());
+            }
+            break;
+            case ReflectionType::Type::Resource:
+            {
+                const ReflectionResourceType* pResource = pType->asResourceType();
+                write((uint32_t)pResource->getType());
+                write((uint32_t)pResource->getDimensions());
+                write((uint32_t)pResource->getStructuredBufferType());
+                write((uint32_t)pResource->getReturnType());
+                write((uint32_t)pResource->getShaderAccess());
+                writeType(pResource->getStructType());
+            }
+            break;
+            default:
+                should_not_get_here();
+            }
+            mWrittenTypes[pType.get()] = (uint32_t)mWrittenTypes.size();
+        }
+
+        void writeVar(const ReflectionVar::SharedConstPtr& pVar)
+        {
+            if (writeReference(pVar.get(), mWrittenVars)) return;
+
+            writeString(pVar->getName());
+            writeType(pVar->getType());
+            write((uint64_t)pVar->getOffset());
+            write(pVar->getDescOffset());
+            write(pVar->getRegisterSpace());
+            write((uint32_t)pVar->getModifier());
+            mWrittenVars[pVar.get()] = (uint32_t)mWrittenVars.size();
+        }
+
+        void writeBlock(const ParameterBlockReflection& block)
+        {
+            writeString(block.mName);
+            write((uint32_t)block.mResources.size());
+            for (const auto& res : block.mResources)
+            {
+                write(res.descOffset);
+                write(res.descCount);
+                write(res.regIndex);
+                write(res.regSpace);
+                write((uint32_t)res.setType);
+                writeString(res.name);
+                writeType(res.pType);
+            }
+            write(block.mpResourceVars->getMemberCount());
+            for (const auto& pVar : *block.mpResourceVars) writeVar(pVar);
+        }
+
+        void writeVariableMap(const ProgramReflection::VariableMap& varMap)
+        {
+            write((uint32_t)varMap.size());
+            for (const auto& v : varMap)
+            {
+                writeString(v.first);
+                write(v.second.bindLocation);
+                writeString(v.second.semanticName);
+                write((int32_t)v.second.type);
+            }
+        }
+
+        // The read functions return false once the data turns out to be malformed
+        bool read(void* pData, size_t size)
+        {
+            if (mpIn->size() - mOffset < size) return false;
+            std::memcpy(pData, mpIn->data() + mOffset, size);
+            mOffset += size;
+            return true;
+        }
+
+        template<typename T> bool read(T& value) { return read(&value, sizeof(T)); }
+
+        bool readString(std::string& str)
+        {
+            uint32_t size;
+            if (read(size) == false || mpIn->size() - mOffset < size) return false;
+            str.assign(mpIn->data() + mOffset, size);
+            mOffset += size;
+            return true;
+        }
+
+        bool readType(ReflectionType::SharedConstPtr& pType)
+        {
+            bool isNew;
+            if (readReference(mReadTypes, pType, isNew) == false) return false;
+            if (isNew == false) return true;
+
+            uint32_t type;
+            uint64_t offset;
+            if (read(type) == false || read(offset) == false) return false;
+            switch ((ReflectionType::Type)type)
+            {
+            case ReflectionType::Type::Array:
+            {
+                uint32_t arraySize, arrayStride;
+                ReflectionType::SharedConstPtr pElementType;
+                if (read(arraySize) == false || read(arrayStride) == false || readType(pElementType) == false || pElementType == nullptr) return false;
+                pType = ReflectionArrayType::create((size_t)offset, arraySize, arrayStride, pElementType);
+            }
+            break;
+            case ReflectionType::Type::Struct:
+            {
+                uint64_t size;
+                std::string name;
+                uint32_t memberCount;
+                if (read(size) == false || readString(name) == false || read(memberCount) == false) return false;
+                ReflectionStructType::SharedPtr pStruct = ReflectionStructType::create((size_t)offset, (size_t)size, name);
+                for (uint32_t i = 0; i < memberCount; i++)
+                {
+                    ReflectionVar::SharedConstPtr pMember;
+                    if (readVar(pMember) == false || pMember == nullptr) return false;
+                    pStruct->addMember(pMember);
+                }
+                pType = pStruct;
+            }
+            break;
+            case ReflectionType::Type::Basic:
+            {
+                int32_t basicType;
+                uint8_t isRowMajor;
+                uint64_t size;
+                if (read(basicType) == false || read(isRowMajor) == false || read(size) == false) return false;
+                pType = ReflectionBasicType::create((size_t)offset, (ReflectionBasicType::Type)basicType, isRowMajor != 0, (size_t)size);
+            }
+            break;
+            case ReflectionType::Type::Resource:
+            {
+                uint32_t values[5];
+                ReflectionType::SharedConstPtr pStructType;
+                if (read(values) == false || readType(pStructType) == false) return false;
+                ReflectionResourceType::SharedPtr pResource = ReflectionResourceType::create((ReflectionResourceType::Type)values[0], (ReflectionResourceType::Dimensions)values[1],
+                    (ReflectionResourceType::StructuredType)values[2], (ReflectionResourceType::ReturnType)values[3], (ReflectionResourceType::ShaderAccess)values[4]);
+                if (pStructType) pResource->setStructType(pStructType);
+                pType = pResource;
+            }
+            break;
+            default:
+                return false;
+            }
+            mReadTypes.push_back(pType);
+            return true;
+        }
+
+        bool readVar(ReflectionVar::SharedConstPtr& pVar)
+        {
+            bool isNew;
+            if (readReference(mReadVars, pVar, isNew) == false) return false;
+            if (isNew == false) return true;
+
+            std::string name;
+            ReflectionType::SharedConstPtr pType;
+            uint64_t offset;
+            uint32_t descOffset, regSpace, modifier;
+            if (readString(name) == false || readType(pType) == false || pType == nullptr) return false;
+            if (read(offset) == false || read(descOffset) == false || read(regSpace) == false || read(modifier) == false) return false;
+            pVar = ReflectionVar::create(name, pType, (size_t)offset, descOffset, regSpace, (ReflectionVar::Modifier)modifier);
+            mReadVars.push_back(pVar);
+            return true;
+        }
+
+        ParameterBlockReflection::SharedPtr readBlock()
+        {
+            std::string name;
+            uint32_t resourceCount;
+            if (readString(name) == false || read(resourceCount) == false) return nullptr;
+
+            ParameterBlockReflection::SharedPtr pBlock = ParameterBlockReflection::create(name);
+            for (uint32_t i = 0; i < resourceCount; i++)
+            {
+                ParameterBlockReflection::ResourceDesc res;
+                uint32_t setType;
+                ReflectionType::SharedConstPtr pType;
+                if (read(res.descOffset) == false || read(res.descCount) == false || read(res.regIndex) == false || read(res.regSpace) == false) return nullptr;
+                if (read(setType) == false || readString(res.name) == false || readType(pType) == false) return nullptr;
+                res.setType = (ParameterBlockReflection::ResourceDesc::Type)setType;
+                res.pType = std::dynamic_pointer_cast<const ReflectionResourceType>(pType);
+                if (res.pType == nullptr) return nullptr;
+                pBlock->mResources.push_back(res);
+            }
+
+            uint32_t varCount;
+            if (read(varCount) == false) return nullptr;
+            for (uint32_t i = 0; i < varCount; i++)
+            {
+                ReflectionVar::SharedConstPtr pVar;
+                if (readVar(pVar) == false || pVar == nullptr) return nullptr;
+                pBlock->mpResourceVars->addMember(pVar);
+            }
+            pBlock->finalize();
+            return pBlock;
+        }
+
+        bool readVariableMap(ProgramReflection::VariableMap& varMap)
+        {
+            uint32_t count;
+            if (read(count) == false) return false;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                std::string name;
+                ProgramReflection::ShaderVariable var;
+                int32_t type;
+                if (readString(name) == false || read(var.bindLocation) == false || readString(var.semanticName) == false || read(type) == false) return false;
+                var.type = (ReflectionBasicType::Type)type;
+                varMap[name] = var;
+            }
+            return true;
+        }
+
+        size_t getOffset() const { return mOffset; }
+
+    private:
+        // A reference is 0 for nullptr, kNewObject if the object follows, or the index of a previous object plus one
+        static const uint32_t kNewObject = -1;
+
+        bool writeReference(const void* pObject, const std::unordered_map<const void*, uint32_t>& written)
+        {
+            if (pObject == nullptr)
+            {
+                write(0u);
+                return true;
+            }
+            const auto& it = written.find(pObject);
+            write(it == written.end() ? kNewObject : it->second + 1);
+            return it != written.end();
+        }
+
+        template<typename T>
+        bool readReference(const std::vector<T>& objects, T& pObject, bool& isNew)
+        {
+            uint32_t ref;
+            if (read(ref) == false) return false;
+            isNew = (ref == kNewObject);
+            pObject = nullptr;
+            if (isNew || ref == 0) return true;
+            if (ref > objects.size()) return false;
+            pObject = objects[ref - 1];
+            return true;
+        }
+
+        std::string* mpOut = nullptr;
+        const std::string* mpIn = nullptr;
+        size_t mOffset = 0;
+        std::unordered_map<const void*, uint32_t> mWrittenTypes;
+        std::unordered_map<const void*, uint32_t> mWrittenVars;
+        std::vector<ReflectionType::SharedConstPtr> mReadTypes;
+        std::vector<ReflectionVar::SharedConstPtr> mReadVars;
+    };
+
+    void ProgramReflection::serialize(std::string& data) const
+    {
+        ReflectionSerializer serializer(data);
+        serializer.write((uint32_t)mpParameterBlocks.size());
+        for (const auto& pBlock : mpParameterBlocks) serializer.writeBlock(*pBlock);
+        serializer.write(mThreadGroupSize);
+        serializer.write((uint8_t)mIsSampleFrequency);
+        serializer.writeVariableMap(mPsOut);
+        serializer.writeVariableMap(mVertAttr);
+        serializer.writeVariableMap(mVertAttrBySemantic);
+    }
+
+    ProgramReflection::SharedPtr ProgramReflection::deserialize(const std::string& data, size_t& offset)
+    {
+        if (offset > data.size()) return nullptr;
+        ReflectionSerializer serializer(data, offset);
+        SharedPtr pReflection = SharedPtr(new ProgramReflection());
+
+        uint32_t blockCount;
+        if (serializer.read(blockCount) == false) return nullptr;
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            ParameterBlockReflection::SharedPtr pBlock = serializer.readBlock();
+            if (pBlock == nullptr || pReflection->mParameterBlocksIndices.count(pBlock->getName())) return nullptr;
+            pReflection->addParameterBlock(pBlock);
+        }
+
+        uint8_t isSampleFrequency;
+        if (serializer.read(pReflection->mThreadGroupSize) == false || serializer.read(isSampleFrequency) == false) return nullptr;
+        pReflection->mIsSampleFrequency = (isSampleFrequency != 0);
+        if (serializer.readVariableMap(pReflection->mPsOut) == false) return nullptr;
+        if (serializer.readVariableMap(pReflection->mVertAttr) == false) return nullptr;
+        if (serializer.readVariableMap(pReflection->mVertAttrBySemantic) == false) return nullptr;
+
+        if (pReflection->mpDefaultBlock) pReflection->updateDefaultBlockResourceBindings();
+        offset = serializer.getOffset();
+        return pReflection;
+    }
 }
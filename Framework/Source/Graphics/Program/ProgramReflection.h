@@ -39,6 +39,7 @@ namespace Falcor
     class ReflectionBasicType;
     class ReflectionStructType;
     class ReflectionArrayType;
+    class ReflectionSerializer;
 
     /** Base class for reflection types
     */
@@ -99,6 +100,7 @@ namespace Falcor
         virtual bool operator==(const ReflectionType& other) const = 0;
         virtual bool operator!=(const ReflectionType& other) const { return !(*this == other); }
     protected:
+        friend class ReflectionSerializer;
         ReflectionType(size_t offset, Type type) : mType(type), mOffset(offset) {}
         size_t mOffset;
         Type mType;
@@ -561,6 +563,7 @@ namespace Falcor
         static SharedPtr merge(const ParameterBlockReflection& first, const ParameterBlockReflection& second);
     private:
         friend class ProgramReflection;
+        friend class ReflectionSerializer;
         void addResource(const ReflectionVar::SharedConstPtr& pVar);
         void finalize();
         ParameterBlockReflection(const std::string& name);
@@ -666,7 +669,19 @@ namespace Falcor
         /** Merge to reflection objects into a new one
         */
         static SharedPtr merge(const ProgramReflection& first, const ProgramReflection& second);
+
+        /** Append a binary representation of the object to a string. Used by the shader cache to store the reflection next to the compiled code.
+        */
+        void serialize(std::string& data) const;
+
+        /** Create a new object from the output of serialize()
+            \param[in] data The serialized data
+            \param[in,out] offset Where the object starts. On success, it's advanced past the object.
+            \return A new object, or nullptr if the data is malformed
+        */
+        static SharedPtr deserialize(const std::string& data, size_t& offset);
     private:
+        ProgramReflection() = default;
         ProgramReflection(slang::ShaderReflection* pSlangReflector, ResourceScope scopeToReflect, std::string& log);
         ProgramReflection(const ProgramReflection&) = default;
         void addParameterBlock(const ParameterBlockReflection::SharedConstPtr& pBlock);
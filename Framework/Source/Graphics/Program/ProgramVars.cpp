@@ -276,7 +276,7 @@ namespace Falcor
             {
                 if (rootSets[s].dirty || forceBind)
                 {
-                    rootSets[s].dirty = false;
+                    if (rootSets[s].dirty) rootSets[s].dirty = false;
                     uint32_t rootIndex = rootIndices[s];
                     if (forGraphics)
                     {
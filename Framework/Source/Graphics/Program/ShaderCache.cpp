@@ -0,0 +1,515 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ShaderCache.h"
+#include "Utils/DiskCacheIndex.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/Platform/OS.h"
+#include "Utils/StringUtils.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+
+namespace Falcor
+{
+    const uint32_t ShaderCache::kShaderCount;
+    const uint32_t ShaderCache::kFormatVersion;
+    const uint64_t ShaderCache::kDefaultSizeLimit;
+
+    static const uint32_t kEntryMagic = 0x31435346; // 'FSC1'
+
+    struct ShaderCacheState
+    {
+        std::mutex mutex;
+        bool enabled = true;
+        bool indexLoaded = false;
+        bool indexDirty = false;
+        std::string directory;
+        uint64_t sizeLimit = ShaderCache::kDefaultSizeLimit;
+        DiskCacheIndex index;
+        ShaderCache::Stats stats;
+
+        ~ShaderCacheState();
+    };
+
+    static ShaderCacheState& getState()
+    {
+        static ShaderCacheState state;
+        return state;
+    }
+
+    static std::string getEntryPath(const ShaderCacheState& state, const std::string& key)
+    {
+        return state.directory + "/" + key + ".bin";
+    }
+
+    static std::string getIndexPath(const ShaderCacheState& state)
+    {
+        return state.directory + "/index.txt";
+    }
+
+    // A name no other thread or process uses, so concurrent writers never share a temporary file
+    static std::string getTempPath(const std::string& path)
+    {
+        static const uint64_t processId = std::random_device()() | ((uint64_t)std::random_device()() << 32);
+        static std::atomic<uint32_t> counter(0);
+        return path + "." + DiskCacheIndex::keyToString(processId) + "." + std::to_string(counter++) + ".tmp";
+    }
+
+    static bool writeFileAtomic(const std::string& path, const std::string& data)
+    {
+        std::string tempPath = getTempPath(path);
+        {
+            std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+            stream.write(data.data(), data.size());
+            if (stream.good() == false)
+            {
+                stream.close();
+                std::remove(tempPath.c_str());
+                return false;
+            }
+        }
+
+        // Replaced in one step, so a concurrent reader never finds the file missing. If another process holds it open, keep its copy.
+        if (replaceFile(tempPath, path) == false)
+        {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // The caller holds the lock
+    static void saveIndex(ShaderCacheState& state)
+    {
+        writeFileAtomic(getIndexPath(state), state.index.serialize());
+        state.indexDirty = false;
+    }
+
+    ShaderCacheState::~ShaderCacheState()
+    {
+        // Hits only update the order of use, which is written once at exit
+        if (indexDirty) saveIndex(*this);
+    }
+
+    static void removeEvicted(ShaderCacheState& state, const std::vector<std::string>& evicted)
+    {
+        for (const auto& e : evicted)
+        {
+            std::remove(getEntryPath(state, e).c_str());
+        }
+        state.stats.evictions += (uint32_t)evicted.size();
+    }
+
+    // The caller holds the lock
+    static void loadIndex(ShaderCacheState& state)
+    {
+        if (state.indexLoaded) return;
+        state.indexLoaded = true;
+
+        if (state.directory.empty())
+        {
+            state.directory = getExecutableDirectory() + "/ShaderCache";
+        }
+        if (isDirectoryExists(state.directory) == false)
+        {
+            createDirectory(state.directory);
+        }
+
+        std::string indexPath = getIndexPath(state);
+        if (doesFileExist(indexPath) && state.index.deserialize(readFile(indexPath)) == false)
+        {
+            logWarning("Shader cache index " + indexPath + " is corrupted. Rebuilding it from the cache directory.");
+        }
+
+        // Drop entries whose file was deleted behind our back, e.g. evicted by another process
+        std::vector<std::string> missing;
+        for (const auto& key : state.index.getKeys())
+        {
+            if (doesFileExist(getEntryPath(state, key)) == false) missing.push_back(key);
+        }
+        for (const auto& key : missing)
+        {
+            state.index.remove(key);
+        }
+
+        // Pick up entries other processes stored after the index was written. They count as the least recently used ones.
+        std::vector<std::string> files;
+        enumerateFiles(state.directory + "/*.bin", files);
+        std::vector<std::string> evicted;
+        uint32_t added = 0;
+        for (const auto& f : files)
+        {
+            std::string key = f.substr(0, f.size() - 4);
+            if (hasSuffix(f, ".bin") == false || state.index.find(key)) continue;
+            std::ifstream file(getEntryPath(state, key), std::ios::binary | std::ios::ate);
+            if (file.is_open() == false) continue;
+            DiskCacheIndex::Entry entry;
+            entry.size = (uint64_t)file.tellg();
+            for (const auto& e : state.index.insert(key, entry, state.sizeLimit)) evicted.push_back(e);
+            added++;
+        }
+        removeEvicted(state, evicted);
+        state.indexDirty = (missing.size() || added);
+    }
+
+    static void appendString(std::string& data, const std::string& str)
+    {
+        uint32_t size = (uint32_t)str.size();
+        data.append((const char*)&size, sizeof(size));
+        data.append(str);
+    }
+
+    template<typename T>
+    static void append(std::string& data, T value)
+    {
+        data.append((const char*)&value, sizeof(T));
+    }
+
+    class EntryReader
+    {
+    public:
+        EntryReader(const std::string& data, size_t size) : mData(data), mSize(size) {}
+
+        template<typename T>
+        bool read(T& value)
+        {
+            if (mSize - mOffset < sizeof(T)) return false;
+            std::memcpy(&value, mData.data() + mOffset, sizeof(T));
+            mOffset += sizeof(T);
+            return true;
+        }
+
+        bool readString(std::string& str)
+        {
+            uint32_t size;
+            if (read(size) == false || mSize - mOffset < size) return false;
+            str.assign(mData.data() + mOffset, size);
+            mOffset += size;
+            return true;
+        }
+
+        bool isAtEnd() const { return mOffset == mSize; }
+    private:
+        const std::string& mData;
+        size_t mSize;
+        size_t mOffset = 0;
+    };
+
+    /** Entry file layout:
+        magic, version, key
+        dependency count, then for every dependency its path and content hash
+        stage mask, then the code of every stage in the mask
+        reflection data
+        hash of everything above
+    */
+    static bool serializeEntry(const std::string& key, const ShaderCache::Entry& entry, std::string& data)
+    {
+        append(data, kEntryMagic);
+        append(data, ShaderCache::kFormatVersion);
+        appendString(data, key);
+
+        append(data, (uint32_t)entry.dependencies.size());
+        for (const auto& d : entry.dependencies)
+        {
+            uint64_t hash;
+            if (ShaderCache::hashFile(d, hash) == false) return false;
+            appendString(data, d);
+            append(data, hash);
+        }
+
+        uint32_t stageMask = 0;
+        for (uint32_t i = 0; i < ShaderCache::kShaderCount; i++)
+        {
+            if (entry.code[i].size()) stageMask |= (1 << i);
+        }
+        append(data, stageMask);
+        for (uint32_t i = 0; i < ShaderCache::kShaderCount; i++)
+        {
+            if (entry.code[i].size()) appendString(data, entry.code[i]);
+        }
+        appendString(data, entry.reflection);
+        append(data, DiskCacheIndex::hash(data.data(), data.size()));
+        return true;
+    }
+
+    enum class EntryStatus
+    {
+        Valid,
+        Corrupted,
+        Stale,
+    };
+
+    static EntryStatus deserializeEntry(const std::string& data, const std::string& key, ShaderCache::Entry& entry)
+    {
+        uint64_t checksum;
+        if (data.size() < sizeof(checksum)) return EntryStatus::Corrupted;
+        size_t size = data.size() - sizeof(checksum);
+        std::memcpy(&checksum, data.data() + size, sizeof(checksum));
+        if (DiskCacheIndex::hash(data.data(), size) != checksum) return EntryStatus::Corrupted;
+
+        EntryReader reader(data, size);
+        uint32_t magic, version, dependencyCount;
+        std::string entryKey;
+        if (reader.read(magic) == false || reader.read(version) == false || reader.readString(entryKey) == false) return EntryStatus::Corrupted;
+        if (magic != kEntryMagic || version != ShaderCache::kFormatVersion || entryKey != key) return EntryStatus::Corrupted;
+
+        if (reader.read(dependencyCount) == false) return EntryStatus::Corrupted;
+        bool upToDate = true;
+        entry.dependencies.resize(dependencyCount);
+        for (auto& d : entry.dependencies)
+        {
+            uint64_t hash, currentHash;
+            if (reader.readString(d) == false || reader.read(hash) == false) return EntryStatus::Corrupted;
+            if (upToDate && (ShaderCache::hashFile(d, currentHash) == false || currentHash != hash)) upToDate = false;
+        }
+        if (upToDate == false) return EntryStatus::Stale;
+
+        uint32_t stageMask;
+        if (reader.read(stageMask) == false) return EntryStatus::Corrupted;
+        for (uint32_t i = 0; i < ShaderCache::kShaderCount; i++)
+        {
+            entry.code[i].clear();
+            if ((stageMask & (1 << i)) && reader.readString(entry.code[i]) == false) return EntryStatus::Corrupted;
+        }
+        if (reader.readString(entry.reflection) == false || reader.isAtEnd() == false) return EntryStatus::Corrupted;
+        return EntryStatus::Valid;
+    }
+
+    bool ShaderCache::load(const std::string& key, Entry& entry)
+    {
+        ShaderCacheState& state = getState();
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        std::string entryPath;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.enabled == false) return false;
+            loadIndex(state);
+            entryPath = getEntryPath(state, key);
+
+            // Another process might have stored the entry since the index was loaded
+            if (state.index.find(key) == nullptr && doesFileExist(entryPath) == false)
+            {
+                state.stats.misses++;
+                return false;
+            }
+        }
+
+        std::string data = doesFileExist(entryPath) ? readFile(entryPath) : std::string();
+        EntryStatus status = deserializeEntry(data, key, entry);
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (status != EntryStatus::Valid)
+        {
+            // Remove it so that the recompiled program replaces it. Failing to delete a file another process holds open is fine.
+            state.index.remove(key);
+            std::remove(entryPath.c_str());
+            state.stats.misses++;
+            state.stats.rejected++;
+            state.indexDirty = true;
+            if (status == EntryStatus::Corrupted) logWarning("Shader cache entry " + entryPath + " is corrupted.");
+            return false;
+        }
+
+        if (state.index.find(key))
+        {
+            state.index.touch(key);
+        }
+        else
+        {
+            DiskCacheIndex::Entry indexEntry;
+            indexEntry.size = data.size();
+            removeEvicted(state, state.index.insert(key, indexEntry, state.sizeLimit));
+        }
+        state.indexDirty = true;
+        state.stats.hits++;
+        state.stats.hitTime += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        return true;
+    }
+
+    void ShaderCache::store(const std::string& key, const Entry& entry, double compileTime)
+    {
+        ShaderCacheState& state = getState();
+        std::string entryPath;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.enabled == false) return;
+            loadIndex(state);
+            entryPath = getEntryPath(state, key);
+        }
+
+        std::string data;
+        if (serializeEntry(key, entry, data) == false || writeFileAtomic(entryPath, data) == false)
+        {
+            logWarning("Shader cache: failed to store " + entryPath + ".");
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        DiskCacheIndex::Entry indexEntry;
+        indexEntry.size = data.size();
+        removeEvicted(state, state.index.insert(key, indexEntry, state.sizeLimit));
+        state.stats.stores++;
+        state.stats.compileTime += compileTime;
+        saveIndex(state);
+    }
+
+    bool ShaderCache::hashFile(const std::string& filename, uint64_t& hash)
+    {
+        size_t size = 0;
+        const void* pData = mapFileForRead(filename, size);
+        if (pData == nullptr)
+        {
+            // Mapping an empty file fails
+            if (doesFileExist(filename) == false) return false;
+            hash = DiskCacheIndex::hash(nullptr, 0);
+            return true;
+        }
+        hash = DiskCacheIndex::hash(pData, size);
+        unmapFile(pData, size);
+        return true;
+    }
+
+    /** Reference-counted blob holding a copy of cached code. Shader::init() also queries it for ID3DBlob, which has the same IID and layout.
+    */
+    class CachedShaderBlob : public ISlangBlob
+    {
+    public:
+        CachedShaderBlob(const std::string& code) : mCode(code) {}
+
+        SLANG_NO_THROW SlangResult SLANG_MCALL queryInterface(SlangUUID const& uuid, void** outObject) override
+        {
+            static const SlangUUID kUnknownUuid = SLANG_UUID_ISlangUnknown;
+            static const SlangUUID kBlobUuid = SLANG_UUID_ISlangBlob;
+            if (std::memcmp(&uuid, &kUnknownUuid, sizeof(SlangUUID)) == 0 || std::memcmp(&uuid, &kBlobUuid, sizeof(SlangUUID)) == 0)
+            {
+                addRef();
+                *outObject = static_cast<ISlangBlob*>(this);
+                return SLANG_OK;
+            }
+            *outObject = nullptr;
+            return SLANG_E_NO_INTERFACE;
+        }
+
+        SLANG_NO_THROW uint32_t SLANG_MCALL addRef() override { return ++mRefCount; }
+
+        SLANG_NO_THROW uint32_t SLANG_MCALL release() override
+        {
+            uint32_t count = --mRefCount;
+            if (count == 0) delete this;
+            return count;
+        }
+
+        SLANG_NO_THROW void const* SLANG_MCALL getBufferPointer() override { return mCode.data(); }
+        SLANG_NO_THROW size_t SLANG_MCALL getBufferSize() override { return mCode.size(); }
+    private:
+        virtual ~CachedShaderBlob() = default;
+        std::string mCode;
+        std::atomic<uint32_t> mRefCount{ 0 };
+    };
+
+    Shader::Blob ShaderCache::createBlob(const std::string& code)
+    {
+        // The ComPtr constructor adds the only reference
+        return Shader::Blob(new CachedShaderBlob(code));
+    }
+
+    void ShaderCache::setEnabled(bool enabled)
+    {
+        ShaderCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.enabled = enabled;
+    }
+
+    bool ShaderCache::isEnabled()
+    {
+        ShaderCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        return state.enabled;
+    }
+
+    void ShaderCache::setDirectory(const std::string& directory)
+    {
+        ShaderCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.indexDirty) saveIndex(state);
+        state.directory = directory;
+        state.index.clear();
+        state.indexLoaded = false;
+    }
+
+    std::string ShaderCache::getDirectory()
+    {
+        ShaderCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        loadIndex(state);
+        return state.directory;
+    }
+
+    void ShaderCache::setSizeLimit(uint64_t sizeLimit)
+    {
+        ShaderCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        loadIndex(state);
+        state.sizeLimit = sizeLimit;
+        std::vector<std::string> evicted = state.index.evict(sizeLimit);
+        if (evicted.size())
+        {
+            removeEvicted(state, evicted);
+            saveIndex(state);
+        }
+    }
+
+    ShaderCache::Stats ShaderCache::getStats()
+    {
+        ShaderCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        loadIndex(state);
+        Stats stats = state.stats;
+        stats.entryCount = state.index.getCount();
+        stats.size = state.index.getTotalSize();
+        stats.sizeLimit = state.sizeLimit;
+        return stats;
+    }
+
+    void ShaderCache::clear()
+    {
+        ShaderCacheState& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        loadIndex(state);
+        for (const auto& key : state.index.getKeys())
+        {
+            std::remove(getEntryPath(state, key).c_str());
+        }
+        state.index.clear();
+        saveIndex(state);
+    }
+}
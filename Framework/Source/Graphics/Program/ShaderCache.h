@@ -0,0 +1,116 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/Shader.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** Persistent on-disk cache of compiled programs.
+        Program::link() computes a key from everything that goes into a compilation: the contents of the source files, the entry points, the define
+        list, the shader model and the compiler flags. An entry stores the compiled code of every stage together with the serialized
+        ProgramReflection objects, so a hit skips Slang and the downstream compiler altogether.
+        Included files are only known after compiling, so every entry also records the files it was built from with a hash of their content.
+        An entry whose dependencies changed is dropped and rebuilt.
+        Several processes can share a directory. Entries are written to a temporary file and renamed, carry a checksum which rejects partial or
+        corrupted files, and entries written by other processes are picked up when the index is loaded. The total size is kept under a limit by
+        evicting the least recently used entries.
+    */
+    class ShaderCache
+    {
+    public:
+        static const uint32_t kShaderCount = (uint32_t)ShaderType::Count;
+
+        struct Entry
+        {
+            std::string code[kShaderCount];             ///< Compiled code for every stage, empty for unused stages
+            std::string reflection;                     ///< Serialized reflection data, opaque to the cache
+            std::vector<std::string> dependencies;      ///< Files the code was compiled from, including the source files
+        };
+
+        struct Stats
+        {
+            uint32_t hits = 0;          ///< Programs loaded from the cache
+            uint32_t misses = 0;        ///< Programs that had to be compiled
+            uint32_t stores = 0;        ///< Entries written
+            uint32_t rejected = 0;      ///< Entries dropped because a dependency changed or the file was corrupted
+            uint32_t evictions = 0;     ///< Entries removed to stay under the size limit
+            uint32_t entryCount = 0;    ///< Entries currently in the cache
+            uint64_t size = 0;          ///< Current size of the cache in bytes
+            uint64_t sizeLimit = 0;     ///< Size limit in bytes
+            double hitTime = 0;         ///< Total time spent loading entries, in milliseconds
+            double compileTime = 0;     ///< Total time spent compiling the programs which were stored, in milliseconds
+        };
+
+        /** Bump whenever the entry layout or the reflection serialization changes, so that stale entries are rebuilt. Part of every key.
+        */
+        static const uint32_t kFormatVersion = 1;
+        static const uint64_t kDefaultSizeLimit = 256ull << 20;
+
+        /** Find an entry
+            \param[in] key The key computed by the caller
+            \param[out] entry The cached data
+            \return false on a miss. Entries with changed dependencies count as a miss.
+        */
+        static bool load(const std::string& key, Entry& entry);
+
+        /** Add an entry, replacing an existing one with the same key
+            \param[in] compileTime Time it took to compile the program, for the statistics
+        */
+        static void store(const std::string& key, const Entry& entry, double compileTime);
+
+        /** Hash the content of a file
+            \return false if the file can't be read
+        */
+        static bool hashFile(const std::string& filename, uint64_t& hash);
+
+        /** Wrap a copy of cached code in a blob which can be passed to Shader::create()
+        */
+        static Shader::Blob createBlob(const std::string& code);
+
+        /** Enable or disable the cache. Enabled by default.
+        */
+        static void setEnabled(bool enabled);
+        static bool isEnabled();
+
+        /** Set the cache directory. Defaults to 'ShaderCache' in the executable directory.
+        */
+        static void setDirectory(const std::string& directory);
+        static std::string getDirectory();
+
+        /** Set the size limit in bytes. Least recently used entries are evicted immediately if the cache is larger.
+        */
+        static void setSizeLimit(uint64_t sizeLimit);
+
+        static Stats getStats();
+
+        /** Delete all entries
+        */
+        static void clear();
+    };
+}
@@ -51,6 +51,9 @@ namespace Falcor
     SceneEditorRenderer::SceneEditorRenderer(const Scene::SharedPtr& pScene)
         : SceneRenderer(pScene)
     {
+        // Gizmo programs and colors are set per model instance, which needs the hierarchy order
+        toggleRenderQueue(false);
+
         mpGraphicsState = GraphicsState::create();
 
         // Solid Rasterizer state
@@ -0,0 +1,111 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "RenderQueue.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    const uint32_t RenderQueue::kProgramBits;
+    const uint32_t RenderQueue::kMaterialBits;
+    const uint32_t RenderQueue::kGeometryBits;
+    const uint32_t RenderQueue::kDepthBits;
+    const uint64_t RenderQueue::kProgramMask;
+    const uint64_t RenderQueue::kMaterialMask;
+    const uint64_t RenderQueue::kGeometryMask;
+    const uint64_t RenderQueue::kDepthMask;
+    const uint32_t RenderQueue::kResortMovesPerDraw;
+
+    uint64_t RenderQueue::makeKey(uint32_t program, uint32_t material, uint32_t geometry, uint32_t depth)
+    {
+        uint64_t key = uint64_t(std::min(program, (1u << kProgramBits) - 1)) << (kMaterialBits + kGeometryBits + kDepthBits);
+        key |= uint64_t(std::min(material, (1u << kMaterialBits) - 1)) << (kGeometryBits + kDepthBits);
+        key |= uint64_t(std::min(geometry, (1u << kGeometryBits) - 1)) << kDepthBits;
+        key |= uint64_t(std::min(depth, (1u << kDepthBits) - 1));
+        return key;
+    }
+
+    uint32_t RenderQueue::quantizeDepth(float depth)
+    {
+        const float maxDepth = float((1u << kDepthBits) - 1);
+        float d = std::min(std::max(depth, 0.f), 1.f);
+        return uint32_t(d * maxDepth);
+    }
+
+    void RenderQueue::sort()
+    {
+        std::stable_sort(mDraws.begin(), mDraws.end(), [](const Draw& a, const Draw& b) { return a.key < b.key; });
+    }
+
+    uint32_t RenderQueue::resort()
+    {
+        uint32_t outOfOrder = 0;
+        for (size_t i = 1; i < mDraws.size(); i++)
+        {
+            if (mDraws[i - 1].key > mDraws[i].key) outOfOrder++;
+        }
+        if (outOfOrder == 0) return 0;
+
+        // Only the depth field changed since the list was sorted, so draws move within their state group and mostly by a few positions.
+        // A camera cut can reverse whole groups though, which is quadratic for the insertion sort.
+        size_t moveBudget = mDraws.size() * kResortMovesPerDraw;
+        for (size_t i = 1; i < mDraws.size(); i++)
+        {
+            if (mDraws[i - 1].key <= mDraws[i].key) continue;
+
+            Draw draw = mDraws[i];
+            size_t j = i;
+            while (j > 0 && mDraws[j - 1].key > draw.key)
+            {
+                mDraws[j] = mDraws[j - 1];
+                j--;
+            }
+            mDraws[j] = draw;
+
+            size_t moves = i - j;
+            if (moves >= moveBudget)
+            {
+                // The front is sorted, the stable sort keeps the order of equal keys like the insertion sort does
+                sort();
+                break;
+            }
+            moveBudget -= moves;
+        }
+        return outOfOrder;
+    }
+
+    uint32_t RenderQueue::getChangeCount(uint64_t fieldMask) const
+    {
+        uint32_t changes = 0;
+        for (size_t i = 0; i < mDraws.size(); i++)
+        {
+            if (i == 0 || ((mDraws[i].key ^ mDraws[i - 1].key) & fieldMask) != 0) changes++;
+        }
+        return changes;
+    }
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+
+namespace Falcor
+{
+    /** Flat list of draws ordered by a 64-bit state key.
+        From the most to the least significant bits the key holds a program variant, a material, a geometry (VAO) and a quantized depth, so walking
+        the list in order changes the expensive state the least often. The key is only used for ordering, the draw keeps its real program index.
+        The renderer builds the list when the scene structure changes and only refreshes the depth field per frame. resort() restores the order
+        with an insertion sort, which is close to linear for the small changes between consecutive frames, and falls back to a full sort when
+        the order changed too much.
+    */
+    class RenderQueue
+    {
+    public:
+        static const uint32_t kProgramBits = 8;
+        static const uint32_t kMaterialBits = 16;
+        static const uint32_t kGeometryBits = 20;
+        static const uint32_t kDepthBits = 20;
+
+        static const uint64_t kProgramMask = ((1ull << kProgramBits) - 1) << (kMaterialBits + kGeometryBits + kDepthBits);
+        static const uint64_t kMaterialMask = ((1ull << kMaterialBits) - 1) << (kGeometryBits + kDepthBits);
+        static const uint64_t kGeometryMask = ((1ull << kGeometryBits) - 1) << kDepthBits;
+        static const uint64_t kDepthMask = (1ull << kDepthBits) - 1;
+
+        /** resort() gives up on the insertion sort after this many element moves per draw
+        */
+        static const uint32_t kResortMovesPerDraw = 8;
+
+        /** A draw of all instances of a mesh in a model instance
+        */
+        struct Draw
+        {
+            uint64_t key;
+            uint32_t program;           ///< Program variant index, the key's program field may be clamped
+            uint32_t modelID;
+            uint32_t modelInstanceID;
+            uint32_t meshID;
+        };
+
+        /** Pack the state indices into a key. Indices that don't fit into their field are clamped, which only costs state changes.
+            Use Draw::program rather than getProgram() to select the program of a draw.
+        */
+        static uint64_t makeKey(uint32_t program, uint32_t material, uint32_t geometry, uint32_t depth);
+        static uint32_t getProgram(uint64_t key) { return uint32_t((key & kProgramMask) >> (kMaterialBits + kGeometryBits + kDepthBits)); }
+        static uint32_t getMaterial(uint64_t key) { return uint32_t((key & kMaterialMask) >> (kGeometryBits + kDepthBits)); }
+        static uint32_t getGeometry(uint64_t key) { return uint32_t((key & kGeometryMask) >> kDepthBits); }
+        static uint32_t getDepth(uint64_t key) { return uint32_t(key & kDepthMask); }
+
+        /** Map a depth in [0, 1] to the depth field, values outside of the range are clamped
+        */
+        static uint32_t quantizeDepth(float depth);
+
+        void clear() { mDraws.clear(); }
+        void add(uint64_t key, uint32_t program, uint32_t modelID, uint32_t modelInstanceID, uint32_t meshID) { mDraws.push_back({ key, program, modelID, modelInstanceID, meshID }); }
+
+        /** Sort the whole list. Draws with equal keys keep the order they were added in.
+        */
+        void sort();
+
+        /** Replace the depth field of a draw. Call resort() once all depths are set.
+        */
+        void setDepth(uint32_t draw, uint32_t depth) { mDraws[draw].key = (mDraws[draw].key & ~kDepthMask) | (depth & kDepthMask); }
+
+        /** Restore the order after setDepth() calls
+            \return Number of draws that were out of order
+        */
+        uint32_t resort();
+
+        /** Number of positions in the list where any of the fields selected by the mask differs from the previous draw, including the first draw
+        */
+        uint32_t getChangeCount(uint64_t fieldMask) const;
+
+        uint32_t getDrawCount() const { return (uint32_t)mDraws.size(); }
+        const Draw& getDraw(uint32_t draw) const { return mDraws[draw]; }
+        const std::vector<Draw>& getDraws() const { return mDraws; }
+
+    private:
+        std::vector<Draw> mDraws;
+    };
+}
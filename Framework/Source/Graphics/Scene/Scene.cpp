@@ -105,6 +105,153 @@ namespace Falcor
         }
     }
 
+    const BoundingVolumeHierarchy& Scene::getMeshInstanceBvh()
+    {
+        updateMeshInstanceData();
+        return mMeshInstanceBvh;
+    }
+
+    const TransformTable& Scene::getTransformTable()
+    {
+        updateMeshInstanceData();
+        return mTransforms;
+    }
+
+    void Scene::prepareForParallelAccess(CopyContext* pContext)
+    {
+        updateExtents();
+        updateMeshInstanceData();
+        const auto& pCamera = getActiveCamera();
+        if (pCamera) pCamera->getViewProjMatrix();
+
+        // Passes sharing a material would otherwise update its parameter block at the same time
+        for (uint32_t modelID = 0; modelID < getModelCount(); modelID++)
+        {
+            const Model* pModel = getModel(modelID).get();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                pModel->getMesh(meshID)->getMaterial()->prepareForParallelAccess(pContext);
+            }
+        }
+    }
+
+    void Scene::setMeshInstanceParent(uint32_t modelID, uint32_t instanceID)
+    {
+        const ModelInstance* pInstance = getModelInstance(modelID, instanceID).get();
+        const Model* pModel = pInstance->getObject().get();
+        const glm::mat4& worldMat = pInstance->getTransformMatrix();
+        const glm::mat4& prevWorldMat = pInstance->getPrevTransformMatrix();
+
+        uint32_t item = mBvhFirstItem[modelID][instanceID];
+        for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+        {
+            for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+            {
+                mMeshInstanceBvh.setItemBox(item, pModel->getMeshInstance(meshID, meshInstanceID)->getBoundingBox().transform(worldMat));
+                mTransforms.setParent(item, worldMat, prevWorldMat);
+                item++;
+            }
+        }
+    }
+
+    void Scene::rebuildMeshInstanceData()
+    {
+        mBvhDirty = false;
+        mMeshInstanceDataVersion++;
+        mBvhFirstItem.resize(getModelCount());
+        mBvhMeshOffset.resize(getModelCount());
+        mBvhTransformVersion.resize(getModelCount());
+        mBvhItemRefs.clear();
+
+        for (uint32_t modelID = 0; modelID < getModelCount(); modelID++)
+        {
+            const Model* pModel = getModel(modelID).get();
+            mBvhMeshOffset[modelID].resize(pModel->getMeshCount());
+            uint32_t meshInstanceCount = 0;
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                mBvhMeshOffset[modelID][meshID] = meshInstanceCount;
+                meshInstanceCount += pModel->getMeshInstanceCount(meshID);
+            }
+
+            mBvhFirstItem[modelID].resize(getModelInstanceCount(modelID));
+            mBvhTransformVersion[modelID].resize(getModelInstanceCount(modelID));
+            for (uint32_t instanceID = 0; instanceID < getModelInstanceCount(modelID); instanceID++)
+            {
+                mBvhFirstItem[modelID][instanceID] = (uint32_t)mBvhItemRefs.size();
+                mBvhTransformVersion[modelID][instanceID] = getModelInstance(modelID, instanceID)->getTransformVersion();
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        mBvhItemRefs.push_back({ modelID, instanceID, meshID, meshInstanceID });
+                    }
+                }
+            }
+        }
+
+        // Skinned meshes are already in model space after vertex blending, their mesh instance transform is not applied
+        const uint32_t itemCount = (uint32_t)mBvhItemRefs.size();
+        std::vector<BoundingBox> boxes(itemCount);
+        mTransforms.resize(itemCount);
+        for (uint32_t i = 0; i < itemCount; i++)
+        {
+            const MeshInstanceRef& ref = mBvhItemRefs[i];
+            const ModelInstance* pInstance = getModelInstance(ref.modelID, ref.modelInstanceID).get();
+            const Model::MeshInstance* pMeshInstance = pInstance->getObject()->getMeshInstance(ref.meshID, ref.meshInstanceID).get();
+
+            boxes[i] = pMeshInstance->getBoundingBox().transform(pInstance->getTransformMatrix());
+            glm::mat4 local(1.0f);
+            glm::mat4 prevLocal(1.0f);
+            if (pMeshInstance->getObject()->hasBones() == false)
+            {
+                local = pMeshInstance->getTransformMatrix();
+                prevLocal = pMeshInstance->getPrevTransformMatrix();
+            }
+            mTransforms.setLocal(i, local, prevLocal);
+            mTransforms.setParent(i, pInstance->getTransformMatrix(), pInstance->getPrevTransformMatrix());
+        }
+
+        mMeshInstanceBvh.build(boxes);
+        updateTransformTable();
+    }
+
+    void Scene::updateMeshInstanceData()
+    {
+        if (mBvhDirty)
+        {
+            rebuildMeshInstanceData();
+            return;
+        }
+
+        // Only model instances whose transform changed since the last update need new item boxes and transforms
+        for (uint32_t modelID = 0; modelID < getModelCount(); modelID++)
+        {
+            for (uint32_t instanceID = 0; instanceID < getModelInstanceCount(modelID); instanceID++)
+            {
+                uint32_t version = getModelInstance(modelID, instanceID)->getTransformVersion();
+                if (version == mBvhTransformVersion[modelID][instanceID]) continue;
+                mBvhTransformVersion[modelID][instanceID] = version;
+                setMeshInstanceParent(modelID, instanceID);
+            }
+        }
+
+        if (mMeshInstanceBvh.refit() > 0 && mMeshInstanceBvh.needsRebuild())
+        {
+            mMeshInstanceBvh.build(mMeshInstanceBvh.getItemBoxes());
+        }
+        updateTransformTable();
+    }
+
+    void Scene::updateTransformTable()
+    {
+        if (mTransforms.getDirtyCount() >= TransformTable::kParallelThreshold && mpTransformPool == nullptr)
+        {
+            mpTransformPool = WorkStealingPool::getShared();
+        }
+        mTransforms.update(mpTransformPool.get());
+    }
+
     bool Scene::update(double currentTime, CameraController* cameraController)
     {
         bool changed = false;
@@ -147,12 +294,14 @@ namespace Falcor
         // Delete entire vector of instances
         mModels.erase(mModels.begin() + modelID);
         mExtentsDirty = true;
+        mBvhDirty = true;
     }
 
     void Scene::deleteAllModels()
     {
         mModels.clear();
         mExtentsDirty = true;
+        mBvhDirty = true;
     }
 
     uint32_t Scene::getModelInstanceCount(uint32_t modelID) const
@@ -176,6 +325,7 @@ namespace Falcor
             if (getModel(modelID) == pInstance->getObject())
             {
                 mModels[modelID].push_back(pInstance);
+                mBvhDirty = true;
                 return;
             }
         }
@@ -184,6 +334,7 @@ namespace Falcor
         mModels.emplace_back();
         mModels.back().push_back(pInstance);
         mExtentsDirty = true;
+        mBvhDirty = true;
     }
 
     void Scene::deleteModelInstance(uint32_t modelID, uint32_t instanceID)
@@ -206,6 +357,7 @@ namespace Falcor
 
         //  Extents will be dirty in either case.
         mExtentsDirty = true;
+        mBvhDirty = true;
     }
 
     const Scene::UserVariable& Scene::getUserVariable(const std::string& name) const
@@ -323,6 +475,7 @@ namespace Falcor
 #undef merge
         mUserVars.insert(pFrom->mUserVars.begin(), pFrom->mUserVars.end());
         mExtentsDirty = true;
+        mBvhDirty = true;
     }
 
     void Scene::createAreaLights()
@@ -37,6 +37,9 @@
 #include "Graphics/Paths/ObjectPath.h"
 #include "Graphics/Model/ObjectInstance.h"
 #include "Graphics/Model/SkinningCache.h"
+#include "Utils/Math/BoundingVolumeHierarchy.h"
+#include "Utils/Math/TransformTable.h"
+#include "Utils/WorkStealingPool.h"
 
 namespace Falcor
 {
@@ -95,6 +98,16 @@ namespace Falcor
         using ModelInstance = ObjectInstance<Model>;
         using ModelInstanceList = std::vector<ModelInstance::SharedPtr>;
 
+        /** Identifies a mesh instance of a model instance
+        */
+        struct MeshInstanceRef
+        {
+            uint32_t modelID;
+            uint32_t modelInstanceID;
+            uint32_t meshID;
+            uint32_t meshInstanceID;
+        };
+
         /**
             Enum to generate light source(s)
         */
@@ -207,6 +220,47 @@ namespace Falcor
         */
         const BoundingBox& getBoundingBox() { updateExtents(); return mBoundingBox; }
 
+        /** Returns a hierarchy over the world space bounds of all mesh instances.
+            Moved model instances (see ObjectInstance::getTransformVersion()) are refit on access, structural changes of the scene rebuild it.
+            Items are numbered with getMeshInstanceIndex(), the numbering is valid until the next structural change.
+        */
+        const BoundingVolumeHierarchy& getMeshInstanceBvh();
+
+        /** Returns the draw transforms of all mesh instances, indexed with getMeshInstanceIndex().
+            World matrices are the model instance transform times the mesh instance transform (only the model instance transform for skinned meshes).
+            Entries of moved model instances are recomputed on access, in parallel for large batches.
+        */
+        const TransformTable& getTransformTable();
+
+        /** Index of a mesh instance in the mesh instance hierarchy and the transform table
+        */
+        uint32_t getMeshInstanceIndex(uint32_t modelID, uint32_t modelInstanceID, uint32_t meshID, uint32_t meshInstanceID) const
+        {
+            return mBvhFirstItem[modelID][modelInstanceID] + mBvhMeshOffset[modelID][meshID] + meshInstanceID;
+        }
+
+        /** Mesh instance of an item of the mesh instance hierarchy
+        */
+        const MeshInstanceRef& getMeshInstanceRef(uint32_t index) const { return mBvhItemRefs[index]; }
+
+        /** Forces a rebuild of the mesh instance hierarchy. Needed after mesh instances of a model were added, removed or moved.
+        */
+        void invalidateMeshInstanceBvh() { mBvhDirty = true; }
+
+        /** Incremented every time the mesh instances are renumbered. Data indexed with getMeshInstanceIndex() has to be rebuilt when it changes.
+        */
+        uint32_t getMeshInstanceDataVersion() { updateMeshInstanceData(); return mMeshInstanceDataVersion; }
+
+        /** Bring the data which is updated on access up to date, so that reading it doesn't write anything:
+            - the extents, the bounding boxes and matrices of the model instances and the world parameters of directional lights
+            - the mesh instance hierarchy and the transform table
+            - the matrices and frustum planes of the active camera
+            - the parameter block of every material: its data, its constant buffer and its descriptor sets (see Material::prepareForParallelAccess())
+            Afterwards the scene can be read from several threads at the same time, as long as nothing is changed. Called before render graph passes are recorded on worker threads.
+            \param[in] pContext Context recording the constant buffer uploads and the resource barriers of the material parameter blocks
+        */
+        void prepareForParallelAccess(CopyContext* pContext);
+
         /**
             This routine creates area light(s) in the scene. All meshes that
             have emissive material are treated as area lights.
@@ -248,6 +302,11 @@ namespace Falcor
         */
         void updateExtents();
 
+        void updateMeshInstanceData();
+        void rebuildMeshInstanceData();
+        void setMeshInstanceParent(uint32_t modelID, uint32_t instanceID);
+        void updateTransformTable();
+
         static uint32_t sSceneCounter;
 
         uint32_t mId;
@@ -273,6 +332,16 @@ namespace Falcor
 
         bool mExtentsDirty = true;
 
+        BoundingVolumeHierarchy mMeshInstanceBvh;
+        TransformTable mTransforms;
+        WorkStealingPool::SharedPtr mpTransformPool;
+        std::vector<std::vector<uint32_t>> mBvhFirstItem;           ///< [model][model instance] first item of the model instance
+        std::vector<std::vector<uint32_t>> mBvhMeshOffset;          ///< [model][mesh] first mesh instance of the mesh within a model instance
+        std::vector<std::vector<uint32_t>> mBvhTransformVersion;    ///< [model][model instance] transform version the items were computed with
+        std::vector<MeshInstanceRef> mBvhItemRefs;
+        bool mBvhDirty = true;
+        uint32_t mMeshInstanceDataVersion = 0;
+
         std::string mFilename;
 
         using string_uservar_map = std::map<const std::string, UserVariable>;
@@ -36,6 +36,8 @@
 #include "VR/OpenVR/VRSystem.h"
 #include "API/Device.h"
 #include "glm/matrix.hpp"
+#include <map>
+#include <unordered_map>
 
 namespace Falcor
 {
@@ -48,6 +50,8 @@ namespace Falcor
     size_t SceneRenderer::sWorldInvTransposeMatOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sMeshIdOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sDrawIDOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sFirstInstanceOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sFirstDrawIdOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightCountOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightArrayOffset = ConstantBuffer::kInvalidOffset;
 
@@ -91,6 +95,11 @@ namespace Falcor
                 sMeshIdOffset = pType->findMember("gMeshId")->getOffset();
                 sDrawIDOffset = pType->findMember("gDrawId[0]")->getOffset();
                 sPrevWorldMatOffset = pType->findMember("gPrevWorldMat[0]")->getOffset();
+
+                const auto& pFirstInstance = pType->findMember("gFirstInstance");
+                sFirstInstanceOffset = pFirstInstance ? pFirstInstance->getOffset() : ConstantBuffer::kInvalidOffset;
+                const auto& pFirstDrawId = pType->findMember("gFirstDrawId");
+                sFirstDrawIdOffset = pFirstDrawId ? pFirstDrawId->getOffset() : ConstantBuffer::kInvalidOffset;
             }
         }
 
@@ -205,21 +214,45 @@ namespace Falcor
         {
             const Mesh* pMesh = pMeshInstance->getObject().get();
 
-            glm::mat4 worldMat = pModelInstance->getTransformMatrix();
-            glm::mat4 prevWorldMat = pModelInstance->getPrevTransformMatrix();
+            if (currentData.useInstanceBuffer)
+            {
+                // The data is in the instance buffer already, the draw only needs to know where its range starts
+                if (drawInstanceID == 0)
+                {
+                    uint32_t entry = mpScene->getMeshInstanceIndex(currentData.modelID, currentData.modelInstanceID, currentData.meshID, currentData.meshInstanceID);
+                    pCB->setVariable(sFirstInstanceOffset, entry);
+                    pCB->setVariable(sFirstDrawIdOffset, currentData.drawID);
+                    pCB->setVariable(sMeshIdOffset, pMesh->getId());
+                }
+                return true;
+            }
 
-            if (pMesh->hasBones() == false)
+            assert(drawInstanceID < sWorldMatArraySize);
+            if (currentData.pTransforms)
             {
-                worldMat = worldMat * pMeshInstance->getTransformMatrix();
-                prevWorldMat = prevWorldMat * pMeshInstance->getPrevTransformMatrix();
+                // Computed by the scene once per frame for moved instances only
+                uint32_t entry = mpScene->getMeshInstanceIndex(currentData.modelID, currentData.modelInstanceID, currentData.meshID, currentData.meshInstanceID);
+                pCB->setBlob(&currentData.pTransforms->getWorld(entry), sWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
+                pCB->setBlob(&currentData.pTransforms->getNormal(entry), sWorldInvTransposeMatOffset + drawInstanceID * sizeof(glm::mat3x4), sizeof(glm::mat3x4));
+                pCB->setBlob(&currentData.pTransforms->getPrevWorld(entry), sPrevWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
             }
+            else
+            {
+                glm::mat4 worldMat = pModelInstance->getTransformMatrix();
+                glm::mat4 prevWorldMat = pModelInstance->getPrevTransformMatrix();
 
-            glm::mat3x4 worldInvTransposeMat = transpose(inverse(glm::mat3(worldMat)));
+                if (pMesh->hasBones() == false)
+                {
+                    worldMat = worldMat * pMeshInstance->getTransformMatrix();
+                    prevWorldMat = prevWorldMat * pMeshInstance->getPrevTransformMatrix();
+                }
 
-            assert(drawInstanceID < sWorldMatArraySize);
-            pCB->setBlob(&worldMat, sWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
-            pCB->setBlob(&worldInvTransposeMat, sWorldInvTransposeMatOffset + drawInstanceID * sizeof(glm::mat3x4), sizeof(glm::mat3x4)); // HLSL uses column-major and packing rules require 16B alignment, hence use glm:mat3x4
-            pCB->setBlob(&prevWorldMat, sPrevWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
+                glm::mat3x4 worldInvTransposeMat = transpose(inverse(glm::mat3(worldMat)));
+
+                pCB->setBlob(&worldMat, sWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
+                pCB->setBlob(&worldInvTransposeMat, sWorldInvTransposeMatOffset + drawInstanceID * sizeof(glm::mat3x4), sizeof(glm::mat3x4)); // HLSL uses column-major and packing rules require 16B alignment, hence use glm:mat3x4
+                pCB->setBlob(&prevWorldMat, sPrevWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
+            }
 
             // Set mesh id
             pCB->setVariable(sMeshIdOffset, pMesh->getId());
@@ -234,10 +267,10 @@ namespace Falcor
         return true;
     }
 
-    void SceneRenderer::executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount)
+    void SceneRenderer::executeDraw(const CurrentWorkingData& currentData, uint32_t startIndex, uint32_t indexCount, uint32_t instanceCount)
     {
         // Draw
-        currentData.pContext->drawIndexedInstanced(indexCount, instanceCount, 0, 0, 0);
+        currentData.pContext->drawIndexedInstanced(indexCount, instanceCount, startIndex, 0, 0);
     }
 
     void SceneRenderer::draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount)
@@ -252,15 +285,19 @@ namespace Falcor
             }
             mpLastMaterial = pMesh->getMaterial().get();
 
-            if(mCompileMaterialWithProgram)
+            if(mCompileMaterialWithProgram && (currentData.useRenderQueue == false))
             {
                 currentData.pState->getProgram()->addDefine("_MS_STATIC_MATERIAL_FLAGS", std::to_string(mpLastMaterial->getFlags()));
             }
         }
 
-        executeDraw(currentData, pMesh->getIndexCount(), instanceCount);
+        const Mesh::Lod& lod = pMesh->getLod(currentData.lod);
+        executeDraw(currentData, lod.startIndex, lod.indexCount, instanceCount);
         postFlushDraw(currentData);
-        currentData.pState->getProgram()->removeDefine("_MS_STATIC_MATERIAL_FLAGS");
+        if (currentData.useRenderQueue == false)
+        {
+            currentData.pState->getProgram()->removeDefine("_MS_STATIC_MATERIAL_FLAGS");
+        }
     }
 
     void SceneRenderer::postFlushDraw(const CurrentWorkingData& currentData)
@@ -270,8 +307,107 @@ namespace Falcor
 
     bool SceneRenderer::cullMeshInstance(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance)
     {
-        BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
-        return currentData.pCamera->isObjectCulled(box);
+        uint32_t index = mpScene->getMeshInstanceIndex(currentData.modelID, currentData.modelInstanceID, currentData.meshID, currentData.meshInstanceID);
+        assert(index < mMeshInstanceVisibility.size());
+        return mMeshInstanceVisibility[index] == 0;
+    }
+
+    void SceneRenderer::cullScene(const CurrentWorkingData& currentData)
+    {
+        // Whole subtrees of the hierarchy are accepted or rejected at once, the hierarchy only refits moved instances
+        const glm::mat4& viewProj = currentData.pCamera->getViewProjMatrix();
+        mpScene->getMeshInstanceBvh().cull(viewProj, mMeshInstanceVisibility);
+        if (mOcclusionCullEnabled)
+        {
+            cullOccludedInstances(&viewProj, 1, mMeshInstanceVisibility);
+        }
+    }
+
+    glm::mat4 SceneRenderer::getLodViewProjMatrix(const CurrentWorkingData& currentData) const
+    {
+        return currentData.pCamera->getViewProjMatrix();
+    }
+
+    uint32_t SceneRenderer::selectLod(const CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t entry) const
+    {
+        const uint32_t lodCount = pMesh->getLodCount();
+        if (lodCount == 1 || currentData.lodPixelScale == 0.0f)
+        {
+            return 0;
+        }
+
+        // The errors are object space distances, the largest axis scale bounds them in world space
+        const glm::mat4& world = currentData.pTransforms->getWorld(entry);
+        const float scale = glm::max(glm::length(glm::vec3(world[0])), glm::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+
+        // Project at the nearest point of the bounding sphere. w is the view depth for perspective projections and 1 for orthographic ones.
+        const BoundingBox& box = mpScene->getMeshInstanceBvh().getItemBoxes()[entry];
+        const glm::mat4& viewProj = currentData.lodViewProj;
+        const glm::vec4 clip = viewProj * glm::vec4(box.center, 1.0f);
+        const glm::vec3 wRow(viewProj[0][3], viewProj[1][3], viewProj[2][3]);
+        const float w = clip.w - glm::length(box.extent) * glm::length(wRow);
+        if (w <= 0.0f)
+        {
+            return 0;
+        }
+
+        const glm::vec3 yRow(viewProj[0][1], viewProj[1][1], viewProj[2][1]);
+        const float pixelsPerUnit = currentData.lodPixelScale * glm::length(yRow) / w;
+
+        float allowedError = mLodSettings.maxPixelError * mLodSettings.bias;
+        if (mLodSettings.peripheryBias > 0.0f)
+        {
+            const float eccentricity = glm::length(glm::vec2(clip) / clip.w);
+            const float periphery = glm::clamp((eccentricity - mLodSettings.peripheryStart) / glm::max(1.0f - mLodSettings.peripheryStart, 1e-3f), 0.0f, 1.0f);
+            allowedError *= 1.0f + mLodSettings.peripheryBias * periphery;
+        }
+
+        const float errorScale = scale * pixelsPerUnit;
+        for (uint32_t level = lodCount - 1; level > 0; level--)
+        {
+            if (pMesh->getLod(level).error * errorScale <= allowedError)
+            {
+                return level;
+            }
+        }
+        return 0;
+    }
+
+    void SceneRenderer::toggleOcclusionCulling(bool enable)
+    {
+        mOcclusionCullEnabled = enable;
+        if (enable && mpOcclusionCuller == nullptr)
+        {
+            mpOcclusionCuller = SoftwareOcclusionCuller::create(320, 192, WorkStealingPool::getShared());
+        }
+    }
+
+    void SceneRenderer::cullOccludedInstances(const glm::mat4* pViewProj, uint32_t viewCount, std::vector<uint8_t>& masks)
+    {
+        const BoundingVolumeHierarchy& bvh = mpScene->getMeshInstanceBvh();
+        const TransformTable& transforms = mpScene->getTransformTable();
+        assert(masks.size() == bvh.getItemCount());
+
+        // Occluders outside of all frustums can't hide anything inside of them, so only instances that passed frustum culling are rasterized
+        mpOcclusionCuller->beginFrame(pViewProj, viewCount);
+        for (uint32_t i = 0; i < (uint32_t)masks.size(); i++)
+        {
+            if (masks[i] == 0) continue;
+
+            const Scene::MeshInstanceRef& ref = mpScene->getMeshInstanceRef(i);
+            const Model* pModel = mpScene->getModel(ref.modelID).get();
+            const Mesh* pMesh = pModel->getMesh(ref.meshID).get();
+            const Mesh::OccluderGeometry* pGeometry = pMesh->getOccluderGeometry().get();
+
+            // Alpha tested materials have holes
+            if (pGeometry == nullptr || pMesh->getMaterial()->getAlphaMode() != AlphaModeOpaque) continue;
+            if (mpScene->getModelInstance(ref.modelID, ref.modelInstanceID)->isVisible() == false) continue;
+            if (pModel->getMeshInstance(ref.meshID, ref.meshInstanceID)->isVisible() == false) continue;
+
+            mpOcclusionCuller->addOccluder(pGeometry->positions.data(), (uint32_t)pGeometry->positions.size(), pGeometry->indices.data(), (uint32_t)pGeometry->indices.size(), transforms.getWorld(i));
+        }
+        mpOcclusionCuller->rasterize();
+        mpOcclusionCuller->testBoxes(bvh.getItemBoxes(), masks);
     }
 
     void SceneRenderer::renderMeshInstances(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t meshID)
@@ -283,7 +419,8 @@ namespace Falcor
         {
             Program* pProgram = currentData.pState->getProgram().get();
             bool useVsSkinning = pMesh->hasBones() && !pModel->getSkinningCache();
-            if (useVsSkinning)
+            bool setBlendingDefine = useVsSkinning && (currentData.useRenderQueue == false);
+            if (setBlendingDefine)
             {
                 pProgram->addDefine("_VERTEX_BLENDING");
             }
@@ -297,17 +434,34 @@ namespace Falcor
             for (uint32_t instanceID = 0; instanceID < instanceCount; instanceID++)
             {
                 const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, instanceID).get();
+                currentData.meshID = meshID;
+                currentData.meshInstanceID = instanceID;
+                bool added = false;
 
                 if (pMeshInstance->isVisible())
                 {
                     if ((mCullEnabled == false) || (cullMeshInstance(currentData, pModelInstance, pMeshInstance) == false))
                     {
+                        // A draw covers instances of one level, a different level ends the run
+                        const uint32_t entry = mpScene->getMeshInstanceIndex(currentData.modelID, currentData.modelInstanceID, meshID, instanceID);
+                        const uint32_t lod = selectLod(currentData, pMesh, entry);
+                        if ((activeInstances != 0) && (lod != currentData.lod))
+                        {
+                            draw(currentData, pMesh, activeInstances);
+                            activeInstances = 0;
+                        }
+                        currentData.lod = lod;
+
                         if (setPerMeshInstanceData(currentData, pModelInstance, pMeshInstance, activeInstances))
                         {
+                            mLodStats.instanceCount[lod]++;
+                            mLodStats.triangleCount += pMesh->getLod(lod).indexCount / 3;
+                            mLodStats.fullDetailTriangleCount += pMesh->getIndexCount() / 3;
                             currentData.drawID++;
                             activeInstances++;
+                            added = true;
 
-                            if (activeInstances == mMaxInstanceCount)
+                            if ((currentData.useInstanceBuffer == false) && (activeInstances == mMaxInstanceCount))
                             {
                                 // DISABLED_FOR_D3D12
                                 //pContext->setProgram(currentData.pProgram->getActiveProgramVersion());
@@ -317,6 +471,13 @@ namespace Falcor
                         }
                     }
                 }
+
+                // Instance buffer draws read consecutive entries, a skipped instance ends the range
+                if (currentData.useInstanceBuffer && (added == false) && (activeInstances != 0))
+                {
+                    draw(currentData, pMesh, activeInstances);
+                    activeInstances = 0;
+                }
             }
             if(activeInstances != 0)
             {
@@ -324,7 +485,7 @@ namespace Falcor
             }
 
             // Restore the program state
-            if (useVsSkinning)
+            if (setBlendingDefine)
             {
                 pProgram->removeDefine("_VERTEX_BLENDING");
             }
@@ -352,29 +513,269 @@ namespace Falcor
         renderScene(pContext, mpScene->getActiveCamera().get());
     }
 
+    bool SceneRenderer::updateInstanceBuffer(const CurrentWorkingData& currentData)
+    {
+        if (sFirstInstanceOffset == ConstantBuffer::kInvalidOffset || currentData.pTransforms == nullptr) return false;
+
+        const TransformTable& transforms = *currentData.pTransforms;
+        const uint32_t count = transforms.getCount();
+        if (count == 0) return false;
+
+        uint32_t firstChanged = count;
+        if (mpInstanceBuffer == nullptr || mpInstanceBuffer->getElementCount() < count)
+        {
+            mpInstanceBuffer = StructuredBuffer::create(currentData.pState->getProgram(), "gMeshInstanceData", count, Resource::BindFlags::ShaderResource);
+            if (mpInstanceBuffer == nullptr) return false;
+
+            mInstanceWorldMatOffset = mpInstanceBuffer->getVariableOffset("worldMat");
+            mInstancePrevWorldMatOffset = mpInstanceBuffer->getVariableOffset("prevWorldMat");
+            mInstanceWorldInvTransposeMatOffset = mpInstanceBuffer->getVariableOffset("worldInvTransposeMat");
+            firstChanged = 0;
+        }
+
+        // Copy runs of entries recomputed since the last copy, every run is uploaded on its own
+        const size_t stride = mpInstanceBuffer->getElementSize();
+        uint32_t entry = 0;
+        while (entry < count)
+        {
+            if (entry < firstChanged && transforms.getEntryUpdate(entry) <= mInstanceBufferUpdate)
+            {
+                entry++;
+                continue;
+            }
+
+            uint32_t runStart = entry;
+            while (entry < count && (entry >= firstChanged || transforms.getEntryUpdate(entry) > mInstanceBufferUpdate))
+            {
+                size_t offset = entry * stride;
+                mpInstanceBuffer->setBlob(&transforms.getWorld(entry), offset + mInstanceWorldMatOffset, sizeof(glm::mat4));
+                mpInstanceBuffer->setBlob(&transforms.getPrevWorld(entry), offset + mInstancePrevWorldMatOffset, sizeof(glm::mat4));
+                mpInstanceBuffer->setBlob(&transforms.getNormal(entry), offset + mInstanceWorldInvTransposeMatOffset, sizeof(glm::mat3x4));
+                entry++;
+            }
+            mpInstanceBuffer->uploadToGPU(runStart * stride, (entry - runStart) * stride);
+        }
+        mInstanceBufferUpdate = transforms.getUpdateCount();
+
+        currentData.pVars->setStructuredBuffer("gMeshInstanceData", mpInstanceBuffer);
+        return true;
+    }
+
+    void SceneRenderer::buildRenderQueue()
+    {
+        mRenderQueue.clear();
+        mQueuePrograms.clear();
+        mPrewarmedPrograms.clear();
+
+        // State indices are assigned in traversal order, only equality matters for the walk
+        std::map<uint64_t, uint32_t> programs;
+        std::unordered_map<const Material*, uint32_t> materials;
+        std::unordered_map<const Vao*, uint32_t> geometries;
+
+        for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = mpScene->getModel(modelID).get();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                const Material* pMaterial = pMesh->getMaterial().get();
+                bool useVsSkinning = pMesh->hasBones() && !pModel->getSkinningCache();
+                uint32_t materialFlags = mCompileMaterialWithProgram ? pMaterial->getFlags() : 0;
+
+                uint64_t programId = (uint64_t(materialFlags) << 1) | (useVsSkinning ? 1 : 0);
+                auto program = programs.emplace(programId, (uint32_t)programs.size());
+                if (program.second)
+                {
+                    mQueuePrograms.push_back({ useVsSkinning, mCompileMaterialWithProgram, materialFlags });
+                }
+                auto material = materials.emplace(pMaterial, (uint32_t)materials.size());
+                const Vao* pVao = useVsSkinning ? pMesh->getVao().get() : pModel->getMeshVao(pMesh).get();
+                auto geometry = geometries.emplace(pVao, (uint32_t)geometries.size());
+
+                uint64_t key = RenderQueue::makeKey(program.first->second, material.first->second, geometry.first->second, 0);
+                for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
+                {
+                    mRenderQueue.add(key, program.first->second, modelID, instanceID, meshID);
+                }
+            }
+        }
+        mRenderQueue.sort();
+    }
+
+    void SceneRenderer::updateRenderQueue(const CurrentWorkingData& currentData)
+    {
+        uint32_t sceneVersion = mpScene->getMeshInstanceDataVersion();
+        if (sceneVersion != mRenderQueueSceneVersion || mRenderQueueCompiledMaterials != mCompileMaterialWithProgram)
+        {
+            buildRenderQueue();
+            mRenderQueueSceneVersion = sceneVersion;
+            mRenderQueueCompiledMaterials = mCompileMaterialWithProgram;
+        }
+
+        if (currentData.pCamera == nullptr) return;
+
+        // Front-to-back within a state group, by the nearest mesh instance box center along the view direction
+        const std::vector<BoundingBox>& boxes = mpScene->getMeshInstanceBvh().getItemBoxes();
+        const glm::vec3 position = currentData.pCamera->getPosition();
+        const glm::vec3 viewDir = glm::normalize(currentData.pCamera->getTarget() - position);
+        const float nearZ = currentData.pCamera->getNearPlane();
+        const float depthRange = currentData.pCamera->getFarPlane() - nearZ;
+
+        for (uint32_t i = 0; i < mRenderQueue.getDrawCount(); i++)
+        {
+            const RenderQueue::Draw& draw = mRenderQueue.getDraw(i);
+            uint32_t firstItem = mpScene->getMeshInstanceIndex(draw.modelID, draw.modelInstanceID, draw.meshID, 0);
+            uint32_t instanceCount = mpScene->getModel(draw.modelID)->getMeshInstanceCount(draw.meshID);
+
+            float nearest = depthRange + nearZ;
+            for (uint32_t item = firstItem; item < firstItem + instanceCount; item++)
+            {
+                nearest = std::min(nearest, glm::dot(boxes[item].center - position, viewDir));
+            }
+            mRenderQueue.setDepth(i, RenderQueue::quantizeDepth((nearest - nearZ) / depthRange));
+        }
+        mRenderQueue.resort();
+    }
+
+    void SceneRenderer::renderQueue(CurrentWorkingData& currentData)
+    {
+        Program* pProgram = currentData.pState->getProgram().get();
+        const uint32_t kInvalidID = uint32_t(-1);
+        uint32_t program = kInvalidID;
+        uint32_t modelID = kInvalidID;
+        uint32_t modelInstanceID = kInvalidID;
+        bool modelValid = false;
+        bool modelInstanceValid = false;
+        const Scene::ModelInstance* pInstance = nullptr;
+        mpLastMaterial = nullptr;
+
+        // Compile the variants a program needs in parallel, instead of one after the other as the walk reaches their groups
+        if (mPrewarmedPrograms.insert(pProgram).second)
+        {
+            for (const QueueProgram& queueProgram : mQueuePrograms)
+            {
+                Program::DefineList defines = pProgram->getDefines();
+                defines.remove("_VERTEX_BLENDING").remove("_MS_STATIC_MATERIAL_FLAGS");
+                if (queueProgram.vertexBlending) defines.add("_VERTEX_BLENDING");
+                if (queueProgram.staticMaterialFlags) defines.add("_MS_STATIC_MATERIAL_FLAGS", std::to_string(queueProgram.materialFlags));
+                pProgram->prewarm(defines);
+            }
+        }
+
+        for (const RenderQueue::Draw& draw : mRenderQueue.getDraws())
+        {
+            if (draw.modelID != modelID)
+            {
+                modelID = draw.modelID;
+                modelInstanceID = kInvalidID;
+                currentData.pModel = mpScene->getModel(modelID).get();
+                currentData.modelID = modelID;
+                modelValid = setPerModelData(currentData);
+            }
+            if (modelValid == false) continue;
+
+            if (draw.modelInstanceID != modelInstanceID)
+            {
+                modelInstanceID = draw.modelInstanceID;
+                pInstance = mpScene->getModelInstance(modelID, modelInstanceID).get();
+                currentData.modelInstanceID = modelInstanceID;
+                modelInstanceValid = pInstance->isVisible() && setPerModelInstanceData(currentData, pInstance, modelInstanceID);
+            }
+            if (modelInstanceValid == false) continue;
+
+            // Defines only change between program variants, so the active program version is looked up once per group
+            if (draw.program != program)
+            {
+                program = draw.program;
+                const QueueProgram& queueProgram = mQueuePrograms[program];
+                if (queueProgram.vertexBlending)
+                {
+                    pProgram->addDefine("_VERTEX_BLENDING");
+                }
+                else
+                {
+                    pProgram->removeDefine("_VERTEX_BLENDING");
+                }
+                if (queueProgram.staticMaterialFlags)
+                {
+                    pProgram->addDefine("_MS_STATIC_MATERIAL_FLAGS", std::to_string(queueProgram.materialFlags));
+                }
+                else
+                {
+                    pProgram->removeDefine("_MS_STATIC_MATERIAL_FLAGS");
+                }
+            }
+
+            renderMeshInstances(currentData, pInstance, draw.meshID);
+        }
+
+        // Restore the program state
+        pProgram->removeDefine("_VERTEX_BLENDING");
+        pProgram->removeDefine("_MS_STATIC_MATERIAL_FLAGS");
+    }
+
     void SceneRenderer::renderScene(CurrentWorkingData& currentData)
     {
         setPerFrameData(currentData);
+        currentData.pTransforms = &mpScene->getTransformTable();
 
-        for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        mLodStats = LodStats();
+        currentData.lod = 0;
+        currentData.lodPixelScale = 0.0f;
+        if (mLodSettings.enabled)
+        {
+            currentData.lodViewProj = getLodViewProjMatrix(currentData);
+            currentData.lodPixelScale = 0.5f * currentData.pState->getViewport(0).height;
+        }
+
+        Program* pProgram = currentData.pState->getProgram().get();
+        currentData.useInstanceBuffer = mUseInstanceBuffer && updateInstanceBuffer(currentData);
+        if (currentData.useInstanceBuffer)
         {
-            currentData.pModel = mpScene->getModel(modelID).get();
+            pProgram->addDefine("_INSTANCE_BUFFER");
+        }
 
-            if (setPerModelData(currentData))
+        if (mCullEnabled)
+        {
+            cullScene(currentData);
+        }
+
+        if (mUseRenderQueue)
+        {
+            updateRenderQueue(currentData);
+            currentData.useRenderQueue = true;
+            renderQueue(currentData);
+            currentData.useRenderQueue = false;
+        }
+        else
+        {
+            for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
             {
-                for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
+                currentData.pModel = mpScene->getModel(modelID).get();
+                currentData.modelID = modelID;
+
+                if (setPerModelData(currentData))
                 {
-                    const auto pInstance = mpScene->getModelInstance(modelID, instanceID).get();
-                    if (pInstance->isVisible())
+                    for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
                     {
-                        if (setPerModelInstanceData(currentData, pInstance, instanceID))
+                        const auto pInstance = mpScene->getModelInstance(modelID, instanceID).get();
+                        currentData.modelInstanceID = instanceID;
+                        if (pInstance->isVisible())
                         {
-                            renderModelInstance(currentData, pInstance);
+                            if (setPerModelInstanceData(currentData, pInstance, instanceID))
+                            {
+                                renderModelInstance(currentData, pInstance);
+                            }
                         }
                     }
                 }
             }
         }
+
+        if (currentData.useInstanceBuffer)
+        {
+            pProgram->removeDefine("_INSTANCE_BUFFER");
+        }
     }
 
     void SceneRenderer::renderScene(RenderContext* pContext, const Camera* pCamera)
@@ -26,13 +26,16 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #pragma once
+#include <set>
 #include <vector>
 #include "Utils/Gui.h"
 #include "Graphics/Camera/CameraController.h"
 #include "Graphics/Scene/Scene.h"
+#include "Graphics/Scene/RenderQueue.h"
 #include "Utils/CpuTimer.h"
 #include "API/ConstantBuffer.h"
 #include "Utils/DebugDrawer.h"
+#include "Utils/Math/SoftwareOcclusionCuller.h"
 
 namespace Falcor
 {
@@ -81,10 +84,80 @@ namespace Falcor
         */
         bool isMeshCullingEnabled() const { return mCullEnabled; }
 
-        /** Set the maximal number of mesh instance to dispatch in a single draw call.
+        /** Enable/disable software occlusion culling of the mesh instances that passed frustum culling. Only has an effect if mesh culling is enabled.
+            Meshes with occluder geometry (see Model::LoadFlags::GenerateOccluders) and an opaque material are rasterized as occluders.
+        */
+        void toggleOcclusionCulling(bool enable);
+
+        /** Check if occlusion culling is enabled
+        */
+        bool isOcclusionCullingEnabled() const { return mOcclusionCullEnabled; }
+
+        /** Get the occlusion culler, e.g. for its statistics. nullptr until occlusion culling was enabled.
+        */
+        const SoftwareOcclusionCuller::SharedPtr& getOcclusionCuller() const { return mpOcclusionCuller; }
+
+        /** Set the maximal number of mesh instance to dispatch in a single draw call. Only used if the instance buffer is disabled.
         */
         void setMaxInstanceCount(uint32_t instanceCount) { mMaxInstanceCount = instanceCount; }
 
+        /** Enable/disable the instance buffer (enabled by default).
+            If enabled, the per mesh instance transforms are kept in a structured buffer that persists across frames and only receives the entries of
+            moved instances. A draw covers a range of consecutive mesh instances of a mesh, which is all of its instances unless culling left gaps.
+            Shaders read the data through the getInstance*() functions of ShaderCommon.slang, which use the buffer if _INSTANCE_BUFFER is defined.
+            If disabled, the transforms are written to the InternalPerMeshCB arrays and draws are split every setMaxInstanceCount() instances.
+        */
+        void toggleInstanceBuffer(bool enable) { mUseInstanceBuffer = enable; }
+
+        /** Check if the instance buffer is enabled
+        */
+        bool isInstanceBufferEnabled() const { return mUseInstanceBuffer; }
+
+        /** Enable/disable the render queue (enabled by default).
+            If enabled, the scene is drawn from a list of (model instance, mesh) draws sorted by program variant, material, VAO and front-to-back depth,
+            so program defines and materials change once per group instead of per draw. The list is rebuilt when the scene structure changes, per frame
+            only the depth is refreshed. If disabled, the scene is drawn in hierarchy order, which renderers that change state per model rely on.
+        */
+        void toggleRenderQueue(bool enable) { mUseRenderQueue = enable; }
+
+        /** Check if the render queue is enabled
+        */
+        bool isRenderQueueEnabled() const { return mUseRenderQueue; }
+
+        /** Force a rebuild of the render queue. Needed after changing the material of a mesh or attaching a skinning cache.
+        */
+        void invalidateRenderQueue() { mRenderQueueSceneVersion = 0; }
+
+        /** Get the render queue in the order of the last frame
+        */
+        const RenderQueue& getRenderQueue() const { return mRenderQueue; }
+
+        /** Screen-space error driven level of detail selection for meshes with several levels (see Model::LoadFlags::GenerateLods).
+            Per mesh instance the coarsest level is drawn whose simplification error, projected at the near side of the instance's bounding sphere,
+            stays within the allowed pixel error. Instances the camera is inside of always use full detail.
+        */
+        struct LodSettings
+        {
+            bool enabled = true;
+            float maxPixelError = 1.0f;     ///< Allowed projected simplification error in pixels
+            float bias = 1.0f;              ///< Scales the allowed error, e.g. for passes that tolerate coarser geometry such as shadow maps
+            float peripheryBias = 0.0f;     ///< Additional scale of the allowed error at the edge of the view. Ramps up linearly from peripheryStart.
+            float peripheryStart = 0.5f;    ///< Distance of the instance from the view center in NDC at which the periphery starts
+        };
+
+        /** Level of detail statistics of the last renderScene() call
+        */
+        struct LodStats
+        {
+            uint32_t instanceCount[Mesh::kMaxLodCount] = {};    ///< Mesh instances drawn per level
+            uint64_t triangleCount = 0;                          ///< Triangles drawn
+            uint64_t fullDetailTriangleCount = 0;                ///< Triangles the same mesh instances have at full detail
+        };
+
+        void setLodSettings(const LodSettings& settings) { mLodSettings = settings; }
+        const LodSettings& getLodSettings() const { return mLodSettings; }
+        const LodStats& getLodStats() const { return mLodStats; }
+
         enum class CameraControllerType
         {
             FirstPerson,
@@ -110,8 +183,18 @@ namespace Falcor
             const Camera* pCamera = nullptr;
             const Model* pModel = nullptr;
             const Material* pMaterial = nullptr;
+            const TransformTable* pTransforms = nullptr;    // If set, the draw transforms are read from the table instead of being computed per draw
+            bool useInstanceBuffer = false;                 // If set, drawInstanceID counts consecutive mesh instances whose data is already in the instance buffer
+            bool useRenderQueue = false;                    // If set, the program defines of a draw are set by renderQueue() once per program variant
+            glm::mat4 lodViewProj;                          // View-projection the level of detail is selected for
+            float lodPixelScale = 0.0f;                     // Half the viewport height in pixels, 0 if level of detail selection is disabled
+            uint32_t lod = 0;                               // Level of detail of the pending draw
 
             uint32_t drawID; // Zero-based mesh instance draw order/ID. Resets at the beginning of renderScene, and increments per mesh instance drawn.
+            uint32_t modelID = 0;           // Indices of the model, model instance, mesh and mesh instance currently processed
+            uint32_t modelInstanceID = 0;
+            uint32_t meshID = 0;
+            uint32_t meshInstanceID = 0;
         };
 
         SceneRenderer(const Scene::SharedPtr& pScene);
@@ -135,6 +218,8 @@ namespace Falcor
         static size_t sWorldInvTransposeMatOffset;
         static size_t sMeshIdOffset;
         static size_t sDrawIDOffset;
+        static size_t sFirstInstanceOffset;
+        static size_t sFirstDrawIdOffset;
 
         static void updateVariableOffsets(const ProgramReflection* pReflector);
 
@@ -144,22 +229,82 @@ namespace Falcor
         virtual bool setPerMeshData(const CurrentWorkingData& currentData, const Mesh* pMesh);
         virtual bool setPerMeshInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, uint32_t drawInstanceID);
         virtual bool setPerMaterialData(const CurrentWorkingData& currentData, const Material* pMaterial);
-        virtual void executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount);
+        virtual void executeDraw(const CurrentWorkingData& currentData, uint32_t startIndex, uint32_t indexCount, uint32_t instanceCount);
         virtual void postFlushDraw(const CurrentWorkingData& currentData);
         virtual bool cullMeshInstance(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance);
 
+        /** Called once per renderScene() before the traversal if culling is enabled. The default implementation culls the scene's mesh instance hierarchy
+            with the camera frustum and stores the result in mMeshInstanceVisibility, which the default cullMeshInstance() looks up.
+        */
+        virtual void cullScene(const CurrentWorkingData& currentData);
+
+        /** Get the view-projection the level of detail is selected for. The default implementation returns the camera's view-projection.
+        */
+        virtual glm::mat4 getLodViewProjMatrix(const CurrentWorkingData& currentData) const;
+
+        /** Select the level of detail of a mesh instance with the current LodSettings
+            \param[in] entry Index of the mesh instance, see Scene::getMeshInstanceIndex()
+        */
+        uint32_t selectLod(const CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t entry) const;
+
+        /** Rasterize the occluders among the mesh instances with a non-zero mask and clear the bits of the views in which a mesh instance is occluded.
+            \param[in] pViewProj View-projection matrices, bit v of a mask refers to pViewProj[v]
+            \param[in,out] masks Visibility masks indexed with Scene::getMeshInstanceIndex(), usually the frustum culling result
+        */
+        void cullOccludedInstances(const glm::mat4* pViewProj, uint32_t viewCount, std::vector<uint8_t>& masks);
+
         void renderModelInstance(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance);
         void renderMeshInstances(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t meshID);
         void draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount);
 
         void renderScene(CurrentWorkingData& currentData);
 
+        /** Create the instance buffer or copy the transform table entries that changed since the last call, then bind it
+            \return false if the program doesn't support the instance buffer
+        */
+        bool updateInstanceBuffer(const CurrentWorkingData& currentData);
+
+        /** Rebuild the render queue if the scene structure changed, otherwise only refresh the depth of the draws and restore the order
+        */
+        void updateRenderQueue(const CurrentWorkingData& currentData);
+        void buildRenderQueue();
+
+        /** Draw the render queue in order. Per model and per model instance data is set whenever the model or model instance changes.
+        */
+        void renderQueue(CurrentWorkingData& currentData);
+
         CameraControllerType mCamControllerType = CameraControllerType::SixDof;
         CameraController::SharedPtr mpCameraController;
 
         uint32_t mMaxInstanceCount = 64;
+        bool mUseInstanceBuffer = true;
+        StructuredBuffer::SharedPtr mpInstanceBuffer;
+        uint32_t mInstanceBufferUpdate = 0;     ///< TransformTable::getUpdateCount() of the last copy
+        size_t mInstanceWorldMatOffset = 0;
+        size_t mInstancePrevWorldMatOffset = 0;
+        size_t mInstanceWorldInvTransposeMatOffset = 0;
         const Material* mpLastMaterial = nullptr;
         bool mCullEnabled = true;
+        std::vector<uint8_t> mMeshInstanceVisibility;   ///< Indexed with Scene::getMeshInstanceIndex()
+        bool mOcclusionCullEnabled = false;
+        SoftwareOcclusionCuller::SharedPtr mpOcclusionCuller;
         bool mCompileMaterialWithProgram = true;
+        LodSettings mLodSettings;
+        LodStats mLodStats;
+
+        // Program variants of the render queue, indexed with RenderQueue::getProgram()
+        struct QueueProgram
+        {
+            bool vertexBlending;
+            bool staticMaterialFlags;
+            uint32_t materialFlags;
+        };
+
+        bool mUseRenderQueue = true;
+        RenderQueue mRenderQueue;
+        std::vector<QueueProgram> mQueuePrograms;
+        std::set<const Program*> mPrewarmedPrograms;   ///< Programs whose queue variants were handed to the ProgramCompiler since the last rebuild
+        uint32_t mRenderQueueSceneVersion = 0;          ///< Scene::getMeshInstanceDataVersion() the queue was built for, 0 if it needs a rebuild
+        bool mRenderQueueCompiledMaterials = false;     ///< mCompileMaterialWithProgram the queue was built with
     };
 }
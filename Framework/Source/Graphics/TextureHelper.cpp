@@ -663,74 +663,98 @@ namespace Falcor
         return nullptr;
     }
 
-    Texture::SharedPtr createTextureFromDDSFile(const std::string filename, bool generateMips, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    struct TextureFileData::Data
     {
+        std::string filename;
+        bool isDds = false;
         DdsData ddsData;
-        loadDDSDataFromFile(filename, ddsData);
+        Bitmap::UniqueConstPtr pBitmap;
+        ResourceFormat format = ResourceFormat::Unknown;
+        uint32_t mipLevels = 1;
+    };
 
-        ResourceFormat format = getDdsResourceFormat(ddsData);
-        assert(format != ResourceFormat::Unknown);
+    TextureFileData::TextureFileData() : mpData(new Data) {}
+    TextureFileData::~TextureFileData() = default;
 
-        if (loadAsSrgb)
-        {
-            format = linearToSrgbFormat(format);
-        }
+    TextureFileData::SharedPtr TextureFileData::load(const std::string& filename, bool generateMipLevels, bool loadAsSrgb)
+    {
+        SharedPtr pFile = SharedPtr(new TextureFileData);
+        Data& data = *pFile->mpData;
+        data.filename = filename;
 
-        uint32_t mipLevels;
-        if (generateMips == false || isCompressedFormat(format))
-        {
-            mipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
-        }
-        else
+        if (hasSuffix(filename, ".dds"))
         {
-            mipLevels = Texture::kMaxPossible;
-        }
+            data.isDds = true;
+            loadDDSDataFromFile(filename, data.ddsData);
+            if (data.ddsData.data.empty()) return nullptr;
 
-        if (ddsData.hasDX10Header)
-        {
-            return createTextureFromDx10Dds(ddsData, filename, format, mipLevels, bindFlags);
+            data.format = getDdsResourceFormat(data.ddsData);
+            assert(data.format != ResourceFormat::Unknown);
+            if (loadAsSrgb)
+            {
+                data.format = linearToSrgbFormat(data.format);
+            }
+
+            if (generateMipLevels == false || isCompressedFormat(data.format))
+            {
+                data.mipLevels = (data.ddsData.header.flags & DdsHeader::kMipCountMask) ? max(data.ddsData.header.mipCount, 1U) : 1;
+            }
+            else
+            {
+                data.mipLevels = Texture::kMaxPossible;
+            }
         }
         else
         {
-            return createTextureFromLegacyDds(ddsData, filename, format, mipLevels, bindFlags);
+            data.pBitmap = Bitmap::createFromFile(filename, kTopDown);
+            if (data.pBitmap == nullptr) return nullptr;
+
+            data.format = data.pBitmap->getFormat();
+            if (loadAsSrgb)
+            {
+                data.format = linearToSrgbFormat(data.format);
+            }
+            data.mipLevels = generateMipLevels ? Texture::kMaxPossible : 1;
         }
-        return nullptr;
+        return pFile;
     }
 
-    Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    Texture::SharedPtr TextureFileData::createTexture(Texture::BindFlags bindFlags)
     {
-#define no_srgb()   \
-    if(loadAsSrgb)  \
-    {               \
-        logWarning("createTexture2DFromFile() warning. " + std::to_string(pBitmap->getBytesPerPixel()) + " channel images doesn't have a matching sRGB format. Loading in linear space.");  \
-    }
-
+        Data& data = *mpData;
         Texture::SharedPtr pTex;
-        if (hasSuffix(filename, ".dds"))
+        if (data.isDds)
         {
-            pTex = createTextureFromDDSFile(filename, generateMipLevels, loadAsSrgb, bindFlags);
+            if (data.ddsData.hasDX10Header)
+            {
+                pTex = createTextureFromDx10Dds(data.ddsData, data.filename, data.format, data.mipLevels, bindFlags);
+            }
+            else
+            {
+                pTex = createTextureFromLegacyDds(data.ddsData, data.filename, data.format, data.mipLevels, bindFlags);
+            }
         }
         else
         {
-            Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
-            if(pBitmap)
-            {
-                ResourceFormat texFormat = pBitmap->getFormat();
-                if(loadAsSrgb)
-                {
-                    texFormat = linearToSrgbFormat(texFormat);
-                }
-
-                pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
-            }
+            pTex = Texture::create2D(data.pBitmap->getWidth(), data.pBitmap->getHeight(), data.format, 1, data.mipLevels, data.pBitmap->getData(), bindFlags);
         }
 
         if (pTex != nullptr)
         {
-            pTex->setSourceFilename(stripDataDirectories(filename));
+            pTex->setSourceFilename(stripDataDirectories(data.filename));
         }
-
         return pTex;
     }
-#undef no_srgb
+
+    size_t TextureFileData::getDataSize() const
+    {
+        if (mpData->isDds) return mpData->ddsData.data.size();
+        return size_t(mpData->pBitmap->getWidth()) * mpData->pBitmap->getHeight() * getFormatBytesPerBlock(mpData->format);
+    }
+
+    Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    {
+        TextureFileData::SharedPtr pFile = TextureFileData::load(filename, generateMipLevels, loadAsSrgb);
+        return pFile ? pFile->createTexture(bindFlags) : nullptr;
+    }
 }
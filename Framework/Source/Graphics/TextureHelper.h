@@ -43,5 +43,36 @@ namespace Falcor
     */
     Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
 
+    /** Image file decoded on the CPU. createTextureFromFile() is load() followed by createTexture(), splitting the two allows decoding many files
+        in parallel while the textures are created on the thread that owns the device.
+    */
+    class TextureFileData
+    {
+    public:
+        using SharedPtr = std::shared_ptr<TextureFileData>;
+
+        /** Read and decode an image file. Can be called from any thread.
+            \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory
+            \param[in] generateMipLevels Whether the mip-chain should be generated when the texture is created
+            \param[in] loadAsSrgb Load the texture using sRGB format. Only valid for 3 or 4 component textures.
+            \return A new object, or nullptr if the file couldn't be loaded
+        */
+        static SharedPtr load(const std::string& filename, bool generateMipLevels, bool loadAsSrgb);
+        ~TextureFileData();
+
+        /** Create the texture. Must be called from the thread that owns the device, and only once since the data may be converted in place.
+        */
+        Texture::SharedPtr createTexture(Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
+
+        /** Get the size of the decoded data in bytes
+        */
+        size_t getDataSize() const;
+
+    private:
+        TextureFileData();
+        struct Data;
+        std::unique_ptr<Data> mpData;
+    };
+
     /*! @} */
 }
\ No newline at end of file
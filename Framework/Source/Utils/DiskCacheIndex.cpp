@@ -0,0 +1,230 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "DiskCacheIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace Falcor
+{
+    const uint64_t DiskCacheIndex::kHashSeed;
+
+    static const char* kIndexTag = "DiskCacheIndex";
+    static const uint32_t kIndexVersion = 1;
+
+    uint64_t DiskCacheIndex::hash(const void* pData, size_t size, uint64_t seed)
+    {
+        const uint64_t kPrime = 0x100000001b3ull;
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        uint64_t h = seed;
+
+        // Whole words first, the source files can be hundreds of MB
+        size_t wordCount = size / sizeof(uint64_t);
+        for (size_t i = 0; i < wordCount; i++)
+        {
+            uint64_t word;
+            std::memcpy(&word, pBytes + i * sizeof(uint64_t), sizeof(word));
+            h = (h ^ word) * kPrime;
+        }
+
+        for (size_t i = wordCount * sizeof(uint64_t); i < size; i++)
+        {
+            h = (h ^ pBytes[i]) * kPrime;
+        }
+        return h;
+    }
+
+    std::string DiskCacheIndex::keyToString(uint64_t key)
+    {
+        static const char* kDigits = "0123456789abcdef";
+        std::string str(16, '0');
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            str[15 - i] = kDigits[(key >> (i * 4)) & 0xf];
+        }
+        return str;
+    }
+
+    const DiskCacheIndex::Entry* DiskCacheIndex::find(const std::string& key) const
+    {
+        auto it = mEntries.find(key);
+        return (it == mEntries.end()) ? nullptr : &it->second;
+    }
+
+    void DiskCacheIndex::touch(const std::string& key)
+    {
+        auto it = mEntries.find(key);
+        if (it != mEntries.end())
+        {
+            it->second.lastUse = ++mUseCounter;
+        }
+    }
+
+    std::vector<std::string> DiskCacheIndex::insert(const std::string& key, const Entry& entry, uint64_t sizeLimit)
+    {
+        remove(key);
+
+        // Don't flush the whole cache for an entry that can't stay anyway
+        if (entry.size > sizeLimit)
+        {
+            return { key };
+        }
+
+        Entry& newEntry = mEntries[key];
+        newEntry = entry;
+        newEntry.lastUse = ++mUseCounter;
+        mTotalSize += entry.size;
+        return evict(sizeLimit);
+    }
+
+    std::vector<std::string> DiskCacheIndex::evict(uint64_t sizeLimit)
+    {
+        std::vector<std::string> evicted;
+        if (mTotalSize <= sizeLimit)
+        {
+            return evicted;
+        }
+
+        std::vector<std::pair<uint64_t, const std::string*>> order;
+        order.reserve(mEntries.size());
+        for (const auto& e : mEntries)
+        {
+            order.push_back({ e.second.lastUse, &e.first });
+        }
+        std::sort(order.begin(), order.end());
+
+        for (const auto& o : order)
+        {
+            if (mTotalSize <= sizeLimit) break;
+            evicted.push_back(*o.second);
+            mTotalSize -= mEntries[*o.second].size;
+        }
+
+        // Erase after the loop, the order vector points into the map
+        for (const auto& key : evicted)
+        {
+            mEntries.erase(key);
+        }
+        return evicted;
+    }
+
+    bool DiskCacheIndex::remove(const std::string& key)
+    {
+        auto it = mEntries.find(key);
+        if (it == mEntries.end())
+        {
+            return false;
+        }
+        mTotalSize -= it->second.size;
+        mEntries.erase(it);
+        return true;
+    }
+
+    std::vector<std::string> DiskCacheIndex::getKeys() const
+    {
+        std::vector<std::string> keys;
+        keys.reserve(mEntries.size());
+        for (const auto& e : mEntries)
+        {
+            keys.push_back(e.first);
+        }
+        return keys;
+    }
+
+    void DiskCacheIndex::clear()
+    {
+        mEntries.clear();
+        mTotalSize = 0;
+    }
+
+    std::string DiskCacheIndex::serialize() const
+    {
+        // One line per entry, followed by one line per dependency. Paths are last on their line so they can contain spaces.
+        std::ostringstream stream;
+        stream << kIndexTag << ' ' << kIndexVersion << ' ' << mUseCounter << ' ' << mEntries.size() << '\n';
+        for (const auto& e : mEntries)
+        {
+            stream << e.first << ' ' << e.second.size << ' ' << e.second.lastUse << ' ' << e.second.dependencies.size() << '\n';
+            for (const auto& d : e.second.dependencies)
+            {
+                stream << d.second << ' ' << d.first << '\n';
+            }
+        }
+        return stream.str();
+    }
+
+    bool DiskCacheIndex::deserialize(const std::string& data)
+    {
+        clear();
+        mUseCounter = 0;
+
+        std::istringstream stream(data);
+        std::string tag;
+        uint32_t version = 0;
+        size_t entryCount = 0;
+        stream >> tag >> version >> mUseCounter >> entryCount;
+        if (stream.fail() || tag != kIndexTag || version != kIndexVersion)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < entryCount; i++)
+        {
+            std::string key;
+            Entry entry;
+            size_t dependencyCount = 0;
+            stream >> key >> entry.size >> entry.lastUse >> dependencyCount;
+            if (stream.fail())
+            {
+                clear();
+                return false;
+            }
+
+            for (size_t d = 0; d < dependencyCount; d++)
+            {
+                int64_t time;
+                std::string path;
+                stream >> time;
+                stream.get();
+                std::getline(stream, path);
+                if (stream.fail())
+                {
+                    clear();
+                    return false;
+                }
+                entry.dependencies.push_back({ path, time });
+            }
+
+            mTotalSize += entry.size;
+            mUseCounter = std::max(mUseCounter, entry.lastUse);
+            mEntries[key] = std::move(entry);
+        }
+        return true;
+    }
+}
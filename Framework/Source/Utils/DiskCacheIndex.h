@@ -0,0 +1,107 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Falcor
+{
+    /** LRU bookkeeping for a directory of cache files.
+        The index only tracks keys, sizes and the order of use. Reading, writing and deleting the files is up to the owner, which also persists the index
+        using serialize()/deserialize(). Not thread-safe.
+    */
+    class DiskCacheIndex
+    {
+    public:
+        struct Entry
+        {
+            uint64_t size = 0;      ///< Size of the cached file in bytes
+            uint64_t lastUse = 0;   ///< Value of the use counter when the entry was last inserted or touched
+            std::vector<std::pair<std::string, int64_t>> dependencies;  ///< Files the entry was built from and their modification times
+        };
+
+        static const uint64_t kHashSeed = 0xcbf29ce484222325ull;
+
+        /** Compute a 64-bit FNV-1a hash, processed in 64-bit words. Pass the result of a previous call as the seed to hash several blocks.
+        */
+        static uint64_t hash(const void* pData, size_t size, uint64_t seed = kHashSeed);
+
+        /** Convert a hash to a 16 character hexadecimal string, suitable for a filename
+        */
+        static std::string keyToString(uint64_t key);
+
+        /** Get an entry, nullptr if the key is not in the index
+        */
+        const Entry* find(const std::string& key) const;
+
+        /** Mark an entry as the most recently used one
+        */
+        void touch(const std::string& key);
+
+        /** Add or replace an entry and evict the least recently used entries until the total size fits the limit.
+            An entry larger than the limit is not added and is returned as evicted, without evicting anything else.
+            \return The keys of the evicted entries
+        */
+        std::vector<std::string> insert(const std::string& key, const Entry& entry, uint64_t sizeLimit);
+
+        /** Evict the least recently used entries until the total size fits the limit
+            \return The keys of the evicted entries
+        */
+        std::vector<std::string> evict(uint64_t sizeLimit);
+
+        /** Remove an entry
+            \return false if the key is not in the index
+        */
+        bool remove(const std::string& key);
+
+        void clear();
+
+        /** Get the keys of all entries, in no particular order
+        */
+        std::vector<std::string> getKeys() const;
+
+        uint32_t getCount() const { return (uint32_t)mEntries.size(); }
+        uint64_t getTotalSize() const { return mTotalSize; }
+
+        /** Convert the index to a text representation
+        */
+        std::string serialize() const;
+
+        /** Replace the index with the content of serialize()'s output
+            \return false if the data is malformed. The index is left empty in that case.
+        */
+        bool deserialize(const std::string& data);
+
+    private:
+        std::unordered_map<std::string, Entry> mEntries;
+        uint64_t mUseCounter = 0;
+        uint64_t mTotalSize = 0;
+    };
+}
@@ -0,0 +1,360 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BoundingVolumeHierarchy.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    const uint32_t BoundingVolumeHierarchy::kMaxLeafSize;
+    const uint32_t BoundingVolumeHierarchy::kInvalidNode;
+    const float BoundingVolumeHierarchy::kRebuildThreshold = 1.5f;
+
+    namespace
+    {
+        struct FrustumPlane
+        {
+            glm::vec3 xyz;
+            glm::vec3 sign;
+            float negW;
+        };
+
+        void extractPlanes(const glm::mat4& viewProj, FrustumPlane planes[6])
+        {
+            // Same extraction and test as Camera, so items are culled exactly like with Camera::isObjectCulled()
+            glm::mat4 tempMat = glm::transpose(viewProj);
+            for (int i = 0; i < 6; i++)
+            {
+                glm::vec4 plane = (i & 1) ? tempMat[i >> 1] : -tempMat[i >> 1];
+                if (i != 5) // Z range is [0, w]. For the 0 <= z plane we don't need to add w
+                {
+                    plane += tempMat[3];
+                }
+                planes[i].xyz = glm::vec3(plane);
+                planes[i].sign = glm::sign(planes[i].xyz);
+                planes[i].negW = -plane.w;
+            }
+        }
+
+        float getSurfaceArea(const glm::vec3& min, const glm::vec3& max)
+        {
+            glm::vec3 d = max - min;
+            return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+        }
+
+        const uint32_t kAllPlanes = 0x3f;
+    }
+
+    void BoundingVolumeHierarchy::build(const std::vector<BoundingBox>& boxes)
+    {
+        const uint32_t itemCount = (uint32_t)boxes.size();
+        mItemBoxes = boxes;
+        mItemOrder.resize(itemCount);
+        mItemLeaf.assign(itemCount, kInvalidNode);
+        mCentroids.resize(itemCount);
+        for (uint32_t i = 0; i < itemCount; i++)
+        {
+            mItemOrder[i] = i;
+            mCentroids[i] = boxes[i].center;
+        }
+
+        mNodes.clear();
+        mDirtyNodes.clear();
+        mDepth = 0;
+        if (itemCount > 0)
+        {
+            mNodes.reserve(2 * itemCount);
+            mNodes.emplace_back();
+            buildNode(0, kInvalidNode, 0, itemCount, 1);
+        }
+        mNodeDirty.assign(mNodes.size(), 0);
+        mSurfaceArea = getSurfaceAreaSum();
+        mBuildSurfaceArea = mSurfaceArea;
+        mCentroids.clear();
+    }
+
+    void BoundingVolumeHierarchy::buildNode(uint32_t nodeIndex, uint32_t parent, uint32_t firstItem, uint32_t itemCount, uint32_t depth)
+    {
+        mDepth = std::max(mDepth, depth);
+        {
+            Node& node = mNodes[nodeIndex];
+            node.parent = parent;
+            node.firstItem = firstItem;
+            node.itemCount = itemCount;
+            node.leftChild = kInvalidNode;
+        }
+
+        if (itemCount <= kMaxLeafSize)
+        {
+            for (uint32_t i = firstItem; i < firstItem + itemCount; i++)
+            {
+                mItemLeaf[mItemOrder[i]] = nodeIndex;
+            }
+            updateNodeBounds(mNodes[nodeIndex]);
+            return;
+        }
+
+        // Median split along the longest axis of the centroid bounds
+        glm::vec3 centroidMin = mCentroids[mItemOrder[firstItem]];
+        glm::vec3 centroidMax = centroidMin;
+        for (uint32_t i = firstItem + 1; i < firstItem + itemCount; i++)
+        {
+            centroidMin = glm::min(centroidMin, mCentroids[mItemOrder[i]]);
+            centroidMax = glm::max(centroidMax, mCentroids[mItemOrder[i]]);
+        }
+        glm::vec3 size = centroidMax - centroidMin;
+        int axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z ? 1 : 2);
+
+        uint32_t half = itemCount / 2;
+        auto begin = mItemOrder.begin() + firstItem;
+        std::nth_element(begin, begin + half, begin + itemCount, [this, axis](uint32_t a, uint32_t b) { return mCentroids[a][axis] < mCentroids[b][axis]; });
+
+        // Siblings are adjacent and always stored after their parent, refit() relies on that
+        uint32_t leftChild = (uint32_t)mNodes.size();
+        mNodes.emplace_back();
+        mNodes.emplace_back();
+        mNodes[nodeIndex].leftChild = leftChild;
+        buildNode(leftChild, nodeIndex, firstItem, half, depth + 1);
+        buildNode(leftChild + 1, nodeIndex, firstItem + half, itemCount - half, depth + 1);
+        updateNodeBounds(mNodes[nodeIndex]);
+    }
+
+    void BoundingVolumeHierarchy::updateNodeBounds(Node& node)
+    {
+        if (node.leftChild == kInvalidNode)
+        {
+            const BoundingBox& first = mItemBoxes[mItemOrder[node.firstItem]];
+            node.min = first.getMinPos();
+            node.max = first.getMaxPos();
+            for (uint32_t i = node.firstItem + 1; i < node.firstItem + node.itemCount; i++)
+            {
+                const BoundingBox& box = mItemBoxes[mItemOrder[i]];
+                node.min = glm::min(node.min, box.getMinPos());
+                node.max = glm::max(node.max, box.getMaxPos());
+            }
+        }
+        else
+        {
+            const Node& left = mNodes[node.leftChild];
+            const Node& right = mNodes[node.leftChild + 1];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+    }
+
+    void BoundingVolumeHierarchy::setItemBox(uint32_t item, const BoundingBox& box)
+    {
+        assert(item < mItemBoxes.size());
+        mItemBoxes[item] = box;
+
+        // Mark the path to the root. Stop at the first node that is already marked, the rest of the path is marked as well.
+        for (uint32_t node = mItemLeaf[item]; node != kInvalidNode && mNodeDirty[node] == 0; node = mNodes[node].parent)
+        {
+            mNodeDirty[node] = 1;
+            mDirtyNodes.push_back(node);
+        }
+    }
+
+    uint32_t BoundingVolumeHierarchy::refit()
+    {
+        // Children have higher indices than their parents, so refitting in descending order is bottom-up
+        std::sort(mDirtyNodes.begin(), mDirtyNodes.end(), std::greater<uint32_t>());
+        for (uint32_t nodeIndex : mDirtyNodes)
+        {
+            Node& node = mNodes[nodeIndex];
+            mSurfaceArea -= getSurfaceArea(node.min, node.max);
+            updateNodeBounds(node);
+            mSurfaceArea += getSurfaceArea(node.min, node.max);
+            mNodeDirty[nodeIndex] = 0;
+        }
+
+        uint32_t refitCount = (uint32_t)mDirtyNodes.size();
+        mDirtyNodes.clear();
+        return refitCount;
+    }
+
+    bool BoundingVolumeHierarchy::needsRebuild() const
+    {
+        return mBuildSurfaceArea > 0.f && mSurfaceArea > mBuildSurfaceArea * kRebuildThreshold;
+    }
+
+    float BoundingVolumeHierarchy::getSurfaceAreaSum() const
+    {
+        float sum = 0.f;
+        for (const Node& node : mNodes)
+        {
+            sum += getSurfaceArea(node.min, node.max);
+        }
+        return sum;
+    }
+
+    BoundingBox BoundingVolumeHierarchy::getBounds() const
+    {
+        return mNodes.empty() ? BoundingBox() : BoundingBox::fromMinMax(mNodes[0].min, mNodes[0].max);
+    }
+
+    uint32_t BoundingVolumeHierarchy::cull(const glm::mat4& viewProj, std::vector<uint8_t>& visible) const
+    {
+        mCullStats = CullStats();
+        visible.assign(mItemBoxes.size(), 0);
+        if (mNodes.empty()) return 0;
+
+        FrustumPlane planes[6];
+        extractPlanes(viewProj, planes);
+
+        // Stack of (node, mask of the planes the node's parent intersects). Planes a parent is completely inside of are skipped for the subtree.
+        mStack.clear();
+        mStack.push_back(0);
+        mStack.push_back(kAllPlanes);
+        while (mStack.empty() == false)
+        {
+            uint32_t planeMask = mStack.back(); mStack.pop_back();
+            uint32_t nodeIndex = mStack.back(); mStack.pop_back();
+            const Node& node = mNodes[nodeIndex];
+            mCullStats.nodesVisited++;
+
+            glm::vec3 center = (node.max + node.min) * 0.5f;
+            glm::vec3 extent = (node.max - node.min) * 0.5f;
+            bool outside = false;
+            uint32_t intersectMask = 0;
+            for (int p = 0; p < 6 && !outside; p++)
+            {
+                if ((planeMask & (1 << p)) == 0) continue;
+                glm::vec3 signedExtent = extent * planes[p].sign;
+                outside = glm::dot(center + signedExtent, planes[p].xyz) <= planes[p].negW;
+                if (glm::dot(center - signedExtent, planes[p].xyz) <= planes[p].negW)
+                {
+                    intersectMask |= (1 << p);
+                }
+            }
+
+            if (outside)
+            {
+                mCullStats.subtreesRejected++;
+            }
+            else if (intersectMask == 0)
+            {
+                // Completely inside, accept the whole subtree without looking at it
+                mCullStats.subtreesAccepted++;
+                for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+                {
+                    visible[mItemOrder[i]] = 1;
+                }
+                mCullStats.itemsVisible += node.itemCount;
+            }
+            else if (node.leftChild == kInvalidNode)
+            {
+                for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+                {
+                    const BoundingBox& box = mItemBoxes[mItemOrder[i]];
+                    bool isInside = true;
+                    for (int p = 0; p < 6 && isInside; p++)
+                    {
+                        if ((intersectMask & (1 << p)) == 0) continue;
+                        glm::vec3 signedExtent = box.extent * planes[p].sign;
+                        isInside = glm::dot(box.center + signedExtent, planes[p].xyz) > planes[p].negW;
+                    }
+                    if (isInside)
+                    {
+                        visible[mItemOrder[i]] = 1;
+                        mCullStats.itemsVisible++;
+                    }
+                }
+            }
+            else
+            {
+                mStack.push_back(node.leftChild);
+                mStack.push_back(intersectMask);
+                mStack.push_back(node.leftChild + 1);
+                mStack.push_back(intersectMask);
+            }
+        }
+
+        return mCullStats.itemsVisible;
+    }
+
+    uint32_t BoundingVolumeHierarchy::cull(const StereoFrustumCuller& culler, std::vector<uint8_t>& masks) const
+    {
+        mCullStats = CullStats();
+        masks.assign(mItemBoxes.size(), 0);
+        if (mNodes.empty()) return 0;
+
+        mBatch.clear();
+        mBatchItems.clear();
+        mStack.clear();
+        mStack.push_back(0);
+        while (mStack.empty() == false)
+        {
+            const Node& node = mNodes[mStack.back()];
+            mStack.pop_back();
+            mCullStats.nodesVisited++;
+
+            BoundingBox box;
+            box.center = (node.max + node.min) * 0.5f;
+            box.extent = (node.max - node.min) * 0.5f;
+            uint8_t contained;
+            uint8_t visible = culler.classify(box, contained);
+
+            if (visible == 0)
+            {
+                mCullStats.subtreesRejected++;
+            }
+            else if (contained == visible)
+            {
+                // Every eye contains the subtree or misses it, so all items get the node's mask
+                mCullStats.subtreesAccepted++;
+                for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+                {
+                    masks[mItemOrder[i]] = visible;
+                }
+                mCullStats.itemsVisible += node.itemCount;
+            }
+            else if (node.leftChild == kInvalidNode)
+            {
+                for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+                {
+                    mBatchItems.push_back(mItemOrder[i]);
+                    mBatch.add(mItemBoxes[mItemOrder[i]]);
+                }
+            }
+            else
+            {
+                mStack.push_back(node.leftChild);
+                mStack.push_back(node.leftChild + 1);
+            }
+        }
+
+        culler.cull(mBatch, mBatchMasks);
+        for (size_t i = 0; i < mBatchItems.size(); i++)
+        {
+            masks[mBatchItems[i]] = mBatchMasks[i];
+            if (mBatchMasks[i] != 0) mCullStats.itemsVisible++;
+        }
+        return mCullStats.itemsVisible;
+    }
+}
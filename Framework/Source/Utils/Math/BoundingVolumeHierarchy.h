@@ -0,0 +1,138 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Utils/AABB.h"
+#include "Utils/Math/StereoFrustumCuller.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** Bounding volume hierarchy over a fixed set of world space boxes ("items"), used for hierarchical frustum culling.
+        The tree is built top-down. Item boxes can change afterwards; setItemBox() only marks the path to the root and refit()
+        recomputes exactly those nodes, so animating a few instances costs O(changed * depth) instead of a rebuild.
+        Refitting keeps the topology, so a lot of movement degrades the tree. needsRebuild() reports when that happened.
+    */
+    class BoundingVolumeHierarchy
+    {
+    public:
+        static const uint32_t kMaxLeafSize = 4;
+
+        /** Traversal statistics of the last cull() call
+        */
+        struct CullStats
+        {
+            uint32_t nodesVisited = 0;
+            uint32_t subtreesAccepted = 0;  ///< Nodes completely inside the frustum, their items were accepted without a test
+            uint32_t subtreesRejected = 0;  ///< Nodes completely outside of at least one plane
+            uint32_t itemsVisible = 0;
+        };
+
+        /** Build the tree. Item i has the box boxes[i].
+        */
+        void build(const std::vector<BoundingBox>& boxes);
+
+        /** Change the box of an item. Takes effect with the next refit().
+        */
+        void setItemBox(uint32_t item, const BoundingBox& box);
+
+        /** Recompute the bounds of all nodes above changed items
+            \return Number of nodes that were refit
+        */
+        uint32_t refit();
+
+        /** Whether the tree lost so much quality through refitting that it should be rebuilt.
+            Compares the summed node surface area with the one right after the last build.
+        */
+        bool needsRebuild() const;
+
+        /** Cull all items against a view frustum
+            \param[in] viewProj View-projection matrix (D3D clip space, 0 <= z <= w)
+            \param[out] visible One entry per item, 1 if the item box intersects the frustum. Items give the same result as Camera::isObjectCulled().
+            \return Number of visible items
+        */
+        uint32_t cull(const glm::mat4& viewProj, std::vector<uint8_t>& visible) const;
+
+        /** Cull all items against both eye frustums.
+            Nodes are classified against the two frustums together. Subtrees that are outside of both or that each eye either contains or misses
+            are decided without looking at their items, only the items of leaves on a frustum border go through the culler's SSE batch test.
+            \param[in] culler Culler with both eye frustums set
+            \param[out] masks One StereoFrustumCuller visibility mask per item, the same as culling every item box with the culler
+            \return Number of items visible to at least one eye
+        */
+        uint32_t cull(const StereoFrustumCuller& culler, std::vector<uint8_t>& masks) const;
+
+        uint32_t getItemCount() const { return (uint32_t)mItemBoxes.size(); }
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+        uint32_t getDepth() const { return mDepth; }
+        const BoundingBox& getItemBox(uint32_t item) const { return mItemBoxes[item]; }
+        const std::vector<BoundingBox>& getItemBoxes() const { return mItemBoxes; }
+
+        /** Bounds of the root node
+        */
+        BoundingBox getBounds() const;
+
+        const CullStats& getLastCullStats() const { return mCullStats; }
+
+        /** Surface area growth relative to the last build that makes needsRebuild() return true
+        */
+        static const float kRebuildThreshold;
+
+    private:
+        struct Node
+        {
+            glm::vec3 min;
+            glm::vec3 max;
+            uint32_t firstItem;     ///< Items of the subtree are mItemOrder[firstItem, firstItem + itemCount)
+            uint32_t itemCount;
+            uint32_t leftChild;     ///< Right child is leftChild + 1, kInvalidNode for leaves
+            uint32_t parent;
+        };
+
+        static const uint32_t kInvalidNode = uint32_t(-1);
+
+        void buildNode(uint32_t nodeIndex, uint32_t parent, uint32_t firstItem, uint32_t itemCount, uint32_t depth);
+        void updateNodeBounds(Node& node);
+        float getSurfaceAreaSum() const;
+
+        std::vector<Node> mNodes;
+        std::vector<BoundingBox> mItemBoxes;
+        std::vector<uint32_t> mItemOrder;       ///< Items sorted so that every subtree is a contiguous range
+        std::vector<uint32_t> mItemLeaf;        ///< Leaf node of each item
+        std::vector<uint8_t> mNodeDirty;
+        std::vector<uint32_t> mDirtyNodes;
+        std::vector<glm::vec3> mCentroids;      ///< Build scratch
+        float mSurfaceArea = 0.f;           ///< Summed surface area of all nodes
+        float mBuildSurfaceArea = 0.f;
+        uint32_t mDepth = 0;
+        mutable CullStats mCullStats;
+        mutable std::vector<uint32_t> mStack;   ///< Traversal scratch, pairs of node index and plane mask
+        mutable StereoFrustumCuller::Batch mBatch;  ///< Stereo traversal scratch, boxes of the border leaves' items
+        mutable std::vector<uint32_t> mBatchItems;
+        mutable std::vector<uint8_t> mBatchMasks;
+    };
+}
@@ -0,0 +1,333 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Falcor
+{
+    const uint32_t MeshOptimizer::kDefaultCacheSize;
+    const float MeshOptimizer::kDefaultOverdrawThreshold = 1.05f;
+
+    namespace
+    {
+        /** FIFO cache simulation. A vertex is cached if it was one of the last cacheSize vertices inserted.
+        */
+        class FifoCache
+        {
+        public:
+            FifoCache(uint32_t vertexCount, uint32_t cacheSize) : mInsertTime(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+            /** Look up a vertex and insert it on a miss. Returns true on a miss.
+            */
+            bool access(uint32_t vertex)
+            {
+                if (mTime - mInsertTime[vertex] > mCacheSize)
+                {
+                    mInsertTime[vertex] = mTime++;
+                    return true;
+                }
+                return false;
+            }
+
+            /** Evict all vertices
+            */
+            void flush() { mTime += mCacheSize + 1; }
+
+        private:
+            std::vector<uint64_t> mInsertTime;
+            uint64_t mCacheSize;
+            uint64_t mTime;
+        };
+
+        uint32_t accessTriangle(FifoCache& cache, const uint32_t* pTriangle)
+        {
+            return (uint32_t)cache.access(pTriangle[0]) + (uint32_t)cache.access(pTriangle[1]) + (uint32_t)cache.access(pTriangle[2]);
+        }
+    }
+
+    MeshOptimizer::VertexCacheStats& MeshOptimizer::VertexCacheStats::operator+=(const VertexCacheStats& other)
+    {
+        transformedCount += other.transformedCount;
+        triangleCount += other.triangleCount;
+        vertexCount += other.vertexCount;
+        return *this;
+    }
+
+    MeshOptimizer::VertexCacheStats MeshOptimizer::analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        assert(indexCount % 3 == 0);
+        VertexCacheStats stats;
+        FifoCache cache(vertexCount, cacheSize);
+        std::vector<bool> used(vertexCount, false);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            uint32_t v = pIndices[i];
+            assert(v < vertexCount);
+            stats.transformedCount += cache.access(v) ? 1 : 0;
+            if (used[v] == false)
+            {
+                used[v] = true;
+                stats.vertexCount++;
+            }
+        }
+        stats.triangleCount = indexCount / 3;
+        return stats;
+    }
+
+    void MeshOptimizer::optimizeVertexCache(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        assert(indexCount % 3 == 0);
+        const uint32_t triangleCount = (uint32_t)(indexCount / 3);
+        if (triangleCount == 0) return;
+
+        // Vertex to triangle adjacency. liveCount is the number of triangles referencing a vertex that were not emitted yet.
+        std::vector<uint32_t> liveCount(vertexCount, 0);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            liveCount[pIndices[i]]++;
+        }
+        std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            adjacencyOffset[v + 1] = adjacencyOffset[v] + liveCount[v];
+        }
+        std::vector<uint32_t> adjacency(indexCount);
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            adjacency[fill[pIndices[i]]++] = (uint32_t)(i / 3);
+        }
+
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint64_t> cacheTime(vertexCount, 0);
+        uint64_t time = cacheSize + 1;
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        uint32_t cursor = 0;
+
+        // Next vertex with live triangles from the dead-end stack, or in input order if the stack runs empty
+        auto skipDeadEnd = [&]() -> int64_t
+        {
+            while (deadEnds.empty() == false)
+            {
+                uint32_t v = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveCount[v] > 0) return v;
+            }
+            for (; cursor < vertexCount; cursor++)
+            {
+                if (liveCount[cursor] > 0) return cursor;
+            }
+            return -1;
+        };
+
+        int64_t fanVertex = skipDeadEnd();
+        while (fanVertex >= 0)
+        {
+            // Emit all remaining triangles around the fanning vertex
+            candidates.clear();
+            for (uint32_t a = adjacencyOffset[fanVertex]; a < adjacencyOffset[fanVertex + 1]; a++)
+            {
+                uint32_t t = adjacency[a];
+                if (emitted[t]) continue;
+                emitted[t] = true;
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    uint32_t v = pIndices[t * 3 + c];
+                    result.push_back(v);
+                    deadEnds.push_back(v);
+                    candidates.push_back(v);
+                    liveCount[v]--;
+                    if (time - cacheTime[v] > cacheSize)
+                    {
+                        cacheTime[v] = time++;
+                    }
+                }
+            }
+
+            // Prefer the oldest candidate that will still be in the cache after its remaining triangles were emitted
+            int64_t next = -1;
+            uint64_t bestPriority = 0;
+            for (uint32_t v : candidates)
+            {
+                if (liveCount[v] == 0) continue;
+                uint64_t priority = 0;
+                if (time - cacheTime[v] + 2 * liveCount[v] <= cacheSize)
+                {
+                    priority = time - cacheTime[v];
+                }
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    next = v;
+                }
+            }
+            fanVertex = (next >= 0) ? next : skipDeadEnd();
+        }
+
+        assert(result.size() == indexCount);
+        std::copy(result.begin(), result.end(), pIndices);
+    }
+
+    void MeshOptimizer::optimizeOverdraw(uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t stride, uint32_t vertexCount, uint32_t cacheSize, float threshold)
+    {
+        assert(indexCount % 3 == 0);
+        const uint32_t triangleCount = (uint32_t)(indexCount / 3);
+        if (triangleCount == 0) return;
+
+        // Hard boundaries: triangles that miss the cache with all three vertices restart the cache order
+        std::vector<uint32_t> hardClusters;
+        {
+            FifoCache cache(vertexCount, cacheSize);
+            for (uint32_t t = 0; t < triangleCount; t++)
+            {
+                if (accessTriangle(cache, pIndices + t * 3) == 3) hardClusters.push_back(t);
+            }
+        }
+        hardClusters.push_back(triangleCount);
+
+        // Soft boundaries: split hard clusters once the cache efficiency of the split part is close to the one of the whole cluster
+        std::vector<uint32_t> clusters;
+        {
+            FifoCache cache(vertexCount, cacheSize);
+            for (size_t h = 0; h + 1 < hardClusters.size(); h++)
+            {
+                uint32_t begin = hardClusters[h];
+                uint32_t end = hardClusters[h + 1];
+
+                cache.flush();
+                uint32_t clusterMisses = 0;
+                for (uint32_t t = begin; t < end; t++)
+                {
+                    clusterMisses += accessTriangle(cache, pIndices + t * 3);
+                }
+                float clusterAcmr = float(clusterMisses) / float(end - begin);
+
+                cache.flush();
+                clusters.push_back(begin);
+                uint32_t misses = 0;
+                uint32_t start = begin;
+                for (uint32_t t = begin; t < end; t++)
+                {
+                    misses += accessTriangle(cache, pIndices + t * 3);
+                    if (t + 1 < end && float(misses) <= threshold * clusterAcmr * float(t + 1 - start))
+                    {
+                        clusters.push_back(t + 1);
+                        start = t + 1;
+                        misses = 0;
+                        cache.flush();
+                    }
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+
+        auto getPosition = [&](uint32_t v) { return *(const glm::vec3*)((const uint8_t*)pPositions + v * stride); };
+
+        glm::vec3 meshCentroid(0.0f);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            meshCentroid += getPosition(pIndices[i]);
+        }
+        meshCentroid /= float(indexCount);
+
+        // Sort key: distance of the area weighted cluster centroid from the mesh centroid along the average cluster normal.
+        // Clusters facing away from the center are more likely to occlude the rest of the mesh.
+        const uint32_t clusterCount = (uint32_t)clusters.size() - 1;
+        std::vector<float> sortKey(clusterCount);
+        for (uint32_t c = 0; c < clusterCount; c++)
+        {
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+            {
+                glm::vec3 p0 = getPosition(pIndices[t * 3]);
+                glm::vec3 p1 = getPosition(pIndices[t * 3 + 1]);
+                glm::vec3 p2 = getPosition(pIndices[t * 3 + 2]);
+                glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                float a = glm::length(n);
+                centroid += (p0 + p1 + p2) * (a / 3.0f);
+                normal += n;
+                area += a;
+            }
+            float normalLength = glm::length(normal);
+            sortKey[c] = (area > 0.0f && normalLength > 0.0f) ? glm::dot(centroid / area - meshCentroid, normal / normalLength) : 0.0f;
+        }
+
+        std::vector<uint32_t> order(clusterCount);
+        for (uint32_t c = 0; c < clusterCount; c++) order[c] = c;
+        std::stable_sort(order.begin(), order.end(), [&sortKey](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+        for (uint32_t c : order)
+        {
+            result.insert(result.end(), pIndices + clusters[c] * 3, pIndices + clusters[c + 1] * 3);
+        }
+        std::copy(result.begin(), result.end(), pIndices);
+    }
+
+    std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount)
+    {
+        const uint32_t kUnassigned = uint32_t(-1);
+        std::vector<uint32_t> remap(vertexCount, kUnassigned);
+        uint32_t next = 0;
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            uint32_t v = pIndices[i];
+            if (remap[v] == kUnassigned) remap[v] = next++;
+        }
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            if (remap[v] == kUnassigned) remap[v] = next++;
+        }
+        return remap;
+    }
+
+    void MeshOptimizer::remapIndices(uint32_t* pIndices, size_t indexCount, const std::vector<uint32_t>& remap)
+    {
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            pIndices[i] = remap[pIndices[i]];
+        }
+    }
+
+    void MeshOptimizer::remapVertices(void* pData, size_t elementSize, const std::vector<uint32_t>& remap)
+    {
+        std::vector<uint8_t> copy((const uint8_t*)pData, (const uint8_t*)pData + remap.size() * elementSize);
+        for (size_t v = 0; v < remap.size(); v++)
+        {
+            std::memcpy((uint8_t*)pData + remap[v] * elementSize, copy.data() + v * elementSize, elementSize);
+        }
+    }
+}
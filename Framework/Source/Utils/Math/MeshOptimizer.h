@@ -0,0 +1,102 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU reordering of indexed triangle lists for the GPU vertex pipeline, used at import time.
+        optimizeVertexCache() reorders triangles for the post-transform vertex cache with Tipsify (Sander et al. 2007).
+        optimizeOverdraw() then splits that order into clusters and sorts the clusters by a view-independent occlusion potential, so
+        outward-facing clusters on the hull are drawn first. Cutting clusters only where the cache order has a restart or where the
+        local cache efficiency is already good keeps most of the cache gains.
+        optimizeVertexFetch() finally renumbers the vertices in order of first use, so the vertex fetch reads memory sequentially.
+        All functions work on a single mesh and are thread-safe for different meshes.
+    */
+    class MeshOptimizer
+    {
+    public:
+        static const uint32_t kDefaultCacheSize = 16;       ///< Post-transform cache size targeted by the optimization and the analysis
+        static const float kDefaultOverdrawThreshold;       ///< Allowed ACMR increase over the cache order when cutting clusters
+
+        /** Result of a FIFO post-transform cache simulation. Counts add up, so results of several meshes can be summed.
+        */
+        struct VertexCacheStats
+        {
+            uint64_t transformedCount = 0;  ///< Vertex shader invocations (cache misses)
+            uint64_t triangleCount = 0;
+            uint64_t vertexCount = 0;       ///< Vertices referenced by the index buffer
+
+            /** Average cache miss ratio, transformed vertices per triangle. 0.5 is the limit for regular meshes, 3 means no reuse.
+            */
+            float getAcmr() const { return triangleCount ? float(transformedCount) / float(triangleCount) : 0.0f; }
+
+            /** Average transform to vertex ratio, 1 is optimal.
+            */
+            float getAtvr() const { return vertexCount ? float(transformedCount) / float(vertexCount) : 0.0f; }
+
+            VertexCacheStats& operator+=(const VertexCacheStats& other);
+        };
+
+        /** Simulate a FIFO post-transform cache
+            \param[in] pIndices Three indices per triangle
+            \param[in] vertexCount Number of vertices, all indices must be smaller
+            \param[in] cacheSize Number of cache entries
+        */
+        static VertexCacheStats analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = kDefaultCacheSize);
+
+        /** Reorder the triangles in place for the post-transform cache. Runs in linear time.
+            \param[in] cacheSize Cache size the order is optimized for
+        */
+        static void optimizeVertexCache(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = kDefaultCacheSize);
+
+        /** Reorder clusters of triangles in place to reduce overdraw. Expects the triangles to be in vertex cache order.
+            \param[in] pPositions Vertex positions, three floats at the start of every vertex
+            \param[in] stride Distance between two positions in bytes
+            \param[in] threshold A cluster is cut once its ACMR is at most threshold times the ACMR of the surrounding cache order. 1 keeps only the cuts at cache restarts.
+        */
+        static void optimizeOverdraw(uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t stride, uint32_t vertexCount,
+            uint32_t cacheSize = kDefaultCacheSize, float threshold = kDefaultOverdrawThreshold);
+
+        /** Compute a vertex remap table that orders the vertices by first use. Unreferenced vertices are moved to the end in their original order.
+            \return For every old vertex the new vertex index
+        */
+        static std::vector<uint32_t> optimizeVertexFetch(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount);
+
+        /** Replace every index with its entry in the remap table
+        */
+        static void remapIndices(uint32_t* pIndices, size_t indexCount, const std::vector<uint32_t>& remap);
+
+        /** Move every vertex of an interleaved or single attribute stream to its new position
+            \param[in] pData remap.size() vertices of elementSize bytes
+        */
+        static void remapVertices(void* pData, size_t elementSize, const std::vector<uint32_t>& remap);
+    };
+}
@@ -0,0 +1,470 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <tuple>
+#include <unordered_map>
+
+namespace Falcor
+{
+    const float MeshSimplifier::kMaxNormalDeviation = 0.25f;
+
+    namespace
+    {
+        const double kBorderWeight = 10.0;      // Border planes are weighted higher than surface planes, so open borders keep their shape
+        const uint32_t kMaxPassCount = 64;
+
+        /** Sum of weighted squared distances to planes, stored as the upper half of a symmetric 4x4 matrix
+        */
+        struct Quadric
+        {
+            double a2 = 0, b2 = 0, c2 = 0, d2 = 0;
+            double ab = 0, ac = 0, ad = 0, bc = 0, bd = 0, cd = 0;
+            double weight = 0;
+
+            static Quadric fromPlane(const glm::dvec3& n, double d, double weight)
+            {
+                Quadric q;
+                q.a2 = n.x * n.x * weight; q.b2 = n.y * n.y * weight; q.c2 = n.z * n.z * weight; q.d2 = d * d * weight;
+                q.ab = n.x * n.y * weight; q.ac = n.x * n.z * weight; q.ad = n.x * d * weight;
+                q.bc = n.y * n.z * weight; q.bd = n.y * d * weight; q.cd = n.z * d * weight;
+                q.weight = weight;
+                return q;
+            }
+
+            Quadric& operator+=(const Quadric& q)
+            {
+                a2 += q.a2; b2 += q.b2; c2 += q.c2; d2 += q.d2;
+                ab += q.ab; ac += q.ac; ad += q.ad; bc += q.bc; bd += q.bd; cd += q.cd;
+                weight += q.weight;
+                return *this;
+            }
+
+            /** Weighted sum of squared distances of a point to the planes
+            */
+            double evaluate(const glm::dvec3& p) const
+            {
+                double rx = a2 * p.x + ab * p.y + ac * p.z + ad;
+                double ry = ab * p.x + b2 * p.y + bc * p.z + bd;
+                double rz = ac * p.x + bc * p.y + c2 * p.z + cd;
+                double rw = ad * p.x + bd * p.y + cd * p.z + d2;
+                return std::max(0.0, rx * p.x + ry * p.y + rz * p.z + rw);
+            }
+        };
+
+        enum class VertexKind : uint8_t
+        {
+            Manifold,   // Single vertex at the position, surrounded by triangles
+            Border,     // Single vertex at the position on exactly one open border
+            Locked,     // Attribute seam, non-manifold or border corner
+        };
+
+        struct Collapse
+        {
+            uint32_t from;      // Position IDs
+            uint32_t to;
+            uint32_t vertex;    // Vertex at the target position the vertex of 'from' is replaced with
+            double cost;
+        };
+
+        uint64_t makeEdgeKey(uint32_t a, uint32_t b)
+        {
+            return (uint64_t(a) << 32) | b;
+        }
+
+        class Simplifier
+        {
+        public:
+            Simplifier(const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t stride, uint32_t vertexCount, const std::vector<MeshSimplifier::Attribute>& attributes)
+                : mVertexCount(vertexCount), mAttributes(attributes)
+            {
+                // Work relative to the extent of the referenced vertices, so the error limit and the attribute weights don't depend on the scale of the mesh
+                glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+                for (size_t i = 0; i < indexCount; i++)
+                {
+                    const glm::vec3& p = *(const glm::vec3*)((const uint8_t*)pPositions + pIndices[i] * stride);
+                    minPos = glm::min(minPos, p);
+                    maxPos = glm::max(maxPos, p);
+                }
+                glm::vec3 extent = maxPos - minPos;
+                mScale = (indexCount > 0) ? std::max(extent.x, std::max(extent.y, extent.z)) : 0.0f;
+                float invScale = (mScale > 0.0f) ? 1.0f / mScale : 0.0f;
+
+                mPositions.resize(vertexCount);
+                for (uint32_t v = 0; v < vertexCount; v++)
+                {
+                    const glm::vec3& p = *(const glm::vec3*)((const uint8_t*)pPositions + v * stride);
+                    mPositions[v] = glm::dvec3((p - minPos) * invScale);
+                }
+
+                // Vertices with bitwise equal positions share a position ID, the vertices of an ID form a list
+                std::vector<uint32_t> order(vertexCount);
+                for (uint32_t v = 0; v < vertexCount; v++) order[v] = v;
+                auto getKey = [pPositions, stride](uint32_t v)
+                {
+                    const uint32_t* pBits = (const uint32_t*)((const uint8_t*)pPositions + v * stride);
+                    return std::make_tuple(pBits[0], pBits[1], pBits[2]);
+                };
+                std::sort(order.begin(), order.end(), [&getKey](uint32_t a, uint32_t b) { return getKey(a) < getKey(b); });
+
+                mPositionId.resize(vertexCount);
+                mWedgeNext.resize(vertexCount);
+                for (uint32_t i = 0; i < vertexCount; i++)
+                {
+                    uint32_t v = order[i];
+                    if (i == 0 || getKey(order[i - 1]) != getKey(v))
+                    {
+                        mPositionVertex.push_back(v);
+                        mWedgeCount.push_back(0);
+                    }
+                    uint32_t id = (uint32_t)mPositionVertex.size() - 1;
+                    mPositionId[v] = id;
+                    mWedgeCount[id]++;
+                    mWedgeNext[v] = (mWedgeCount[id] == 1) ? v : mWedgeNext[mPositionVertex[id]];
+                    mWedgeNext[mPositionVertex[id]] = v;
+                }
+            }
+
+            float getScale() const { return mScale; }
+
+            /** Remove collapses until the target is reached or the cheapest collapse exceeds the error limit
+                \return The largest error of a collapse, relative to the mesh extent
+            */
+            double simplify(std::vector<uint32_t>& indices, size_t targetIndexCount, double maxError)
+            {
+                const double errorLimit = maxError * maxError;
+                double resultError = 0.0;
+
+                for (uint32_t pass = 0; pass < kMaxPassCount && indices.size() > targetIndexCount; pass++)
+                {
+                    classifyVertices(indices);
+                    computeQuadrics(indices);
+                    buildAdjacency(indices);
+                    std::vector<Collapse> collapses = rankCollapses(indices);
+                    if (collapses.empty() || collapses[0].cost > errorLimit) break;
+
+                    // Every collapse removes up to two triangles
+                    const size_t triangleCount = indices.size() / 3;
+                    const size_t targetTriangleCount = targetIndexCount / 3;
+                    size_t budget = std::max<size_t>((triangleCount - targetTriangleCount) / 2, 1);
+
+                    std::vector<uint32_t> remap(mVertexCount);
+                    for (uint32_t v = 0; v < mVertexCount; v++) remap[v] = v;
+                    std::vector<bool> locked(mPositionVertex.size(), false);
+                    size_t collapseCount = 0;
+
+                    for (const Collapse& c : collapses)
+                    {
+                        if (c.cost > errorLimit || collapseCount >= budget) break;
+                        if (locked[c.from] || locked[c.to]) continue;
+                        if (flipsTriangle(indices, c.from, c.to)) continue;
+
+                        remap[mPositionVertex[c.from]] = c.vertex;
+                        resultError = std::max(resultError, c.cost);
+                        collapseCount++;
+
+                        // The triangles around the moved vertex change, lock their vertices so that the flip test stays valid for this pass
+                        for (uint32_t a = mAdjacencyOffset[c.from]; a < mAdjacencyOffset[c.from + 1]; a++)
+                        {
+                            const uint32_t* pTriangle = &indices[mAdjacency[a] * 3];
+                            for (uint32_t i = 0; i < 3; i++) locked[mPositionId[pTriangle[i]]] = true;
+                        }
+                        locked[c.to] = true;
+                    }
+                    if (collapseCount == 0) break;
+
+                    // Apply the collapses and drop the triangles that became degenerate
+                    size_t writeIndex = 0;
+                    for (size_t t = 0; t < indices.size(); t += 3)
+                    {
+                        uint32_t v0 = remap[indices[t]], v1 = remap[indices[t + 1]], v2 = remap[indices[t + 2]];
+                        uint32_t p0 = mPositionId[v0], p1 = mPositionId[v1], p2 = mPositionId[v2];
+                        if (p0 == p1 || p1 == p2 || p0 == p2) continue;
+                        indices[writeIndex++] = v0;
+                        indices[writeIndex++] = v1;
+                        indices[writeIndex++] = v2;
+                    }
+                    indices.resize(writeIndex);
+                }
+                return std::sqrt(resultError);
+            }
+
+        private:
+            void classifyVertices(const std::vector<uint32_t>& indices)
+            {
+                // Directed edges between positions, an edge without its opposite is on an open border
+                mEdges.clear();
+                for (size_t t = 0; t < indices.size(); t += 3)
+                {
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        uint32_t a = mPositionId[indices[t + i]];
+                        uint32_t b = mPositionId[indices[t + (i + 1) % 3]];
+                        mEdges[makeEdgeKey(a, b)]++;
+                    }
+                }
+
+                std::vector<uint32_t> borderOut(mPositionVertex.size(), 0);
+                std::vector<uint32_t> borderIn(mPositionVertex.size(), 0);
+                std::vector<bool> nonManifold(mPositionVertex.size(), false);
+                for (const auto& edge : mEdges)
+                {
+                    uint32_t a = uint32_t(edge.first >> 32);
+                    uint32_t b = uint32_t(edge.first);
+                    if (edge.second > 1)
+                    {
+                        nonManifold[a] = nonManifold[b] = true;
+                    }
+                    if (mEdges.count(makeEdgeKey(b, a)) == 0)
+                    {
+                        borderOut[a]++;
+                        borderIn[b]++;
+                    }
+                }
+
+                mKind.resize(mPositionVertex.size());
+                for (uint32_t p = 0; p < (uint32_t)mPositionVertex.size(); p++)
+                {
+                    if (mWedgeCount[p] > 1 || nonManifold[p]) mKind[p] = VertexKind::Locked;
+                    else if (borderOut[p] == 0 && borderIn[p] == 0) mKind[p] = VertexKind::Manifold;
+                    else if (borderOut[p] == 1 && borderIn[p] == 1) mKind[p] = VertexKind::Border;
+                    else mKind[p] = VertexKind::Locked;
+                }
+            }
+
+            void computeQuadrics(const std::vector<uint32_t>& indices)
+            {
+                mQuadrics.assign(mPositionVertex.size(), Quadric());
+                for (size_t t = 0; t < indices.size(); t += 3)
+                {
+                    const glm::dvec3& p0 = mPositions[indices[t]];
+                    const glm::dvec3& p1 = mPositions[indices[t + 1]];
+                    const glm::dvec3& p2 = mPositions[indices[t + 2]];
+                    glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+                    double length = glm::length(n);
+                    if (length == 0.0) continue;
+                    n /= length;
+
+                    Quadric q = Quadric::fromPlane(n, -glm::dot(n, p0), length * 0.5);
+                    for (uint32_t i = 0; i < 3; i++) mQuadrics[mPositionId[indices[t + i]]] += q;
+
+                    // Border edges get a plane through the edge, perpendicular to the triangle
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        uint32_t a = mPositionId[indices[t + i]];
+                        uint32_t b = mPositionId[indices[t + (i + 1) % 3]];
+                        if (mEdges.count(makeEdgeKey(b, a)) != 0) continue;
+
+                        const glm::dvec3& pa = mPositions[indices[t + i]];
+                        glm::dvec3 edge = mPositions[indices[t + (i + 1) % 3]] - pa;
+                        glm::dvec3 borderNormal = glm::cross(edge, n);
+                        double borderLength = glm::length(borderNormal);
+                        if (borderLength == 0.0) continue;
+                        borderNormal /= borderLength;
+
+                        Quadric border = Quadric::fromPlane(borderNormal, -glm::dot(borderNormal, pa), glm::dot(edge, edge) * kBorderWeight);
+                        mQuadrics[a] += border;
+                        mQuadrics[b] += border;
+                    }
+                }
+            }
+
+            void buildAdjacency(const std::vector<uint32_t>& indices)
+            {
+                const size_t positionCount = mPositionVertex.size();
+                mAdjacencyOffset.assign(positionCount + 1, 0);
+                for (uint32_t index : indices) mAdjacencyOffset[mPositionId[index] + 1]++;
+                for (size_t p = 0; p < positionCount; p++) mAdjacencyOffset[p + 1] += mAdjacencyOffset[p];
+
+                mAdjacency.resize(indices.size());
+                std::vector<uint32_t> fill(mAdjacencyOffset.begin(), mAdjacencyOffset.end() - 1);
+                for (size_t i = 0; i < indices.size(); i++)
+                {
+                    mAdjacency[fill[mPositionId[indices[i]]]++] = uint32_t(i / 3);
+                }
+            }
+
+            double getAttributeError(uint32_t a, uint32_t b) const
+            {
+                double error = 0.0;
+                for (const auto& attrib : mAttributes)
+                {
+                    const float* pA = (const float*)((const uint8_t*)attrib.pData + a * attrib.stride);
+                    const float* pB = (const float*)((const uint8_t*)attrib.pData + b * attrib.stride);
+                    double sum = 0.0;
+                    for (uint32_t c = 0; c < attrib.componentCount; c++)
+                    {
+                        double d = double(pA[c]) - double(pB[c]);
+                        sum += d * d;
+                    }
+                    error += sum * double(attrib.weight) * double(attrib.weight);
+                }
+                return error;
+            }
+
+            /** Cheapest valid collapse of every movable position, sorted by cost
+            */
+            std::vector<Collapse> rankCollapses(const std::vector<uint32_t>& indices) const
+            {
+                std::vector<Collapse> best(mPositionVertex.size(), { 0, 0, 0, DBL_MAX });
+                for (size_t t = 0; t < indices.size(); t += 3)
+                {
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        for (uint32_t j = 1; j < 3; j++)
+                        {
+                            uint32_t from = mPositionId[indices[t + i]];
+                            uint32_t to = mPositionId[indices[t + (i + j) % 3]];
+                            VertexKind kind = mKind[from];
+                            if (kind == VertexKind::Locked) continue;
+
+                            // Border vertices may only slide along their border
+                            if (kind == VertexKind::Border)
+                            {
+                                bool borderEdge = (mEdges.count(makeEdgeKey(from, to)) == 0) || (mEdges.count(makeEdgeKey(to, from)) == 0);
+                                if (borderEdge == false || mKind[to] == VertexKind::Manifold) continue;
+                            }
+
+                            Quadric q = mQuadrics[from];
+                            q += mQuadrics[to];
+                            uint32_t fromVertex = mPositionVertex[from];
+                            const glm::dvec3& target = mPositions[mPositionVertex[to]];
+                            double positionError = (q.weight > 0.0) ? q.evaluate(target) / q.weight : 0.0;
+
+                            // Pick the vertex at the target position with the closest attributes
+                            uint32_t vertex = mPositionVertex[to];
+                            double attributeError = getAttributeError(fromVertex, vertex);
+                            for (uint32_t w = mWedgeNext[vertex]; w != mPositionVertex[to]; w = mWedgeNext[w])
+                            {
+                                double e = getAttributeError(fromVertex, w);
+                                if (e < attributeError)
+                                {
+                                    attributeError = e;
+                                    vertex = w;
+                                }
+                            }
+
+                            double cost = positionError + attributeError;
+                            if (cost < best[from].cost) best[from] = { from, to, vertex, cost };
+                        }
+                    }
+                }
+
+                std::vector<Collapse> collapses;
+                for (const Collapse& c : best)
+                {
+                    if (c.cost != DBL_MAX) collapses.push_back(c);
+                }
+                std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+                return collapses;
+            }
+
+            bool flipsTriangle(const std::vector<uint32_t>& indices, uint32_t from, uint32_t to) const
+            {
+                const glm::dvec3& target = mPositions[mPositionVertex[to]];
+                for (uint32_t a = mAdjacencyOffset[from]; a < mAdjacencyOffset[from + 1]; a++)
+                {
+                    const uint32_t* pTriangle = &indices[mAdjacency[a] * 3];
+                    glm::dvec3 before[3], after[3];
+                    bool degenerate = false;
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        uint32_t p = mPositionId[pTriangle[i]];
+                        degenerate |= (p == to);
+                        before[i] = mPositions[pTriangle[i]];
+                        after[i] = (p == from) ? target : before[i];
+                    }
+                    // Triangles containing the edge disappear
+                    if (degenerate) continue;
+
+                    glm::dvec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::dvec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    if (glm::dot(n0, n1) <= double(MeshSimplifier::kMaxNormalDeviation) * glm::length(n0) * glm::length(n1)) return true;
+                }
+                return false;
+            }
+
+            uint32_t mVertexCount;
+            const std::vector<MeshSimplifier::Attribute>& mAttributes;
+            float mScale = 0.0f;
+            std::vector<glm::dvec3> mPositions;         // Relative to the mesh extent, indexed by vertex
+            std::vector<uint32_t> mPositionId;          // Indexed by vertex
+            std::vector<uint32_t> mWedgeNext;           // Next vertex with the same position, circular
+            std::vector<uint32_t> mPositionVertex;      // First vertex of every position
+            std::vector<uint32_t> mWedgeCount;          // Vertices of every position
+
+            // Per pass, indexed by position ID
+            std::unordered_map<uint64_t, uint32_t> mEdges;
+            std::vector<VertexKind> mKind;
+            std::vector<Quadric> mQuadrics;
+            std::vector<uint32_t> mAdjacencyOffset;
+            std::vector<uint32_t> mAdjacency;
+        };
+    }
+
+    std::vector<uint32_t> MeshSimplifier::simplify(const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t stride, uint32_t vertexCount,
+        const std::vector<Attribute>& attributes, size_t targetIndexCount, float maxError, float* pError)
+    {
+        assert(indexCount % 3 == 0);
+        std::vector<uint32_t> indices(pIndices, pIndices + indexCount);
+        Simplifier simplifier(pIndices, indexCount, pPositions, stride, vertexCount, attributes);
+        double error = (simplifier.getScale() > 0.0f) ? simplifier.simplify(indices, targetIndexCount, maxError) : 0.0;
+        if (pError) *pError = float(error) * simplifier.getScale();
+        return indices;
+    }
+
+    std::vector<MeshSimplifier::Lod> MeshSimplifier::generateLods(const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t stride, uint32_t vertexCount,
+        const std::vector<Attribute>& attributes, uint32_t maxLodCount, uint32_t minTriangleCount, float maxError)
+    {
+        assert(indexCount % 3 == 0);
+        std::vector<Lod> lods;
+        Simplifier simplifier(pIndices, indexCount, pPositions, stride, vertexCount, attributes);
+        if (simplifier.getScale() == 0.0f) return lods;
+
+        std::vector<uint32_t> indices(pIndices, pIndices + indexCount);
+        double chainError = 0.0;
+        while (lods.size() < maxLodCount)
+        {
+            size_t triangleCount = indices.size() / 3;
+            size_t targetTriangleCount = triangleCount / 2;
+            if (targetTriangleCount < minTriangleCount) break;
+
+            chainError += simplifier.simplify(indices, targetTriangleCount * 3, maxError - chainError);
+            if (chainError > maxError || indices.size() / 3 > triangleCount * 3 / 4) break;
+
+            Lod lod;
+            lod.indices = indices;
+            lod.error = float(chainError) * simplifier.getScale();
+            lods.push_back(std::move(lod));
+        }
+        return lods;
+    }
+}
@@ -0,0 +1,86 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Index buffer simplification for mesh LODs, based on quadric error metrics (Garland and Heckbert 1997).
+        Vertices are collapsed onto neighboring vertices, so the simplified index buffers reference the vertices of the full detail mesh and all
+        levels of detail can share its vertex buffers. Every collapse is rated by the quadric error of the moved position plus the weighted change of
+        the vertex attributes, the cheapest collapses are done first.
+        Vertices that share a position with other vertices (attribute seams) and non-manifold vertices are never moved. Vertices on an open border
+        only move along the border, so holes and mesh boundaries keep their shape. Collapses that would flip a triangle are rejected.
+        Errors are distances in object space. They are measured relative to the level that was simplified, generateLods() sums them up along the chain.
+    */
+    class MeshSimplifier
+    {
+    public:
+        static const float kMaxNormalDeviation;     ///< Cosine of the largest allowed rotation of a triangle normal by a collapse
+
+        /** Vertex attribute that should be preserved
+        */
+        struct Attribute
+        {
+            const float* pData = nullptr;
+            size_t stride = 0;              ///< Distance between the attributes of two vertices in bytes
+            uint32_t componentCount = 0;
+            float weight = 1.0f;            ///< The attribute difference times the weight is compared to position differences relative to the mesh extent
+        };
+
+        /** A level of detail
+        */
+        struct Lod
+        {
+            std::vector<uint32_t> indices;
+            float error = 0.0f;             ///< Estimated object space distance to the full detail mesh
+        };
+
+        /** Simplify a triangle list
+            \param[in] pPositions Vertex positions, three floats at the start of every vertex
+            \param[in] stride Distance between two positions in bytes
+            \param[in] targetIndexCount Stop once the result has at most this many indices
+            \param[in] maxError Largest error of a collapse, relative to the largest extent of the mesh
+            \param[out] pError If not nullptr, the object space error of the result
+            \return Indices of the simplified mesh. Has more than targetIndexCount indices if the error limit was reached first.
+        */
+        static std::vector<uint32_t> simplify(const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t stride, uint32_t vertexCount,
+            const std::vector<Attribute>& attributes, size_t targetIndexCount, float maxError, float* pError = nullptr);
+
+        /** Generate a chain of levels of detail. Every level targets half the triangles of the previous level and is simplified from it.
+            The chain ends after maxLodCount levels, when a level would have less than minTriangleCount triangles, or when a level can't remove a
+            quarter of the triangles of the previous one within maxError.
+            \param[in] maxError Largest error of a level relative to the largest extent of the mesh, summed over the chain
+            \return The levels after the full detail mesh, ordered from fine to coarse
+        */
+        static std::vector<Lod> generateLods(const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t stride, uint32_t vertexCount,
+            const std::vector<Attribute>& attributes, uint32_t maxLodCount, uint32_t minTriangleCount, float maxError);
+    };
+}
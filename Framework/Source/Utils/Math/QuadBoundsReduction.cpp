@@ -0,0 +1,350 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "QuadBoundsReduction.h"
+#include "Utils/CpuTimer.h"
+#include <algorithm>
+#include <cfloat>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define QUAD_BOUNDS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Falcor
+{
+    namespace
+    {
+        void initBounds(QuadBoundsReduction::Bounds& bounds)
+        {
+            bounds.minDepth = FLT_MAX;
+            bounds.maxDepth = -FLT_MAX;
+            bounds.minNormal = glm::vec3(FLT_MAX);
+            bounds.maxNormal = glm::vec3(-FLT_MAX);
+        }
+
+        // Handles tiles crossing the image border, texels outside of the image read as 0
+        void reduceTileScalar(const float* pDepth, const glm::vec4* pNormal, uint32_t width, uint32_t height, uint32_t x0, uint32_t y0, QuadBoundsReduction::Bounds& bounds)
+        {
+            initBounds(bounds);
+            for (uint32_t y = y0; y < y0 + QuadBoundsReduction::kTileSize; y++)
+            {
+                for (uint32_t x = x0; x < x0 + QuadBoundsReduction::kTileSize; x++)
+                {
+                    bool inside = x < width && y < height;
+                    size_t index = (size_t)y * width + x;
+                    float d = inside ? pDepth[index] : 0.f;
+                    bounds.minDepth = std::min(bounds.minDepth, d);
+                    bounds.maxDepth = std::max(bounds.maxDepth, d);
+                    if (pNormal)
+                    {
+                        glm::vec3 n = inside ? glm::vec3(pNormal[index]) : glm::vec3(0.f);
+                        bounds.minNormal = glm::min(bounds.minNormal, n);
+                        bounds.maxNormal = glm::max(bounds.maxNormal, n);
+                    }
+                }
+            }
+        }
+
+#ifdef QUAD_BOUNDS_X86
+        inline float horizontalMin(__m128 v)
+        {
+            v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+            v = _mm_min_ss(v, _mm_shuffle_ps(v, v, 1));
+            return _mm_cvtss_f32(v);
+        }
+
+        inline float horizontalMax(__m128 v)
+        {
+            v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+            v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+            return _mm_cvtss_f32(v);
+        }
+
+        inline glm::vec3 toVec3(__m128 v)
+        {
+            alignas(16) float f[4];
+            _mm_store_ps(f, v);
+            return glm::vec3(f[0], f[1], f[2]);
+        }
+
+        // Tile fully inside the image. A depth row is 4 registers, a normal row 16 registers (one texel each).
+        TARGET_SSE41 void reduceTileSSE41(const float* pDepth, const glm::vec4* pNormal, uint32_t width, uint32_t x0, uint32_t y0, QuadBoundsReduction::Bounds& bounds)
+        {
+            __m128 minD0 = _mm_set1_ps(FLT_MAX), minD1 = minD0;
+            __m128 maxD0 = _mm_set1_ps(-FLT_MAX), maxD1 = maxD0;
+            for (uint32_t y = 0; y < QuadBoundsReduction::kTileSize; y++)
+            {
+                const float* pRow = pDepth + (size_t)(y0 + y) * width + x0;
+                __m128 a = _mm_loadu_ps(pRow);
+                __m128 b = _mm_loadu_ps(pRow + 4);
+                __m128 c = _mm_loadu_ps(pRow + 8);
+                __m128 d = _mm_loadu_ps(pRow + 12);
+                minD0 = _mm_min_ps(minD0, _mm_min_ps(a, b));
+                minD1 = _mm_min_ps(minD1, _mm_min_ps(c, d));
+                maxD0 = _mm_max_ps(maxD0, _mm_max_ps(a, b));
+                maxD1 = _mm_max_ps(maxD1, _mm_max_ps(c, d));
+            }
+            bounds.minDepth = horizontalMin(_mm_min_ps(minD0, minD1));
+            bounds.maxDepth = horizontalMax(_mm_max_ps(maxD0, maxD1));
+
+            if (pNormal == nullptr)
+            {
+                bounds.minNormal = glm::vec3(FLT_MAX);
+                bounds.maxNormal = glm::vec3(-FLT_MAX);
+                return;
+            }
+
+            __m128 minN[4], maxN[4];
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                minN[i] = _mm_set1_ps(FLT_MAX);
+                maxN[i] = _mm_set1_ps(-FLT_MAX);
+            }
+            for (uint32_t y = 0; y < QuadBoundsReduction::kTileSize; y++)
+            {
+                const float* pRow = &pNormal[(size_t)(y0 + y) * width + x0].x;
+                for (uint32_t x = 0; x < QuadBoundsReduction::kTileSize; x += 4)
+                {
+                    for (uint32_t i = 0; i < 4; i++)
+                    {
+                        __m128 n = _mm_loadu_ps(pRow + (x + i) * 4);
+                        minN[i] = _mm_min_ps(minN[i], n);
+                        maxN[i] = _mm_max_ps(maxN[i], n);
+                    }
+                }
+            }
+            bounds.minNormal = toVec3(_mm_min_ps(_mm_min_ps(minN[0], minN[1]), _mm_min_ps(minN[2], minN[3])));
+            bounds.maxNormal = toVec3(_mm_max_ps(_mm_max_ps(maxN[0], maxN[1]), _mm_max_ps(maxN[2], maxN[3])));
+        }
+
+        // Tile fully inside the image. A depth row is 2 registers, a normal row 8 registers (two texels each).
+        TARGET_AVX2 void reduceTileAVX2(const float* pDepth, const glm::vec4* pNormal, uint32_t width, uint32_t x0, uint32_t y0, QuadBoundsReduction::Bounds& bounds)
+        {
+            __m256 minD = _mm256_set1_ps(FLT_MAX);
+            __m256 maxD = _mm256_set1_ps(-FLT_MAX);
+            for (uint32_t y = 0; y < QuadBoundsReduction::kTileSize; y++)
+            {
+                const float* pRow = pDepth + (size_t)(y0 + y) * width + x0;
+                __m256 a = _mm256_loadu_ps(pRow);
+                __m256 b = _mm256_loadu_ps(pRow + 8);
+                minD = _mm256_min_ps(minD, _mm256_min_ps(a, b));
+                maxD = _mm256_max_ps(maxD, _mm256_max_ps(a, b));
+            }
+            bounds.minDepth = horizontalMin(_mm_min_ps(_mm256_castps256_ps128(minD), _mm256_extractf128_ps(minD, 1)));
+            bounds.maxDepth = horizontalMax(_mm_max_ps(_mm256_castps256_ps128(maxD), _mm256_extractf128_ps(maxD, 1)));
+
+            if (pNormal == nullptr)
+            {
+                bounds.minNormal = glm::vec3(FLT_MAX);
+                bounds.maxNormal = glm::vec3(-FLT_MAX);
+                return;
+            }
+
+            __m256 minN[4], maxN[4];
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                minN[i] = _mm256_set1_ps(FLT_MAX);
+                maxN[i] = _mm256_set1_ps(-FLT_MAX);
+            }
+            for (uint32_t y = 0; y < QuadBoundsReduction::kTileSize; y++)
+            {
+                const float* pRow = &pNormal[(size_t)(y0 + y) * width + x0].x;
+                for (uint32_t x = 0; x < QuadBoundsReduction::kTileSize; x += 8)
+                {
+                    for (uint32_t i = 0; i < 4; i++)
+                    {
+                        __m256 n = _mm256_loadu_ps(pRow + (x + i * 2) * 4);
+                        minN[i] = _mm256_min_ps(minN[i], n);
+                        maxN[i] = _mm256_max_ps(maxN[i], n);
+                    }
+                }
+            }
+            __m256 minAll = _mm256_min_ps(_mm256_min_ps(minN[0], minN[1]), _mm256_min_ps(minN[2], minN[3]));
+            __m256 maxAll = _mm256_max_ps(_mm256_max_ps(maxN[0], maxN[1]), _mm256_max_ps(maxN[2], maxN[3]));
+            bounds.minNormal = toVec3(_mm_min_ps(_mm256_castps256_ps128(minAll), _mm256_extractf128_ps(minAll, 1)));
+            bounds.maxNormal = toVec3(_mm_max_ps(_mm256_castps256_ps128(maxAll), _mm256_extractf128_ps(maxAll, 1)));
+        }
+#endif
+    }
+
+    QuadBoundsReduction::UniquePtr QuadBoundsReduction::create(WorkStealingPool::SharedPtr pPool, SimdLevel maxSimdLevel)
+    {
+        if (pPool == nullptr) pPool = WorkStealingPool::getShared();
+        return UniquePtr(new QuadBoundsReduction(pPool, maxSimdLevel));
+    }
+
+    QuadBoundsReduction::QuadBoundsReduction(WorkStealingPool::SharedPtr pPool, SimdLevel maxSimdLevel) : mpPool(pPool)
+    {
+        setSimdLevel(maxSimdLevel);
+    }
+
+    void QuadBoundsReduction::setSimdLevel(SimdLevel level)
+    {
+        mSimdLevel = std::min(level, getSupportedSimdLevel());
+    }
+
+    QuadBoundsReduction::SimdLevel QuadBoundsReduction::getSupportedSimdLevel()
+    {
+#ifdef QUAD_BOUNDS_X86
+        static const SimdLevel sLevel = []()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            int maxId = info[0];
+            __cpuid(info, 1);
+            bool sse41 = (info[2] & (1 << 19)) != 0;
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            // The OS has to save the YMM registers on context switches
+            bool ymmEnabled = osxsave && ((_xgetbv(0) & 0x6) == 0x6);
+            bool avx2 = false;
+            if (maxId >= 7)
+            {
+                __cpuidex(info, 7, 0);
+                avx2 = avx && ymmEnabled && (info[1] & (1 << 5)) != 0;
+            }
+#else
+            bool sse41 = __builtin_cpu_supports("sse4.1");
+            bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+            return avx2 ? SimdLevel::AVX2 : (sse41 ? SimdLevel::SSE41 : SimdLevel::Scalar);
+        }();
+        return sLevel;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    void QuadBoundsReduction::reduce(const float* pDepth, const glm::vec4* pNormal, uint32_t width, uint32_t height, std::vector<Bounds>& result)
+    {
+        reduce(pDepth, pNormal, width, height, (width + kTileSize - 1) / kTileSize, (height + kTileSize - 1) / kTileSize, result);
+    }
+
+    void QuadBoundsReduction::reduce(const float* pDepth, const glm::vec4* pNormal, uint32_t width, uint32_t height, uint32_t tileCountX, uint32_t tileCountY, std::vector<Bounds>& result)
+    {
+        assert(pDepth);
+        result.resize(tileCountX * tileCountY);
+        const SimdLevel level = mSimdLevel;
+
+        mpPool->parallelFor(tileCountY, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t ty = begin; ty < end; ty++)
+            {
+                for (uint32_t tx = 0; tx < tileCountX; tx++)
+                {
+                    const uint32_t x0 = tx * kTileSize;
+                    const uint32_t y0 = ty * kTileSize;
+                    Bounds& bounds = result[ty * tileCountX + tx];
+                    bool inside = (x0 + kTileSize <= width) && (y0 + kTileSize <= height);
+
+#ifdef QUAD_BOUNDS_X86
+                    if (inside && level == SimdLevel::AVX2)
+                    {
+                        reduceTileAVX2(pDepth, pNormal, width, x0, y0, bounds);
+                    }
+                    else if (inside && level == SimdLevel::SSE41)
+                    {
+                        reduceTileSSE41(pDepth, pNormal, width, x0, y0, bounds);
+                    }
+                    else
+#endif
+                    {
+                        reduceTileScalar(pDepth, pNormal, width, height, x0, y0, bounds);
+                    }
+
+                    if (pNormal == nullptr)
+                    {
+                        bounds.minNormal = bounds.maxNormal = glm::vec3(0.f);
+                    }
+                }
+            }
+        });
+    }
+
+    std::vector<QuadBoundsReduction::BenchmarkResult> QuadBoundsReduction::benchmark(uint32_t iterations)
+    {
+        static const glm::uvec2 kResolutions[] = { { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+        iterations = std::max(1u, iterations);
+
+        std::vector<BenchmarkResult> results;
+        const SimdLevel prevLevel = mSimdLevel;
+        const SimdLevel maxLevel = getSupportedSimdLevel();
+        std::vector<Bounds> bounds;
+
+        for (const auto& res : kResolutions)
+        {
+            // Smooth depth with some noise, so the min/max comparisons are not trivially predictable
+            const size_t pixelCount = (size_t)res.x * res.y;
+            std::vector<float> depth(pixelCount);
+            std::vector<glm::vec4> normals(pixelCount);
+            uint32_t seed = 12345;
+            for (size_t i = 0; i < pixelCount; i++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                float noise = (float)(seed >> 8) / (float)(1 << 24);
+                depth[i] = 0.9f + 0.09f * ((float)(i % res.x) / res.x) + 0.001f * noise;
+                normals[i] = glm::vec4(glm::normalize(glm::vec3(noise - 0.5f, 1.f, 0.5f - noise)), 0.f);
+            }
+
+            for (uint32_t level = (uint32_t)SimdLevel::Scalar; level <= (uint32_t)maxLevel; level++)
+            {
+                mSimdLevel = (SimdLevel)level;
+                reduce(depth.data(), normals.data(), res.x, res.y, bounds);
+
+                CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+                for (uint32_t i = 0; i < iterations; i++)
+                {
+                    reduce(depth.data(), normals.data(), res.x, res.y, bounds);
+                }
+                float ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / iterations;
+
+                BenchmarkResult result;
+                result.width = res.x;
+                result.height = res.y;
+                result.simdLevel = mSimdLevel;
+                result.ms = ms;
+                double bytes = (double)pixelCount * (sizeof(float) + sizeof(glm::vec4));
+                result.gbPerSec = ms > 0 ? bytes / (ms * 1.0e6) : 0;
+                results.push_back(result);
+            }
+        }
+
+        mSimdLevel = prevLevel;
+        return results;
+    }
+}
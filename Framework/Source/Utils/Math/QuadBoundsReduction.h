@@ -0,0 +1,116 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Framework.h"
+#include "Utils/WorkStealingPool.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU equivalent of a per-tile min/max reduction over a depth buffer and a normal buffer, as done on the GPU by QuadLevelCompute.slang.
+        The inner loops use AVX2 or SSE4.1 when the CPU supports it and fall back to scalar code otherwise. Tile rows are spread over a WorkStealingPool.
+    */
+    class QuadBoundsReduction
+    {
+    public:
+        using UniquePtr = std::unique_ptr<QuadBoundsReduction>;
+
+        enum class SimdLevel
+        {
+            Scalar,
+            SSE41,
+            AVX2
+        };
+
+        struct Bounds
+        {
+            float minDepth;
+            float maxDepth;
+            glm::vec3 minNormal;
+            glm::vec3 maxNormal;
+        };
+
+        struct BenchmarkResult
+        {
+            uint32_t width;
+            uint32_t height;
+            SimdLevel simdLevel;
+            float ms;               ///< Average time of a single reduce() call
+            double gbPerSec;        ///< Input bytes (depth + normals) read per second
+        };
+
+        /** Create a new object
+            \param[in] pPool Pool to run on. If nullptr, the shared pool is used.
+            \param[in] maxSimdLevel Highest instruction set to use, clamped to what the CPU supports
+        */
+        static UniquePtr create(WorkStealingPool::SharedPtr pPool = nullptr, SimdLevel maxSimdLevel = SimdLevel::AVX2);
+
+        /** Reduce a tileCountX * tileCountY grid of kTileSize * kTileSize tiles, starting at the top-left pixel.
+            Texels outside of the image read as 0, like out of bounds texture loads on the GPU.
+            \param[in] pDepth Depth values, width * height floats
+            \param[in] pNormal Normals, width * height float4s (w is ignored). Can be nullptr, the normal bounds are 0 then.
+            \param[out] result Bounds per tile, row-major
+        */
+        void reduce(const float* pDepth, const glm::vec4* pNormal, uint32_t width, uint32_t height, uint32_t tileCountX, uint32_t tileCountY, std::vector<Bounds>& result);
+
+        /** Reduce the whole image, partial tiles at the right and bottom border included
+        */
+        void reduce(const float* pDepth, const glm::vec4* pNormal, uint32_t width, uint32_t height, std::vector<Bounds>& result);
+
+        /** Measure reduce() on synthetic 1080p, 1440p and 2160p buffers for every supported SIMD level
+        */
+        std::vector<BenchmarkResult> benchmark(uint32_t iterations = 20);
+
+        void setSimdLevel(SimdLevel level);
+        SimdLevel getSimdLevel() const { return mSimdLevel; }
+
+        /** Get the highest SIMD level supported by the CPU
+        */
+        static SimdLevel getSupportedSimdLevel();
+
+        static const uint32_t kTileSize = 16;
+
+    private:
+        QuadBoundsReduction(WorkStealingPool::SharedPtr pPool, SimdLevel maxSimdLevel);
+        WorkStealingPool::SharedPtr mpPool;
+        SimdLevel mSimdLevel;
+    };
+
+#define simd_level_str(a) case QuadBoundsReduction::SimdLevel::a: return #a
+    inline std::string to_string(QuadBoundsReduction::SimdLevel level)
+    {
+        switch (level)
+        {
+            simd_level_str(Scalar);
+            simd_level_str(SSE41);
+            simd_level_str(AVX2);
+        default: should_not_get_here(); return "";
+        }
+    }
+#undef simd_level_str
+}
@@ -0,0 +1,465 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SoftwareOcclusionCuller.h"
+#include "Utils/WorkStealingPool.h"
+#include <algorithm>
+#include <cfloat>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OCCLUSION_CULL_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace Falcor
+{
+    const uint32_t SoftwareOcclusionCuller::kMaxViews;
+    const uint32_t SoftwareOcclusionCuller::kTileWidth;
+    const uint32_t SoftwareOcclusionCuller::kTileHeight;
+    const uint32_t SoftwareOcclusionCuller::kBandTileRows;
+    const uint32_t SoftwareOcclusionCuller::kParallelBoxThreshold;
+
+    namespace
+    {
+        const uint32_t kFullCoverage = 0xffffffff;
+        const uint32_t kBoxGrainSize = 256;
+
+        uint32_t roundUp(uint32_t value, uint32_t multiple)
+        {
+            return ((std::max(value, 1u) + multiple - 1) / multiple) * multiple;
+        }
+    }
+
+    SoftwareOcclusionCuller::SharedPtr SoftwareOcclusionCuller::create(uint32_t width, uint32_t height, const std::shared_ptr<WorkStealingPool>& pPool)
+    {
+        return SharedPtr(new SoftwareOcclusionCuller(width, height, pPool));
+    }
+
+    SoftwareOcclusionCuller::SoftwareOcclusionCuller(uint32_t width, uint32_t height, const std::shared_ptr<WorkStealingPool>& pPool) : mpPool(pPool)
+    {
+        mWidth = roundUp(width, kTileWidth);
+        mHeight = roundUp(height, kTileHeight * kBandTileRows);
+        mTilesX = mWidth / kTileWidth;
+        mTilesY = mHeight / kTileHeight;
+        mBandCount = mTilesY / kBandTileRows;
+        mCoarseX = (mTilesX + kBandTileRows - 1) / kBandTileRows;
+
+        for (View& view : mViews)
+        {
+            view.bins.resize(mBandCount);
+            view.zMax0.resize(mTilesX * mTilesY);
+            view.zMax1.resize(mTilesX * mTilesY);
+            view.mask.resize(mTilesX * mTilesY);
+            view.coarseZMax.resize(mCoarseX * mBandCount);
+        }
+    }
+
+    void SoftwareOcclusionCuller::beginFrame(const glm::mat4* pViewProj, uint32_t viewCount)
+    {
+        assert(viewCount > 0 && viewCount <= kMaxViews);
+        mViewCount = std::min(viewCount, kMaxViews);
+        mStats = Stats();
+
+        for (uint32_t v = 0; v < mViewCount; v++)
+        {
+            View& view = mViews[v];
+            view.viewProj = pViewProj[v];
+            view.triangles.clear();
+            for (auto& bin : view.bins)
+            {
+                bin.clear();
+            }
+            std::fill(view.zMax0.begin(), view.zMax0.end(), 1.f);
+            std::fill(view.zMax1.begin(), view.zMax1.end(), 0.f);
+            std::fill(view.mask.begin(), view.mask.end(), 0u);
+            std::fill(view.coarseZMax.begin(), view.coarseZMax.end(), 1.f);
+        }
+    }
+
+    void SoftwareOcclusionCuller::addOccluder(const glm::vec3* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount, const glm::mat4& worldMat)
+    {
+        mClipPositions.resize(vertexCount);
+        for (uint32_t v = 0; v < mViewCount; v++)
+        {
+            View& view = mViews[v];
+            glm::mat4 worldViewProj = view.viewProj * worldMat;
+            for (uint32_t i = 0; i < vertexCount; i++)
+            {
+                mClipPositions[i] = worldViewProj * glm::vec4(pPositions[i], 1.f);
+            }
+
+            for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+            {
+                assert(pIndices[i] < vertexCount && pIndices[i + 1] < vertexCount && pIndices[i + 2] < vertexCount);
+                setupTriangle(view, mClipPositions[pIndices[i]], mClipPositions[pIndices[i + 1]], mClipPositions[pIndices[i + 2]]);
+            }
+        }
+        mStats.occluderCount++;
+    }
+
+    void SoftwareOcclusionCuller::setupTriangle(View& view, const glm::vec4& p0, const glm::vec4& p1, const glm::vec4& p2)
+    {
+        const glm::vec4* pClip[3] = { &p0, &p1, &p2 };
+        float x[3], y[3];
+        float zMax = 0.f;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            const glm::vec4& p = *pClip[i];
+            if (p.w <= 0.f || p.z < 0.f)
+            {
+                // Crosses the near plane. Clipping would only add occluders right in front of the camera, skipping is conservative.
+                mStats.skippedTriangleCount++;
+                return;
+            }
+            float invW = 1.f / p.w;
+            x[i] = (p.x * invW * 0.5f + 0.5f) * (float)mWidth;
+            y[i] = (0.5f - p.y * invW * 0.5f) * (float)mHeight;
+            zMax = std::max(zMax, p.z * invW);
+        }
+
+        float minX = std::min(std::min(x[0], x[1]), x[2]);
+        float maxX = std::max(std::max(x[0], x[1]), x[2]);
+        float minY = std::min(std::min(y[0], y[1]), y[2]);
+        float maxY = std::max(std::max(y[0], y[1]), y[2]);
+        if (maxX < 0.f || maxY < 0.f || minX >= (float)mWidth || minY >= (float)mHeight || zMax >= 1.f)
+        {
+            return;
+        }
+
+        Triangle tri;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            uint32_t j = (i + 1) % 3;
+            tri.edgeA[i] = y[i] - y[j];
+            tri.edgeB[i] = x[j] - x[i];
+            tri.edgeC[i] = x[i] * y[j] - y[i] * x[j];
+        }
+
+        // Both windings are occluders, orient the edges so that the inside is positive
+        float area = tri.edgeA[0] * x[2] + tri.edgeB[0] * y[2] + tri.edgeC[0];
+        if (!(area != 0.f))
+        {
+            return;
+        }
+        if (area < 0.f)
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                tri.edgeA[i] = -tri.edgeA[i];
+                tri.edgeB[i] = -tri.edgeB[i];
+                tri.edgeC[i] = -tri.edgeC[i];
+            }
+        }
+
+        tri.zMax = zMax;
+        tri.tileMinX = (uint32_t)std::max(minX, 0.f) / kTileWidth;
+        tri.tileMinY = (uint32_t)std::max(minY, 0.f) / kTileHeight;
+        tri.tileMaxX = std::min((uint32_t)std::min(maxX, (float)(mWidth - 1)) / kTileWidth, mTilesX - 1);
+        tri.tileMaxY = std::min((uint32_t)std::min(maxY, (float)(mHeight - 1)) / kTileHeight, mTilesY - 1);
+
+        uint32_t index = (uint32_t)view.triangles.size();
+        view.triangles.push_back(tri);
+        for (uint32_t band = tri.tileMinY / kBandTileRows; band <= tri.tileMaxY / kBandTileRows; band++)
+        {
+            view.bins[band].push_back(index);
+        }
+        mStats.triangleCount++;
+    }
+
+    void SoftwareOcclusionCuller::rasterize()
+    {
+        uint32_t taskCount = mViewCount * mBandCount;
+        auto rasterizeRange = [this](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t task = begin; task < end; task++)
+            {
+                rasterizeBand(task / mBandCount, task % mBandCount);
+            }
+        };
+
+        if (mpPool && taskCount > 1)
+        {
+            mpPool->parallelFor(taskCount, 1, rasterizeRange);
+        }
+        else
+        {
+            rasterizeRange(0, taskCount);
+        }
+    }
+
+    void SoftwareOcclusionCuller::rasterizeBand(uint32_t viewIndex, uint32_t band)
+    {
+        View& view = mViews[viewIndex];
+        uint32_t rowBegin = band * kBandTileRows;
+        uint32_t rowEnd = rowBegin + kBandTileRows;
+
+        for (uint32_t index : view.bins[band])
+        {
+            const Triangle& tri = view.triangles[index];
+            uint32_t tileMinY = std::max(tri.tileMinY, rowBegin);
+            uint32_t tileMaxY = std::min(tri.tileMaxY, rowEnd - 1);
+            for (uint32_t tileY = tileMinY; tileY <= tileMaxY; tileY++)
+            {
+                for (uint32_t tileX = tri.tileMinX; tileX <= tri.tileMaxX; tileX++)
+                {
+                    uint32_t tile = tileY * mTilesX + tileX;
+                    if (tri.zMax >= view.zMax0[tile]) continue;
+
+                    uint32_t coverage = computeCoverage(tri, tileX, tileY);
+                    if (coverage != 0)
+                    {
+                        updateTile(view, tile, coverage, tri.zMax);
+                    }
+                }
+            }
+        }
+
+        // Coarse level of this band
+        for (uint32_t coarseX = 0; coarseX < mCoarseX; coarseX++)
+        {
+            uint32_t tileEndX = std::min((coarseX + 1) * kBandTileRows, mTilesX);
+            float zMax = 0.f;
+            for (uint32_t tileY = rowBegin; tileY < rowEnd; tileY++)
+            {
+                for (uint32_t tileX = coarseX * kBandTileRows; tileX < tileEndX; tileX++)
+                {
+                    zMax = std::max(zMax, view.zMax0[tileY * mTilesX + tileX]);
+                }
+            }
+            view.coarseZMax[band * mCoarseX + coarseX] = zMax;
+        }
+    }
+
+    uint32_t SoftwareOcclusionCuller::computeCoverage(const Triangle& tri, uint32_t tileX, uint32_t tileY) const
+    {
+        // Pixel centers are sampled, bit y * kTileWidth + x is pixel (x, y) of the tile
+        const float x0 = (float)(tileX * kTileWidth);
+        const float y0 = (float)(tileY * kTileHeight);
+        uint32_t coverage = 0;
+
+#ifdef OCCLUSION_CULL_SSE
+        if (mUseSimd)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 pxLo = _mm_add_ps(_mm_set1_ps(x0), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+            const __m128 pxHi = _mm_add_ps(_mm_set1_ps(x0), _mm_setr_ps(4.5f, 5.5f, 6.5f, 7.5f));
+            __m128 axLo[3], axHi[3], c[3];
+            for (uint32_t e = 0; e < 3; e++)
+            {
+                __m128 a = _mm_set1_ps(tri.edgeA[e]);
+                axLo[e] = _mm_mul_ps(a, pxLo);
+                axHi[e] = _mm_mul_ps(a, pxHi);
+                c[e] = _mm_set1_ps(tri.edgeC[e]);
+            }
+
+            for (uint32_t row = 0; row < kTileHeight; row++)
+            {
+                float py = y0 + ((float)row + 0.5f);
+                __m128 insideLo = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                __m128 insideHi = insideLo;
+                for (uint32_t e = 0; e < 3; e++)
+                {
+                    __m128 by = _mm_set1_ps(tri.edgeB[e] * py);
+                    insideLo = _mm_and_ps(insideLo, _mm_cmpgt_ps(_mm_add_ps(_mm_add_ps(axLo[e], by), c[e]), zero));
+                    insideHi = _mm_and_ps(insideHi, _mm_cmpgt_ps(_mm_add_ps(_mm_add_ps(axHi[e], by), c[e]), zero));
+                }
+                uint32_t rowBits = (uint32_t)_mm_movemask_ps(insideLo) | ((uint32_t)_mm_movemask_ps(insideHi) << 4);
+                coverage |= rowBits << (row * kTileWidth);
+            }
+            return coverage;
+        }
+#endif
+
+        for (uint32_t row = 0; row < kTileHeight; row++)
+        {
+            float py = y0 + ((float)row + 0.5f);
+            for (uint32_t col = 0; col < kTileWidth; col++)
+            {
+                float px = x0 + ((float)col + 0.5f);
+                bool inside = true;
+                for (uint32_t e = 0; e < 3; e++)
+                {
+                    float ax = tri.edgeA[e] * px;
+                    float by = tri.edgeB[e] * py;
+                    inside = inside && ((ax + by) + tri.edgeC[e] > 0.f);
+                }
+                coverage |= (inside ? 1u : 0u) << (row * kTileWidth + col);
+            }
+        }
+        return coverage;
+    }
+
+    void SoftwareOcclusionCuller::updateTile(View& view, uint32_t tile, uint32_t coverage, float zMax) const
+    {
+        float& zMax0 = view.zMax0[tile];
+        float& zMax1 = view.zMax1[tile];
+        uint32_t& mask = view.mask[tile];
+
+        // Merge heuristic: if adding the triangle would push the working layer further back than the triangle is in front of the reference layer,
+        // the working layer is unlikely to become useful. Start a new one from this triangle.
+        float growth = zMax - zMax1;
+        float distance = zMax0 - zMax;
+        if (growth > distance)
+        {
+            mask = 0;
+            zMax1 = 0.f;
+        }
+
+        mask |= coverage;
+        zMax1 = std::max(zMax1, zMax);
+        if (mask == kFullCoverage)
+        {
+            zMax0 = zMax1;
+            mask = 0;
+            zMax1 = 0.f;
+        }
+    }
+
+    bool SoftwareOcclusionCuller::isBoxVisible(const View& view, const BoundingBox& box) const
+    {
+        // Corners are the min corner plus combinations of the scaled matrix columns
+        glm::vec3 size = box.extent * 2.f;
+        glm::vec4 base = view.viewProj * glm::vec4(box.center - box.extent, 1.f);
+        glm::vec4 dx = view.viewProj[0] * size.x;
+        glm::vec4 dy = view.viewProj[1] * size.y;
+        glm::vec4 dz = view.viewProj[2] * size.z;
+
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+        float zMin = FLT_MAX;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            glm::vec4 p = base;
+            if (i & 1) p += dx;
+            if (i & 2) p += dy;
+            if (i & 4) p += dz;
+            if (p.w <= 0.f || p.z < 0.f)
+            {
+                return true;
+            }
+
+            float invW = 1.f / p.w;
+            float x = (p.x * invW * 0.5f + 0.5f) * (float)mWidth;
+            float y = (0.5f - p.y * invW * 0.5f) * (float)mHeight;
+            minX = std::min(minX, x); maxX = std::max(maxX, x);
+            minY = std::min(minY, y); maxY = std::max(maxY, y);
+            zMin = std::min(zMin, p.z * invW);
+        }
+
+        // Boxes outside of the buffer are left to the frustum culling
+        if (maxX < 0.f || maxY < 0.f || minX >= (float)mWidth || minY >= (float)mHeight)
+        {
+            return true;
+        }
+
+        uint32_t tileMinX = (uint32_t)std::max(minX, 0.f) / kTileWidth;
+        uint32_t tileMinY = (uint32_t)std::max(minY, 0.f) / kTileHeight;
+        uint32_t tileMaxX = std::min((uint32_t)std::min(maxX, (float)(mWidth - 1)) / kTileWidth, mTilesX - 1);
+        uint32_t tileMaxY = std::min((uint32_t)std::min(maxY, (float)(mHeight - 1)) / kTileHeight, mTilesY - 1);
+
+        // Coarse test first, most occluded boxes are rejected here
+        bool coarseOccluded = true;
+        for (uint32_t band = tileMinY / kBandTileRows; band <= tileMaxY / kBandTileRows && coarseOccluded; band++)
+        {
+            for (uint32_t coarseX = tileMinX / kBandTileRows; coarseX <= tileMaxX / kBandTileRows; coarseX++)
+            {
+                if (zMin <= view.coarseZMax[band * mCoarseX + coarseX])
+                {
+                    coarseOccluded = false;
+                    break;
+                }
+            }
+        }
+        if (coarseOccluded)
+        {
+            return false;
+        }
+
+        for (uint32_t tileY = tileMinY; tileY <= tileMaxY; tileY++)
+        {
+            for (uint32_t tileX = tileMinX; tileX <= tileMaxX; tileX++)
+            {
+                if (zMin <= view.zMax0[tileY * mTilesX + tileX])
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    uint8_t SoftwareOcclusionCuller::testBox(const BoundingBox& box) const
+    {
+        uint8_t mask = 0;
+        for (uint32_t v = 0; v < mViewCount; v++)
+        {
+            if (isBoxVisible(mViews[v], box))
+            {
+                mask |= (uint8_t)(1 << v);
+            }
+        }
+        return mask;
+    }
+
+    uint32_t SoftwareOcclusionCuller::testBoxes(const std::vector<BoundingBox>& boxes, std::vector<uint8_t>& masks)
+    {
+        assert(boxes.size() == masks.size());
+        uint32_t count = (uint32_t)boxes.size();
+        uint32_t testedCount = (uint32_t)std::count_if(masks.begin(), masks.end(), [](uint8_t m) { return m != 0; });
+
+        auto testRange = [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                uint8_t mask = masks[i];
+                for (uint32_t v = 0; v < mViewCount && mask != 0; v++)
+                {
+                    uint8_t bit = (uint8_t)(1 << v);
+                    if ((mask & bit) && isBoxVisible(mViews[v], boxes[i]) == false)
+                    {
+                        mask &= ~bit;
+                    }
+                }
+                masks[i] = mask;
+            }
+        };
+
+        if (mpPool && count >= kParallelBoxThreshold)
+        {
+            mpPool->parallelFor(count, kBoxGrainSize, testRange);
+        }
+        else
+        {
+            testRange(0, count);
+        }
+
+        uint32_t visibleCount = (uint32_t)std::count_if(masks.begin(), masks.end(), [](uint8_t m) { return m != 0; });
+        mStats.testedBoxCount += testedCount;
+        mStats.occludedBoxCount += testedCount - visibleCount;
+        return testedCount - visibleCount;
+    }
+}
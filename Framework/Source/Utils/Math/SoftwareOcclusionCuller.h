@@ -0,0 +1,161 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Utils/AABB.h"
+#include <memory>
+#include <vector>
+
+namespace Falcor
+{
+    class WorkStealingPool;
+
+    /** CPU depth rasterizer for occlusion culling, following the masked occlusion culling idea (Andersson et al. 2015).
+        Occluder triangles are rasterized into a low resolution buffer of 8x4 pixel tiles. Instead of per pixel depths every tile stores a
+        reference depth that the whole tile is known to be in front of, plus a working layer (coverage mask and its farthest depth) that is
+        merged into the reference once it covers the tile. Coverage is computed with SSE, eight pixels of a tile row at a time.
+        Groups of four tile rows ("bands") are rasterized in parallel; every band processes the triangles in submission order, so the result
+        does not depend on the thread count. After rasterization every band stores the farthest depth of each 4x4 tile block as a coarse level
+        which rejects most occluded boxes with a few reads.
+        Up to kMaxViews views are rasterized from the same occluders, bit v of a visibility mask refers to view v. This matches the bits of
+        StereoFrustumCuller, so both eyes are tested in one call.
+        Depth is D3D clip space depth (0 near, 1 far). Triangles crossing the near plane are skipped and boxes crossing it are visible,
+        which keeps the culling conservative at the cost of the closest occluders.
+    */
+    class SoftwareOcclusionCuller
+    {
+    public:
+        using SharedPtr = std::shared_ptr<SoftwareOcclusionCuller>;
+
+        static const uint32_t kMaxViews = 2;
+        static const uint32_t kTileWidth = 8;
+        static const uint32_t kTileHeight = 4;
+        static const uint32_t kBandTileRows = 4;        ///< Tile rows per band, also the size of a coarse block in tiles
+        static const uint32_t kParallelBoxThreshold = 1024;
+
+        struct Stats
+        {
+            uint32_t occluderCount = 0;
+            uint32_t triangleCount = 0;     ///< Triangles binned for rasterization, summed over all views
+            uint32_t skippedTriangleCount = 0;  ///< Triangles crossing the near plane, summed over all views
+            uint32_t testedBoxCount = 0;
+            uint32_t occludedBoxCount = 0;  ///< Boxes that were occluded in all views they were tested for
+        };
+
+        /** Create a new culler
+            \param[in] width Buffer width in pixels, rounded up to a multiple of kTileWidth
+            \param[in] height Buffer height in pixels, rounded up to a multiple of kTileHeight * kBandTileRows
+            \param[in] pPool Pool for rasterization and batch tests. If nullptr, everything runs on the calling thread.
+        */
+        static SharedPtr create(uint32_t width = 320, uint32_t height = 192, const std::shared_ptr<WorkStealingPool>& pPool = nullptr);
+
+        /** Clear the buffers and set the views for the next set of occluders
+            \param[in] pViewProj viewCount view-projection matrices (D3D clip space, 0 <= z <= w)
+        */
+        void beginFrame(const glm::mat4* pViewProj, uint32_t viewCount);
+
+        /** Add an occluder to all views. Triangles are set up right away, rasterization happens in rasterize().
+            \param[in] pPositions Object space vertex positions
+            \param[in] pIndices Three indices per triangle
+            \param[in] worldMat Object to world transform
+        */
+        void addOccluder(const glm::vec3* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount, const glm::mat4& worldMat);
+
+        /** Rasterize all occluders added since beginFrame()
+        */
+        void rasterize();
+
+        /** Test a world space box against all views
+            \return Visibility mask, bit v is set unless the box is occluded in view v
+        */
+        uint8_t testBox(const BoundingBox& box) const;
+
+        /** Test a batch of world space boxes. Only views whose bit is set in masks[i] are tested; bits of views in which the box is occluded are cleared.
+            \return Number of boxes whose mask turned 0
+        */
+        uint32_t testBoxes(const std::vector<BoundingBox>& boxes, std::vector<uint8_t>& masks);
+
+        /** Use the SSE coverage path. The scalar path gives the same results and is meant for testing.
+        */
+        void setSimdEnabled(bool enable) { mUseSimd = enable; }
+
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+        uint32_t getTileCountX() const { return mTilesX; }
+        uint32_t getTileCountY() const { return mTilesY; }
+        uint32_t getViewCount() const { return mViewCount; }
+
+        /** Get the reference depth of a tile. 1 means nothing was rasterized that covers the whole tile.
+        */
+        float getTileDepth(uint32_t view, uint32_t tileX, uint32_t tileY) const { return mViews[view].zMax0[tileY * mTilesX + tileX]; }
+
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        SoftwareOcclusionCuller(uint32_t width, uint32_t height, const std::shared_ptr<WorkStealingPool>& pPool);
+
+        struct Triangle
+        {
+            float edgeA[3];     ///< Edge functions a * x + b * y + c, positive inside
+            float edgeB[3];
+            float edgeC[3];
+            float zMax;         ///< Farthest vertex depth
+            uint32_t tileMinX, tileMaxX;
+            uint32_t tileMinY, tileMaxY;
+        };
+
+        struct View
+        {
+            glm::mat4 viewProj;
+            std::vector<Triangle> triangles;
+            std::vector<std::vector<uint32_t>> bins;    ///< Triangle indices per band
+            std::vector<float> zMax0;                   ///< Reference layer per tile
+            std::vector<float> zMax1;                   ///< Working layer per tile
+            std::vector<uint32_t> mask;                 ///< Working layer coverage per tile, bit y * kTileWidth + x
+            std::vector<float> coarseZMax;              ///< Farthest zMax0 per block of kBandTileRows x kBandTileRows tiles
+        };
+
+        void setupTriangle(View& view, const glm::vec4& p0, const glm::vec4& p1, const glm::vec4& p2);
+        void rasterizeBand(uint32_t viewIndex, uint32_t band);
+        uint32_t computeCoverage(const Triangle& tri, uint32_t tileX, uint32_t tileY) const;
+        void updateTile(View& view, uint32_t tile, uint32_t coverage, float zMax) const;
+        bool isBoxVisible(const View& view, const BoundingBox& box) const;
+
+        std::shared_ptr<WorkStealingPool> mpPool;
+        uint32_t mWidth;
+        uint32_t mHeight;
+        uint32_t mTilesX;
+        uint32_t mTilesY;
+        uint32_t mBandCount;
+        uint32_t mCoarseX;
+        uint32_t mViewCount = 0;
+        View mViews[kMaxViews];
+        std::vector<glm::vec4> mClipPositions;  ///< Setup scratch
+        bool mUseSimd = true;
+        Stats mStats;
+    };
+}
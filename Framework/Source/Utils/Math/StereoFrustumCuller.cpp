@@ -0,0 +1,249 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "StereoFrustumCuller.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define STEREO_CULL_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace Falcor
+{
+    const float StereoFrustumCuller::kSharedPlaneTolerance = 1.0e-5f;
+
+    namespace
+    {
+        bool isSamePlane(const glm::vec4& a, const glm::vec4& b)
+        {
+            float lengthA = glm::length(glm::vec3(a));
+            float lengthB = glm::length(glm::vec3(b));
+            if (lengthA == 0.f || lengthB == 0.f) return false;
+
+            glm::vec4 na = a / lengthA;
+            glm::vec4 nb = b / lengthB;
+            float tolerance = StereoFrustumCuller::kSharedPlaneTolerance * std::max(1.f, std::abs(na.w));
+            glm::vec4 diff = glm::abs(na - nb);
+            return std::max(std::max(diff.x, diff.y), std::max(diff.z, diff.w)) <= tolerance;
+        }
+    }
+
+    void StereoFrustumCuller::Batch::clear()
+    {
+        centerX.clear(); centerY.clear(); centerZ.clear();
+        extentX.clear(); extentY.clear(); extentZ.clear();
+    }
+
+    void StereoFrustumCuller::Batch::reserve(size_t count)
+    {
+        centerX.reserve(count); centerY.reserve(count); centerZ.reserve(count);
+        extentX.reserve(count); extentY.reserve(count); extentZ.reserve(count);
+    }
+
+    void StereoFrustumCuller::Batch::add(const BoundingBox& box)
+    {
+        centerX.push_back(box.center.x); centerY.push_back(box.center.y); centerZ.push_back(box.center.z);
+        extentX.push_back(box.extent.x); extentY.push_back(box.extent.y); extentZ.push_back(box.extent.z);
+    }
+
+    void StereoFrustumCuller::extractPlanes(const glm::mat4& viewProj, glm::vec4 planes[6])
+    {
+        // Same extraction as Camera::calculateCameraParameters()
+        // See: https://fgiesen.wordpress.com/2012/08/31/frustum-planes-from-the-projection-matrix/
+        glm::mat4 tempMat = glm::transpose(viewProj);
+        for (int i = 0; i < 6; i++)
+        {
+            glm::vec4 plane = (i & 1) ? tempMat[i >> 1] : -tempMat[i >> 1];
+            if (i != 5) // Z range is [0, w]. For the 0 <= z plane we don't need to add w
+            {
+                plane += tempMat[3];
+            }
+            planes[i] = plane;
+        }
+    }
+
+    StereoFrustumCuller::Plane StereoFrustumCuller::makePlane(const glm::vec4& plane)
+    {
+        Plane p;
+        p.xyz = glm::vec3(plane);
+        p.absXyz = glm::abs(p.xyz);
+        p.negW = -plane.w;
+        return p;
+    }
+
+    void StereoFrustumCuller::setFrustums(const glm::mat4& leftViewProj, const glm::mat4& rightViewProj)
+    {
+        glm::vec4 left[6];
+        glm::vec4 right[6];
+        extractPlanes(leftViewProj, left);
+        extractPlanes(rightViewProj, right);
+
+        mSharedPlanes.clear();
+        mLeftPlanes.clear();
+        mRightPlanes.clear();
+        for (int i = 0; i < 6; i++)
+        {
+            if (isSamePlane(left[i], right[i]))
+            {
+                mSharedPlanes.push_back(makePlane(left[i]));
+            }
+            else
+            {
+                mLeftPlanes.push_back(makePlane(left[i]));
+                mRightPlanes.push_back(makePlane(right[i]));
+            }
+        }
+    }
+
+    bool StereoFrustumCuller::isInside(const std::vector<Plane>& planes, const glm::vec3& center, const glm::vec3& extent)
+    {
+        // AABB vs. plane test, see method 4b: https://fgiesen.wordpress.com/2010/10/17/view-frustum-culling/
+        // The operation order matches the SSE path, so both give identical results
+        for (const Plane& p : planes)
+        {
+            float dr = center.x * p.xyz.x;
+            dr += center.y * p.xyz.y;
+            dr += center.z * p.xyz.z;
+            dr += extent.x * p.absXyz.x;
+            dr += extent.y * p.absXyz.y;
+            dr += extent.z * p.absXyz.z;
+            if (!(dr > p.negW)) return false;
+        }
+        return true;
+    }
+
+    bool StereoFrustumCuller::isContained(const std::vector<Plane>& planes, const glm::vec3& center, const glm::vec3& extent)
+    {
+        // Same test with the corner closest to the outside
+        for (const Plane& p : planes)
+        {
+            float dr = glm::dot(center, p.xyz) - glm::dot(extent, p.absXyz);
+            if (!(dr > p.negW)) return false;
+        }
+        return true;
+    }
+
+    uint8_t StereoFrustumCuller::classify(const BoundingBox& box, uint8_t& contained) const
+    {
+        contained = 0;
+        uint8_t mask = cull(box);
+        if (mask != 0 && isContained(mSharedPlanes, box.center, box.extent))
+        {
+            if ((mask & kVisibleLeft) && isContained(mLeftPlanes, box.center, box.extent)) contained |= kVisibleLeft;
+            if ((mask & kVisibleRight) && isContained(mRightPlanes, box.center, box.extent)) contained |= kVisibleRight;
+        }
+        return mask;
+    }
+
+    uint8_t StereoFrustumCuller::cull(const BoundingBox& box) const
+    {
+        if (!isInside(mSharedPlanes, box.center, box.extent)) return 0;
+        uint8_t mask = 0;
+        if (isInside(mLeftPlanes, box.center, box.extent)) mask |= kVisibleLeft;
+        if (isInside(mRightPlanes, box.center, box.extent)) mask |= kVisibleRight;
+        return mask;
+    }
+
+#ifdef STEREO_CULL_SSE
+    namespace
+    {
+        struct SimdBoxes
+        {
+            __m128 cx, cy, cz, ex, ey, ez;
+        };
+
+        template<typename PlaneT>
+        __m128 insidePlanesSSE(const std::vector<PlaneT>& planes, const SimdBoxes& b, __m128 inside)
+        {
+            for (const PlaneT& p : planes)
+            {
+                __m128 dr = _mm_mul_ps(b.cx, _mm_set1_ps(p.xyz.x));
+                dr = _mm_add_ps(dr, _mm_mul_ps(b.cy, _mm_set1_ps(p.xyz.y)));
+                dr = _mm_add_ps(dr, _mm_mul_ps(b.cz, _mm_set1_ps(p.xyz.z)));
+                dr = _mm_add_ps(dr, _mm_mul_ps(b.ex, _mm_set1_ps(p.absXyz.x)));
+                dr = _mm_add_ps(dr, _mm_mul_ps(b.ey, _mm_set1_ps(p.absXyz.y)));
+                dr = _mm_add_ps(dr, _mm_mul_ps(b.ez, _mm_set1_ps(p.absXyz.z)));
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(dr, _mm_set1_ps(p.negW)));
+            }
+            return inside;
+        }
+    }
+#endif
+
+    void StereoFrustumCuller::cull(const Batch& batch, std::vector<uint8_t>& masks, bool useSimd) const
+    {
+        const size_t count = batch.size();
+        masks.resize(count);
+        size_t i = 0;
+
+#ifdef STEREO_CULL_SSE
+        if (useSimd)
+        {
+            const __m128 allInside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (; i + 4 <= count; i += 4)
+            {
+                SimdBoxes b;
+                b.cx = _mm_loadu_ps(&batch.centerX[i]);
+                b.cy = _mm_loadu_ps(&batch.centerY[i]);
+                b.cz = _mm_loadu_ps(&batch.centerZ[i]);
+                b.ex = _mm_loadu_ps(&batch.extentX[i]);
+                b.ey = _mm_loadu_ps(&batch.extentY[i]);
+                b.ez = _mm_loadu_ps(&batch.extentZ[i]);
+
+                __m128 shared = insidePlanesSSE(mSharedPlanes, b, allInside);
+                int leftBits = 0;
+                int rightBits = 0;
+                if (_mm_movemask_ps(shared) != 0)
+                {
+                    leftBits = _mm_movemask_ps(insidePlanesSSE(mLeftPlanes, b, shared));
+                    rightBits = _mm_movemask_ps(insidePlanesSSE(mRightPlanes, b, shared));
+                }
+
+                for (int k = 0; k < 4; k++)
+                {
+                    masks[i + k] = (uint8_t)(((leftBits >> k) & 1) | (((rightBits >> k) & 1) << 1));
+                }
+            }
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            glm::vec3 center(batch.centerX[i], batch.centerY[i], batch.centerZ[i]);
+            glm::vec3 extent(batch.extentX[i], batch.extentY[i], batch.extentZ[i]);
+            uint8_t mask = 0;
+            if (isInside(mSharedPlanes, center, extent))
+            {
+                if (isInside(mLeftPlanes, center, extent)) mask |= kVisibleLeft;
+                if (isInside(mRightPlanes, center, extent)) mask |= kVisibleRight;
+            }
+            masks[i] = mask;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Utils/AABB.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** Culls world space bounding boxes against the left and right eye frustum in one go.
+        Each box is tested once against the merged plane set: planes both eyes share (for parallel stereo cameras top, bottom, near
+        and far) are evaluated once, only the remaining side planes are evaluated per eye. The result is a 2-bit visibility mask per box.
+        Batches are processed four boxes at a time with SSE.
+    */
+    class StereoFrustumCuller
+    {
+    public:
+        enum : uint8_t
+        {
+            kVisibleLeft = 0x1,
+            kVisibleRight = 0x2,
+            kVisibleBoth = kVisibleLeft | kVisibleRight
+        };
+
+        /** Boxes in structure-of-arrays layout
+        */
+        struct Batch
+        {
+            std::vector<float> centerX, centerY, centerZ;
+            std::vector<float> extentX, extentY, extentZ;
+
+            void clear();
+            void reserve(size_t count);
+            size_t size() const { return centerX.size(); }
+
+            /** Add a world space box
+            */
+            void add(const BoundingBox& box);
+
+            /** Transform a local space box into world space and add it. This is the only transform the box needs for both eyes.
+            */
+            void add(const BoundingBox& box, const glm::mat4& worldMat) { add(box.transform(worldMat)); }
+        };
+
+        /** Set the eye frustums.
+            \param[in] leftViewProj Left eye view-projection matrix (D3D clip space, 0 <= z <= w)
+            \param[in] rightViewProj Right eye view-projection matrix
+        */
+        void setFrustums(const glm::mat4& leftViewProj, const glm::mat4& rightViewProj);
+
+        /** Get the visibility mask of a single box
+        */
+        uint8_t cull(const BoundingBox& box) const;
+
+        /** Classify a box for hierarchical culling, e.g. a BVH node
+            \param[in] box World space box
+            \param[out] contained Eyes whose frustum contains the box completely
+            \return Eyes whose frustum the box intersects, the same mask as cull()
+        */
+        uint8_t classify(const BoundingBox& box, uint8_t& contained) const;
+
+        /** Get the visibility masks of a batch
+            \param[in] batch Boxes to test
+            \param[out] masks One mask per box
+            \param[in] useSimd Use the SSE path. The scalar path gives the same results and is meant for testing.
+        */
+        void cull(const Batch& batch, std::vector<uint8_t>& masks, bool useSimd = true) const;
+
+        /** Number of planes each eye shares with the other one (0-6)
+        */
+        uint32_t getSharedPlaneCount() const { return (uint32_t)mSharedPlanes.size(); }
+
+        /** Planes are treated as shared if their normalized coefficients differ by less than this (relative to the plane distance)
+        */
+        static const float kSharedPlaneTolerance;
+
+    private:
+        struct Plane
+        {
+            glm::vec3 xyz;
+            glm::vec3 absXyz;
+            float negW;
+        };
+
+        static void extractPlanes(const glm::mat4& viewProj, glm::vec4 planes[6]);
+        static Plane makePlane(const glm::vec4& plane);
+        static bool isInside(const std::vector<Plane>& planes, const glm::vec3& center, const glm::vec3& extent);
+        static bool isContained(const std::vector<Plane>& planes, const glm::vec3& center, const glm::vec3& extent);
+
+        std::vector<Plane> mSharedPlanes;
+        std::vector<Plane> mLeftPlanes;
+        std::vector<Plane> mRightPlanes;
+    };
+}
@@ -0,0 +1,118 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TransformTable.h"
+#include "Utils/WorkStealingPool.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    const uint32_t TransformTable::kParallelThreshold;
+    const uint32_t TransformTable::kGrainSize;
+
+    void TransformTable::resize(uint32_t count)
+    {
+        const glm::mat4 identity(1.0f);
+        uint32_t oldCount = getCount();
+        mLocal.resize(count, identity);
+        mPrevLocal.resize(count, identity);
+        mParent.resize(count, identity);
+        mPrevParent.resize(count, identity);
+        mWorld.resize(count, identity);
+        mPrevWorld.resize(count, identity);
+        mNormal.resize(count, glm::mat3x4(glm::mat3(1.0f)));
+        mDirty.resize(count, 0);
+        mEntryUpdate.resize(count, 0);
+
+        // Entries beyond the new end may still be queued
+        if (count < oldCount)
+        {
+            mDirtyEntries.erase(std::remove_if(mDirtyEntries.begin(), mDirtyEntries.end(), [count](uint32_t entry) { return entry >= count; }), mDirtyEntries.end());
+        }
+    }
+
+    void TransformTable::markDirty(uint32_t entry)
+    {
+        if (mDirty[entry] == 0)
+        {
+            mDirty[entry] = 1;
+            mDirtyEntries.push_back(entry);
+        }
+    }
+
+    void TransformTable::setLocal(uint32_t entry, const glm::mat4& local, const glm::mat4& prevLocal)
+    {
+        assert(entry < getCount());
+        mLocal[entry] = local;
+        mPrevLocal[entry] = prevLocal;
+        markDirty(entry);
+    }
+
+    void TransformTable::setParent(uint32_t entry, const glm::mat4& parent, const glm::mat4& prevParent)
+    {
+        assert(entry < getCount());
+        mParent[entry] = parent;
+        mPrevParent[entry] = prevParent;
+        markDirty(entry);
+    }
+
+    void TransformTable::updateRange(uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            uint32_t entry = mDirtyEntries[i];
+            mWorld[entry] = mParent[entry] * mLocal[entry];
+            mPrevWorld[entry] = mPrevParent[entry] * mPrevLocal[entry];
+            mNormal[entry] = transpose(inverse(glm::mat3(mWorld[entry])));
+            mDirty[entry] = 0;
+            mEntryUpdate[entry] = mUpdateCount;
+        }
+    }
+
+    uint32_t TransformTable::update(WorkStealingPool* pPool)
+    {
+        uint32_t count = (uint32_t)mDirtyEntries.size();
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        mUpdateCount++;
+        if (pPool && count >= kParallelThreshold)
+        {
+            // Every entry is in the list once, so the ranges write disjoint elements
+            pPool->parallelFor(count, kGrainSize, [this](uint32_t begin, uint32_t end) { updateRange(begin, end); });
+        }
+        else
+        {
+            updateRange(0, count);
+        }
+        mDirtyEntries.clear();
+        return count;
+    }
+}
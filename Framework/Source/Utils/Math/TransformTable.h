@@ -0,0 +1,109 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "glm/mat4x4.hpp"
+#include "glm/mat3x4.hpp"
+#include <vector>
+
+namespace Falcor
+{
+    class WorkStealingPool;
+
+    /** Structure-of-arrays store of draw transforms.
+        Every entry combines a local matrix (e.g. a mesh instance) with a parent matrix (e.g. the model instance it belongs to) and caches the world matrix,
+        the previous frame's world matrix and the normal matrix (transpose of the inverse of the upper 3x3). Setting a matrix only marks the entry,
+        update() recomputes the marked entries in one batch, in parallel if the batch is large enough. Renderers read the results instead of
+        recomputing them per draw.
+    */
+    class TransformTable
+    {
+    public:
+        /** Batches with at least this many entries are distributed across the pool
+        */
+        static const uint32_t kParallelThreshold = 512;
+        static const uint32_t kGrainSize = 128;
+
+        /** Set the number of entries. New entries are identity transforms.
+        */
+        void resize(uint32_t count);
+        uint32_t getCount() const { return (uint32_t)mWorld.size(); }
+
+        void setLocal(uint32_t entry, const glm::mat4& local, const glm::mat4& prevLocal);
+        void setParent(uint32_t entry, const glm::mat4& parent, const glm::mat4& prevParent);
+
+        /** Recompute all entries changed since the last call
+            \param[in] pPool Pool for large batches. If nullptr, the batch is processed on the calling thread.
+            \return Number of recomputed entries
+        */
+        uint32_t update(WorkStealingPool* pPool = nullptr);
+
+        uint32_t getDirtyCount() const { return (uint32_t)mDirtyEntries.size(); }
+
+        /** Number of update() calls that recomputed at least one entry. Consumers that mirror the table (e.g. in a GPU buffer) remember this value
+            and only copy the entries whose getEntryUpdate() is larger the next time.
+        */
+        uint32_t getUpdateCount() const { return mUpdateCount; }
+
+        /** Value of getUpdateCount() after the update() call that last recomputed the entry, 0 if it was never recomputed
+        */
+        uint32_t getEntryUpdate(uint32_t entry) const { return mEntryUpdate[entry]; }
+
+        const glm::mat4& getWorld(uint32_t entry) const { return mWorld[entry]; }
+        const glm::mat4& getPrevWorld(uint32_t entry) const { return mPrevWorld[entry]; }
+
+        /** HLSL packs a float3x3 with 16B aligned columns, so the normal matrix is stored as mat3x4 and can be copied as is
+        */
+        const glm::mat3x4& getNormal(uint32_t entry) const { return mNormal[entry]; }
+
+        /** Contiguous arrays, getCount() elements each
+        */
+        const glm::mat4* getWorldData() const { return mWorld.data(); }
+        const glm::mat4* getPrevWorldData() const { return mPrevWorld.data(); }
+        const glm::mat3x4* getNormalData() const { return mNormal.data(); }
+
+    private:
+        void markDirty(uint32_t entry);
+        void updateRange(uint32_t begin, uint32_t end);
+
+        // Inputs
+        std::vector<glm::mat4> mLocal;
+        std::vector<glm::mat4> mPrevLocal;
+        std::vector<glm::mat4> mParent;
+        std::vector<glm::mat4> mPrevParent;
+
+        // Results
+        std::vector<glm::mat4> mWorld;
+        std::vector<glm::mat4> mPrevWorld;
+        std::vector<glm::mat3x4> mNormal;
+
+        std::vector<uint8_t> mDirty;
+        std::vector<uint32_t> mDirtyEntries;
+        std::vector<uint32_t> mEntryUpdate;
+        uint32_t mUpdateCount = 0;
+    };
+}
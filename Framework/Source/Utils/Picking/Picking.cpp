@@ -71,6 +71,10 @@ namespace Falcor
     Picking::Picking(const Scene::SharedPtr& pScene, uint32_t fboWidth, uint32_t fboHeight)
         : SceneRenderer(pScene)
     {
+        // Picking writes a draw ID per instance into the constant buffer and swaps programs per model
+        toggleInstanceBuffer(false);
+        toggleRenderQueue(false);
+
         mpGraphicsState = GraphicsState::create();
 
         // Create FBO
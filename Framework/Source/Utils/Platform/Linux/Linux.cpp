@@ -36,12 +36,15 @@
 #include <sys/ptrace.h>
 #include <gtk/gtk.h>
 #include <fstream>
+#include <cstdio>
 #include <fcntl.h>
 #include <libgen.h>
 #include <errno.h>
 #include <algorithm>
 #include <experimental/filesystem>
 #include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
 namespace fs = std::experimental::filesystem;
 
 namespace Falcor
@@ -211,6 +214,12 @@ namespace Falcor
         return filePath;
     }
 
+    bool replaceFile(const std::string& source, const std::string& destination)
+    {
+        // rename() replaces an existing destination atomically on POSIX
+        return std::rename(source.c_str(), destination.c_str()) == 0;
+    }
+
     const std::string& getExecutableDirectory()
     {
         char result[PATH_MAX] = { 0 };
@@ -507,6 +516,43 @@ namespace Falcor
         dlclose(dll);
     }
 
+    const void* mapFileForRead(const std::string& filename, size_t& size)
+    {
+        size = 0;
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            return nullptr;
+        }
+
+        struct stat s;
+        void* pData = nullptr;
+        if (fstat(fd, &s) == 0 && s.st_size > 0)
+        {
+            pData = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pData == MAP_FAILED)
+            {
+                pData = nullptr;
+            }
+        }
+        // The mapping stays valid after the descriptor is closed
+        close(fd);
+
+        if (pData)
+        {
+            size = (size_t)s.st_size;
+        }
+        return pData;
+    }
+
+    void unmapFile(const void* pData, size_t size)
+    {
+        if (pData)
+        {
+            munmap(const_cast<void*>(pData), size);
+        }
+    }
+
     /** Get a function pointer from a library
     */
     void* getDllProcAddress(DllHandle dll, const std::string& funcName)
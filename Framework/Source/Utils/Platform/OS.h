@@ -153,6 +153,13 @@ namespace Falcor
     */
     bool createDirectory(const std::string& path);
 
+    /** Move a file over another one in a single step. Other processes see either the old or the new destination, never a missing one.
+        \param[in] source The file to move
+        \param[in] destination The file to replace, doesn't need to exist
+        \return true if the file was moved, otherwise false. The source is left in place on failure.
+    */
+    bool replaceFile(const std::string& source, const std::string& destination);
+
     /** Given the app name and full command line arguments, begin the process
     */
     size_t executeProcess(const std::string& appName, const std::string& commandLineArgs);
@@ -320,6 +327,17 @@ namespace Falcor
     */
     std::string readFile(const std::string& filename);
 
+    /** Map a file into the address space of the process for reading. The view stays valid until unmapFile() is called.
+        \param[in] filename Full path of the file
+        \param[out] size Size of the mapped view in bytes
+        \return Pointer to the first byte of the file, or nullptr if the file can't be opened or is empty
+    */
+    const void* mapFileForRead(const std::string& filename, size_t& size);
+
+    /** Release a view created with mapFileForRead()
+    */
+    void unmapFile(const void* pData, size_t size);
+
     /** Load a shared-library
     */
     DllHandle loadDll(const std::string& libPath);
@@ -108,6 +108,11 @@ namespace Falcor
         return res == TRUE;
     }
 
+    bool replaceFile(const std::string& source, const std::string& destination)
+    {
+        return MoveFileExW(string_2_wstring(source).c_str(), string_2_wstring(destination).c_str(), MOVEFILE_REPLACE_EXISTING) == TRUE;
+    }
+
     std::string getTempFilename()
     {
         char* error = nullptr;
@@ -583,6 +588,44 @@ namespace Falcor
         FreeLibrary(dll);
     }
 
+    const void* mapFileForRead(const std::string& filename, size_t& size)
+    {
+        size = 0;
+        HANDLE hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSize;
+        const void* pData = nullptr;
+        if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0)
+        {
+            HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (hMapping)
+            {
+                pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+                // The view keeps the mapping object alive
+                CloseHandle(hMapping);
+            }
+        }
+        CloseHandle(hFile);
+
+        if (pData)
+        {
+            size = (size_t)fileSize.QuadPart;
+        }
+        return pData;
+    }
+
+    void unmapFile(const void* pData, size_t size)
+    {
+        if (pData)
+        {
+            UnmapViewOfFile(pData);
+        }
+    }
+
     /** Get a function pointer from a library
     */
     void* getDllProcAddress(DllHandle dll, const std::string& funcName)
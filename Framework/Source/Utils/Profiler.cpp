@@ -30,9 +30,6 @@
 #include "API/GpuTimer.h"
 #include "API/LowLevel/FencedPool.h"
 
-#include <iostream>
-#include <fstream>
-#include <sstream>
 #include <cstdio>
 
 namespace Falcor
@@ -43,6 +40,7 @@ namespace Falcor
     uint32_t Profiler::sCurrentLevel = 0;
     uint32_t Profiler::sGpuTimerIndex = 0;
     std::vector<Profiler::EventData*> Profiler::sProfilerVector;
+    static thread_local bool sThreadSuspended = false;
 
     void Profiler::initNewEvent(EventData *pEvent, const std::string& name)
     {
@@ -71,6 +69,7 @@ namespace Falcor
 
     void Profiler::startEvent(const std::string& name, bool showInMsg)
     {
+        if (sThreadSuspended) return;
         EventData* pData = getEvent(name);
         pData->triggered++;
         if (pData->triggered > 1)
@@ -96,6 +95,7 @@ namespace Falcor
 
     void Profiler::endEvent(const std::string& name)
     {
+        if (sThreadSuspended) return;
         EventData* pData = getEvent(name);
         pData->triggered--;
         if (pData->triggered != 0) return;
@@ -152,24 +152,6 @@ namespace Falcor
             uint32_t nameIndent = pData->level * 2 + 1;
             uint32_t cpuIndent = 30 - (nameIndent + (uint32_t)pData->name.size());
             snprintf(event, 1000, "%*s%s %*.2f %14.2f\n", nameIndent, " ", pData->name.c_str(), cpuIndent, getCpuTime(pData), gpuTime);
-#if _PROFILING_LOG == 1
-            pData->cpuMs[pData->stepNr] = pData->cpuTotal;
-            pData->gpuMs[pData->stepNr] = (float)gpuTime;
-            pData->stepNr++;
-            if (pData->stepNr == _PROFILING_LOG_BATCH_SIZE)
-            {
-                std::ostringstream logOss, fileOss;
-                logOss << "dumping " << "profile_" << pData->name << "_" << pData->filesWritten;
-                logInfo(logOss.str());
-                fileOss << "profile_" << pData->name << "_" << pData->filesWritten++;
-                std::ofstream out(fileOss.str().c_str());
-                for (int i = 0; i < _PROFILING_LOG_BATCH_SIZE; ++i)
-                {
-                    out << pData->cpuMs[i] << " " << pData->gpuMs[i] << "\n";
-                }
-                pData->stepNr = 0;
-            }
-#endif
             results += event;
         }
 
@@ -180,6 +162,21 @@ namespace Falcor
     {
         for (EventData* pData : sProfilerVector)
         {
+#if _PROFILING_LOG == 1
+            // Hand the frame's times to the telemetry writer thread, nothing is written to disk here
+            Telemetry* pTelemetry = Telemetry::getActive();
+            if (gProfileEnabled && pTelemetry)
+            {
+                if (pData->telemetryGeneration != pTelemetry->getGeneration())
+                {
+                    pData->telemetryGeneration = pTelemetry->getGeneration();
+                    pData->cpuCounterId = pTelemetry->getCounterId(pData->name + ".cpuMs");
+                    pData->gpuCounterId = pTelemetry->getCounterId(pData->name + ".gpuMs");
+                }
+                pTelemetry->record(pData->cpuCounterId, pData->cpuTotal);
+                pTelemetry->record(pData->gpuCounterId, (float)getGpuTime(pData));
+            }
+#endif
             pData->showInMsg = false;
             pData->cpuTotal = 0;
             pData->triggered = 0; 
@@ -189,23 +186,10 @@ namespace Falcor
         sGpuTimerIndex = 1 - sGpuTimerIndex;
     }
 
-#if _PROFILING_LOG == 1
-    void Profiler::flushLog() {
-        for (EventData* pData : sProfilerVector)
-        {
-            std::ostringstream logOss, fileOss;
-            logOss << "dumping " << "profile_" << pData->name << "_" << pData->filesWritten;
-            logInfo(logOss.str());
-            fileOss << "profile_" << pData->name << "_" << pData->filesWritten++;
-            std::ofstream out(fileOss.str().c_str());
-            for (int i = 0; i < pData->stepNr; ++i)
-            {
-                out << pData->cpuMs[i] << " " << pData->gpuMs[i] << "\n";
-            }
-            pData->stepNr = 0;
-        }
+    void Profiler::setThreadSuspended(bool suspended)
+    {
+        sThreadSuspended = suspended;
     }
-#endif
 
     void Profiler::clearEvents()
     {
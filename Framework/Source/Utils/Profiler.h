@@ -33,6 +33,7 @@
 #include "API/GpuTimer.h"
 #include "Utils/CpuTimer.h"
 #include "FalcorConfig.h"
+#include "Utils/Telemetry.h"
 #include <stack>
 
 namespace Falcor
@@ -50,10 +51,6 @@ namespace Falcor
     {
     public:
 
-#if _PROFILING_LOG == 1
-        static void flushLog();
-#endif
-
         struct EventData
         {
             virtual ~EventData() {}
@@ -72,10 +69,9 @@ namespace Falcor
             uint32_t level;
             uint32_t triggered = 0;
 #if _PROFILING_LOG == 1
-            int stepNr = 0;
-            int filesWritten = 0;
-            float cpuMs[_PROFILING_LOG_BATCH_SIZE];
-            float gpuMs[_PROFILING_LOG_BATCH_SIZE];
+            uint64_t telemetryGeneration = 0;   // generation of the sink the counter IDs below belong to, 0 if none
+            uint32_t cpuCounterId = 0;
+            uint32_t gpuCounterId = 0;
 #endif
         };
 
@@ -136,6 +132,11 @@ namespace Falcor
         */
         static void clearEvents();
 
+        /** Ignore events started and ended on the calling thread.
+            The profiler is not thread-safe and times the GPU on the default render-context, so render graph passes recorded on worker threads are not profiled.
+        */
+        static void setThreadSuspended(bool suspended);
+
     private:
         static double getGpuTime(const EventData* pData);
         static double getCpuTime(const EventData* pData);
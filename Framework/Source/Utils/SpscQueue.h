@@ -0,0 +1,91 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <atomic>
+#include <vector>
+
+namespace Falcor
+{
+    /** Bounded lock-free queue for exactly one producer and one consumer thread.
+        push() and pop() never block or allocate, so the producer can be a render thread that must not stall on the consumer.
+    */
+    template<typename T>
+    class SpscQueue
+    {
+    public:
+        /** Create a queue
+            \param[in] capacity Minimum number of elements the queue can hold, rounded up to a power of two
+        */
+        explicit SpscQueue(size_t capacity)
+        {
+            size_t size = 1;
+            while (size < capacity) size <<= 1;
+            mBuffer.resize(size);
+            mMask = size - 1;
+        }
+
+        /** Add an element. Producer thread only.
+            \return false if the queue is full, the element is not added in that case
+        */
+        bool push(const T& value)
+        {
+            const size_t head = mHead.load(std::memory_order_relaxed);
+            if (head - mTail.load(std::memory_order_acquire) == mBuffer.size()) return false;
+            mBuffer[head & mMask] = value;
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Remove the oldest element. Consumer thread only.
+            \return false if the queue is empty
+        */
+        bool pop(T& value)
+        {
+            const size_t tail = mTail.load(std::memory_order_relaxed);
+            if (tail == mHead.load(std::memory_order_acquire)) return false;
+            value = mBuffer[tail & mMask];
+            mTail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Get the number of queued elements. Only a snapshot if the other thread is active.
+        */
+        size_t size() const { return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire); }
+
+        bool empty() const { return size() == 0; }
+
+        size_t capacity() const { return mBuffer.size(); }
+
+    private:
+        // Producer and consumer indices on separate cache lines
+        alignas(64) std::atomic<size_t> mHead = { 0 };
+        alignas(64) std::atomic<size_t> mTail = { 0 };
+        std::vector<T> mBuffer;
+        size_t mMask = 0;
+    };
+}
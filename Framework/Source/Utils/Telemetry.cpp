@@ -0,0 +1,440 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace Falcor
+{
+    Telemetry::SharedPtr Telemetry::spActive;
+    std::atomic<uint64_t> Telemetry::sNextGeneration = { 1 };
+
+    namespace
+    {
+        // Binary layout: magic, version, metadata count and key/value strings, followed by tagged records.
+        // kTagCounter: u32 id, string name (IDs are dense and defined before their first use)
+        // kTagFrame:   u64 frame, u32 sample count, { u32 id, f32 value } per sample
+        // Strings are a u32 length followed by the characters.
+        const char kMagic[4] = { 'F', 'T', 'L', 'M' };
+        const uint32_t kVersion = 1;
+        const uint8_t kTagCounter = 1;
+        const uint8_t kTagFrame = 2;
+        const char* kCsvFrameColumn = "frame";
+
+        void writeString(std::ostream& stream, const std::string& str)
+        {
+            uint32_t length = (uint32_t)str.size();
+            stream.write((const char*)&length, sizeof(length));
+            stream.write(str.data(), length);
+        }
+
+        bool readString(std::istream& stream, std::string& str)
+        {
+            uint32_t length = 0;
+            if (!stream.read((char*)&length, sizeof(length))) return false;
+            str.resize(length);
+            return length == 0 || (bool)stream.read(&str[0], length);
+        }
+
+        template<typename T>
+        bool readValue(std::istream& stream, T& value)
+        {
+            return (bool)stream.read((char*)&value, sizeof(T));
+        }
+
+        uint32_t addCounter(Telemetry::Log& log, std::unordered_map<std::string, uint32_t>& ids, const std::string& name)
+        {
+            auto it = ids.find(name);
+            if (it != ids.end()) return it->second;
+
+            uint32_t id = (uint32_t)log.counters.size();
+            ids[name] = id;
+            log.counters.push_back(name);
+            log.columns.push_back(std::vector<float>(log.frameIds.size(), std::numeric_limits<float>::quiet_NaN()));
+            return id;
+        }
+
+        void addFrame(Telemetry::Log& log, uint64_t frameId)
+        {
+            log.frameIds.push_back(frameId);
+            for (auto& column : log.columns) column.push_back(std::numeric_limits<float>::quiet_NaN());
+        }
+
+        bool loadBinary(std::ifstream& stream, Telemetry::Log& log)
+        {
+            uint32_t version = 0, metadataCount = 0;
+            if (!readValue(stream, version) || version != kVersion || !readValue(stream, metadataCount)) return false;
+            for (uint32_t i = 0; i < metadataCount; i++)
+            {
+                std::pair<std::string, std::string> entry;
+                if (!readString(stream, entry.first) || !readString(stream, entry.second)) return false;
+                log.metadata.push_back(entry);
+            }
+
+            uint8_t tag;
+            while (readValue(stream, tag))
+            {
+                if (tag == kTagCounter)
+                {
+                    uint32_t id;
+                    std::string name;
+                    if (!readValue(stream, id) || !readString(stream, name) || id != log.counters.size()) return false;
+                    log.counters.push_back(name);
+                    log.columns.push_back(std::vector<float>(log.frameIds.size(), std::numeric_limits<float>::quiet_NaN()));
+                }
+                else if (tag == kTagFrame)
+                {
+                    uint64_t frameId;
+                    uint32_t sampleCount;
+                    if (!readValue(stream, frameId) || !readValue(stream, sampleCount)) return false;
+                    addFrame(log, frameId);
+                    for (uint32_t i = 0; i < sampleCount; i++)
+                    {
+                        uint32_t id;
+                        float value;
+                        if (!readValue(stream, id) || !readValue(stream, value) || id >= log.counters.size()) return false;
+                        log.columns[id].back() = value;
+                    }
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool loadCsv(std::ifstream& stream, Telemetry::Log& log)
+        {
+            std::unordered_map<std::string, uint32_t> ids;
+            std::vector<uint32_t> columnIds;
+            std::string line;
+            while (std::getline(stream, line))
+            {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty()) continue;
+
+                if (line[0] == '#')
+                {
+                    size_t separator = line.find('=');
+                    if (separator == std::string::npos) continue;
+                    log.metadata.push_back({ line.substr(2, separator - 2), line.substr(separator + 1) });
+                    continue;
+                }
+
+                std::vector<std::string> fields;
+                std::istringstream ss(line);
+                std::string field;
+                while (std::getline(ss, field, ',')) fields.push_back(field);
+                if (line.back() == ',') fields.push_back(std::string());
+
+                if (fields[0] == kCsvFrameColumn)
+                {
+                    columnIds.clear();
+                    for (size_t i = 1; i < fields.size(); i++) columnIds.push_back(addCounter(log, ids, fields[i]));
+                    continue;
+                }
+
+                if (fields.size() != columnIds.size() + 1) return false;
+                addFrame(log, std::stoull(fields[0]));
+                for (size_t i = 1; i < fields.size(); i++)
+                {
+                    if (!fields[i].empty()) log.columns[columnIds[i - 1]].back() = std::stof(fields[i]);
+                }
+            }
+            return true;
+        }
+    }
+
+    /** Writes the samples to disk, only used by the writer thread (apart from opening the file)
+    */
+    class Telemetry::Writer
+    {
+    public:
+        bool open(const std::string& filename, Format format, const Metadata& metadata)
+        {
+            mFormat = format;
+            mStream.open(filename.c_str(), format == Format::Binary ? (std::ios::out | std::ios::binary) : std::ios::out);
+            if (!mStream.is_open()) return false;
+
+            if (mFormat == Format::Binary)
+            {
+                mStream.write(kMagic, sizeof(kMagic));
+                mStream.write((const char*)&kVersion, sizeof(kVersion));
+                uint32_t metadataCount = (uint32_t)metadata.size();
+                mStream.write((const char*)&metadataCount, sizeof(metadataCount));
+                for (const auto& entry : metadata)
+                {
+                    writeString(mStream, entry.first);
+                    writeString(mStream, entry.second);
+                }
+            }
+            else
+            {
+                mStream.precision(std::numeric_limits<float>::max_digits10);
+                for (const auto& entry : metadata) mStream << "# " << entry.first << "=" << entry.second << "\n";
+            }
+            return true;
+        }
+
+        void defineCounter(uint32_t id, const std::string& name)
+        {
+            mNames.push_back(name);
+            mValues.push_back(std::numeric_limits<float>::quiet_NaN());
+            if (mFormat == Format::Binary)
+            {
+                mStream.write((const char*)&kTagCounter, sizeof(kTagCounter));
+                mStream.write((const char*)&id, sizeof(id));
+                writeString(mStream, name);
+            }
+        }
+
+        uint32_t getCounterCount() const { return (uint32_t)mNames.size(); }
+
+        void setValue(uint32_t id, float value)
+        {
+            if (std::isnan(mValues[id])) mRecorded.push_back(id);
+            mValues[id] = value;
+        }
+
+        void endFrame()
+        {
+            if (mFormat == Format::Binary)
+            {
+                uint32_t sampleCount = (uint32_t)mRecorded.size();
+                mStream.write((const char*)&kTagFrame, sizeof(kTagFrame));
+                mStream.write((const char*)&mFrameId, sizeof(mFrameId));
+                mStream.write((const char*)&sampleCount, sizeof(sampleCount));
+                for (uint32_t id : mRecorded)
+                {
+                    mStream.write((const char*)&id, sizeof(id));
+                    mStream.write((const char*)&mValues[id], sizeof(float));
+                }
+            }
+            else
+            {
+                if (mHeaderColumnCount != mNames.size())
+                {
+                    mStream << kCsvFrameColumn;
+                    for (const auto& name : mNames) mStream << "," << name;
+                    mStream << "\n";
+                    mHeaderColumnCount = mNames.size();
+                }
+                mStream << mFrameId;
+                for (float value : mValues)
+                {
+                    mStream << ",";
+                    if (!std::isnan(value)) mStream << value;
+                }
+                mStream << "\n";
+            }
+
+            for (uint32_t id : mRecorded) mValues[id] = std::numeric_limits<float>::quiet_NaN();
+            mRecorded.clear();
+            mFrameId++;
+        }
+
+        void flush() { mStream.flush(); }
+
+    private:
+        Format mFormat = Format::Binary;
+        std::ofstream mStream;
+        std::vector<std::string> mNames;
+        std::vector<float> mValues;         // NaN if not recorded in the current frame
+        std::vector<uint32_t> mRecorded;
+        size_t mHeaderColumnCount = 0;
+        uint64_t mFrameId = 0;
+    };
+
+    Telemetry::SharedPtr Telemetry::create(const std::string& filename, Format format, const Metadata& metadata, size_t queueCapacity)
+    {
+        SharedPtr pTelemetry = SharedPtr(new Telemetry(filename, format, queueCapacity));
+        if (pTelemetry->mpWriter->open(filename, format, metadata) == false)
+        {
+            logWarning("Telemetry::create() - can't open " + filename);
+            return nullptr;
+        }
+        pTelemetry->mThread = std::thread(&Telemetry::writerThread, pTelemetry.get());
+        return pTelemetry;
+    }
+
+    Telemetry::Telemetry(const std::string& filename, Format format, size_t queueCapacity) : mFilename(filename), mGeneration(sNextGeneration++), mFormat(format), mpWriter(new Writer), mQueue(queueCapacity)
+    {
+    }
+
+    Telemetry::~Telemetry()
+    {
+        mStop = true;
+        if (mThread.joinable()) mThread.join();
+    }
+
+    void Telemetry::setActive(const SharedPtr& pTelemetry)
+    {
+        spActive = pTelemetry;
+    }
+
+    uint32_t Telemetry::getCounterId(const std::string& name)
+    {
+        auto it = mCounterIds.find(name);
+        if (it != mCounterIds.end()) return it->second;
+
+        std::lock_guard<std::mutex> lock(mNameMutex);
+        uint32_t id = (uint32_t)mCounterNames.size();
+        mCounterNames.push_back(name);
+        mCounterIds[name] = id;
+        return id;
+    }
+
+    void Telemetry::record(uint32_t counterId, float value)
+    {
+        assert(counterId < mCounterNames.size());
+        push({ counterId, value });
+    }
+
+    void Telemetry::endFrame()
+    {
+        push({ kInvalidCounter, 0.f });
+        mFrameCount++;
+    }
+
+    void Telemetry::push(const Sample& sample)
+    {
+        if (mQueue.push(sample))
+        {
+            mPushedSamples++;
+        }
+        else
+        {
+            mDroppedSamples++;
+        }
+    }
+
+    void Telemetry::flush()
+    {
+        while (mWrittenSamples.load() != mPushedSamples)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void Telemetry::writerThread()
+    {
+        while (true)
+        {
+            // Check before draining, so nothing pushed before the stop request is lost
+            const bool stop = mStop.load();
+
+            uint64_t count = 0;
+            Sample sample;
+            while (mQueue.pop(sample))
+            {
+                if (sample.counterId == kInvalidCounter)
+                {
+                    mpWriter->endFrame();
+                }
+                else
+                {
+                    if (sample.counterId >= mpWriter->getCounterCount())
+                    {
+                        std::lock_guard<std::mutex> lock(mNameMutex);
+                        for (uint32_t id = mpWriter->getCounterCount(); id < mCounterNames.size(); id++) mpWriter->defineCounter(id, mCounterNames[id]);
+                    }
+                    mpWriter->setValue(sample.counterId, sample.value);
+                }
+                count++;
+            }
+
+            if (count > 0)
+            {
+                mpWriter->flush();
+                mWrittenSamples += count;
+            }
+            else if (stop)
+            {
+                break;
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+        mpWriter->flush();
+    }
+
+    const std::vector<float>* Telemetry::Log::getColumn(const std::string& name) const
+    {
+        for (size_t i = 0; i < counters.size(); i++)
+        {
+            if (counters[i] == name) return &columns[i];
+        }
+        return nullptr;
+    }
+
+    bool Telemetry::load(const std::string& filename, Log& log)
+    {
+        log = Log();
+        std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+        if (!stream.is_open()) return false;
+
+        char magic[4] = {};
+        stream.read(magic, sizeof(magic));
+        if (stream && std::equal(magic, magic + 4, kMagic)) return loadBinary(stream, log);
+
+        stream.clear();
+        stream.seekg(0);
+        return loadCsv(stream, log);
+    }
+
+    bool Telemetry::saveCsv(const Log& log, const std::string& filename)
+    {
+        std::ofstream stream(filename.c_str());
+        if (!stream.is_open()) return false;
+
+        stream.precision(std::numeric_limits<float>::max_digits10);
+        for (const auto& entry : log.metadata) stream << "# " << entry.first << "=" << entry.second << "\n";
+        stream << kCsvFrameColumn;
+        for (const auto& name : log.counters) stream << "," << name;
+        stream << "\n";
+        for (size_t f = 0; f < log.frameIds.size(); f++)
+        {
+            stream << log.frameIds[f];
+            for (const auto& column : log.columns)
+            {
+                stream << ",";
+                if (!std::isnan(column[f])) stream << column[f];
+            }
+            stream << "\n";
+        }
+        return true;
+    }
+}
@@ -0,0 +1,165 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Utils/SpscQueue.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Falcor
+{
+    /** Per-frame telemetry sink.
+        The render thread records named counters (e.g. CPU/GPU times, hole or triangle counts) into a lock-free queue and a background thread
+        writes them to disk, so recording never waits on file I/O. Each frame becomes one row: a compact binary record or a CSV line
+        with one column per counter. The run metadata is stored in the file header.
+    */
+    class Telemetry
+    {
+    public:
+        using SharedPtr = std::shared_ptr<Telemetry>;
+        using Metadata = std::vector<std::pair<std::string, std::string>>;
+
+        enum class Format
+        {
+            Binary,     ///< Tagged records, see Telemetry.cpp for the layout
+            Csv         ///< '#' metadata lines, then a header line and one line per frame. The header is repeated when new counters appear.
+        };
+
+        static const size_t kDefaultQueueCapacity = 1 << 16;
+        static const uint32_t kInvalidCounter = ~0u;
+
+        /** Create a sink and start its writer thread
+            \param[in] filename Output file, overwritten if it exists
+            \param[in] format File format
+            \param[in] metadata Key/value pairs describing the run (scene, resolution, settings, ...)
+            \param[in] queueCapacity Samples that can be in flight. Samples that don't fit are dropped and counted.
+            \return A new object, or nullptr if the file couldn't be created
+        */
+        static SharedPtr create(const std::string& filename, Format format, const Metadata& metadata = Metadata(), size_t queueCapacity = kDefaultQueueCapacity);
+
+        /** Writes all queued samples and closes the file
+        */
+        ~Telemetry();
+
+        /** Set the sink that the Profiler and the render passes record into. Pass nullptr to stop recording.
+        */
+        static void setActive(const SharedPtr& pTelemetry);
+
+        /** Get the active sink, nullptr if there is none
+        */
+        static Telemetry* getActive() { return spActive.get(); }
+
+        /** Get the ID of a counter, registers it on first use. The recording functions may only be called from one thread,
+            render passes record through RenderPass::recordTelemetry() for that reason.
+        */
+        uint32_t getCounterId(const std::string& name);
+
+        /** Record a value for the current frame. A counter recorded twice in a frame keeps the last value.
+        */
+        void record(uint32_t counterId, float value);
+        void record(const std::string& name, float value) { record(getCounterId(name), value); }
+
+        /** Close the current frame. Everything recorded since the last call ends up in one row.
+        */
+        void endFrame();
+
+        /** Block until the writer thread has written everything recorded so far
+        */
+        void flush();
+
+        uint64_t getFrameCount() const { return mFrameCount; }
+        uint64_t getDroppedSampleCount() const { return mDroppedSamples; }
+        const std::string& getFilename() const { return mFilename; }
+
+        /** Get a number that no other sink of this process shares. Use it instead of the address to tell whether cached counter IDs belong to this sink,
+            a new sink can be allocated where a destroyed one lived.
+        */
+        uint64_t getGeneration() const { return mGeneration; }
+
+        /** Content of a telemetry file
+        */
+        struct Log
+        {
+            Metadata metadata;
+            std::vector<std::string> counters;
+            std::vector<uint64_t> frameIds;
+            std::vector<std::vector<float>> columns;    ///< One per counter, one value per frame. NaN if the counter wasn't recorded in that frame.
+
+            /** Get the values of a counter, nullptr if it doesn't exist
+            */
+            const std::vector<float>* getColumn(const std::string& name) const;
+        };
+
+        /** Load a telemetry file written in either format
+        */
+        static bool load(const std::string& filename, Log& log);
+
+        /** Write a log as columnar CSV, e.g. to convert a binary file for a spreadsheet
+        */
+        static bool saveCsv(const Log& log, const std::string& filename);
+
+    private:
+        Telemetry(const std::string& filename, Format format, size_t queueCapacity);
+
+        struct Sample
+        {
+            uint32_t counterId;     ///< kInvalidCounter marks the end of a frame
+            float value;
+        };
+
+        class Writer;
+
+        void push(const Sample& sample);
+        void writerThread();
+
+        std::string mFilename;
+        uint64_t mGeneration;
+        Format mFormat;
+        std::unique_ptr<Writer> mpWriter;
+        SpscQueue<Sample> mQueue;
+        std::thread mThread;
+        std::atomic<bool> mStop = { false };
+
+        // Counter names are shared with the writer thread. Registration is rare, so a mutex is fine here.
+        std::unordered_map<std::string, uint32_t> mCounterIds;
+        std::vector<std::string> mCounterNames;
+        std::mutex mNameMutex;
+
+        uint64_t mFrameCount = 0;
+        uint64_t mPushedSamples = 0;
+        std::atomic<uint64_t> mWrittenSamples = { 0 };
+        uint64_t mDroppedSamples = 0;
+
+        static SharedPtr spActive;
+        static std::atomic<uint64_t> sNextGeneration;
+    };
+}
@@ -0,0 +1,217 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "WorkStealingPool.h"
+
+namespace Falcor
+{
+    WorkStealingPool::SharedPtr WorkStealingPool::create(uint32_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        return SharedPtr(new WorkStealingPool(threadCount));
+    }
+
+    WorkStealingPool::SharedPtr WorkStealingPool::getShared()
+    {
+        static SharedPtr spShared = create();
+        return spShared;
+    }
+
+    WorkStealingPool::WorkStealingPool(uint32_t threadCount)
+    {
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            mQueues.push_back(std::make_unique<Queue>());
+        }
+
+        for (uint32_t i = 1; i < threadCount; i++)
+        {
+            mThreads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            mTerminate = true;
+        }
+        mWakeCondition.notify_all();
+
+        for (auto& t : mThreads)
+        {
+            t.join();
+        }
+    }
+
+    void WorkStealingPool::parallelFor(uint32_t count, uint32_t grainSize, const RangeFunc& func)
+    {
+        if (count == 0) return;
+        grainSize = std::max(1u, grainSize);
+
+        const uint32_t taskCount = (count + grainSize - 1) / grainSize;
+        if (taskCount == 1 || mThreads.empty())
+        {
+            func(0, count);
+            return;
+        }
+
+        Batch batch;
+        batch.pFunc = &func;
+        batch.pending = taskCount;
+        batch.failed = false;
+
+        // Deal the ranges out round-robin, neighbouring ranges end up on different threads
+        for (uint32_t t = 0; t < taskCount; t++)
+        {
+            Task task;
+            task.pBatch = &batch;
+            task.begin = t * grainSize;
+            task.end = std::min(count, task.begin + grainSize);
+
+            Queue& queue = *mQueues[t % mQueues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(task);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            mQueuedTasks += taskCount;
+        }
+        mWakeCondition.notify_all();
+
+        // Help out until our own ranges are done. We might end up running tasks of another caller, which is fine.
+        while (batch.pending.load() > 0)
+        {
+            if (runTask(0) == false)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        if (batch.pError)
+        {
+            std::rethrow_exception(batch.pError);
+        }
+    }
+
+    void WorkStealingPool::submitBackground(const std::function<void()>& func)
+    {
+        if (mThreads.empty())
+        {
+            func();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            mBackgroundTasks.push_back(func);
+        }
+        mWakeCondition.notify_one();
+    }
+
+    bool WorkStealingPool::runTask(uint32_t queueIndex)
+    {
+        Task task;
+        bool found = false;
+
+        // Own queue first (LIFO keeps the caches warm), then steal the oldest task from the others
+        for (uint32_t i = 0; i < mQueues.size() && !found; i++)
+        {
+            Queue& queue = *mQueues[(queueIndex + i) % mQueues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+
+            if (i == 0)
+            {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            found = true;
+        }
+
+        if (found == false) return false;
+
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            mQueuedTasks--;
+        }
+
+        // An exception must not escape, the caller would wait for the range forever. It gets the first one once all ranges are accounted for.
+        Batch& batch = *task.pBatch;
+        if (batch.failed.load() == false)
+        {
+            try
+            {
+                (*batch.pFunc)(task.begin, task.end);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(batch.errorMutex);
+                if (batch.pError == nullptr) batch.pError = std::current_exception();
+                batch.failed = true;
+            }
+        }
+        batch.pending.fetch_sub(1);
+        return true;
+    }
+
+    bool WorkStealingPool::runBackgroundTask()
+    {
+        std::function<void()> func;
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            if (mBackgroundTasks.empty()) return false;
+            func = std::move(mBackgroundTasks.front());
+            mBackgroundTasks.pop_front();
+        }
+        func();
+        return true;
+    }
+
+    void WorkStealingPool::workerLoop(uint32_t queueIndex)
+    {
+        while (true)
+        {
+            if (runTask(queueIndex)) continue;
+            if (runBackgroundTask()) continue;
+
+            std::unique_lock<std::mutex> lock(mWakeMutex);
+            mWakeCondition.wait(lock, [this]() { return mTerminate || mQueuedTasks > 0 || mBackgroundTasks.empty() == false; });
+            if (mTerminate && mQueuedTasks == 0 && mBackgroundTasks.empty()) return;
+        }
+    }
+}
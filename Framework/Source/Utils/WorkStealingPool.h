@@ -0,0 +1,120 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+    /** Thread pool for data parallel CPU work.
+        Every thread owns a task queue. Threads pop from the back of their own queue and steal from the front of the others once it runs dry,
+        so uneven work gets balanced without a central queue. The thread calling parallelFor() takes part in the work as well.
+        Framework systems share one pool (see getShared()), so the process doesn't end up with a full set of threads per system.
+    */
+    class WorkStealingPool
+    {
+    public:
+        using SharedPtr = std::shared_ptr<WorkStealingPool>;
+        using RangeFunc = std::function<void(uint32_t begin, uint32_t end)>;
+
+        /** Create a new pool
+            \param[in] threadCount Total number of threads working on a parallelFor() call, including the caller. 0 uses all hardware threads.
+        */
+        static SharedPtr create(uint32_t threadCount = 0);
+        ~WorkStealingPool();
+
+        /** Get the process-wide pool, created with all hardware threads on first use. Use it unless a fixed thread count is needed,
+            e.g. for scaling measurements. parallelFor() can be nested, a caller waiting for its ranges works on other tasks meanwhile.
+        */
+        static SharedPtr getShared();
+
+        /** Split [0, count) into ranges of at most grainSize elements and run func on all of them. Returns once every range was processed.
+            Can be called from several threads at the same time. If func throws, the ranges that haven't started yet are skipped and the first
+            exception is rethrown on the calling thread.
+        */
+        void parallelFor(uint32_t count, uint32_t grainSize, const RangeFunc& func);
+
+        /** Run func on a worker thread without waiting for it, meant for long jobs such as shader compilation.
+            Workers only pick background jobs up when no range is queued, and threads waiting in parallelFor() never do, so a long job doesn't
+            delay a parallelFor() call. The caller limits how many jobs it keeps in flight, every running job takes a worker away from parallelFor().
+            A pool without worker threads runs func right away.
+        */
+        void submitBackground(const std::function<void()>& func);
+
+        /** Get the number of threads working on a parallelFor() call, including the caller
+        */
+        uint32_t getThreadCount() const { return (uint32_t)mQueues.size(); }
+
+    private:
+        WorkStealingPool(uint32_t threadCount);
+
+        // State of one parallelFor() call, lives on the caller's stack
+        struct Batch
+        {
+            const RangeFunc* pFunc;
+            std::atomic<uint32_t> pending;
+            std::atomic<bool> failed;
+            std::mutex errorMutex;
+            std::exception_ptr pError;
+        };
+
+        struct Task
+        {
+            Batch* pBatch;
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        bool runTask(uint32_t queueIndex);
+        bool runBackgroundTask();
+        void workerLoop(uint32_t queueIndex);
+
+        // Queue 0 belongs to the threads calling parallelFor()
+        std::vector<std::unique_ptr<Queue>> mQueues;
+        std::vector<std::thread> mThreads;
+
+        std::mutex mWakeMutex;
+        std::condition_variable mWakeCondition;
+        uint32_t mQueuedTasks = 0;
+        std::deque<std::function<void()>> mBackgroundTasks;    ///< Protected by mWakeMutex
+        bool mTerminate = false;
+    };
+}
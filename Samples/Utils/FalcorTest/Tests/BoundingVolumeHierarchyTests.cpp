@@ -0,0 +1,189 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        glm::mat4 getViewProj(const glm::vec3& eye, const glm::vec3& forward)
+        {
+            glm::mat4 proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+            return proj * glm::lookAt(eye, eye + forward, glm::vec3(0, 1, 0));
+        }
+
+        // Same test as Camera::isObjectCulled()
+        bool isVisible(const glm::mat4& viewProj, const BoundingBox& box)
+        {
+            glm::mat4 tempMat = glm::transpose(viewProj);
+            bool isInside = true;
+            for (int i = 0; i < 6; i++)
+            {
+                glm::vec4 plane = (i & 1) ? tempMat[i >> 1] : -tempMat[i >> 1];
+                if (i != 5) plane += tempMat[3];
+                glm::vec3 xyz = glm::vec3(plane);
+                isInside = isInside && (glm::dot(box.center + box.extent * glm::sign(xyz), xyz) > -plane.w);
+            }
+            return isInside;
+        }
+
+        BoundingBox getRandomBox(std::mt19937& rng, float range)
+        {
+            std::uniform_real_distribution<float> position(-range, range);
+            std::uniform_real_distribution<float> size(0.01f, 1.f);
+            BoundingBox box;
+            box.center = glm::vec3(position(rng), position(rng) * 0.25f, position(rng));
+            box.extent = glm::vec3(size(rng), size(rng), size(rng));
+            return box;
+        }
+
+        void expectMatchesBruteForce(CPUUnitTestContext& ctx, const BoundingVolumeHierarchy& bvh, const glm::mat4& viewProj)
+        {
+            std::vector<uint8_t> visible;
+            uint32_t visibleCount = bvh.cull(viewProj, visible);
+            EXPECT_EQ(visible.size(), (size_t)bvh.getItemCount());
+
+            uint32_t referenceCount = 0;
+            for (uint32_t i = 0; i < bvh.getItemCount(); i++)
+            {
+                bool reference = isVisible(viewProj, bvh.getItemBox(i));
+                EXPECT_EQ(visible[i] != 0, reference) << "item " << i;
+                if (reference) referenceCount++;
+            }
+            EXPECT_EQ(visibleCount, referenceCount);
+        }
+    }
+
+    // Hierarchical culling has to give the same visible set as testing every box
+    CPU_TEST(BoundingVolumeHierarchyCull)
+    {
+        std::mt19937 rng(11);
+        std::vector<BoundingBox> boxes;
+        for (uint32_t i = 0; i < 10000; i++) boxes.push_back(getRandomBox(rng, 200.f));
+
+        BoundingVolumeHierarchy bvh;
+        bvh.build(boxes);
+        EXPECT_EQ(bvh.getItemCount(), 10000u);
+        EXPECT_LE(bvh.getNodeCount(), 2u * 10000u);
+        EXPECT_LE(bvh.getDepth(), 16u);
+
+        expectMatchesBruteForce(ctx, bvh, getViewProj(glm::vec3(0.f), glm::vec3(0, 0, -1)));
+        expectMatchesBruteForce(ctx, bvh, getViewProj(glm::vec3(50.f, 5.f, 20.f), glm::normalize(glm::vec3(-0.3f, -0.1f, -1.f))));
+
+        // A camera looking into the scene from the border should skip most of the tree
+        expectMatchesBruteForce(ctx, bvh, getViewProj(glm::vec3(0.f, 0.f, 200.f), glm::vec3(0, 0, -1)));
+        EXPECT_LT(bvh.getLastCullStats().nodesVisited, bvh.getNodeCount() / 2);
+        EXPECT(bvh.getLastCullStats().subtreesAccepted > 0 && bvh.getLastCullStats().subtreesRejected > 0);
+
+        BoundingVolumeHierarchy empty;
+        std::vector<uint8_t> visible;
+        empty.build({});
+        EXPECT_EQ(empty.cull(getViewProj(glm::vec3(0.f), glm::vec3(0, 0, -1)), visible), 0u);
+    }
+
+    // The stereo traversal has to give every item the mask the culler gives its box
+    CPU_TEST(BoundingVolumeHierarchyStereoCull)
+    {
+        std::mt19937 rng(3);
+        std::vector<BoundingBox> boxes;
+        for (uint32_t i = 0; i < 10000; i++) boxes.push_back(getRandomBox(rng, 200.f));
+
+        BoundingVolumeHierarchy bvh;
+        bvh.build(boxes);
+
+        // Eyes 6.4 cm apart, looking into the scene from its border so that most subtrees are decided without touching their items
+        const glm::vec3 forward(0, 0, -1);
+        StereoFrustumCuller culler;
+        culler.setFrustums(getViewProj(glm::vec3(-0.032f, 0.f, 200.f), forward), getViewProj(glm::vec3(0.032f, 0.f, 200.f), forward));
+
+        std::vector<uint8_t> masks;
+        uint32_t visibleCount = bvh.cull(culler, masks);
+        EXPECT_EQ(masks.size(), boxes.size());
+
+        uint32_t referenceCount = 0;
+        for (uint32_t i = 0; i < bvh.getItemCount(); i++)
+        {
+            uint8_t reference = culler.cull(bvh.getItemBox(i));
+            EXPECT_EQ((uint32_t)masks[i], (uint32_t)reference) << "item " << i;
+            if (reference != 0) referenceCount++;
+        }
+        EXPECT_EQ(visibleCount, referenceCount);
+        EXPECT_LT(bvh.getLastCullStats().nodesVisited, bvh.getNodeCount() / 2);
+        EXPECT(bvh.getLastCullStats().subtreesAccepted > 0 && bvh.getLastCullStats().subtreesRejected > 0);
+    }
+
+    // Refitting only touches the paths above moved items and keeps the culling exact
+    CPU_TEST(BoundingVolumeHierarchyRefit)
+    {
+        std::mt19937 rng(5);
+        std::vector<BoundingBox> boxes;
+        for (uint32_t i = 0; i < 4096; i++) boxes.push_back(getRandomBox(rng, 100.f));
+
+        BoundingVolumeHierarchy bvh;
+        bvh.build(boxes);
+        EXPECT_EQ(bvh.refit(), 0u);
+
+        const uint32_t movedCount = 32;
+        for (uint32_t i = 0; i < movedCount; i++)
+        {
+            BoundingBox box = bvh.getItemBox(i * 97);
+            box.center += glm::vec3(3.f, 0.f, -2.f);
+            bvh.setItemBox(i * 97, box);
+        }
+        uint32_t refitCount = bvh.refit();
+        EXPECT(refitCount > 0);
+        EXPECT_LE(refitCount, movedCount * bvh.getDepth());
+        EXPECT(bvh.needsRebuild() == false);
+
+        const glm::mat4 viewProj = getViewProj(glm::vec3(10.f, 2.f, 30.f), glm::normalize(glm::vec3(0.2f, 0.f, -1.f)));
+        expectMatchesBruteForce(ctx, bvh, viewProj);
+
+        // The root has to contain every item (up to the rounding of the center/extent representation)
+        BoundingBox bounds = bvh.getBounds();
+        const glm::vec3 epsilon(1e-4f);
+        for (uint32_t i = 0; i < bvh.getItemCount(); i++)
+        {
+            const BoundingBox& box = bvh.getItemBox(i);
+            EXPECT(glm::all(glm::greaterThanEqual(box.getMinPos() + epsilon, bounds.getMinPos())) && glm::all(glm::lessThanEqual(box.getMaxPos() - epsilon, bounds.getMaxPos()))) << "item " << i;
+        }
+
+        // Scattering everything keeps the tree correct but degrades it
+        for (uint32_t i = 0; i < bvh.getItemCount(); i++)
+        {
+            bvh.setItemBox(i, getRandomBox(rng, 100.f));
+        }
+        bvh.refit();
+        EXPECT(bvh.needsRebuild());
+        expectMatchesBruteForce(ctx, bvh, viewProj);
+
+        bvh.build(bvh.getItemBoxes());
+        EXPECT(bvh.needsRebuild() == false);
+        expectMatchesBruteForce(ctx, bvh, viewProj);
+    }
+}
@@ -0,0 +1,126 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+
+namespace Falcor
+{
+    // Eviction has to follow the order of use, not the order of insertion
+    CPU_TEST(DiskCacheIndexLru)
+    {
+        DiskCacheIndex index;
+        DiskCacheIndex::Entry entry;
+        entry.size = 100;
+
+        EXPECT_EQ(index.insert("a", entry, 300).size(), 0u);
+        EXPECT_EQ(index.insert("b", entry, 300).size(), 0u);
+        EXPECT_EQ(index.insert("c", entry, 300).size(), 0u);
+        EXPECT_EQ(index.getTotalSize(), 300u);
+
+        // 'a' is now the most recently used entry, so 'b' goes first
+        index.touch("a");
+        std::vector<std::string> evicted = index.insert("d", entry, 300);
+        EXPECT_EQ(evicted.size(), 1u);
+        if (evicted.size() == 1) EXPECT_EQ(evicted[0], std::string("b"));
+        EXPECT(index.find("a") != nullptr);
+        EXPECT(index.find("b") == nullptr);
+
+        // Replacing an entry updates the total size instead of adding to it
+        entry.size = 50;
+        EXPECT_EQ(index.insert("c", entry, 300).size(), 0u);
+        EXPECT_EQ(index.getTotalSize(), 250u);
+
+        // An entry larger than the limit is rejected without flushing the rest of the cache
+        entry.size = 1000;
+        evicted = index.insert("e", entry, 300);
+        EXPECT_EQ(evicted.size(), 1u);
+        if (evicted.size() == 1) EXPECT_EQ(evicted[0], std::string("e"));
+        EXPECT_EQ(index.getCount(), 3u);
+        EXPECT_EQ(index.getTotalSize(), 250u);
+
+        // Shrinking the limit evicts in order of use: 'a' was touched before 'd' and 'c' were inserted
+        evicted = index.evict(100);
+        EXPECT_EQ(evicted.size(), 2u);
+        if (evicted.size() == 2)
+        {
+            EXPECT_EQ(evicted[0], std::string("a"));
+            EXPECT_EQ(evicted[1], std::string("d"));
+        }
+    }
+
+    CPU_TEST(DiskCacheIndexSerialize)
+    {
+        DiskCacheIndex index;
+        DiskCacheIndex::Entry entry;
+        entry.size = 123;
+        entry.dependencies = { { "C:/Media/Some Folder/texture.dds", 1234567 }, { "/media/normal.png", -1 } };
+        index.insert("0123456789abcdef", entry, ~0ull);
+        entry.dependencies.clear();
+        entry.size = 7;
+        index.insert("fedcba9876543210", entry, ~0ull);
+        index.touch("0123456789abcdef");
+
+        DiskCacheIndex copy;
+        EXPECT(copy.deserialize(index.serialize()));
+        EXPECT_EQ(copy.getCount(), 2u);
+        EXPECT_EQ(copy.getTotalSize(), 130u);
+
+        const DiskCacheIndex::Entry* pEntry = copy.find("0123456789abcdef");
+        EXPECT(pEntry != nullptr);
+        if (pEntry)
+        {
+            EXPECT_EQ(pEntry->dependencies.size(), 2u);
+            if (pEntry->dependencies.size() == 2)
+            {
+                EXPECT_EQ(pEntry->dependencies[0].first, std::string("C:/Media/Some Folder/texture.dds"));
+                EXPECT_EQ(pEntry->dependencies[0].second, 1234567);
+                EXPECT_EQ(pEntry->dependencies[1].second, -1);
+            }
+        }
+
+        // The order of use survives the round trip
+        std::vector<std::string> evicted = copy.evict(123);
+        EXPECT_EQ(evicted.size(), 1u);
+        if (evicted.size() == 1) EXPECT_EQ(evicted[0], std::string("fedcba9876543210"));
+
+        EXPECT(copy.deserialize("garbage") == false);
+        EXPECT_EQ(copy.getCount(), 0u);
+    }
+
+    CPU_TEST(DiskCacheIndexHash)
+    {
+        // FNV-1a test vectors for inputs shorter than a word
+        EXPECT_EQ(DiskCacheIndex::hash("", 0), 0xcbf29ce484222325ull);
+        EXPECT_EQ(DiskCacheIndex::hash("a", 1), 0xaf63dc4c8601ec8cull);
+
+        const char data[] = "The quick brown fox jumps over the lazy dog";
+        uint64_t full = DiskCacheIndex::hash(data, sizeof(data));
+        EXPECT_NE(full, DiskCacheIndex::hash(data, sizeof(data) - 1));
+        EXPECT_EQ(DiskCacheIndex::keyToString(0x0123456789abcdefull), std::string("0123456789abcdef"));
+        EXPECT_EQ(DiskCacheIndex::keyToString(full).size(), 16u);
+    }
+}
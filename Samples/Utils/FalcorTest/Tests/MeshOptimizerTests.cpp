@@ -0,0 +1,151 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kGridSize = 32;
+
+        /** Triangulated grid of kGridSize x kGridSize vertices, triangles in pseudo random order
+        */
+        void createShuffledGrid(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+        {
+            positions.clear();
+            indices.clear();
+            for (uint32_t y = 0; y < kGridSize; y++)
+            {
+                for (uint32_t x = 0; x < kGridSize; x++)
+                {
+                    positions.push_back(glm::vec3(float(x), float(y), 0.0f));
+                }
+            }
+
+            std::vector<glm::uvec3> triangles;
+            for (uint32_t y = 0; y + 1 < kGridSize; y++)
+            {
+                for (uint32_t x = 0; x + 1 < kGridSize; x++)
+                {
+                    uint32_t v = y * kGridSize + x;
+                    triangles.push_back(glm::uvec3(v, v + 1, v + kGridSize));
+                    triangles.push_back(glm::uvec3(v + 1, v + kGridSize + 1, v + kGridSize));
+                }
+            }
+
+            uint32_t seed = 12345;
+            for (size_t i = triangles.size() - 1; i > 0; i--)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                std::swap(triangles[i], triangles[(seed >> 8) % (i + 1)]);
+            }
+            for (const auto& t : triangles)
+            {
+                indices.insert(indices.end(), { t.x, t.y, t.z });
+            }
+        }
+
+        /** Triangles with their winding preserved, rotated to start at the smallest index and sorted
+        */
+        std::vector<glm::uvec3> getTriangleSet(const std::vector<uint32_t>& indices)
+        {
+            std::vector<glm::uvec3> triangles;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                glm::uvec3 t(indices[i], indices[i + 1], indices[i + 2]);
+                while (t.x > t.y || t.x > t.z) t = glm::uvec3(t.y, t.z, t.x);
+                triangles.push_back(t);
+            }
+            std::sort(triangles.begin(), triangles.end(), [](const glm::uvec3& a, const glm::uvec3& b)
+            {
+                return (a.x != b.x) ? a.x < b.x : (a.y != b.y) ? a.y < b.y : a.z < b.z;
+            });
+            return triangles;
+        }
+    }
+
+    CPU_TEST(MeshOptimizerAnalyze)
+    {
+        // Two triangles sharing an edge transform four vertices
+        const uint32_t indices[] = { 0, 1, 2, 2, 1, 3 };
+        MeshOptimizer::VertexCacheStats stats = MeshOptimizer::analyzeVertexCache(indices, arraysize(indices), 4);
+        EXPECT_EQ(stats.transformedCount, 4u);
+        EXPECT_EQ(stats.triangleCount, 2u);
+        EXPECT_EQ(stats.vertexCount, 4u);
+        EXPECT_EQ(stats.getAcmr(), 2.0f);
+        EXPECT_EQ(stats.getAtvr(), 1.0f);
+
+        // With a single cache entry every index but the repeated one in the middle misses
+        stats = MeshOptimizer::analyzeVertexCache(indices, arraysize(indices), 4, 1);
+        EXPECT_EQ(stats.transformedCount, 5u);
+    }
+
+    CPU_TEST(MeshOptimizerVertexCache)
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        createShuffledGrid(positions, indices);
+        const uint32_t vertexCount = (uint32_t)positions.size();
+        std::vector<glm::uvec3> triangleSet = getTriangleSet(indices);
+
+        MeshOptimizer::VertexCacheStats before = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+        MeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+        MeshOptimizer::VertexCacheStats after = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+        // A random order transforms almost every vertex of every triangle, a regular grid can get close to 0.5
+        EXPECT_GT(before.getAcmr(), 2.5f);
+        EXPECT_LT(after.getAcmr(), 0.8f);
+        EXPECT_LT(after.getAtvr(), 1.5f);
+        EXPECT(getTriangleSet(indices) == triangleSet);
+
+        // Reordering the clusters keeps the triangles and most of the cache efficiency
+        MeshOptimizer::optimizeOverdraw(indices.data(), indices.size(), &positions[0].x, sizeof(glm::vec3), vertexCount);
+        MeshOptimizer::VertexCacheStats sorted = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+        EXPECT_LT(sorted.getAcmr(), after.getAcmr() * 1.2f);
+        EXPECT(getTriangleSet(indices) == triangleSet);
+    }
+
+    CPU_TEST(MeshOptimizerVertexFetch)
+    {
+        // Vertex 2 is unreferenced
+        std::vector<uint32_t> indices = { 4, 3, 0, 0, 3, 1 };
+        std::vector<uint32_t> remap = MeshOptimizer::optimizeVertexFetch(indices.data(), indices.size(), 5);
+        const std::vector<uint32_t> expected = { 2, 3, 4, 1, 0 };
+        EXPECT(remap == expected);
+
+        MeshOptimizer::remapIndices(indices.data(), indices.size(), remap);
+        const std::vector<uint32_t> expectedIndices = { 0, 1, 2, 2, 1, 3 };
+        EXPECT(indices == expectedIndices);
+
+        std::vector<float> vertices = { 10, 11, 12, 13, 14 };
+        MeshOptimizer::remapVertices(vertices.data(), sizeof(float), remap);
+        const std::vector<float> expectedVertices = { 14, 13, 10, 11, 12 };
+        EXPECT(vertices == expectedVertices);
+    }
+}
@@ -0,0 +1,138 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Sphere made of a subdivided octahedron, without seams
+        */
+        void createSphere(uint32_t subdivisions, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+        {
+            positions = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+            indices = { 0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5 };
+
+            for (uint32_t s = 0; s < subdivisions; s++)
+            {
+                std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+                auto getMidpoint = [&](uint32_t a, uint32_t b)
+                {
+                    auto key = std::make_pair(std::min(a, b), std::max(a, b));
+                    auto it = midpoints.find(key);
+                    if (it != midpoints.end()) return it->second;
+                    positions.push_back(glm::normalize(positions[a] + positions[b]));
+                    uint32_t v = (uint32_t)positions.size() - 1;
+                    midpoints[key] = v;
+                    return v;
+                };
+
+                std::vector<uint32_t> subdivided;
+                for (size_t t = 0; t < indices.size(); t += 3)
+                {
+                    uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+                    uint32_t ab = getMidpoint(a, b), bc = getMidpoint(b, c), ca = getMidpoint(c, a);
+                    subdivided.insert(subdivided.end(), { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca });
+                }
+                indices = subdivided;
+            }
+        }
+
+        float getArea(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, bool& flipped)
+        {
+            float area = 0.0f;
+            flipped = false;
+            for (size_t t = 0; t < indices.size(); t += 3)
+            {
+                glm::vec3 n = glm::cross(positions[indices[t + 1]] - positions[indices[t]], positions[indices[t + 2]] - positions[indices[t]]);
+                area += 0.5f * glm::length(n);
+                flipped |= (n.z <= 0.0f);
+            }
+            return area;
+        }
+    }
+
+    // A flat grid can be simplified without error, the open border has to keep its shape
+    CPU_TEST(MeshSimplifierPlane)
+    {
+        const uint32_t kSize = 16;
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        for (uint32_t y = 0; y < kSize; y++)
+        {
+            for (uint32_t x = 0; x < kSize; x++)
+            {
+                positions.push_back(glm::vec3(float(x), float(y), 0.0f));
+                if (x + 1 < kSize && y + 1 < kSize)
+                {
+                    uint32_t v = y * kSize + x;
+                    indices.insert(indices.end(), { v, v + 1, v + kSize, v + 1, v + kSize + 1, v + kSize });
+                }
+            }
+        }
+
+        float error = -1.0f;
+        std::vector<uint32_t> simplified = MeshSimplifier::simplify(indices.data(), indices.size(), &positions[0].x, sizeof(glm::vec3), (uint32_t)positions.size(), {}, 12, 0.01f, &error);
+        EXPECT_LE(simplified.size(), indices.size() / 8);
+        EXPECT_LT(error, 1e-3f);
+
+        bool flipped = true;
+        float area = getArea(positions, simplified, flipped);
+        EXPECT_LT(std::abs(area - float((kSize - 1) * (kSize - 1))), 1e-2f);
+        EXPECT(flipped == false);
+    }
+
+    CPU_TEST(MeshSimplifierLodChain)
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        createSphere(4, positions, indices);
+
+        std::vector<MeshSimplifier::Lod> lods = MeshSimplifier::generateLods(indices.data(), indices.size(), &positions[0].x, sizeof(glm::vec3), (uint32_t)positions.size(), {}, 4, 32, 0.2f);
+        EXPECT_EQ(lods.size(), 4u);
+
+        size_t previousCount = indices.size();
+        float previousError = 0.0f;
+        for (const auto& lod : lods)
+        {
+            // Every level removes at least a quarter of the triangles and the error grows along the chain
+            EXPECT_LE(lod.indices.size(), previousCount * 3 / 4);
+            EXPECT_GE(lod.error, previousError);
+            EXPECT_LT(lod.error, 0.4f);     // Twice the relative limit, the sphere has a diameter of 2
+            for (uint32_t index : lod.indices) EXPECT_LT(index, (uint32_t)positions.size());
+            previousCount = lod.indices.size();
+            previousError = lod.error;
+        }
+        if (lods.size() == 4) EXPECT_LE(lods[3].indices.size(), indices.size() / 16 + 3);
+
+        // A tight error limit stops the chain early
+        std::vector<MeshSimplifier::Lod> tightLods = MeshSimplifier::generateLods(indices.data(), indices.size(), &positions[0].x, sizeof(glm::vec3), (uint32_t)positions.size(), {}, 4, 32, 0.01f);
+        EXPECT_LT(tightLods.size(), lods.size());
+    }
+}
@@ -0,0 +1,100 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+namespace Falcor
+{
+    CPU_TEST(ProgramCompilerJobs)
+    {
+        std::atomic<uint32_t> counter(0);
+        std::vector<ProgramCompiler::Job::SharedPtr> jobs;
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            jobs.push_back(ProgramCompiler::submit([&counter]() { counter++; }));
+        }
+
+        // Waiting for a single job works whether a worker took it or not
+        jobs[40]->wait();
+        EXPECT(jobs[40]->isReady());
+
+        ProgramCompiler::waitIdle();
+        EXPECT_EQ(counter.load(), 64u);
+        for (const auto& pJob : jobs) EXPECT(pJob->isReady());
+        EXPECT_EQ(ProgramCompiler::getStats().pending, 0u);
+    }
+
+    CPU_TEST(ProgramCompilerManifest)
+    {
+        const std::string program = "ProgramCompilerTest.slang:main";
+        ProgramCompiler::DefineList defines;
+        defines.add("_FLAG").add("_VALUE", "3");
+        ProgramCompiler::DefineList unwritable;
+        unwritable.add("_VALUE", "a b");
+
+        ProgramCompiler::recordVariant(program, defines);
+        ProgramCompiler::recordVariant(program, ProgramCompiler::DefineList());
+        ProgramCompiler::recordVariant(program, defines);
+        ProgramCompiler::recordVariant(program, unwritable);
+        EXPECT_EQ(ProgramCompiler::getManifestVariants(program).size(), 2u);
+
+        std::string filename = getExecutableDirectory() + "/ProgramCompilerTest.txt";
+        EXPECT(ProgramCompiler::saveManifest(filename));
+
+        // Loading replaces the variants of the listed programs
+        ProgramCompiler::DefineList other;
+        other.add("_OTHER");
+        ProgramCompiler::recordVariant(program, other);
+        EXPECT(ProgramCompiler::loadManifest(filename));
+        auto variants = ProgramCompiler::getManifestVariants(program);
+        EXPECT_EQ(variants.size(), 2u);
+        EXPECT(std::find(variants.begin(), variants.end(), defines) != variants.end());
+        EXPECT(std::find(variants.begin(), variants.end(), other) == variants.end());
+        std::remove(filename.c_str());
+    }
+
+    GPU_TEST(ProgramPrewarm)
+    {
+        ComputeProgram::SharedPtr pProgram = ComputeProgram::createFromFile("ShadingUtilsTests.cs.slang", "testRand");
+        EXPECT(pProgram->getActiveVersion() != nullptr);
+
+        Program::DefineList defines = pProgram->getDefines();
+        defines.add("_PROGRAM_PREWARM_TEST");
+        pProgram->prewarm(defines);
+        ProgramCompiler::waitIdle();
+
+        // The prewarmed variant is installed without compiling
+        uint32_t waits = ProgramCompiler::getStats().waits;
+        pProgram->setDefines(defines);
+        EXPECT(pProgram->getActiveVersion() != nullptr);
+        EXPECT(pProgram->isActiveVersionReady());
+        EXPECT_EQ(ProgramCompiler::getStats().waits, waits);
+    }
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <random>
+
+namespace Falcor
+{
+    // All SIMD paths have to produce exactly the same bounds as the scalar code. The odd image size covers partial border tiles.
+    CPU_TEST(QuadBoundsReductionSimd)
+    {
+        const uint32_t width = 333;
+        const uint32_t height = 171;
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::vector<float> depth(width * height);
+        std::vector<glm::vec4> normals(width * height);
+        for (uint32_t i = 0; i < width * height; i++)
+        {
+            depth[i] = dist(rng);
+            normals[i] = glm::vec4(dist(rng), dist(rng), dist(rng), 100.f);
+        }
+
+        QuadBoundsReduction::UniquePtr pReduction = QuadBoundsReduction::create(WorkStealingPool::create(4), QuadBoundsReduction::SimdLevel::Scalar);
+        std::vector<QuadBoundsReduction::Bounds> reference;
+        pReduction->reduce(depth.data(), normals.data(), width, height, reference);
+        EXPECT_EQ(reference.size(), 21u * 11u);
+
+        const uint32_t maxLevel = (uint32_t)QuadBoundsReduction::getSupportedSimdLevel();
+        for (uint32_t level = 0; level <= maxLevel; level++)
+        {
+            pReduction->setSimdLevel((QuadBoundsReduction::SimdLevel)level);
+            std::vector<QuadBoundsReduction::Bounds> result;
+            pReduction->reduce(depth.data(), normals.data(), width, height, result);
+            for (size_t i = 0; i < reference.size(); i++)
+            {
+                EXPECT_EQ(result[i].minDepth, reference[i].minDepth) << "level = " << level << ", tile = " << i;
+                EXPECT_EQ(result[i].maxDepth, reference[i].maxDepth) << "level = " << level << ", tile = " << i;
+                EXPECT(result[i].minNormal == reference[i].minNormal) << "level = " << level << ", tile = " << i;
+                EXPECT(result[i].maxNormal == reference[i].maxNormal) << "level = " << level << ", tile = " << i;
+            }
+        }
+
+        // The last tile column reaches past the border, the missing texels read as 0
+        const QuadBoundsReduction::Bounds& border = reference[20];
+        EXPECT_LE(border.minDepth, 0.f);
+        EXPECT_GE(border.maxDepth, 0.f);
+    }
+
+    CPU_TEST(WorkStealingPoolCoverage)
+    {
+        WorkStealingPool::SharedPtr pPool = WorkStealingPool::create(4);
+        const uint32_t count = 10000;
+        std::vector<std::atomic<uint32_t>> hits(count);
+        for (auto& h : hits) h = 0;
+
+        for (uint32_t grainSize : { 1u, 7u, 64u, count })
+        {
+            pPool->parallelFor(count, grainSize, [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; i++) hits[i]++;
+            });
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            EXPECT_EQ(hits[i].load(), 4u) << "i = " << i;
+        }
+    }
+}  // namespace Falcor
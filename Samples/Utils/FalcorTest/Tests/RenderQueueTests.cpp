@@ -0,0 +1,149 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <random>
+
+namespace Falcor
+{
+    // Fields have to survive packing and compare in the order program, material, geometry, depth
+    CPU_TEST(RenderQueueKey)
+    {
+        uint64_t key = RenderQueue::makeKey(3, 1000, 70000, 12345);
+        EXPECT_EQ(RenderQueue::getProgram(key), 3u);
+        EXPECT_EQ(RenderQueue::getMaterial(key), 1000u);
+        EXPECT_EQ(RenderQueue::getGeometry(key), 70000u);
+        EXPECT_EQ(RenderQueue::getDepth(key), 12345u);
+
+        // Out of range indices are clamped instead of overflowing into the next field
+        uint64_t clamped = RenderQueue::makeKey(0, 1u << 20, 0, 0);
+        EXPECT_EQ(RenderQueue::getProgram(clamped), 0u);
+        EXPECT_EQ(RenderQueue::getMaterial(clamped), (1u << RenderQueue::kMaterialBits) - 1);
+
+        EXPECT_LT(RenderQueue::makeKey(0, 9, 9, 9), RenderQueue::makeKey(1, 0, 0, 0));
+        EXPECT_LT(RenderQueue::makeKey(1, 0, 9, 9), RenderQueue::makeKey(1, 1, 0, 0));
+        EXPECT_LT(RenderQueue::makeKey(1, 1, 0, 9), RenderQueue::makeKey(1, 1, 1, 0));
+
+        EXPECT_EQ(RenderQueue::quantizeDepth(-1.f), 0u);
+        EXPECT_EQ(RenderQueue::quantizeDepth(2.f), (1u << RenderQueue::kDepthBits) - 1);
+        EXPECT_LT(RenderQueue::quantizeDepth(0.25f), RenderQueue::quantizeDepth(0.5f));
+    }
+
+    // Refreshing the depth and resorting has to give the same order as a full sort
+    CPU_TEST(RenderQueueResort)
+    {
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<uint32_t> state(0, 3);
+        std::uniform_real_distribution<float> depth(0.f, 1.f);
+
+        RenderQueue queue;
+        for (uint32_t i = 0; i < 500; i++)
+        {
+            uint32_t program = state(rng);
+            queue.add(RenderQueue::makeKey(program, state(rng), state(rng), 0), program, i, 0, 0);
+        }
+        queue.sort();
+        for (uint32_t i = 1; i < queue.getDrawCount(); i++)
+        {
+            EXPECT(queue.getDraw(i - 1).key <= queue.getDraw(i).key) << "draw " << i;
+        }
+
+        // Draws with equal keys stay in the order they were added in
+        for (uint32_t i = 1; i < queue.getDrawCount(); i++)
+        {
+            if (queue.getDraw(i - 1).key == queue.getDraw(i).key)
+            {
+                EXPECT_LT(queue.getDraw(i - 1).modelID, queue.getDraw(i).modelID);
+            }
+        }
+        uint32_t programChanges = queue.getChangeCount(RenderQueue::kProgramMask);
+        EXPECT(programChanges <= 4u);
+
+        // Depth only reorders draws within their state group
+        for (uint32_t frame = 0; frame < 3; frame++)
+        {
+            for (uint32_t i = 0; i < queue.getDrawCount(); i++)
+            {
+                queue.setDepth(i, RenderQueue::quantizeDepth(depth(rng)));
+            }
+            RenderQueue reference = queue;
+            reference.sort();
+            queue.resort();
+
+            for (uint32_t i = 0; i < queue.getDrawCount(); i++)
+            {
+                EXPECT_EQ(queue.getDraw(i).key, reference.getDraw(i).key) << "draw " << i;
+            }
+            EXPECT_EQ(queue.getChangeCount(RenderQueue::kProgramMask), programChanges);
+        }
+
+        // A sorted list doesn't move
+        EXPECT_EQ(queue.resort(), 0u);
+    }
+
+    // Reversing a large group exceeds the insertion sort's budget, the full sort fallback has to give the same order
+    CPU_TEST(RenderQueueResortReversed)
+    {
+        RenderQueue queue;
+        for (uint32_t i = 0; i < 300; i++)
+        {
+            uint32_t program = i / 100;
+            queue.add(RenderQueue::makeKey(program, 0, 0, RenderQueue::quantizeDepth(float(i % 100) / 100.f)), program, i, 0, 0);
+        }
+        queue.sort();
+
+        for (uint32_t i = 0; i < queue.getDrawCount(); i++)
+        {
+            queue.setDepth(i, RenderQueue::quantizeDepth(1.f - float(i % 100) / 100.f));
+        }
+        RenderQueue reference = queue;
+        reference.sort();
+        EXPECT_EQ(queue.resort(), 297u);
+        for (uint32_t i = 0; i < queue.getDrawCount(); i++)
+        {
+            EXPECT_EQ(queue.getDraw(i).key, reference.getDraw(i).key) << "draw " << i;
+            EXPECT_EQ(queue.getDraw(i).modelID, reference.getDraw(i).modelID) << "draw " << i;
+        }
+        EXPECT_EQ(queue.getChangeCount(RenderQueue::kProgramMask), 3u);
+    }
+
+    // Program indices beyond the key's field share its last value for sorting, the draw still knows its own program
+    CPU_TEST(RenderQueueProgramOverflow)
+    {
+        const uint32_t maxProgram = (1u << RenderQueue::kProgramBits) - 1;
+        RenderQueue queue;
+        queue.add(RenderQueue::makeKey(maxProgram + 5, 0, 0, 0), maxProgram + 5, 0, 0, 0);
+        queue.add(RenderQueue::makeKey(maxProgram, 0, 0, 0), maxProgram, 1, 0, 0);
+        queue.add(RenderQueue::makeKey(0, 0, 0, 0), 0, 2, 0, 0);
+        queue.sort();
+
+        EXPECT_EQ(queue.getDraw(0).program, 0u);
+        EXPECT_EQ(queue.getDraw(1).program, maxProgram + 5);
+        EXPECT_EQ(queue.getDraw(2).program, maxProgram);
+        EXPECT_EQ(RenderQueue::getProgram(queue.getDraw(1).key), maxProgram);
+    }
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <fstream>
+
+namespace Falcor
+{
+    static void writeTextFile(const std::string& filename, const std::string& text)
+    {
+        std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+        stream << text;
+    }
+
+    CPU_TEST(ShaderCacheEntries)
+    {
+        std::string oldDirectory = ShaderCache::getDirectory();
+        std::string directory = getExecutableDirectory() + "/ShaderCacheTest";
+        ShaderCache::setDirectory(directory);
+        ShaderCache::clear();
+
+        std::string source = directory + "/source.slang";
+        writeTextFile(source, "float4 main() : SV_TARGET { return 1; }");
+
+        ShaderCache::Entry entry;
+        entry.code[(uint32_t)ShaderType::Pixel] = std::string("code\0with\0zeros", 15);
+        entry.reflection = "reflection";
+        entry.dependencies = { source };
+
+        ShaderCache::Entry loaded;
+        EXPECT(ShaderCache::load("00000000000000a1", loaded) == false);
+        ShaderCache::store("00000000000000a1", entry, 0);
+        EXPECT(ShaderCache::load("00000000000000a1", loaded));
+        EXPECT(loaded.code[(uint32_t)ShaderType::Pixel] == entry.code[(uint32_t)ShaderType::Pixel]);
+        EXPECT(loaded.code[(uint32_t)ShaderType::Vertex].empty());
+        EXPECT(loaded.reflection == entry.reflection);
+        EXPECT(loaded.dependencies == entry.dependencies);
+
+        // Blobs hand out a copy of the code
+        Shader::Blob blob = ShaderCache::createBlob(loaded.code[(uint32_t)ShaderType::Pixel]);
+        EXPECT_EQ(blob->getBufferSize(), 15u);
+        EXPECT(std::string((const char*)blob->getBufferPointer(), blob->getBufferSize()) == entry.code[(uint32_t)ShaderType::Pixel]);
+
+        // Changing a dependency invalidates the entry
+        writeTextFile(source, "float4 main() : SV_TARGET { return 0; }");
+        EXPECT(ShaderCache::load("00000000000000a1", loaded) == false);
+        EXPECT_EQ(ShaderCache::getStats().entryCount, 0u);
+
+        // A damaged file is rejected rather than handed to the driver
+        ShaderCache::store("00000000000000a2", entry, 0);
+        std::string data = readFile(directory + "/00000000000000a2.bin");
+        data[data.size() / 2] ^= 1;
+        writeTextFile(directory + "/00000000000000a2.bin", data);
+        EXPECT(ShaderCache::load("00000000000000a2", loaded) == false);
+
+        ShaderCache::clear();
+        std::remove(source.c_str());
+        ShaderCache::setDirectory(oldDirectory);
+    }
+
+    GPU_TEST(ProgramReflectionSerialize)
+    {
+        ComputeProgram::SharedPtr pProgram = ComputeProgram::createFromFile("ShadingUtilsTests.cs.slang", "testRand");
+        ProgramReflection::SharedConstPtr pReflector = pProgram->getReflector();
+        EXPECT(pReflector != nullptr);
+        if (pReflector == nullptr) return;
+
+        std::string data;
+        pReflector->serialize(data);
+        size_t offset = 0;
+        ProgramReflection::SharedPtr pCopy = ProgramReflection::deserialize(data, offset);
+        EXPECT(pCopy != nullptr);
+        if (pCopy == nullptr) return;
+        EXPECT_EQ(offset, data.size());
+        EXPECT(pCopy->getThreadGroupSize() == pReflector->getThreadGroupSize());
+        EXPECT_EQ(pCopy->getParameterBlockCount(), pReflector->getParameterBlockCount());
+
+        for (uint32_t b = 0; b < (uint32_t)std::min(pCopy->getParameterBlockCount(), pReflector->getParameterBlockCount()); b++)
+        {
+            const auto& pBlock = pReflector->getParameterBlock(b);
+            const auto& pCopyBlock = pCopy->getParameterBlock(b);
+            EXPECT(pBlock->getName() == pCopyBlock->getName());
+            EXPECT(*pBlock == *pCopyBlock);
+            EXPECT_EQ(pBlock->getResourceVec().size(), pCopyBlock->getResourceVec().size());
+            EXPECT_EQ(pBlock->getDescriptorSetLayouts().size(), pCopyBlock->getDescriptorSetLayouts().size());
+            for (const auto& res : pBlock->getResourceVec())
+            {
+                auto loc = pBlock->getResourceBinding(res.name);
+                auto copyLoc = pCopyBlock->getResourceBinding(res.name);
+                EXPECT_EQ(loc.setIndex, copyLoc.setIndex);
+                EXPECT_EQ(loc.rangeIndex, copyLoc.rangeIndex);
+            }
+        }
+
+        // Truncated data must not produce an object
+        std::string truncated = data.substr(0, data.size() - 1);
+        offset = 0;
+        EXPECT(ProgramReflection::deserialize(truncated, offset) == nullptr);
+    }
+}
@@ -0,0 +1,182 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        glm::mat4 getViewProj(const glm::vec3& eye, const glm::vec3& forward)
+        {
+            glm::mat4 proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+            return proj * glm::lookAt(eye, eye + forward, glm::vec3(0, 1, 0));
+        }
+
+        // Axis aligned quad facing the z axis
+        void addQuad(SoftwareOcclusionCuller& culler, const glm::vec2& min, const glm::vec2& max, float z)
+        {
+            const glm::vec3 positions[4] = { glm::vec3(min.x, min.y, z), glm::vec3(max.x, min.y, z), glm::vec3(max.x, max.y, z), glm::vec3(min.x, max.y, z) };
+            const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+            culler.addOccluder(positions, 4, indices, 6, glm::mat4(1.0f));
+        }
+
+        BoundingBox makeBox(const glm::vec3& center, float extent)
+        {
+            BoundingBox box;
+            box.center = center;
+            box.extent = glm::vec3(extent);
+            return box;
+        }
+    }
+
+    CPU_TEST(SoftwareOcclusionCullerWall)
+    {
+        SoftwareOcclusionCuller::SharedPtr pCuller = SoftwareOcclusionCuller::create(320, 180);
+        EXPECT_EQ(pCuller->getWidth(), 320u);
+        EXPECT_EQ(pCuller->getHeight(), 192u);
+
+        glm::mat4 viewProj = getViewProj(glm::vec3(0.f), glm::vec3(0, 0, -1));
+        pCuller->beginFrame(&viewProj, 1);
+        addQuad(*pCuller, glm::vec2(-2.f), glm::vec2(2.f), -10.f);
+        pCuller->rasterize();
+        EXPECT_EQ(pCuller->getStats().triangleCount, 2u);
+
+        EXPECT_EQ((uint32_t)pCuller->testBox(makeBox(glm::vec3(0.f, 0.f, -20.f), 0.5f)), 0u) << "behind the wall";
+        EXPECT_EQ((uint32_t)pCuller->testBox(makeBox(glm::vec3(0.f, 0.f, -5.f), 0.5f)), 1u) << "in front of the wall";
+        EXPECT_EQ((uint32_t)pCuller->testBox(makeBox(glm::vec3(0.f, 0.f, -10.f), 0.5f)), 1u) << "intersecting the wall";
+        EXPECT_EQ((uint32_t)pCuller->testBox(makeBox(glm::vec3(8.f, 0.f, -20.f), 0.5f)), 1u) << "beside the wall";
+        EXPECT_EQ((uint32_t)pCuller->testBox(makeBox(glm::vec3(0.f, 0.f, -20.f), 6.f)), 1u) << "larger than the wall";
+        EXPECT_EQ((uint32_t)pCuller->testBox(makeBox(glm::vec3(0.f, 0.f, 0.f), 0.5f)), 1u) << "crossing the near plane";
+
+        // The wall's own bounds are never occluded by the wall
+        EXPECT_EQ((uint32_t)pCuller->testBox(BoundingBox::fromMinMax(glm::vec3(-2.f, -2.f, -10.f), glm::vec3(2.f, 2.f, -10.f))), 1u);
+
+        // Tiles in the middle are covered by the wall, corners are not
+        const uint32_t centerX = pCuller->getTileCountX() / 2;
+        const uint32_t centerY = pCuller->getTileCountY() / 2;
+        EXPECT_LT(pCuller->getTileDepth(0, centerX, centerY), 1.f);
+        EXPECT_EQ(pCuller->getTileDepth(0, 0, 0), 1.f);
+
+        // Triangles crossing the near plane are skipped
+        pCuller->beginFrame(&viewProj, 1);
+        addQuad(*pCuller, glm::vec2(-2.f), glm::vec2(2.f), 1.f);
+        pCuller->rasterize();
+        EXPECT_EQ(pCuller->getStats().skippedTriangleCount, 2u);
+        EXPECT_EQ((uint32_t)pCuller->testBox(makeBox(glm::vec3(0.f, 0.f, -20.f), 0.5f)), 1u);
+    }
+
+    // A pillar in front of the left eye hides a box from the left eye only
+    CPU_TEST(SoftwareOcclusionCullerStereo)
+    {
+        SoftwareOcclusionCuller::SharedPtr pCuller = SoftwareOcclusionCuller::create();
+        const glm::vec3 forward(0, 0, -1);
+        glm::mat4 viewProj[2] = { getViewProj(glm::vec3(-1.f, 0.f, 0.f), forward), getViewProj(glm::vec3(1.f, 0.f, 0.f), forward) };
+        pCuller->beginFrame(viewProj, 2);
+        addQuad(*pCuller, glm::vec2(-1.5f, -3.f), glm::vec2(-0.5f, 3.f), -5.f);
+        pCuller->rasterize();
+
+        const BoundingBox box = makeBox(glm::vec3(-1.f, 0.f, -20.f), 0.2f);
+        EXPECT_EQ((uint32_t)pCuller->testBox(box), (uint32_t)StereoFrustumCuller::kVisibleRight);
+
+        std::vector<BoundingBox> boxes = { box, box, box, box };
+        std::vector<uint8_t> masks = { StereoFrustumCuller::kVisibleBoth, StereoFrustumCuller::kVisibleLeft, StereoFrustumCuller::kVisibleRight, 0 };
+        EXPECT_EQ(pCuller->testBoxes(boxes, masks), 1u);
+        EXPECT_EQ((uint32_t)masks[0], (uint32_t)StereoFrustumCuller::kVisibleRight);
+        EXPECT_EQ((uint32_t)masks[1], 0u);
+        EXPECT_EQ((uint32_t)masks[2], (uint32_t)StereoFrustumCuller::kVisibleRight);
+        EXPECT_EQ((uint32_t)masks[3], 0u);
+        EXPECT_EQ(pCuller->getStats().testedBoxCount, 3u);
+        EXPECT_EQ(pCuller->getStats().occludedBoxCount, 1u);
+    }
+
+    // The SSE path and band parallel rasterization have to give exactly the serial scalar results
+    CPU_TEST(SoftwareOcclusionCullerSimdParallel)
+    {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> position(-15.f, 15.f);
+        std::uniform_real_distribution<float> depth(-40.f, -2.f);
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i < 300; i++)
+        {
+            glm::vec3 center(position(rng), position(rng) * 0.5f, depth(rng));
+            for (uint32_t v = 0; v < 3; v++)
+            {
+                indices.push_back((uint32_t)positions.size());
+                positions.push_back(center + glm::vec3(position(rng), position(rng), position(rng)) * 0.3f);
+            }
+        }
+
+        std::vector<BoundingBox> boxes;
+        for (uint32_t i = 0; i < 2000; i++)
+        {
+            boxes.push_back(makeBox(glm::vec3(position(rng), position(rng) * 0.5f, depth(rng) * 2.f), 0.2f));
+        }
+
+        glm::mat4 viewProj[2] = { getViewProj(glm::vec3(-0.032f, 0.f, 0.f), glm::vec3(0, 0, -1)), getViewProj(glm::vec3(0.032f, 0.f, 0.f), glm::vec3(0, 0, -1)) };
+        SoftwareOcclusionCuller::SharedPtr pSerial = SoftwareOcclusionCuller::create();
+        SoftwareOcclusionCuller::SharedPtr pParallel = SoftwareOcclusionCuller::create(320, 192, WorkStealingPool::create(4));
+        pSerial->setSimdEnabled(false);
+
+        std::vector<uint8_t> serialMasks(boxes.size(), StereoFrustumCuller::kVisibleBoth);
+        std::vector<uint8_t> parallelMasks(boxes.size(), StereoFrustumCuller::kVisibleBoth);
+        for (auto& pCuller : { pSerial, pParallel })
+        {
+            pCuller->beginFrame(viewProj, 2);
+            pCuller->addOccluder(positions.data(), (uint32_t)positions.size(), indices.data(), (uint32_t)indices.size(), glm::mat4(1.0f));
+            pCuller->rasterize();
+            pCuller->testBoxes(boxes, pCuller == pSerial ? serialMasks : parallelMasks);
+        }
+
+        uint32_t coveredTiles = 0;
+        for (uint32_t v = 0; v < 2; v++)
+        {
+            for (uint32_t y = 0; y < pSerial->getTileCountY(); y++)
+            {
+                for (uint32_t x = 0; x < pSerial->getTileCountX(); x++)
+                {
+                    EXPECT_EQ(pParallel->getTileDepth(v, x, y), pSerial->getTileDepth(v, x, y)) << "view " << v << " tile " << x << ", " << y;
+                    if (pSerial->getTileDepth(v, x, y) < 1.f) coveredTiles++;
+                }
+            }
+        }
+
+        uint32_t occluded = 0;
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            EXPECT_EQ((uint32_t)parallelMasks[i], (uint32_t)serialMasks[i]) << "box " << i;
+            EXPECT_EQ((uint32_t)serialMasks[i], (uint32_t)pSerial->testBox(boxes[i])) << "box " << i;
+            if (serialMasks[i] != StereoFrustumCuller::kVisibleBoth) occluded++;
+        }
+        // The random scene has to exercise both outcomes
+        EXPECT_GT(coveredTiles, 0u);
+        EXPECT_GT(occluded, 0u);
+        EXPECT_LT(occluded, (uint32_t)boxes.size());
+    }
+}
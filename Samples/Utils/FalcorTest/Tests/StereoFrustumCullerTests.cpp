@@ -0,0 +1,147 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        const float kEyeOffset = 0.032f;
+
+        glm::mat4 getEyeViewProj(const glm::vec3& center, const glm::vec3& forward, float eyeOffset)
+        {
+            glm::mat4 proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+            glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0, 1, 0)));
+            glm::vec3 eye = center + right * eyeOffset;
+            return proj * glm::lookAt(eye, eye + forward, glm::vec3(0, 1, 0));
+        }
+
+        // Two separate six plane tests, the way Camera::isObjectCulled() is used once per eye
+        uint8_t getReferenceMask(const glm::mat4& leftViewProj, const glm::mat4& rightViewProj, const BoundingBox& box)
+        {
+            uint8_t mask = 0;
+            const glm::mat4* viewProj[2] = { &leftViewProj, &rightViewProj };
+            for (uint32_t eye = 0; eye < 2; eye++)
+            {
+                glm::mat4 tempMat = glm::transpose(*viewProj[eye]);
+                bool isInside = true;
+                for (int i = 0; i < 6; i++)
+                {
+                    glm::vec4 plane = (i & 1) ? tempMat[i >> 1] : -tempMat[i >> 1];
+                    if (i != 5) plane += tempMat[3];
+                    glm::vec3 n = glm::vec3(plane);
+                    float dr = glm::dot(box.center, n) + glm::dot(box.extent, glm::abs(n));
+                    isInside = isInside && (dr > -plane.w);
+                }
+                if (isInside) mask |= (1 << eye);
+            }
+            return mask;
+        }
+
+        void addRandomBoxes(StereoFrustumCuller::Batch& batch, std::vector<BoundingBox>& boxes, uint32_t count)
+        {
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<float> position(-30.f, 30.f);
+            std::uniform_real_distribution<float> size(0.01f, 2.f);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                BoundingBox box;
+                box.center = glm::vec3(position(rng), position(rng) * 0.5f, position(rng));
+                box.extent = glm::vec3(size(rng), size(rng), size(rng));
+                boxes.push_back(box);
+                batch.add(box);
+            }
+        }
+    }
+
+    // With parallel eyes, top, bottom, near and far are shared and the merged test has to match two independent per-eye tests
+    CPU_TEST(StereoFrustumCullerMatchesPerEye)
+    {
+        const glm::vec3 forward(0, 0, -1);
+        glm::mat4 left = getEyeViewProj(glm::vec3(0.f), forward, -kEyeOffset);
+        glm::mat4 right = getEyeViewProj(glm::vec3(0.f), forward, kEyeOffset);
+
+        StereoFrustumCuller culler;
+        culler.setFrustums(left, right);
+        EXPECT_EQ(culler.getSharedPlaneCount(), 4u);
+
+        StereoFrustumCuller::Batch batch;
+        std::vector<BoundingBox> boxes;
+        addRandomBoxes(batch, boxes, 1001);
+
+        std::vector<uint8_t> masks;
+        culler.cull(batch, masks, false);
+        EXPECT_EQ(masks.size(), boxes.size());
+
+        uint32_t counts[4] = { 0, 0, 0, 0 };
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            EXPECT_EQ((uint32_t)masks[i], (uint32_t)getReferenceMask(left, right, boxes[i])) << "box " << i;
+            EXPECT_EQ((uint32_t)masks[i], (uint32_t)culler.cull(boxes[i])) << "box " << i;
+            counts[masks[i]]++;
+        }
+        // The random set has to cover culled and visible boxes
+        EXPECT(counts[0] > 0 && counts[StereoFrustumCuller::kVisibleBoth] > 0);
+
+        // Just outside the right edge of the left eye but inside the right eye
+        const float tanHalfFovX = std::tan(glm::radians(30.f)) * 16.f / 9.f;
+        BoundingBox rightOnly;
+        rightOnly.center = glm::vec3(tanHalfFovX * 10.f + 0.032f, 0.f, -10.f);
+        rightOnly.extent = glm::vec3(0.01f);
+        EXPECT_EQ((uint32_t)culler.cull(rightOnly), (uint32_t)StereoFrustumCuller::kVisibleRight);
+
+        BoundingBox behind;
+        behind.center = glm::vec3(0.f, 0.f, 5.f);
+        behind.extent = glm::vec3(1.f);
+        EXPECT_EQ((uint32_t)culler.cull(behind), 0u);
+    }
+
+    // The SSE path has to give exactly the scalar results, also for a rotated camera and a batch size that is not a multiple of 4
+    CPU_TEST(StereoFrustumCullerSimd)
+    {
+        const glm::vec3 center(3.f, 1.5f, -2.f);
+        const glm::vec3 forward = glm::normalize(glm::vec3(0.4f, -0.2f, -1.f));
+        StereoFrustumCuller culler;
+        culler.setFrustums(getEyeViewProj(center, forward, -kEyeOffset), getEyeViewProj(center, forward, kEyeOffset));
+
+        StereoFrustumCuller::Batch batch;
+        std::vector<BoundingBox> boxes;
+        addRandomBoxes(batch, boxes, 4099);
+
+        std::vector<uint8_t> scalar;
+        std::vector<uint8_t> simd;
+        culler.cull(batch, scalar, false);
+        culler.cull(batch, simd, true);
+        EXPECT_EQ(scalar.size(), simd.size());
+        for (size_t i = 0; i < scalar.size(); i++)
+        {
+            EXPECT_EQ((uint32_t)simd[i], (uint32_t)scalar[i]) << "box " << i;
+        }
+    }
+}
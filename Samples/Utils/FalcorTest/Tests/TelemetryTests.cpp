@@ -0,0 +1,121 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+namespace Falcor
+{
+    CPU_TEST(SpscQueueOrder)
+    {
+        SpscQueue<uint32_t> queue(100);
+        EXPECT_EQ(queue.capacity(), 128u);
+
+        // The producer spins on a full queue, so the small capacity is exercised as well
+        const uint32_t count = 100000;
+        std::thread producer([&]()
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                while (!queue.push(i)) std::this_thread::yield();
+            }
+        });
+
+        uint32_t expected = 0;
+        while (expected < count)
+        {
+            uint32_t value;
+            if (queue.pop(value))
+            {
+                EXPECT_EQ(value, expected);
+                expected++;
+            }
+        }
+        producer.join();
+        EXPECT(queue.empty());
+    }
+
+    // Both formats have to load back the same counters, frames and metadata, including counters that show up late and gaps
+    CPU_TEST(TelemetryRoundTrip)
+    {
+        for (Telemetry::Format format : { Telemetry::Format::Binary, Telemetry::Format::Csv })
+        {
+            const std::string filename = format == Telemetry::Format::Binary ? "telemetry_test.ftlm" : "telemetry_test.csv";
+            {
+                Telemetry::SharedPtr pTelemetry = Telemetry::create(filename, format, { { "scene", "Test" }, { "width", "1920" } });
+                EXPECT(pTelemetry != nullptr);
+                uint32_t cpuId = pTelemetry->getCounterId("cpuMs");
+                for (uint32_t frame = 0; frame < 100; frame++)
+                {
+                    pTelemetry->record(cpuId, (float)frame * 0.5f);
+                    if (frame >= 50) pTelemetry->record("holes", (float)(frame * 3));
+                    pTelemetry->endFrame();
+                }
+                pTelemetry->flush();
+                EXPECT_EQ(pTelemetry->getDroppedSampleCount(), 0u);
+            }
+
+            Telemetry::Log log;
+            EXPECT(Telemetry::load(filename, log)) << filename;
+            EXPECT_EQ(log.metadata.size(), 2u);
+            EXPECT_EQ(log.frameIds.size(), 100u);
+            EXPECT_EQ(log.counters.size(), 2u);
+            const std::vector<float>* pCpu = log.getColumn("cpuMs");
+            const std::vector<float>* pHoles = log.getColumn("holes");
+            EXPECT(pCpu != nullptr && pHoles != nullptr);
+            if (pCpu == nullptr || pHoles == nullptr || log.frameIds.size() != 100) continue;
+
+            for (uint32_t frame = 0; frame < 100; frame++)
+            {
+                EXPECT_EQ(log.frameIds[frame], frame);
+                EXPECT_EQ((*pCpu)[frame], (float)frame * 0.5f) << "frame = " << frame;
+                if (frame < 50) EXPECT(std::isnan((*pHoles)[frame])) << "frame = " << frame;
+                else EXPECT_EQ((*pHoles)[frame], (float)(frame * 3)) << "frame = " << frame;
+            }
+            std::remove(filename.c_str());
+        }
+    }
+
+    // The Profiler caches counter IDs per sink, a sink created after another one was destroyed must not look like it
+    CPU_TEST(TelemetryGeneration)
+    {
+        const std::string filename = "telemetry_generation_test.csv";
+        uint64_t generation = 0;
+        {
+            Telemetry::SharedPtr pTelemetry = Telemetry::create(filename, Telemetry::Format::Csv);
+            EXPECT(pTelemetry != nullptr);
+            if (pTelemetry) generation = pTelemetry->getGeneration();
+        }
+        Telemetry::SharedPtr pTelemetry = Telemetry::create(filename, Telemetry::Format::Csv);
+        EXPECT(pTelemetry != nullptr);
+        if (pTelemetry) EXPECT_NE(pTelemetry->getGeneration(), generation);
+        pTelemetry = nullptr;
+        std::remove(filename.c_str());
+    }
+}  // namespace Falcor
@@ -0,0 +1,141 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        glm::mat4 getRandomAffine(std::mt19937& rng)
+        {
+            std::uniform_real_distribution<float> dist(-2.f, 2.f);
+            glm::mat4 m(1.0f);
+            for (int c = 0; c < 4; c++)
+            {
+                m[c] = glm::vec4(dist(rng), dist(rng), dist(rng), c == 3 ? 1.f : 0.f);
+            }
+            // Keep the 3x3 part invertible
+            m[0][0] += 5.f; m[1][1] += 5.f; m[2][2] += 5.f;
+            return m;
+        }
+
+        bool isEqual(const glm::mat4& a, const glm::mat4& b)
+        {
+            for (int c = 0; c < 4; c++) if (a[c] != b[c]) return false;
+            return true;
+        }
+
+        bool isEqual(const glm::mat3x4& a, const glm::mat3x4& b)
+        {
+            for (int c = 0; c < 3; c++) if (a[c] != b[c]) return false;
+            return true;
+        }
+    }
+
+    // The cached matrices have to be exactly what SceneRenderer used to compute per draw, and only changed entries are recomputed
+    CPU_TEST(TransformTableUpdate)
+    {
+        std::mt19937 rng(3);
+        TransformTable table;
+        table.resize(100);
+        EXPECT(isEqual(table.getWorld(17), glm::mat4(1.0f)));
+
+        std::vector<glm::mat4> local(100), parent(100), prevParent(100);
+        for (uint32_t i = 0; i < 100; i++)
+        {
+            local[i] = getRandomAffine(rng);
+            parent[i] = getRandomAffine(rng);
+            prevParent[i] = getRandomAffine(rng);
+            table.setLocal(i, local[i], local[i]);
+            table.setParent(i, parent[i], prevParent[i]);
+        }
+        EXPECT_EQ(table.getDirtyCount(), 100u);
+        EXPECT_EQ(table.update(), 100u);
+        EXPECT_EQ(table.getDirtyCount(), 0u);
+
+        for (uint32_t i = 0; i < 100; i++)
+        {
+            glm::mat4 worldMat = parent[i] * local[i];
+            glm::mat3x4 normalMat = transpose(inverse(glm::mat3(worldMat)));
+            EXPECT(isEqual(table.getWorld(i), worldMat)) << "entry " << i;
+            EXPECT(isEqual(table.getPrevWorld(i), prevParent[i] * local[i])) << "entry " << i;
+            EXPECT(isEqual(table.getNormal(i), normalMat)) << "entry " << i;
+        }
+
+        // Moving a parent touches only its entries, setting an entry twice recomputes it once
+        glm::mat4 moved = getRandomAffine(rng);
+        table.setParent(5, moved, parent[5]);
+        table.setParent(6, moved, parent[6]);
+        table.setLocal(6, local[6], local[6]);
+        EXPECT_EQ(table.update(), 2u);
+        EXPECT(isEqual(table.getWorld(5), moved * local[5]));
+        EXPECT(isEqual(table.getPrevWorld(6), parent[6] * local[6]));
+        EXPECT(isEqual(table.getWorld(7), parent[7] * local[7]));
+        EXPECT_EQ(table.update(), 0u);
+
+        // Update stamps tell mirrors which entries changed since they last copied the table
+        EXPECT_EQ(table.getUpdateCount(), 2u);
+        EXPECT_EQ(table.getEntryUpdate(5), 2u);
+        EXPECT_EQ(table.getEntryUpdate(6), 2u);
+        EXPECT_EQ(table.getEntryUpdate(7), 1u);
+
+        // Shrinking drops queued entries beyond the end
+        table.setParent(99, moved, moved);
+        table.resize(50);
+        EXPECT_EQ(table.update(), 0u);
+    }
+
+    // Large batches are split across the pool and have to give the same results as the serial update
+    CPU_TEST(TransformTableParallel)
+    {
+        const uint32_t count = 10000;
+        std::mt19937 rng(9);
+        TransformTable serial;
+        TransformTable parallel;
+        serial.resize(count);
+        parallel.resize(count);
+        for (uint32_t i = 0; i < count; i += 3)
+        {
+            glm::mat4 local = getRandomAffine(rng);
+            glm::mat4 parent = getRandomAffine(rng);
+            serial.setLocal(i, local, local);
+            serial.setParent(i, parent, parent);
+            parallel.setLocal(i, local, local);
+            parallel.setParent(i, parent, parent);
+        }
+
+        WorkStealingPool::SharedPtr pPool = WorkStealingPool::create(4);
+        EXPECT_EQ(parallel.update(pPool.get()), serial.update());
+        for (uint32_t i = 0; i < count; i++)
+        {
+            EXPECT(isEqual(parallel.getWorld(i), serial.getWorld(i))) << "entry " << i;
+            EXPECT(isEqual(parallel.getNormal(i), serial.getNormal(i))) << "entry " << i;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Experimental/RenderGraph/TransientHeapAllocator.h"
+#include <random>
+
+namespace Falcor
+{
+    using Allocation = TransientHeapAllocator::Allocation;
+
+    static Allocation makeAllocation(uint64_t size, uint64_t alignment, uint32_t firstUsed, uint32_t lastUsed)
+    {
+        Allocation a;
+        a.size = size;
+        a.alignment = alignment;
+        a.firstUsed = firstUsed;
+        a.lastUsed = lastUsed;
+        return a;
+    }
+
+    CPU_TEST(TransientHeapAllocatorReuse)
+    {
+        // A chain of passes, every resource is only read by the next pass
+        std::vector<Allocation> allocations;
+        allocations.push_back(makeAllocation(100, 1, 0, 1));
+        allocations.push_back(makeAllocation(100, 1, 1, 2));
+        allocations.push_back(makeAllocation(100, 1, 2, 3));
+        allocations.push_back(makeAllocation(50, 1, 3, 4));
+
+        uint64_t heapSize = TransientHeapAllocator::pack(allocations);
+        EXPECT_EQ(heapSize, 200u);
+        EXPECT_EQ(allocations[0].offset, allocations[2].offset);
+        EXPECT(allocations[1].offset != allocations[0].offset);
+        EXPECT(allocations[3].offset == allocations[0].offset || allocations[3].offset == allocations[1].offset);
+
+        // Resources alive at the same time never share memory
+        std::vector<Allocation> concurrent(3, makeAllocation(64, 1, 0, 0));
+        EXPECT_EQ(TransientHeapAllocator::pack(concurrent), 192u);
+    }
+
+    CPU_TEST(TransientHeapAllocatorRandom)
+    {
+        std::mt19937 rng(7);
+        for (uint32_t iteration = 0; iteration < 1000; iteration++)
+        {
+            std::vector<Allocation> allocations(rng() % 16);
+            uint64_t totalSize = 0;
+            for (auto& a : allocations)
+            {
+                uint32_t firstUsed = rng() % 10;
+                a = makeAllocation(1 + rng() % 4096, 1ull << (rng() % 8), firstUsed, firstUsed + rng() % 4);
+                totalSize += a.size + a.alignment;
+            }
+
+            uint64_t heapSize = TransientHeapAllocator::pack(allocations);
+            EXPECT(heapSize <= totalSize);
+            for (size_t i = 0; i < allocations.size(); i++)
+            {
+                const Allocation& a = allocations[i];
+                EXPECT_EQ(a.offset % a.alignment, 0u);
+                EXPECT(a.offset + a.size <= heapSize);
+                for (size_t j = i + 1; j < allocations.size(); j++)
+                {
+                    const Allocation& b = allocations[j];
+                    EXPECT(TransientHeapAllocator::lifetimesOverlap(a, b) == false || TransientHeapAllocator::memoryOverlaps(a, b) == false);
+                }
+            }
+        }
+    }
+}
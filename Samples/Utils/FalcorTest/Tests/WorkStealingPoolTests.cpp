@@ -0,0 +1,102 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include <atomic>
+#include <future>
+#include <stdexcept>
+
+namespace Falcor
+{
+    // Framework systems nest parallelFor() calls on the shared pool, e.g. a render pass recorded on a worker updating the scene transforms
+    CPU_TEST(WorkStealingPoolNested)
+    {
+        WorkStealingPool::SharedPtr pPool = WorkStealingPool::getShared();
+        EXPECT(pPool == WorkStealingPool::getShared());
+
+        std::vector<std::atomic<uint32_t>> counts(64 * 256);
+        for (auto& c : counts) c = 0;
+        pPool->parallelFor(64, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                pPool->parallelFor(256, 16, [&](uint32_t innerBegin, uint32_t innerEnd)
+                {
+                    for (uint32_t j = innerBegin; j < innerEnd; j++) counts[i * 256 + j]++;
+                });
+            }
+        });
+
+        uint32_t wrongCount = 0;
+        for (auto& c : counts) wrongCount += (c.load() == 1) ? 0 : 1;
+        EXPECT_EQ(wrongCount, 0u);
+    }
+
+    // Background jobs run on a worker, never on a thread waiting in parallelFor()
+    CPU_TEST(WorkStealingPoolBackground)
+    {
+        WorkStealingPool::SharedPtr pPool = WorkStealingPool::create(4);
+        std::promise<std::thread::id> started;
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        pPool->submitBackground([&started, released]()
+        {
+            started.set_value(std::this_thread::get_id());
+            released.wait();
+        });
+        EXPECT(started.get_future().get() != std::this_thread::get_id());
+
+        // The remaining workers and the caller still run ranges while the job blocks its worker
+        std::atomic<uint32_t> sum(0);
+        pPool->parallelFor(1000, 10, [&sum](uint32_t begin, uint32_t end) { sum += end - begin; });
+        EXPECT_EQ(sum.load(), 1000u);
+        release.set_value();
+    }
+
+    // A throwing range must not leave the caller waiting, the exception arrives on the calling thread and the pool stays usable
+    CPU_TEST(WorkStealingPoolException)
+    {
+        WorkStealingPool::SharedPtr pPool = WorkStealingPool::create(4);
+        bool caught = false;
+        try
+        {
+            pPool->parallelFor(1000, 10, [](uint32_t begin, uint32_t end)
+            {
+                if (begin <= 500 && 500 < end) throw std::runtime_error("range 500");
+            });
+        }
+        catch (const std::runtime_error& e)
+        {
+            caught = std::string(e.what()) == "range 500";
+        }
+        EXPECT(caught);
+
+        std::atomic<uint32_t> sum(0);
+        pPool->parallelFor(1000, 10, [&sum](uint32_t begin, uint32_t end) { sum += end - begin; });
+        EXPECT_EQ(sum.load(), 1000u);
+    }
+}  // namespace Falcor